@@ -0,0 +1,199 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#ifndef CORE_INCLUDE_DEVICE_BLOCKDEV_H_
+#define CORE_INCLUDE_DEVICE_BLOCKDEV_H_
+
+#include <stdint.h>
+
+struct blockdev_operations;
+
+/**
+ * @brief Defines a block device: anything that stores data in fixed-size blocks (SDCARD, RAM disk, etc.)
+ */
+struct blockdev_device {
+    /** Block device operation definition */
+    const struct blockdev_operations * const ops;
+    /** Block device private object which is implementation specific */
+    const void * const priv;
+};
+
+/**
+ * @brief Geometry of a block device
+ */
+struct blockdev_geometry {
+    uint32_t block_size;    /** Size of a block in bytes */
+    uint32_t block_count;   /** Number of blocks in the device */
+};
+
+/**
+ * @brief Type of an asynchronous request
+ */
+enum blockdev_request_type {
+    BLOCKDEV_REQ_READ,
+    BLOCKDEV_REQ_WRITE,
+    BLOCKDEV_REQ_TRIM,
+    BLOCKDEV_REQ_FLUSH,
+};
+
+struct blockdev_request;
+
+/**
+ * @brief Called when an asynchronous request is finished. May be called from the context that submitted the request
+ * when the block device is synchronous
+ *
+ * @param request The request that finished
+ * @param result Same value the synchronous operation would return
+ */
+typedef void (*blockdev_done_fn)(struct blockdev_request *request, int32_t result);
+
+/**
+ * @brief Defines an asynchronous request. Must remain valid until done() is called
+ */
+struct blockdev_request {
+    enum blockdev_request_type type;
+    uint32_t block;         /** First block */
+    uint32_t count;         /** Number of blocks */
+    void *data;             /** Data to read to or to write from */
+    blockdev_done_fn done;  /** Completion callback */
+    void *arg;              /** User argument */
+};
+
+/**
+ * @brief Possible operations on block device objects.
+ * Every *_operaitions structure should have the first funptr a init()-like function:
+ * it should only receive a "struct *_device * const" and nothing more
+ */
+struct blockdev_operations {
+    /**
+     * @brief Initializes the block device
+     * @param bdev Block device
+     *
+     * @return Negative on error.
+     */
+    int32_t     (*blockdev_init)(const struct blockdev_device * const bdev);
+
+    /**
+     * @brief Reads [count] blocks starting at [block] to [data]
+     *
+     * @return Amount of bytes read. Negative on error.
+     */
+    int32_t     (*blockdev_read_op)(const struct blockdev_device * const bdev, uint32_t block, uint32_t count,
+        void *data);
+
+    /**
+     * @brief Writes [count] blocks starting at [block] from [data]
+     *
+     * @return Amount of bytes written. Negative on error.
+     */
+    int32_t     (*blockdev_write_op)(const struct blockdev_device * const bdev, uint32_t block, uint32_t count,
+        const void *data);
+
+    /**
+     * @brief Tells the device that [count] blocks starting at [block] are no longer in use
+     *
+     * @return Negative on error.
+     */
+    int32_t     (*blockdev_trim_op)(const struct blockdev_device * const bdev, uint32_t block, uint32_t count);
+
+    /**
+     * @brief Waits until every write is on the storage
+     *
+     * @return Negative on error.
+     */
+    int32_t     (*blockdev_flush_op)(const struct blockdev_device * const bdev);
+
+    /**
+     * @brief Gets device geometry
+     *
+     * @return Negative on error.
+     */
+    int32_t     (*blockdev_geometry_op)(const struct blockdev_device * const bdev, struct blockdev_geometry *geometry);
+
+    /**
+     * @brief Submits an asynchronous request. Synchronous devices should use blockdev_submit_sync()
+     *
+     * @return Negative if the request could not be submitted. In this case done() is not called
+     */
+    int32_t     (*blockdev_submit_op)(const struct blockdev_device * const bdev, struct blockdev_request *request);
+};
+
+/*
+ * API Definition
+ */
+
+/**
+ * @brief Reads blocks from a block device
+ *
+ * @param bdev Block device object
+ * @param block First block to read
+ * @param count Number of blocks to read
+ * @param data [out] Buffer large enough for count blocks
+ * @return int32_t Number of bytes read or negative on error
+ */
+extern int32_t blockdev_read(const struct blockdev_device * const bdev, uint32_t block, uint32_t count, void *data);
+
+/**
+ * @brief Writes blocks to a block device
+ *
+ * @param bdev Block device object
+ * @param block First block to write
+ * @param count Number of blocks to write
+ * @param data [in] Data of count blocks
+ * @return int32_t Number of bytes written or negative on error
+ */
+extern int32_t blockdev_write(const struct blockdev_device * const bdev, uint32_t block, uint32_t count,
+    const void *data);
+
+/**
+ * @brief Marks blocks as unused
+ *
+ * @param bdev Block device object
+ * @param block First block
+ * @param count Number of blocks
+ * @return int32_t E_SUCCESS on success
+ */
+extern int32_t blockdev_trim(const struct blockdev_device * const bdev, uint32_t block, uint32_t count);
+
+/**
+ * @brief Flushes pending writes
+ *
+ * @param bdev Block device object
+ * @return int32_t E_SUCCESS on success
+ */
+extern int32_t blockdev_flush(const struct blockdev_device * const bdev);
+
+/**
+ * @brief Gets block size and block count of a block device
+ *
+ * @param bdev Block device object
+ * @param geometry [out] Geometry
+ * @return int32_t E_SUCCESS on success
+ */
+extern int32_t blockdev_get_geometry(const struct blockdev_device * const bdev, struct blockdev_geometry *geometry);
+
+/**
+ * @brief Submits an asynchronous request
+ *
+ * @param bdev Block device object
+ * @param request Request. Must remain valid until request->done() is called
+ * @return int32_t E_SUCCESS if the request was accepted
+ */
+extern int32_t blockdev_submit(const struct blockdev_device * const bdev, struct blockdev_request *request);
+
+/**
+ * @brief Executes a request right away using the synchronous operations and calls done(). Block devices without
+ * asynchronous support use it as blockdev_submit_op
+ *
+ * @param bdev Block device object
+ * @param request Request
+ * @return int32_t E_SUCCESS
+ */
+extern int32_t blockdev_submit_sync(const struct blockdev_device * const bdev, struct blockdev_request *request);
+
+#endif // CORE_INCLUDE_DEVICE_BLOCKDEV_H_
@@ -16,6 +16,7 @@ struct cpu {
     int32_t (*get_rtc_timestamp)(const struct cpu * const cpu, uint32_t * const timestamp);
     int32_t (*get_clock_in_hz)(const struct cpu * const cpu, uint32_t * const clock);
     int32_t (*reset)(const struct cpu * const cpu);
+    int32_t (*get_cycle_counter)(const struct cpu * const cpu, uint32_t * const cycles);
 };
 
 /* API Definition */
@@ -48,6 +49,16 @@ extern int32_t cpu_get_rtc_timestamp(const struct cpu * const cpu, uint32_t * co
  */
 extern int32_t cpu_get_clock_in_hz(const struct cpu * const cpu, uint32_t * const clock);
 
+/**
+ * @brief Gets a free running counter incremented at every CPU clock cycle. It wraps around every 2^32 cycles. May be
+ * called from ISRs
+ *
+ * @param cpu CPU object
+ * @param cycles [out] Number of cycles
+ * @return int32_t E_SUCCESS on success. E_UNIMPEMENTED if the CPU has no cycle counter
+ */
+extern int32_t cpu_get_cycle_counter(const struct cpu * const cpu, uint32_t * const cycles);
+
 /**
  * @brief Resets the CPU
  *
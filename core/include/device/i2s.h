@@ -12,6 +12,19 @@
 #include <stdint.h>
 
 struct i2s_operations;
+struct i2s_device;
+
+/**
+ * @brief Called from interrupt context each time a block of captured frames is complete
+ *
+ * @param i2s I2S device object
+ * @param stereo Interleaved frames, left channel first. Valid until the same half of the capture buffer is filled
+ * again
+ * @param frames Number of frames
+ * @param arg Argument given to i2s_capture_start()
+ */
+typedef void (*i2s_block_callback)(const struct i2s_device * const i2s, const int16_t *stereo, uint32_t frames,
+    void *arg);
 
 struct i2s_device {
     /** I2C operation definition */
@@ -32,6 +45,23 @@ struct i2s_operations {
      * @brief Writes to an I2C device
      */
     int32_t (*i2s_write_op)(const struct i2s_device * const i2s, uint16_t l_ch, uint16_t r_ch);
+
+    /**
+     * @brief Writes a block of interleaved frames, usually through DMA. Optional: when NULL the block is written
+     * frame by frame with i2s_write_op
+     */
+    int32_t (*i2s_write_block_op)(const struct i2s_device * const i2s, const int16_t *stereo, uint32_t frames);
+
+    /**
+     * @brief Starts a circular capture, usually through DMA. Optional: NULL when the device can not receive
+     */
+    int32_t (*i2s_capture_start_op)(const struct i2s_device * const i2s, int16_t * const buffer, uint32_t frames,
+        i2s_block_callback callback, void *arg);
+
+    /**
+     * @brief Stops the capture. Optional: NULL when the device can not receive
+     */
+    int32_t (*i2s_capture_stop_op)(const struct i2s_device * const i2s);
 };
 
 /*
@@ -49,4 +79,39 @@ struct i2s_operations {
  */
 extern int32_t i2s_write(const struct i2s_device * const i2s, uint16_t l_ch, uint16_t r_ch);
 
+/**
+ * @brief Writes a block of frames to an I2S device
+ *
+ * @param i2s I2S device object
+ * @param stereo Interleaved frames, left channel first
+ * @param frames Number of frames
+ *
+ * @return int32_t Number of frames transmited. Negative number on error
+ */
+extern int32_t i2s_write_block(const struct i2s_device * const i2s, const int16_t *stereo, uint32_t frames);
+
+/**
+ * @brief Starts capturing from an I2S device. The device fills the two halves of buffer in turns, forever, and
+ * calls callback each time one is complete. Writes keep working meanwhile (full duplex)
+ *
+ * @param i2s I2S device object
+ * @param buffer Capture buffer of 2 * frames stereo frames
+ * @param frames Number of frames of each half: the block size
+ * @param callback Called from interrupt context with every complete half
+ * @param arg Argument of callback
+ *
+ * @return int32_t E_SUCCESS on success. E_UNIMPEMENTED if the device can not receive
+ */
+extern int32_t i2s_capture_start(const struct i2s_device * const i2s, int16_t * const buffer, uint32_t frames,
+    i2s_block_callback callback, void *arg);
+
+/**
+ * @brief Stops capturing. No callback is called once it returns
+ *
+ * @param i2s I2S device object
+ *
+ * @return int32_t E_SUCCESS on success. E_UNIMPEMENTED if the device can not receive
+ */
+extern int32_t i2s_capture_stop(const struct i2s_device * const i2s);
+
 #endif // INCLUDE_DEVICE_I2S_H_
\ No newline at end of file
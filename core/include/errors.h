@@ -34,9 +34,16 @@ enum errors {
     /***** FIFO errors *****/
     E_TX_QUEUE_FULL,        /** TX queue full */
     E_RX_QUEUE_EMPTY,       /** RX queue empty */
+    E_RX_OVERRUN,           /** Data was overwritten before being consumed */
+
+    /***** Sensor errors *****/
+    E_SENSOR_MOVED,         /** Sensor moved while it had to stay still */
 
     /***** Generic error codes *****/
     E_INVALID_CRC,          /** Invalid CRC */
+    E_INVALID_FORMAT,       /** Data is not in a supported format */
+    E_NO_MEMORY,            /** Out of buffers or memory */
+    E_NO_SPACE,             /** Storage or file is full */
     E_UNIMPEMENTED,         /** Function not implemented yet */
     E_SUCCESS = 0,          /** Success */
 };
@@ -0,0 +1,68 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#include "include/device/blockdev.h"
+
+#include "include/errors.h"
+
+#include <stdint.h>
+#include <stddef.h>
+
+int32_t blockdev_read(const struct blockdev_device * const bdev, uint32_t block, uint32_t count, void *data)
+{
+    return bdev->ops->blockdev_read_op(bdev, block, count, data);
+}
+
+int32_t blockdev_write(const struct blockdev_device * const bdev, uint32_t block, uint32_t count, const void *data)
+{
+    return bdev->ops->blockdev_write_op(bdev, block, count, data);
+}
+
+int32_t blockdev_trim(const struct blockdev_device * const bdev, uint32_t block, uint32_t count)
+{
+    return bdev->ops->blockdev_trim_op(bdev, block, count);
+}
+
+int32_t blockdev_flush(const struct blockdev_device * const bdev)
+{
+    return bdev->ops->blockdev_flush_op(bdev);
+}
+
+int32_t blockdev_get_geometry(const struct blockdev_device * const bdev, struct blockdev_geometry *geometry)
+{
+    return bdev->ops->blockdev_geometry_op(bdev, geometry);
+}
+
+int32_t blockdev_submit(const struct blockdev_device * const bdev, struct blockdev_request *request)
+{
+    return bdev->ops->blockdev_submit_op(bdev, request);
+}
+
+int32_t blockdev_submit_sync(const struct blockdev_device * const bdev, struct blockdev_request *request)
+{
+    int32_t ret;
+
+    if (request == NULL || request->done == NULL) {
+        ret = E_INVALID_PARAMETER;
+        goto exit;
+    }
+
+    switch (request->type) {
+        case BLOCKDEV_REQ_READ: ret = blockdev_read(bdev, request->block, request->count, request->data); break;
+        case BLOCKDEV_REQ_WRITE: ret = blockdev_write(bdev, request->block, request->count, request->data); break;
+        case BLOCKDEV_REQ_TRIM: ret = blockdev_trim(bdev, request->block, request->count); break;
+        case BLOCKDEV_REQ_FLUSH: ret = blockdev_flush(bdev); break;
+        default: { ret = E_INVALID_PARAMETER; goto exit; }
+    }
+
+    request->done(request, ret);
+    ret = E_SUCCESS;
+
+    exit:
+    return ret;
+}
@@ -11,6 +11,7 @@
 #include "include/errors.h"
 
 #include <stdint.h>
+#include <stddef.h>
 
 int32_t cpu_get_uuid(const struct cpu * const cpu, void * const uuid, uint32_t size)
 {
@@ -27,6 +28,12 @@ int32_t cpu_get_clock_in_hz(const struct cpu * const cpu, uint32_t * const clock
     return cpu->get_clock_in_hz(cpu, clock);
 }
 
+int32_t cpu_get_cycle_counter(const struct cpu * const cpu, uint32_t * const cycles)
+{
+    if (cpu->get_cycle_counter == NULL) return E_UNIMPEMENTED;
+    return cpu->get_cycle_counter(cpu, cycles);
+}
+
 int32_t cpu_reset(const struct cpu * const cpu)
 {
     return cpu->reset(cpu);
@@ -8,9 +8,41 @@
 
 #include "device/i2s.h"
 
+#include "include/errors.h"
+
 #include <stdint.h>
+#include <stddef.h>
 
 int32_t i2s_write(const struct i2s_device * const i2s, uint16_t l_ch, uint16_t r_ch)
 {
     return i2s->i2s_ops->i2s_write_op(i2s, l_ch, r_ch);
-}
\ No newline at end of file
+}
+
+int32_t i2s_write_block(const struct i2s_device * const i2s, const int16_t *stereo, uint32_t frames)
+{
+    int32_t ret;
+
+    if (i2s->i2s_ops->i2s_write_block_op != NULL) return i2s->i2s_ops->i2s_write_block_op(i2s, stereo, frames);
+
+    for (uint32_t i = 0; i < frames; i++) {
+        ret = i2s->i2s_ops->i2s_write_op(i2s, stereo[2 * i], stereo[2 * i + 1]);
+        if (ret < 0) { goto exit; }
+    }
+    ret = frames;
+
+    exit:
+    return ret;
+}
+
+int32_t i2s_capture_start(const struct i2s_device * const i2s, int16_t * const buffer, uint32_t frames,
+    i2s_block_callback callback, void *arg)
+{
+    if (i2s->i2s_ops->i2s_capture_start_op == NULL) return E_UNIMPEMENTED;
+    return i2s->i2s_ops->i2s_capture_start_op(i2s, buffer, frames, callback, arg);
+}
+
+int32_t i2s_capture_stop(const struct i2s_device * const i2s)
+{
+    if (i2s->i2s_ops->i2s_capture_stop_op == NULL) return E_UNIMPEMENTED;
+    return i2s->i2s_ops->i2s_capture_stop_op(i2s);
+}
@@ -30,9 +30,16 @@ const char *error_to_str(enum errors error)
         /***** FIFO errors *****/
         ERRSTR(E_TX_QUEUE_FULL);
         ERRSTR(E_RX_QUEUE_EMPTY);
+        ERRSTR(E_RX_OVERRUN);
+
+        /***** Sensor errors *****/
+        ERRSTR(E_SENSOR_MOVED);
 
         /***** Generic error codes *****/
         ERRSTR(E_INVALID_CRC);
+        ERRSTR(E_INVALID_FORMAT);
+        ERRSTR(E_NO_MEMORY);
+        ERRSTR(E_NO_SPACE);
         ERRSTR(E_UNIMPEMENTED);
         ERRSTR(E_SUCCESS);
         default: return "UNKNOWN";
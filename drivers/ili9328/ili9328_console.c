@@ -0,0 +1,245 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#include "drivers/ili9328/ili9328_console.h"
+#include "drivers/ili9328/ili9328_driver.h"
+
+#include "libs/gfx/font.h"
+
+#include "include/errors.h"
+
+#include "ulibc/include/log.h"
+#include "ulibc/include/utils.h"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#define TAG "ili9328_console"
+
+#define CONSOLE_TASK_SIZE 256
+#define CONSOLE_TASK_PRIORITY (tskIDLE_PRIORITY + 1)
+
+/** Cell of the 5x7 font */
+#define CELL_WIDTH 6
+#define CELL_HEIGHT 8
+
+/** Cells sent by each blit */
+#define BLIT_COLUMNS 10
+
+/** Screen columns: the GRAM lines scanned by the panel */
+#define SCREEN_WIDTH (ILI9328_CONSOLE_ROWS * CELL_HEIGHT)
+
+#define COLOR_DEBUG ILI9328_GREEN_SOLID
+#define COLOR_INFO  ILI9328_RGB(0, 63, 31)
+#define COLOR_WARN  ILI9328_YELLOW_SOLID
+#define COLOR_ERROR ILI9328_RED_SOLID
+
+struct console_line {
+    uint16_t color;
+    char text[ILI9328_CONSOLE_LINE_SIZE];
+};
+
+static StackType_t console_stack[CONSOLE_TASK_SIZE];
+static StaticTask_t console_tcb;
+static TaskHandle_t console_task_handle;
+
+/** Queue of lines. Printing tasks move head inside a critical section and only the console task moves tail */
+static struct console_line lines[ILI9328_CONSOLE_LINES];
+static volatile uint32_t head;
+static volatile uint32_t tail;
+
+static uint16_t console_background;
+/** Row shown at the top, as set in the scroll register */
+static uint32_t top;
+/** Rows written since the screen was cleared, up to ILI9328_CONSOLE_ROWS */
+static uint32_t used;
+/** Cells of each row that are not background */
+static uint8_t drawn[ILI9328_CONSOLE_ROWS];
+
+static struct ili9328_console_stats console_stats;
+
+/**
+ * @brief Draws cells of a row. Cells past the text are drawn as background
+ *
+ * @param row Row
+ * @param text Text of the row
+ * @param length Length of the text
+ * @param first First cell
+ * @param last One past the last cell
+ * @param color Color of the text
+ */
+static void draw_cells(uint32_t row, const char *text, uint32_t length, uint32_t first, uint32_t last,
+    uint16_t color)
+{
+    static uint16_t pixels[BLIT_COLUMNS * CELL_WIDTH * CELL_HEIGHT];
+    const struct gfx_font *font = &gfx_font_5x7;
+    // Row lines go right to left on the screen, so the window is filled from the last line of the row up
+    const struct ili9328_window window = {
+        .point_st = {SCREEN_WIDTH - (row + 1) * CELL_HEIGHT, first * CELL_WIDTH},
+        .point_end = {SCREEN_WIDTH - 1 - row * CELL_HEIGHT, last * CELL_WIDTH - 1},
+    };
+    uint16_t *cell = pixels;
+
+    for (uint32_t column = first; column < last; column++, cell += CELL_WIDTH * CELL_HEIGHT) {
+        for (uint32_t i = 0; i < CELL_WIDTH * CELL_HEIGHT; i++) cell[i] = console_background;
+        if (column >= length) continue;
+
+        const uint8_t code = (uint8_t)text[column];
+        const struct gfx_glyph *glyph = &font->glyphs[(code < font->first || code > font->last) ? 0 :
+            code - font->first];
+        const uint8_t *bitmap = &font->bitmap[glyph->offset];
+        for (uint32_t y = 0; y < glyph->height; y++) {
+            for (uint32_t x = 0; x < glyph->width; x++) {
+                const uint32_t bit = y * glyph->width + x;
+                const uint32_t cx = x + glyph->x_offset, cy = y + glyph->y_offset;
+                if (cx < CELL_WIDTH && cy < CELL_HEIGHT && IS_BIT_SET(bitmap[bit >> 3], 0x80 >> (bit & 7))) {
+                    cell[cx * CELL_HEIGHT + CELL_HEIGHT - 1 - cy] = color;
+                }
+            }
+        }
+    }
+
+    ili9328_blit(&window, pixels);
+    console_stats.pixels += (last - first) * CELL_WIDTH * CELL_HEIGHT;
+}
+
+/**
+ * @brief Moves to a new row: the next empty one, or the oldest one, to be scrolled to the bottom once redrawn
+ *
+ * @param scroll [out] TRUE if the row is the oldest one
+ * @return uint32_t Row
+ */
+static uint32_t next_row(uint8_t * const scroll)
+{
+    *scroll = used == ILI9328_CONSOLE_ROWS;
+    if (!*scroll) return used++;
+
+    return top;
+}
+
+/**
+ * @brief Moves the oldest row to the bottom of the screen
+ */
+static void scroll_row(void)
+{
+    top = (top + 1) % ILI9328_CONSOLE_ROWS;
+    ili9328_set_scroll(top * CELL_HEIGHT);
+    console_stats.scrolls++;
+}
+
+/**
+ * @brief Draws a line over as many rows as it needs
+ */
+static void draw_line(const char *text, uint16_t color)
+{
+    do {
+        char row_text[ILI9328_CONSOLE_COLUMNS];
+        uint32_t length = 0;
+
+        while (*text != '\0' && *text != '\n' && length < ILI9328_CONSOLE_COLUMNS) row_text[length++] = *text++;
+        if (*text == '\n') text++;
+
+        // Only cells that change: the text and what is left of the old one
+        uint8_t scroll;
+        const uint32_t row = next_row(&scroll);
+        const uint32_t columns = CHOOSE_MAX(length, drawn[row]);
+        for (uint32_t first = 0; first < columns; first += BLIT_COLUMNS) {
+            draw_cells(row, row_text, length, first, CHOOSE_MIN(first + BLIT_COLUMNS, columns), color);
+        }
+        drawn[row] = length;
+        // Scrolled only now, so the bottom row never shows the old text
+        if (scroll) scroll_row();
+    } while (*text != '\0');
+
+    console_stats.lines++;
+}
+
+static void console_task(void *arg)
+{
+    (void)arg;
+
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        while (tail != head) {
+            const struct console_line *line = &lines[tail % ILI9328_CONSOLE_LINES];
+            draw_line(line->text, line->color);
+            tail++;
+        }
+    }
+}
+
+int32_t ili9328_console_start(uint16_t background)
+{
+    if (console_task_handle != NULL) return E_SUCCESS;
+
+    console_background = background;
+    top = 0;
+    used = 0;
+    memset(drawn, 0, sizeof(drawn));
+    memset(&console_stats, 0, sizeof(console_stats));
+    ili9328_set_scroll(0);
+    ili9328_clear_screen(background);
+
+    console_task_handle = xTaskCreateStatic(console_task, TAG, CONSOLE_TASK_SIZE, NULL, CONSOLE_TASK_PRIORITY,
+        console_stack, &console_tcb);
+
+    return E_SUCCESS;
+}
+
+int32_t ili9328_console_print(const char *text, uint16_t color)
+{
+    int32_t ret = E_SUCCESS;
+
+    if (console_task_handle == NULL) return E_NOT_INITIALIZED;
+
+    taskENTER_CRITICAL();
+    if (head - tail == ILI9328_CONSOLE_LINES) {
+        console_stats.dropped++;
+        ret = E_TX_QUEUE_FULL;
+    } else {
+        struct console_line *line = &lines[head % ILI9328_CONSOLE_LINES];
+        line->color = color;
+        strncpy(line->text, text, sizeof(line->text) - 1);
+        line->text[sizeof(line->text) - 1] = '\0';
+        head++;
+    }
+    taskEXIT_CRITICAL();
+
+    if (ret == E_SUCCESS) xTaskNotifyGive(console_task_handle);
+
+    return ret;
+}
+
+void ili9328_console_log_sink(enum log_level level, const char *tag, const char *message)
+{
+    char text[ILI9328_CONSOLE_LINE_SIZE];
+    uint16_t color;
+
+    switch (level) {
+        case INFO_LVL: color = COLOR_INFO; break;
+        case WARN_LVL: color = COLOR_WARN; break;
+        case ERROR_LVL: color = COLOR_ERROR; break;
+        default:
+        case DEBUG_LVL: color = COLOR_DEBUG; break;
+    }
+
+    snprintf(text, sizeof(text), "%s: %s", tag, message);
+    ili9328_console_print(text, color);
+}
+
+void ili9328_console_get_stats(struct ili9328_console_stats * const stats)
+{
+    taskENTER_CRITICAL();
+    *stats = console_stats;
+    taskEXIT_CRITICAL();
+}
@@ -0,0 +1,85 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#ifndef DRIVERS_ILI9328_ILI9328_CONSOLE_H_
+#define DRIVERS_ILI9328_ILI9328_CONSOLE_H_
+
+#include "ulibc/include/log.h"
+
+#include <stdint.h>
+
+/**
+ * @brief Text console on the ILI9328 with hardware scrolling.
+ *
+ * The panel can only scroll along its GRAM lines, which the driver maps to screen columns, so the console uses the
+ * panel in its native portrait orientation: it reads with the board turned so that the right edge of the landscape
+ * screen is the top. Text rows are bands of 8 GRAM lines holding 40 cells of the 5x7 font.
+ *
+ * A new row is drawn over the oldest one, which the scroll register then moves to the bottom. Scrolling costs one
+ * register write instead of redrawing the 76800 pixels of the screen, and a row is drawn only up to the longer of its
+ * new and old texts.
+ *
+ * Lines are queued by any task and drawn by a task of the console, so logging never waits for the display. Lines
+ * printed while the queue is full are dropped and counted.
+ */
+
+/** Cells per row */
+#define ILI9328_CONSOLE_COLUMNS 40
+
+/** Rows on the screen */
+#define ILI9328_CONSOLE_ROWS 40
+
+/** Lines waiting to be drawn */
+#define ILI9328_CONSOLE_LINES 8
+
+/** Longest line queued, two rows. Longer lines are truncated */
+#define ILI9328_CONSOLE_LINE_SIZE (2 * ILI9328_CONSOLE_COLUMNS)
+
+struct ili9328_console_stats {
+    uint32_t lines;             /** Lines drawn */
+    uint32_t dropped;           /** Lines dropped because the queue was full */
+    uint32_t scrolls;           /** Rows scrolled */
+    uint32_t pixels;            /** Pixels written */
+};
+
+/**
+ * @brief Clears the screen and starts the console. The display must be initialized with ili9328_init()
+ *
+ * @param background Background color
+ * @return int32_t E_SUCCESS on success
+ */
+extern int32_t ili9328_console_start(uint16_t background);
+
+/**
+ * @brief Queues a line. Lines wrap at the end of a row and at each '\n'. Must not be called from an ISR
+ *
+ * @param text Text of the line
+ * @param color Color of the text
+ * @return int32_t E_SUCCESS on success. E_NOT_INITIALIZED if the console was not started. E_TX_QUEUE_FULL if the
+ * line was dropped
+ */
+extern int32_t ili9328_console_print(const char *text, uint16_t color);
+
+/**
+ * @brief Log sink that prints log lines as "tag: message", colored by level. Install it with
+ * ulog_set_sink(ili9328_console_log_sink). Logs must then not be written from an ISR
+ *
+ * @param level Log level
+ * @param tag Tag of the line
+ * @param message Message
+ */
+extern void ili9328_console_log_sink(enum log_level level, const char *tag, const char *message);
+
+/**
+ * @brief Gets statistics of the console
+ *
+ * @param stats [out] Statistics
+ */
+extern void ili9328_console_get_stats(struct ili9328_console_stats * const stats);
+
+#endif // DRIVERS_ILI9328_ILI9328_CONSOLE_H_
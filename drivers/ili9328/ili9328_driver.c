@@ -29,6 +29,12 @@ static void ili9328_write_reg(uint8_t reg, uint16_t val);
 
 static void ili9328_delay(uint8_t delay);
 
+static void ili9328_set_window(uint16_t x_st, uint16_t y_st, uint16_t x_end, uint16_t y_end);
+
+static void ili9328_write_color(uint16_t color, uint32_t count);
+
+static void ili9328_write_pixels(const uint16_t *pixels, uint32_t count);
+
 struct ili9328_startup_sequence {
     uint8_t reg;
     uint8_t delay_ms;
@@ -80,7 +86,7 @@ static const struct ili9328_startup_sequence startup[50] = {
     {ILI9328_REG_VERTICAL_ADDRESS_START,        0, 0x0000},
     {ILI9328_REG_VERTICAL_ADDRESS_END,          0, 0x013f},
     {ILI9328_REG_DRIVER_OUTPUT_CTRL_2,          0, 0xa700},
-    {ILI9328_REG_BASE_IMAGE_DISPLAY_CTRL,       0, 0x0001},
+    {ILI9328_REG_BASE_IMAGE_DISPLAY_CTRL,       0, 0x0003}, // REV and VLE: ili9328_set_scroll() takes effect
     {ILI9328_REG_VERTICAL_SCROLL_CTRL,          0, 0x0000},
     /* Partial display control */
     {ILI9328_REG_PARTIAL_IMAGE_1_DISPLAY_POS,   0, 0x0000},
@@ -109,7 +115,7 @@ int32_t ili9328_init(void)
         ili9328_write_reg(startup[i].reg, startup[i].value);
         if (startup[i].delay_ms) ili9328_delay(startup[i].delay_ms);
     }
-    ILI9328_LCD_REG = ILI9328_REG_WRITE_DATA_GRAM;
+    ILI9328_WRITE_INDEX(ILI9328_REG_WRITE_DATA_GRAM);
 
     exit:
     return ret;
@@ -117,20 +123,16 @@ int32_t ili9328_init(void)
 
 void ili9328_clear_screen(uint16_t bg_color)
 {
-    const struct ili9328_point home = {0, 0};
-    ili9328_set_cursor(&home);
-    ILI9328_LCD_REG = ILI9328_REG_WRITE_DATA_GRAM;
-    for (int i = 0; i < ILI9328_MAX_X * ILI9328_MAX_Y; i++) {
-        ILI9328_LCD_RAM = bg_color;
-    }
+    const struct ili9328_window screen = {{0, 0}, {ILI9328_MAX_X - 1, ILI9328_MAX_Y - 1}, bg_color};
+    ili9328_fill_rect(&screen);
 }
 
 int32_t ili9328_set_cursor(const struct ili9328_point *point)
 {
-    int32_t ret = 0;
+    int32_t ret = E_SUCCESS;
 
-    if (point->x_pos > ILI9328_MAX_X || point->y_pos > ILI9328_MAX_Y) {
-        ret = -1;
+    if (point->x_pos >= ILI9328_MAX_X || point->y_pos >= ILI9328_MAX_Y) {
+        ret = E_INVALID_PARAMETER;
         goto exit;
     }
 
@@ -138,61 +140,170 @@ int32_t ili9328_set_cursor(const struct ili9328_point *point)
     ili9328_write_reg(ILI9328_REG_HORIZONTAL_GRAM_ADDRESS_SET, point->y_pos);
     ili9328_write_reg(ILI9328_REG_VERTICAL_GRAM_ADDRESS_SET, ILI9328_MAX_X - 1 - point->x_pos);
 
-    ILI9328_LCD_REG = ILI9328_REG_WRITE_DATA_GRAM;
+    ILI9328_WRITE_INDEX(ILI9328_REG_WRITE_DATA_GRAM);
 
     exit:
     return ret;
 }
 
+/**
+ * @brief Checks that a window is inside the screen and not empty
+ */
+static int32_t ili9328_check_window(const struct ili9328_window *window)
+{
+    if (window == NULL) return E_INVALID_PARAMETER;
+
+    const struct ili9328_point *st = &window->point_st;
+    const struct ili9328_point *end = &window->point_end;
+    if (st->x_pos > end->x_pos || st->y_pos > end->y_pos || end->x_pos >= ILI9328_MAX_X ||
+        end->y_pos >= ILI9328_MAX_Y) {
+        return E_INVALID_PARAMETER;
+    }
+
+    return E_SUCCESS;
+}
+
 int32_t ili9328_set_gram_window(const struct ili9328_window *window)
 {
-    int32_t ret = E_SUCCESS;
+    int32_t ret = ili9328_check_window(window);
+    if (ret < 0) { goto exit; }
 
-    uint16_t x_pos_st = window->point_st.x_pos;
-    uint16_t y_pos_st = window->point_st.y_pos;
-    uint16_t x_pos_end = window->point_end.x_pos;
-    uint16_t y_pos_end = window->point_end.y_pos;
+    ili9328_set_window(window->point_st.x_pos, window->point_st.y_pos, window->point_end.x_pos,
+        window->point_end.y_pos);
+    ILI9328_WRITE_INDEX(ILI9328_REG_WRITE_DATA_GRAM);
 
-    if (x_pos_st > x_pos_end || y_pos_st > y_pos_end || x_pos_st > ILI9328_MAX_X || x_pos_end > ILI9328_MAX_X ||
-        y_pos_st > ILI9328_MAX_Y || y_pos_end > ILI9328_MAX_Y) {
+    exit:
+    return ret;
+}
+
+int32_t ili9328_fill_rect(const struct ili9328_window *window)
+{
+    int32_t ret = ili9328_check_window(window);
+    if (ret < 0) { goto exit; }
+
+    const uint32_t width = window->point_end.x_pos - window->point_st.x_pos + 1;
+    const uint32_t height = window->point_end.y_pos - window->point_st.y_pos + 1;
+
+    // The address counter wraps inside the window, so the whole rectangle is a single stream of pixels
+    ili9328_set_window(window->point_st.x_pos, window->point_st.y_pos, window->point_end.x_pos,
+        window->point_end.y_pos);
+    ili9328_write_color(window->window_color, width * height);
+    ili9328_set_window(0, 0, ILI9328_MAX_X - 1, ILI9328_MAX_Y - 1);
 
+    exit:
+    return ret;
+}
+
+int32_t ili9328_blit(const struct ili9328_window *window, const uint16_t *pixels)
+{
+    int32_t ret = ili9328_check_window(window);
+    if (ret < 0) { goto exit; }
+    if (pixels == NULL) {
         ret = E_INVALID_PARAMETER;
         goto exit;
     }
 
-    // Since the display is rotated 270 degrees the following construction is done
-    ili9328_write_reg(ILI9328_REG_HORIZONTAL_ADDRESS_START, y_pos_st);
-    ili9328_write_reg(ILI9328_REG_VERTICAL_ADDRESS_START, ILI9328_MAX_X - x_pos_end);
-
-    ili9328_write_reg(ILI9328_REG_HORIZONTAL_ADDRESS_END, y_pos_end);
-    ili9328_write_reg(ILI9328_REG_VERTICAL_ADDRESS_END, ILI9328_MAX_X - x_pos_st);
+    const uint32_t width = window->point_end.x_pos - window->point_st.x_pos + 1;
+    const uint32_t height = window->point_end.y_pos - window->point_st.y_pos + 1;
 
-    ILI9328_LCD_REG = ILI9328_REG_WRITE_DATA_GRAM;
+    ili9328_set_window(window->point_st.x_pos, window->point_st.y_pos, window->point_end.x_pos,
+        window->point_end.y_pos);
+    ili9328_write_pixels(pixels, width * height);
+    ili9328_set_window(0, 0, ILI9328_MAX_X - 1, ILI9328_MAX_Y - 1);
 
     exit:
     return ret;
 }
 
 int32_t ili9328_clear_window(const struct ili9328_window *window)
+{
+    return ili9328_fill_rect(window);
+}
+
+int32_t ili9328_set_scroll(uint16_t lines)
 {
     int32_t ret = E_SUCCESS;
 
-    if (window == NULL) {
+    if (lines >= ILI9328_MAX_X) {
         ret = E_INVALID_PARAMETER;
         goto exit;
     }
 
-    if ((ret = ili9328_set_cursor(&window->point_st)) < 0) {
-        goto exit;
-    }
-
-    int window_size = (window->point_end.x_pos - window->point_st.x_pos + 1) * (window->point_end.y_pos - window->point_st.y_pos + 1);
-    for (int i = 0; i < window_size; i++, ILI9328_LCD_RAM = window->window_color);
+    ili9328_write_reg(ILI9328_REG_VERTICAL_SCROLL_CTRL, lines);
+    ILI9328_WRITE_INDEX(ILI9328_REG_WRITE_DATA_GRAM);
 
     exit:
     return ret;
 }
 
+/**
+ * @brief Sets the GRAM window and moves the cursor to its first pixel. The entry mode moves the address counter
+ * along screen rows (x), then to the next row (y), wrapping inside the window
+ *
+ * @param x_st First column
+ * @param y_st First row
+ * @param x_end Last column
+ * @param y_end Last row
+ */
+static void ili9328_set_window(uint16_t x_st, uint16_t y_st, uint16_t x_end, uint16_t y_end)
+{
+    // Since the display is rotated 270 degrees the following construction is done
+    ili9328_write_reg(ILI9328_REG_HORIZONTAL_ADDRESS_START, y_st);
+    ili9328_write_reg(ILI9328_REG_HORIZONTAL_ADDRESS_END, y_end);
+    ili9328_write_reg(ILI9328_REG_VERTICAL_ADDRESS_START, ILI9328_MAX_X - 1 - x_end);
+    ili9328_write_reg(ILI9328_REG_VERTICAL_ADDRESS_END, ILI9328_MAX_X - 1 - x_st);
+
+    ili9328_write_reg(ILI9328_REG_HORIZONTAL_GRAM_ADDRESS_SET, y_st);
+    ili9328_write_reg(ILI9328_REG_VERTICAL_GRAM_ADDRESS_SET, ILI9328_MAX_X - 1 - x_st);
+}
+
+/**
+ * @brief Writes the same color to count pixels from the address counter
+ *
+ * @param color Color
+ * @param count Number of pixels
+ */
+static void ili9328_write_color(uint16_t color, uint32_t count)
+{
+    ILI9328_WRITE_INDEX(ILI9328_REG_WRITE_DATA_GRAM);
+
+    // Eight stores per iteration: the loop costs little next to the bus cycles
+    for (; count >= 8; count -= 8) {
+        ILI9328_WRITE_DATA(color);
+        ILI9328_WRITE_DATA(color);
+        ILI9328_WRITE_DATA(color);
+        ILI9328_WRITE_DATA(color);
+        ILI9328_WRITE_DATA(color);
+        ILI9328_WRITE_DATA(color);
+        ILI9328_WRITE_DATA(color);
+        ILI9328_WRITE_DATA(color);
+    }
+    for (; count > 0; count--) ILI9328_WRITE_DATA(color);
+}
+
+/**
+ * @brief Writes count pixels from the address counter
+ *
+ * @param pixels Pixels
+ * @param count Number of pixels
+ */
+static void ili9328_write_pixels(const uint16_t *pixels, uint32_t count)
+{
+    ILI9328_WRITE_INDEX(ILI9328_REG_WRITE_DATA_GRAM);
+
+    for (; count >= 8; count -= 8, pixels += 8) {
+        ILI9328_WRITE_DATA(pixels[0]);
+        ILI9328_WRITE_DATA(pixels[1]);
+        ILI9328_WRITE_DATA(pixels[2]);
+        ILI9328_WRITE_DATA(pixels[3]);
+        ILI9328_WRITE_DATA(pixels[4]);
+        ILI9328_WRITE_DATA(pixels[5]);
+        ILI9328_WRITE_DATA(pixels[6]);
+        ILI9328_WRITE_DATA(pixels[7]);
+    }
+    for (; count > 0; count--) ILI9328_WRITE_DATA(*pixels++);
+}
+
 /**
  * @brief Reads a register
  *
@@ -201,8 +312,8 @@ int32_t ili9328_clear_window(const struct ili9328_window *window)
  */
 static uint16_t ili9328_read_reg(uint8_t reg)
 {
-    ILI9328_LCD_REG = reg;
-    return ILI9328_LCD_RAM;
+    ILI9328_WRITE_INDEX(reg);
+    return ILI9328_READ_DATA();
 }
 
 /**
@@ -213,8 +324,8 @@ static uint16_t ili9328_read_reg(uint8_t reg)
  */
 static void ili9328_write_reg(uint8_t reg, uint16_t val)
 {
-    ILI9328_LCD_REG = reg;
-    ILI9328_LCD_RAM = val;
+    ILI9328_WRITE_INDEX(reg);
+    ILI9328_WRITE_DATA(val);
 }
 
 /**
@@ -46,7 +46,7 @@ extern void ili9328_clear_screen(uint16_t bg_color);
 extern int32_t ili9328_set_cursor(const struct ili9328_point *point);
 
 /**
- * @brief Sets GRAM window
+ * @brief Sets GRAM window and moves the cursor to its first pixel. Pixels written then fill the window row by row
  *
  * window Window object that defines the window
  *
@@ -62,6 +62,34 @@ extern int32_t ili9328_set_gram_window(const struct ili9328_window *window);
  */
 extern int32_t ili9328_clear_window(const struct ili9328_window *window);
 
+/**
+ * @brief Fills a rectangle with window_color. The GRAM window is programmed once and the pixels are streamed to it;
+ * the window is set back to the whole screen afterwards
+ *
+ * @param window Rectangle, both points included, and its color
+ * @return int32_t E_SUCCESS on success. E_INVALID_PARAMETER if the rectangle is not inside the screen
+ */
+extern int32_t ili9328_fill_rect(const struct ili9328_window *window);
+
+/**
+ * @brief Copies pixels to a rectangle. window_color is not used
+ *
+ * @param window Rectangle, both points included
+ * @param pixels Pixels of the rectangle, row by row
+ * @return int32_t E_SUCCESS on success. E_INVALID_PARAMETER if the rectangle is not inside the screen
+ */
+extern int32_t ili9328_blit(const struct ili9328_window *window, const uint16_t *pixels);
+
+/**
+ * @brief Scrolls the whole screen in hardware. The panel scans GRAM lines, which are screen columns here, starting
+ * lines further: what is drawn at column x is shown at column (x + lines) % 320. Drawing keeps using the unscrolled
+ * coordinates
+ *
+ * @param lines Scroll, from 0 to 319
+ * @return int32_t E_SUCCESS on success. E_INVALID_PARAMETER if lines is out of range
+ */
+extern int32_t ili9328_set_scroll(uint16_t lines);
+
 /* Some colors */
 
 /** RGB color space macro */
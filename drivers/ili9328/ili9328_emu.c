@@ -0,0 +1,127 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#include "drivers/ili9328/ili9328_emu.h"
+#include "drivers/ili9328/ili9328_driver_regs.h"
+
+#include <stdint.h>
+#include <string.h>
+
+/** Driver code read from register 0 */
+#define EMU_DRIVER_CODE 0x9328
+
+/** ILI9328_REG_ENTRY_MODE fields */
+#define ENTRY_MODE_AM   0x0008  /** Address moves vertically first */
+#define ENTRY_MODE_ID0  0x0010  /** Horizontal address increments */
+#define ENTRY_MODE_ID1  0x0020  /** Vertical address increments */
+
+/** ILI9328_REG_BASE_IMAGE_DISPLAY_CTRL fields */
+#define BASE_IMAGE_VLE  0x0002  /** Vertical scroll enabled */
+
+struct ili9328_emu ili9328_emu;
+
+/**
+ * @brief Moves an address one step inside [start, end], wrapping around
+ *
+ * @param address Address
+ * @param start Window start
+ * @param end Window end
+ * @param increment Non-zero to increment, zero to decrement
+ * @return uint32_t Non-zero when the address wrapped around
+ */
+static uint32_t step(uint16_t * const address, uint16_t start, uint16_t end, uint32_t increment)
+{
+    if (increment) {
+        if (*address >= end) {
+            *address = start;
+            return 1;
+        }
+        (*address)++;
+    } else {
+        if (*address <= start) {
+            *address = end;
+            return 1;
+        }
+        (*address)--;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Writes a pixel at the address counter and moves it as set by the entry mode
+ */
+static void write_gram(struct ili9328_emu * const emu, uint16_t value)
+{
+    const uint16_t mode = emu->regs[ILI9328_REG_ENTRY_MODE];
+    const uint16_t hsa = emu->regs[ILI9328_REG_HORIZONTAL_ADDRESS_START];
+    const uint16_t hea = emu->regs[ILI9328_REG_HORIZONTAL_ADDRESS_END];
+    const uint16_t vsa = emu->regs[ILI9328_REG_VERTICAL_ADDRESS_START];
+    const uint16_t vea = emu->regs[ILI9328_REG_VERTICAL_ADDRESS_END];
+
+    if (emu->h < ILI9328_EMU_GRAM_H && emu->v < ILI9328_EMU_GRAM_V) emu->gram[emu->v][emu->h] = value;
+    emu->gram_writes++;
+
+    if (mode & ENTRY_MODE_AM) {
+        if (step(&emu->v, vsa, vea, mode & ENTRY_MODE_ID1)) step(&emu->h, hsa, hea, mode & ENTRY_MODE_ID0);
+    } else {
+        if (step(&emu->h, hsa, hea, mode & ENTRY_MODE_ID0)) step(&emu->v, vsa, vea, mode & ENTRY_MODE_ID1);
+    }
+}
+
+void ili9328_emu_reset(struct ili9328_emu * const emu)
+{
+    memset(emu, 0, sizeof(*emu));
+    emu->regs[ILI9328_REG_ENTRY_MODE] = ENTRY_MODE_ID0 | ENTRY_MODE_ID1;
+    emu->regs[ILI9328_REG_HORIZONTAL_ADDRESS_END] = ILI9328_EMU_GRAM_H - 1;
+    emu->regs[ILI9328_REG_VERTICAL_ADDRESS_END] = ILI9328_EMU_GRAM_V - 1;
+}
+
+void ili9328_emu_write_index(struct ili9328_emu * const emu, uint16_t reg)
+{
+    emu->index = reg & 0xff;
+    emu->index_writes++;
+}
+
+void ili9328_emu_write_data(struct ili9328_emu * const emu, uint16_t value)
+{
+    emu->data_writes++;
+
+    switch (emu->index) {
+        case ILI9328_REG_WRITE_DATA_GRAM: write_gram(emu, value); return;
+        case ILI9328_REG_HORIZONTAL_GRAM_ADDRESS_SET: emu->h = value; break;
+        case ILI9328_REG_VERTICAL_GRAM_ADDRESS_SET: emu->v = value; break;
+        default: break;
+    }
+    emu->regs[emu->index] = value;
+}
+
+uint16_t ili9328_emu_read_data(struct ili9328_emu * const emu)
+{
+    emu->data_reads++;
+
+    if (emu->index == ILI9328_REG_DRIVER_CODE_READ) return EMU_DRIVER_CODE;
+    return emu->regs[emu->index];
+}
+
+uint16_t ili9328_emu_pixel(const struct ili9328_emu * const emu, uint16_t x, uint16_t y)
+{
+    return emu->gram[ILI9328_EMU_GRAM_V - 1 - x][y];
+}
+
+uint16_t ili9328_emu_shown_pixel(const struct ili9328_emu * const emu, uint16_t x, uint16_t y)
+{
+    uint32_t line = ILI9328_EMU_GRAM_V - 1 - x;
+
+    // Panel line n scans GRAM line n + VL
+    if (emu->regs[ILI9328_REG_BASE_IMAGE_DISPLAY_CTRL] & BASE_IMAGE_VLE) {
+        line = (line + emu->regs[ILI9328_REG_VERTICAL_SCROLL_CTRL]) % ILI9328_EMU_GRAM_V;
+    }
+
+    return emu->gram[line][y];
+}
@@ -0,0 +1,98 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#ifndef DRIVERS_ILI9328_ILI9328_EMU_H_
+#define DRIVERS_ILI9328_ILI9328_EMU_H_
+
+#include <stdint.h>
+
+/**
+ * @brief Host-side emulation of the ILI9328 behind the FSMC address space.
+ *
+ * Build the driver with ILI9328_EMU defined and every bus access goes to the global emulator ili9328_emu. It keeps
+ * the registers and the 240x320 GRAM, and moves the address counter on GRAM writes as the controller does: in the
+ * direction set by the entry mode register and wrapping inside the window registers. Tests draw with the driver and
+ * then check pixels with ili9328_emu_pixel() (screen coordinates, as the driver uses them) or the bus statistics.
+ */
+
+/** GRAM size: horizontal (screen y) by vertical (screen x) addresses */
+#define ILI9328_EMU_GRAM_H 240
+#define ILI9328_EMU_GRAM_V 320
+
+struct ili9328_emu {
+    /* Statistics */
+
+    uint32_t index_writes;      /** Register selections */
+    uint32_t data_writes;       /** Writes to registers and GRAM */
+    uint32_t gram_writes;       /** Pixels written */
+    uint32_t data_reads;        /** Reads */
+
+    /* Private state. Do not touch */
+
+    uint16_t index;
+    uint16_t regs[256];
+    uint16_t h;
+    uint16_t v;
+    uint16_t gram[ILI9328_EMU_GRAM_V][ILI9328_EMU_GRAM_H];
+};
+
+/** The emulator reached by the driver */
+extern struct ili9328_emu ili9328_emu;
+
+/**
+ * @brief Resets the emulator: registers and GRAM cleared, statistics zeroed
+ *
+ * @param emu Emulator object
+ */
+extern void ili9328_emu_reset(struct ili9328_emu * const emu);
+
+/**
+ * @brief Write to the index (register select) address
+ *
+ * @param emu Emulator object
+ * @param reg Register
+ */
+extern void ili9328_emu_write_index(struct ili9328_emu * const emu, uint16_t reg);
+
+/**
+ * @brief Write to the data address: the selected register or, for ILI9328_REG_WRITE_DATA_GRAM, a pixel
+ *
+ * @param emu Emulator object
+ * @param value Value
+ */
+extern void ili9328_emu_write_data(struct ili9328_emu * const emu, uint16_t value);
+
+/**
+ * @brief Read from the data address
+ *
+ * @param emu Emulator object
+ * @return uint16_t The selected register. The driver code for register 0
+ */
+extern uint16_t ili9328_emu_read_data(struct ili9328_emu * const emu);
+
+/**
+ * @brief Pixel at screen coordinates, with the 270 degrees rotation of the driver
+ *
+ * @param emu Emulator object
+ * @param x Column, 0 to 319
+ * @param y Row, 0 to 239
+ * @return uint16_t Pixel
+ */
+extern uint16_t ili9328_emu_pixel(const struct ili9328_emu * const emu, uint16_t x, uint16_t y);
+
+/**
+ * @brief Pixel shown on the panel at a screen position, once the hardware scroll is applied
+ *
+ * @param emu Emulator
+ * @param x Screen column
+ * @param y Screen row
+ * @return uint16_t Color
+ */
+extern uint16_t ili9328_emu_shown_pixel(const struct ili9328_emu * const emu, uint16_t x, uint16_t y);
+
+#endif // DRIVERS_ILI9328_ILI9328_EMU_H_
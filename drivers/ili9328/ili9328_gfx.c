@@ -0,0 +1,30 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#include "drivers/ili9328/ili9328_gfx.h"
+#include "drivers/ili9328/ili9328_driver.h"
+
+#include "libs/gfx/gfx.h"
+
+#include <stdint.h>
+
+static int32_t ili9328_gfx_blit(const struct gfx_rect * const rect, const uint16_t *pixels)
+{
+    const struct ili9328_window window = {
+        .point_st = {rect->x, rect->y},
+        .point_end = {rect->x + rect->w - 1, rect->y + rect->h - 1},
+    };
+
+    return ili9328_blit(&window, pixels);
+}
+
+const struct gfx_display ili9328_gfx_display = {
+    .width = 320,
+    .height = 240,
+    .blit = ili9328_gfx_blit,
+};
@@ -0,0 +1,17 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#ifndef DRIVERS_ILI9328_ILI9328_GFX_H_
+#define DRIVERS_ILI9328_ILI9328_GFX_H_
+
+#include "libs/gfx/gfx.h"
+
+/** The ILI9328 screen as a gfx display. Tiles are written with ili9328_blit() */
+extern const struct gfx_display ili9328_gfx_display;
+
+#endif // DRIVERS_ILI9328_ILI9328_GFX_H_
@@ -11,7 +11,29 @@
 
 #include <stdint.h>
 
+/**
+ * @brief Bus accesses to the ILI9328. On the target the controller sits in the FSMC address space: a write to
+ * ILI9328_LCD_REG selects a register (index) and ILI9328_LCD_RAM reads or writes it. Host builds define ILI9328_EMU
+ * and reach the emulator of ili9328_emu.c instead.
+ */
+
+#if defined(ILI9328_EMU)
+
+#include "drivers/ili9328/ili9328_emu.h"
+
+#define ILI9328_WRITE_INDEX(reg) ili9328_emu_write_index(&ili9328_emu, reg)
+#define ILI9328_WRITE_DATA(value) ili9328_emu_write_data(&ili9328_emu, value)
+#define ILI9328_READ_DATA() ili9328_emu_read_data(&ili9328_emu)
+
+#else
+
 #define ILI9328_LCD_REG (*((volatile uint16_t *)0x6d000000))
 #define ILI9328_LCD_RAM (*((volatile uint16_t *)0x6d010000))
 
-#endif // INC_ILI9328_LCD_ADDR_H_
\ No newline at end of file
+#define ILI9328_WRITE_INDEX(reg) (ILI9328_LCD_REG = (reg))
+#define ILI9328_WRITE_DATA(value) (ILI9328_LCD_RAM = (value))
+#define ILI9328_READ_DATA() (ILI9328_LCD_RAM)
+
+#endif
+
+#endif // INC_ILI9328_LCD_ADDR_H_
@@ -0,0 +1,144 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#include "drivers/imgdisk/imgdisk.h"
+
+#include "include/device/blockdev.h"
+#include "include/errors.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static int32_t imgdisk_init(const struct blockdev_device * const bdev)
+{
+    const struct imgdisk *img = (const struct imgdisk *)bdev->priv;
+    return img->map != NULL ? E_SUCCESS : E_NOT_INITIALIZED;
+}
+
+static int32_t imgdisk_check_range(const struct imgdisk *img, uint32_t block, uint32_t count)
+{
+    if (img->map == NULL) return E_NOT_INITIALIZED;
+    if (block >= img->block_count || count > img->block_count - block) return E_INVALID_PARAMETER;
+    return E_SUCCESS;
+}
+
+static int32_t imgdisk_read(const struct blockdev_device * const bdev, uint32_t block, uint32_t count, void *data)
+{
+    const struct imgdisk *img = (const struct imgdisk *)bdev->priv;
+    int32_t ret = imgdisk_check_range(img, block, count);
+    if (ret < 0) goto exit;
+
+    memcpy(data, &img->map[(size_t)block * img->block_size], (size_t)count * img->block_size);
+    ret = count * img->block_size;
+
+    exit:
+    return ret;
+}
+
+static int32_t imgdisk_write(const struct blockdev_device * const bdev, uint32_t block, uint32_t count,
+    const void *data)
+{
+    const struct imgdisk *img = (const struct imgdisk *)bdev->priv;
+    int32_t ret = imgdisk_check_range(img, block, count);
+    if (ret < 0) goto exit;
+
+    memcpy(&img->map[(size_t)block * img->block_size], data, (size_t)count * img->block_size);
+    ret = count * img->block_size;
+
+    exit:
+    return ret;
+}
+
+static int32_t imgdisk_trim(const struct blockdev_device * const bdev, uint32_t block, uint32_t count)
+{
+    const struct imgdisk *img = (const struct imgdisk *)bdev->priv;
+    return imgdisk_check_range(img, block, count);
+}
+
+static int32_t imgdisk_flush(const struct blockdev_device * const bdev)
+{
+    const struct imgdisk *img = (const struct imgdisk *)bdev->priv;
+
+    if (img->map == NULL) return E_NOT_INITIALIZED;
+    if (msync(img->map, (size_t)img->block_count * img->block_size, MS_SYNC) != 0) return E_HARDWARE_CONFIG_FAILED;
+    return E_SUCCESS;
+}
+
+static int32_t imgdisk_geometry(const struct blockdev_device * const bdev, struct blockdev_geometry *geometry)
+{
+    const struct imgdisk *img = (const struct imgdisk *)bdev->priv;
+
+    geometry->block_size = img->block_size;
+    geometry->block_count = img->block_count;
+    return E_SUCCESS;
+}
+
+const struct blockdev_operations imgdisk_blockdev_ops = {
+    .blockdev_init = imgdisk_init,
+    .blockdev_read_op = imgdisk_read,
+    .blockdev_write_op = imgdisk_write,
+    .blockdev_trim_op = imgdisk_trim,
+    .blockdev_flush_op = imgdisk_flush,
+    .blockdev_geometry_op = imgdisk_geometry,
+    .blockdev_submit_op = blockdev_submit_sync,
+};
+
+int32_t imgdisk_open(struct imgdisk * const img, const char *path)
+{
+    int32_t ret = E_SUCCESS;
+    struct stat st;
+
+    if (img == NULL || path == NULL || img->block_size == 0) {
+        ret = E_INVALID_PARAMETER;
+        goto exit;
+    }
+
+    img->map = NULL;
+    img->fd = open(path, O_RDWR);
+    if (img->fd < 0) {
+        ret = E_DEVICE_NOT_FOUND;
+        goto exit;
+    }
+
+    if (fstat(img->fd, &st) != 0 || st.st_size < img->block_size) {
+        ret = E_INVALID_PARAMETER;
+        goto close;
+    }
+
+    img->block_count = st.st_size / img->block_size;
+    void *map = mmap(NULL, (size_t)img->block_count * img->block_size, PROT_READ | PROT_WRITE, MAP_SHARED, img->fd, 0);
+    if (map == MAP_FAILED) {
+        ret = E_HARDWARE_CONFIG_FAILED;
+        goto close;
+    }
+    img->map = (uint8_t *)map;
+    goto exit;
+
+    close:
+    close(img->fd);
+    img->fd = -1;
+
+    exit:
+    return ret;
+}
+
+void imgdisk_close(struct imgdisk * const img)
+{
+    if (img->map != NULL) {
+        msync(img->map, (size_t)img->block_count * img->block_size, MS_SYNC);
+        munmap(img->map, (size_t)img->block_count * img->block_size);
+    }
+    if (img->fd >= 0) close(img->fd);
+    img->map = NULL;
+    img->fd = -1;
+}
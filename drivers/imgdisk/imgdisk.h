@@ -0,0 +1,51 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#ifndef DRIVERS_IMGDISK_IMGDISK_H_
+#define DRIVERS_IMGDISK_IMGDISK_H_
+
+#include "include/device/blockdev.h"
+
+#include <stdint.h>
+
+/**
+ * @brief A block device backed by a memory-mapped disk image file. Host builds only (needs POSIX mmap)
+ */
+struct imgdisk {
+    /** Size of a block in bytes. Must be set before imgdisk_open() */
+    uint32_t block_size;
+
+    /* Private state. Do not touch */
+
+    int fd;
+    uint8_t *map;
+    uint32_t block_count;
+};
+
+/**
+ * @brief Block device operations for a disk image. priv must point to a struct imgdisk opened with imgdisk_open()
+ */
+extern const struct blockdev_operations imgdisk_blockdev_ops;
+
+/**
+ * @brief Maps a disk image file. Its size defines the number of blocks
+ *
+ * @param img Image disk object
+ * @param path Path to the image file
+ * @return int32_t E_SUCCESS on success
+ */
+extern int32_t imgdisk_open(struct imgdisk * const img, const char *path);
+
+/**
+ * @brief Unmaps the disk image, writing back any change
+ *
+ * @param img Image disk object
+ */
+extern void imgdisk_close(struct imgdisk * const img);
+
+#endif // DRIVERS_IMGDISK_IMGDISK_H_
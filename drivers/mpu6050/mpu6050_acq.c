@@ -0,0 +1,492 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#include "drivers/mpu6050/mpu6050_acq.h"
+#include "drivers/mpu6050/mpu6050_driver.h"
+#include "drivers/mpu6050/mpu6050_cal.h"
+
+#include "include/device/cpu.h"
+#include "include/device/i2c.h"
+#include "include/errors.h"
+
+#include "ulibc/include/log.h"
+#include "ulibc/include/utils.h"
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#define TAG "mpu6050_acq"
+
+#define ACQ_TASK_SIZE 256
+#define ACQ_TASK_PRIORITY (tskIDLE_PRIORITY + 3)
+
+#define RING_MASK (MPU6050_ACQ_RING_LENGTH - 1)
+
+#if (MPU6050_ACQ_RING_LENGTH & RING_MASK) != 0
+#error "MPU6050_ACQ_RING_LENGTH must be a power of 2"
+#endif
+
+#define US_PER_TICK (1000000 / configTICK_RATE_HZ)
+
+static StackType_t acq_stack[ACQ_TASK_SIZE];
+static StaticTask_t acq_tcb;
+static TaskHandle_t acq_task_handle;
+
+static const struct i2c_device * volatile acq_i2c;
+static const struct cpu * volatile acq_cpu;
+static volatile TickType_t acq_period;
+/** Samples read from the FIFO at each wake up. 0 reads the sensor registers once per period */
+static volatile uint32_t acq_batch;
+static struct mpu6050_acq_stats acq_stats;
+
+/** TRUE while the task is not sampling. Changes together with the read of acq_i2c, in a critical section */
+static volatile uint8_t acq_parked;
+/** Task waiting in mpu6050_acq_stop() for the task to park */
+static TaskHandle_t acq_stopper;
+
+/** Correction applied to samples before they are published */
+static struct mpu6050_cal acq_cal;
+static volatile uint8_t acq_cal_enabled;
+
+/** Time of the last data ready interrupt */
+static volatile uint32_t irq_ticks;
+static volatile uint32_t irq_cycles;
+static volatile uint32_t irq_count;
+static volatile uint8_t irq_seen;
+
+/** Cycle counter state used to extend it to 64 bits */
+static uint32_t cycles_per_us;
+static uint32_t last_cycles;
+static uint64_t total_cycles;
+
+/** FIFO mode: time of the next sample the MPU6050 clocks in, and TRUE while the FIFO holds more than a batch */
+static uint32_t fifo_next_us;
+static uint8_t fifo_backlog;
+
+static struct mpu6050_sample ring[MPU6050_ACQ_RING_LENGTH];
+/** Number of samples published. The next sample goes to ring[ring_head & RING_MASK] */
+static uint32_t ring_head;
+
+static struct mpu6050_acq_reader *readers[MPU6050_ACQ_MAX_READERS];
+
+/**
+ * @brief Aligns the µs clock with the tick count. Called whenever sampling (re)starts, as the cycle counter may
+ * have wrapped meanwhile
+ *
+ * @param cpu CPU object or NULL
+ */
+static void clock_resync(const struct cpu * const cpu)
+{
+    if (cpu == NULL || cpu_get_cycle_counter(cpu, &last_cycles) != E_SUCCESS) return;
+    total_cycles = (uint64_t)xTaskGetTickCount() * US_PER_TICK * cycles_per_us;
+}
+
+/**
+ * @brief Gets the time in µs, from the cycle counter if there is one
+ *
+ * @param cpu CPU object or NULL
+ * @return uint32_t Time in µs
+ */
+static uint32_t clock_now_us(const struct cpu * const cpu)
+{
+    uint32_t cycles;
+
+    if (cpu == NULL || cpu_get_cycle_counter(cpu, &cycles) != E_SUCCESS) {
+        return xTaskGetTickCount() * US_PER_TICK;
+    }
+
+    total_cycles += cycles - last_cycles;
+    last_cycles = cycles;
+    return (uint32_t)(total_cycles / cycles_per_us);
+}
+
+/**
+ * @brief Converts a cycle counter value taken shortly before or after the last clock_now_us() to µs
+ *
+ * @param cycles Cycle counter value
+ * @return uint32_t Time in µs
+ */
+static uint32_t clock_at_us(uint32_t cycles)
+{
+    return (uint32_t)((total_cycles + (int32_t)(cycles - last_cycles)) / cycles_per_us);
+}
+
+static void notify_readers(void)
+{
+    taskENTER_CRITICAL();
+    for (int i = 0; i < MPU6050_ACQ_MAX_READERS; i++) {
+        if (readers[i] != NULL) xTaskNotifyGive(readers[i]->task);
+    }
+    taskEXIT_CRITICAL();
+}
+
+/**
+ * @brief Takes a copy of the correction, so it does not change half way through a sample or a batch
+ *
+ * @param cal [out] Correction
+ * @return uint8_t TRUE if samples must be corrected
+ */
+static uint8_t get_calibration(struct mpu6050_cal * const cal)
+{
+    if (!acq_cal_enabled) return FALSE;
+
+    taskENTER_CRITICAL();
+    *cal = acq_cal;
+    const uint8_t enabled = acq_cal_enabled;
+    taskEXIT_CRITICAL();
+
+    return enabled;
+}
+
+/**
+ * @brief Makes the sample at the head of the ring visible to the readers
+ */
+static void publish(void)
+{
+    // Readers see the new head only after the sample is complete
+    __atomic_store_n(&ring_head, ring_head + 1, __ATOMIC_RELEASE);
+    acq_stats.samples++;
+}
+
+/**
+ * @brief Reads a sample straight into the ring and publishes it
+ *
+ * @param i2c I2C object
+ * @param cpu CPU object or NULL
+ * @param sequence Period number
+ */
+static void acquire(const struct i2c_device * const i2c, const struct cpu * const cpu, uint32_t sequence)
+{
+    static uint32_t previous_us;
+    struct mpu6050_sample *sample = &ring[ring_head & RING_MASK];
+    struct mpu6050_cal cal;
+    const uint32_t timestamp_us = clock_now_us(cpu);
+
+    if (mpu6050_read_motion(i2c, &sample->accel, &sample->gyro) != E_SUCCESS) {
+        acq_stats.errors++;
+        return;
+    }
+    if (get_calibration(&cal)) mpu6050_cal_apply(&cal, &sample->accel, &sample->gyro);
+    sample->timestamp_us = timestamp_us;
+    sample->sequence = sequence;
+
+    if (acq_stats.samples > 0) {
+        const int32_t interval_us = timestamp_us - previous_us;
+        const int32_t period_us = acq_period * US_PER_TICK;
+        const uint32_t jitter_us = interval_us > period_us ? interval_us - period_us : period_us - interval_us;
+        // Intervals spanning missed periods are not jitter
+        if (interval_us < 2 * period_us && jitter_us > acq_stats.max_jitter_us) acq_stats.max_jitter_us = jitter_us;
+    }
+    previous_us = timestamp_us;
+
+    publish();
+    notify_readers();
+}
+
+/**
+ * @brief Waits for a batch of samples in the MPU6050 FIFO, reads all of them in one burst and publishes them
+ *
+ * @param i2c I2C object
+ * @param cpu CPU object or NULL
+ * @param sequence Number of the last sample published
+ * @return uint32_t Number of the last sample published
+ */
+static uint32_t acquire_fifo(const struct i2c_device * const i2c, const struct cpu * const cpu, uint32_t sequence)
+{
+    static struct mpu6050_motion motion[MPU6050_ACQ_FIFO_BATCH_MAX];
+    struct mpu6050_cal cal;
+    const TickType_t period = acq_period;
+    const uint32_t period_us = period * US_PER_TICK;
+    uint32_t newest_us, seen;
+
+    // Without the INT pin routed to mpu6050_acq_irq_handler() the task still wakes once a batch is due
+    if (!fifo_backlog) ulTaskNotifyTake(pdTRUE, (acq_batch + 1) * period);
+    acq_stats.wakeups++;
+
+    int32_t count = mpu6050_fifo_read(i2c, motion, ARRAY_SIZE(motion));
+    if (count == E_RX_OVERRUN) {
+        // The FIFO held MPU6050_FIFO_SAMPLES samples at least: leave a gap that large in the sequence
+        acq_stats.overflows++;
+        fifo_backlog = FALSE;
+        return sequence + MPU6050_FIFO_SAMPLES;
+    }
+    if (count < 0) {
+        acq_stats.errors++;
+        return sequence;
+    }
+    fifo_backlog = (count == ARRAY_SIZE(motion));
+    if (get_calibration(&cal)) mpu6050_cal_apply_batch(&cal, motion, count);
+
+    // Brings the cycle count up to date so the interrupt stamp converts without wrapping
+    if (cpu != NULL) clock_now_us(cpu);
+
+    taskENTER_CRITICAL();
+    seen = irq_seen;
+    irq_seen = FALSE;
+    newest_us = cpu != NULL ? clock_at_us(irq_cycles) : irq_ticks * US_PER_TICK;
+    taskEXIT_CRITICAL();
+
+    // The interrupt stamps the newest sample only when the FIFO was drained. Otherwise samples are spaced by the
+    // period from the last one published, as the MPU6050 clocks them
+    if (!seen || fifo_backlog) newest_us = fifo_next_us + (count - 1) * period_us;
+
+    for (int32_t i = 0; i < count; i++) {
+        struct mpu6050_sample *sample = &ring[ring_head & RING_MASK];
+        sample->accel = motion[i].accel;
+        sample->gyro = motion[i].gyro;
+        sample->timestamp_us = newest_us - (count - 1 - i) * period_us;
+        sample->sequence = ++sequence;
+        publish();
+    }
+    fifo_next_us = newest_us + period_us;
+
+    if (count > 0) notify_readers();
+    return sequence;
+}
+
+static void acq_task(void *arg)
+{
+    (void)arg;
+    TickType_t last_wake = 0;
+    uint32_t sequence = 0;
+
+    while (1) {
+        TaskHandle_t stopper = NULL;
+
+        taskENTER_CRITICAL();
+        const struct i2c_device *i2c = acq_i2c;
+        const struct cpu *cpu = acq_cpu;
+        acq_parked = i2c == NULL;
+        if (acq_parked) {
+            stopper = acq_stopper;
+            acq_stopper = NULL;
+        }
+        taskEXIT_CRITICAL();
+
+        if (i2c == NULL) {
+            // Done with the MPU6050: mpu6050_acq_stop() may return
+            if (stopper != NULL) xTaskNotifyGive(stopper);
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            clock_resync(acq_cpu);
+            last_wake = xTaskGetTickCount();
+            continue;
+        }
+
+        if (acq_batch > 0) {
+            sequence = acquire_fifo(i2c, cpu, sequence);
+            continue;
+        }
+
+        const TickType_t period = acq_period;
+        vTaskDelayUntil(&last_wake, period);
+        sequence++;
+
+        // Late by one period or more: skip the missed periods instead of sampling them in a burst
+        const TickType_t late = xTaskGetTickCount() - last_wake;
+        if (late >= period) {
+            acq_stats.missed += late / period;
+            sequence += late / period;
+            last_wake += (late / period) * period;
+        }
+
+        acquire(i2c, cpu, sequence);
+    }
+}
+
+/**
+ * @brief Configures the MPU6050 and (re)starts the task
+ *
+ * @param i2c I2C object
+ * @param cpu CPU object or NULL
+ * @param rate_hz Sample rate in Hz
+ * @param batch Samples read from the FIFO at each wake up. 0 to read the sensor registers once per period
+ * @return int32_t Negative value on error
+ */
+static int32_t start(const struct i2c_device * const i2c, const struct cpu * const cpu, uint32_t rate_hz,
+    uint32_t batch)
+{
+    int32_t ret;
+    uint32_t clock_hz, cycles;
+
+    if (i2c == NULL || rate_hz == 0 || rate_hz > MPU6050_ACQ_MAX_RATE_HZ || configTICK_RATE_HZ % rate_hz != 0) {
+        ret = E_INVALID_PARAMETER;
+        goto exit;
+    }
+
+    mpu6050_acq_stop();
+
+    ret = mpu6050_set_sample_rate(i2c, rate_hz);
+    if (ret < 0) { goto exit; }
+    ret = mpu6050_fifo_enable(i2c, batch > 0);
+    if (ret < 0) { goto exit; }
+    ret = mpu6050_data_ready_irq_enable(i2c, batch > 0);
+    if (ret < 0) { goto exit; }
+
+    acq_cpu = NULL;
+    if (cpu != NULL && cpu_get_clock_in_hz(cpu, &clock_hz) == E_SUCCESS && clock_hz >= 1000000 &&
+        cpu_get_cycle_counter(cpu, &cycles) == E_SUCCESS) {
+        cycles_per_us = clock_hz / 1000000;
+        clock_resync(cpu);
+        acq_cpu = cpu;
+    } else {
+        WARN(TAG, "No cycle counter. Samples are stamped with the tick count");
+    }
+
+    acq_period = configTICK_RATE_HZ / rate_hz;
+    acq_batch = batch;
+    // The FIFO restarts empty: its first sample comes one period from now
+    fifo_next_us = clock_now_us(acq_cpu) + acq_period * US_PER_TICK;
+    fifo_backlog = FALSE;
+    irq_count = 0;
+    irq_seen = FALSE;
+    acq_stats.samples = 0;
+    acq_stats.errors = 0;
+    acq_stats.missed = 0;
+    acq_stats.max_jitter_us = 0;
+    acq_stats.overflows = 0;
+    acq_stats.wakeups = 0;
+    acq_i2c = i2c;
+
+    if (acq_task_handle == NULL) {
+        acq_task_handle = xTaskCreateStatic(acq_task, TAG, ACQ_TASK_SIZE, NULL, ACQ_TASK_PRIORITY, acq_stack,
+            &acq_tcb);
+    }
+    xTaskNotifyGive(acq_task_handle);
+
+    exit:
+    return ret;
+}
+
+int32_t mpu6050_acq_start(const struct i2c_device * const i2c, const struct cpu * const cpu, uint32_t rate_hz)
+{
+    return start(i2c, cpu, rate_hz, 0);
+}
+
+int32_t mpu6050_acq_start_fifo(const struct i2c_device * const i2c, const struct cpu * const cpu, uint32_t rate_hz,
+    uint32_t batch)
+{
+    if (batch == 0 || batch > MPU6050_ACQ_FIFO_BATCH_MAX) return E_INVALID_PARAMETER;
+    return start(i2c, cpu, rate_hz, batch);
+}
+
+void mpu6050_acq_stop(void)
+{
+    taskENTER_CRITICAL();
+    acq_i2c = NULL;
+    const uint8_t running = acq_task_handle != NULL && !acq_parked;
+    if (running) acq_stopper = xTaskGetCurrentTaskHandle();
+    taskEXIT_CRITICAL();
+
+    if (!running) return;
+
+    // Cuts a FIFO wait short, then waits for the sample or batch in progress. Other notifications of the calling
+    // task (e.g. of a reader) only make it check again
+    xTaskNotifyGive(acq_task_handle);
+    while (!acq_parked) ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+}
+
+void mpu6050_acq_irq_handler(void)
+{
+    BaseType_t higher_priority_task_woken = pdFALSE;
+    const struct cpu *cpu = acq_cpu;
+
+    if (acq_task_handle == NULL || acq_batch == 0) return;
+
+    irq_ticks = xTaskGetTickCountFromISR();
+    if (cpu != NULL) cpu_get_cycle_counter(cpu, (uint32_t *)&irq_cycles);
+    irq_seen = TRUE;
+
+    // The MPU6050 has no FIFO watermark interrupt: data ready pulses are counted and the task woken once a batch
+    if (++irq_count >= acq_batch) {
+        irq_count = 0;
+        vTaskNotifyGiveFromISR(acq_task_handle, &higher_priority_task_woken);
+    }
+    portYIELD_FROM_ISR(higher_priority_task_woken);
+}
+
+int32_t mpu6050_acq_attach(struct mpu6050_acq_reader * const reader)
+{
+    int32_t ret = E_INVALID_PARAMETER;
+
+    reader->cursor = __atomic_load_n(&ring_head, __ATOMIC_ACQUIRE);
+    reader->overruns = 0;
+    reader->task = xTaskGetCurrentTaskHandle();
+
+    taskENTER_CRITICAL();
+    for (int i = 0; i < MPU6050_ACQ_MAX_READERS; i++) {
+        if (readers[i] == NULL) {
+            readers[i] = reader;
+            ret = E_SUCCESS;
+            break;
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    return ret;
+}
+
+void mpu6050_acq_detach(struct mpu6050_acq_reader * const reader)
+{
+    taskENTER_CRITICAL();
+    for (int i = 0; i < MPU6050_ACQ_MAX_READERS; i++) {
+        if (readers[i] == reader) readers[i] = NULL;
+    }
+    taskEXIT_CRITICAL();
+}
+
+const struct mpu6050_sample *mpu6050_acq_peek(struct mpu6050_acq_reader * const reader, uint32_t timeout)
+{
+    const TickType_t start = xTaskGetTickCount();
+    uint32_t head = __atomic_load_n(&ring_head, __ATOMIC_ACQUIRE);
+
+    while (head == reader->cursor) {
+        const TickType_t elapsed = xTaskGetTickCount() - start;
+        if (elapsed >= timeout) return NULL;
+        // Notifications of samples already read may be pending: check the head again after every wake up
+        ulTaskNotifyTake(pdTRUE, timeout - elapsed);
+        head = __atomic_load_n(&ring_head, __ATOMIC_ACQUIRE);
+    }
+
+    // The slot of sample head - MPU6050_ACQ_RING_LENGTH is the one being written next
+    if (head - reader->cursor >= MPU6050_ACQ_RING_LENGTH) {
+        const uint32_t oldest = head - MPU6050_ACQ_RING_LENGTH + 1;
+        reader->overruns += oldest - reader->cursor;
+        reader->cursor = oldest;
+    }
+
+    return &ring[reader->cursor & RING_MASK];
+}
+
+int32_t mpu6050_acq_release(struct mpu6050_acq_reader * const reader)
+{
+    // Reads of the sample must complete before the head is checked
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    const uint32_t head = __atomic_load_n(&ring_head, __ATOMIC_ACQUIRE);
+    const int32_t ret = head - reader->cursor >= MPU6050_ACQ_RING_LENGTH ? E_RX_OVERRUN : E_SUCCESS;
+
+    if (ret == E_RX_OVERRUN) reader->overruns++;
+    reader->cursor++;
+
+    return ret;
+}
+
+void mpu6050_acq_set_calibration(const struct mpu6050_cal * const cal)
+{
+    taskENTER_CRITICAL();
+    if (cal != NULL) acq_cal = *cal;
+    acq_cal_enabled = cal != NULL;
+    taskEXIT_CRITICAL();
+}
+
+void mpu6050_acq_get_stats(struct mpu6050_acq_stats * const stats)
+{
+    *stats = acq_stats;
+}
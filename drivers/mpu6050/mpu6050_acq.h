@@ -0,0 +1,167 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#ifndef DRIVERS_MPU6050_MPU6050_ACQ_H_
+#define DRIVERS_MPU6050_MPU6050_ACQ_H_
+
+#include "drivers/mpu6050/mpu6050_driver.h"
+#include "drivers/mpu6050/mpu6050_cal.h"
+
+#include "include/device/cpu.h"
+#include "include/device/i2c.h"
+
+#include <stdint.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+/**
+ * @brief Fixed rate MPU6050 acquisition service.
+ *
+ * A task woken by vTaskDelayUntil() reads accelerometer and gyroscope in a single burst at every period and
+ * publishes the sample in a ring. The ring has a single producer and any number of readers, each with a cursor of
+ * its own: a reader gets a pointer to the sample inside the ring and nothing is copied. The producer never waits for
+ * the readers. A reader that falls more than a ring behind skips the samples that were overwritten.
+ *
+ *     struct mpu6050_acq_reader reader;
+ *     mpu6050_acq_attach(&reader);
+ *     while (1) {
+ *         const struct mpu6050_sample *sample = mpu6050_acq_peek(&reader, portMAX_DELAY);
+ *         if (sample == NULL) continue;
+ *         ... use sample ...
+ *         if (mpu6050_acq_release(&reader) == E_RX_OVERRUN) ... sample was overwritten while in use ...
+ *     }
+ *
+ * Readers are woken with direct to task notifications, so a reader task must not wait for other notifications.
+ *
+ * In FIFO mode the MPU6050 paces sampling and fills its FIFO. The platform routes the INT pin to
+ * mpu6050_acq_irq_handler(), which counts data ready pulses and wakes the task once per batch. The task reads every
+ * sample in the FIFO in a single I2C burst, so I2C transactions and task wake ups drop by the batch size. The newest
+ * sample is stamped with the time of its interrupt and the others backwards from it with the sample period. If the
+ * INT pin is not routed the task wakes once a batch is due. A FIFO overflow leaves a gap in the sequence numbers.
+ */
+
+/** Number of samples in the ring. Must be a power of 2 */
+#define MPU6050_ACQ_RING_LENGTH 64
+
+/** Number of readers that may be attached at the same time */
+#define MPU6050_ACQ_MAX_READERS 4
+
+/** Highest sample rate */
+#define MPU6050_ACQ_MAX_RATE_HZ configTICK_RATE_HZ
+
+/** Most samples read from the FIFO in a single burst */
+#define MPU6050_ACQ_FIFO_BATCH_MAX 32
+
+/** Sample published by the acquisition service */
+struct mpu6050_sample {
+    uint32_t timestamp_us;      /** Time of the read in µs. Wraps around every 2^32 µs */
+    uint32_t sequence;          /** Period number. Gaps tell which periods were missed */
+    struct mpu6050_axis accel;  /** Accelerometer values */
+    struct mpu6050_axis gyro;   /** Gyroscope values */
+};
+
+/** Reader of the sample ring */
+struct mpu6050_acq_reader {
+    uint32_t cursor;            /** Number of the next sample to read */
+    uint32_t overruns;          /** Samples overwritten before this reader got them */
+    TaskHandle_t task;          /** Task notified when a sample is published */
+};
+
+/** Acquisition statistics */
+struct mpu6050_acq_stats {
+    uint32_t samples;           /** Samples published */
+    uint32_t errors;            /** Failed reads */
+    uint32_t missed;            /** Periods skipped because the task ran late. Not in FIFO mode */
+    uint32_t max_jitter_us;     /** Largest deviation of the sample interval from the period. Not in FIFO mode */
+    uint32_t overflows;         /** FIFO overflows */
+    uint32_t wakeups;           /** Times the FIFO was read */
+};
+
+/**
+ * @brief Configures the MPU6050 sample rate and starts sampling. Calling it again changes the rate
+ *
+ * @param i2c I2C object of an initialized MPU6050
+ * @param cpu CPU object whose cycle counter stamps the samples. NULL stamps them with the tick count
+ * @param rate_hz Sample rate in Hz. Must divide configTICK_RATE_HZ and the MPU6050 internal rate (1kHz)
+ * @return int32_t Negative value on error
+ */
+extern int32_t mpu6050_acq_start(const struct i2c_device * const i2c, const struct cpu * const cpu, uint32_t rate_hz);
+
+/**
+ * @brief Configures the MPU6050 sample rate and starts sampling through its FIFO. Calling it again changes the rate
+ *
+ * @param i2c I2C object of an initialized MPU6050
+ * @param cpu CPU object whose cycle counter stamps the samples. NULL stamps them with the tick count
+ * @param rate_hz Sample rate in Hz. Must divide configTICK_RATE_HZ and the MPU6050 internal rate (1kHz)
+ * @param batch Samples read at each wake up. Up to MPU6050_ACQ_FIFO_BATCH_MAX
+ * @return int32_t Negative value on error
+ */
+extern int32_t mpu6050_acq_start_fifo(const struct i2c_device * const i2c, const struct cpu * const cpu,
+    uint32_t rate_hz, uint32_t batch);
+
+/**
+ * @brief Must be called from the ISR of the MPU6050 INT pin (rising edge)
+ */
+extern void mpu6050_acq_irq_handler(void);
+
+/**
+ * @brief Stops sampling and waits for the task to finish the sample or batch in progress, so the MPU6050 is free
+ * once it returns. Samples in the ring are kept. Must be called from a task
+ */
+extern void mpu6050_acq_stop(void);
+
+/**
+ * @brief Attaches a reader to the ring. It gets the samples published from now on. Must be called by the task
+ * that reads
+ *
+ * @param reader Reader object. Must live until mpu6050_acq_detach()
+ * @return int32_t E_SUCCESS on success. E_INVALID_PARAMETER if there are MPU6050_ACQ_MAX_READERS readers already
+ */
+extern int32_t mpu6050_acq_attach(struct mpu6050_acq_reader * const reader);
+
+/**
+ * @brief Detaches a reader from the ring
+ *
+ * @param reader Reader object
+ */
+extern void mpu6050_acq_detach(struct mpu6050_acq_reader * const reader);
+
+/**
+ * @brief Gets the next sample of a reader, waiting for it to be published if needed
+ *
+ * @param reader Reader object
+ * @param timeout Time to wait in ticks
+ * @return const struct mpu6050_sample* Sample inside the ring or NULL on timeout. Valid until mpu6050_acq_release()
+ */
+extern const struct mpu6050_sample *mpu6050_acq_peek(struct mpu6050_acq_reader * const reader, uint32_t timeout);
+
+/**
+ * @brief Releases the sample returned by mpu6050_acq_peek() and moves to the next one
+ *
+ * @param reader Reader object
+ * @return int32_t E_SUCCESS on success. E_RX_OVERRUN if the producer overwrote the sample while it was in use
+ */
+extern int32_t mpu6050_acq_release(struct mpu6050_acq_reader * const reader);
+
+/**
+ * @brief Sets the correction applied to samples before they are published. A batch read from the FIFO is corrected
+ * at once
+ *
+ * @param cal Calibration, copied. NULL publishes raw samples
+ */
+extern void mpu6050_acq_set_calibration(const struct mpu6050_cal * const cal);
+
+/**
+ * @brief Gets acquisition statistics
+ *
+ * @param stats [out] Statistics
+ */
+extern void mpu6050_acq_get_stats(struct mpu6050_acq_stats * const stats);
+
+#endif // DRIVERS_MPU6050_MPU6050_ACQ_H_
@@ -0,0 +1,274 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#include "drivers/mpu6050/mpu6050_cal.h"
+#include "drivers/mpu6050/mpu6050_acq.h"
+#include "drivers/mpu6050/mpu6050_driver.h"
+
+#include "libs/crc16/crc16.h"
+#include "libs/ffresult/ffresult.h"
+
+#include "include/errors.h"
+
+#include "ulibc/include/utils.h"
+
+#include "components/fatfs/source/ff.h"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+/** "M6CL" */
+#define CAL_FILE_MAGIC 0x4c43364d
+
+/** Calibration file */
+struct cal_file {
+    uint32_t magic;
+    struct mpu6050_cal cal;
+    uint16_t crc;               /** CRC16-CCITT of the fields above */
+};
+
+/**
+ * @brief Saturates a value to 16 bits
+ */
+static inline int16_t saturate16(int32_t value)
+{
+    if (value > INT16_MAX) return INT16_MAX;
+    if (value < INT16_MIN) return INT16_MIN;
+    return value;
+}
+
+/**
+ * @brief Rounds a Q16 mean to the nearest integer
+ */
+static inline int32_t round_q16(int64_t value)
+{
+    return (int32_t)((value + (1 << 15)) >> 16);
+}
+
+/**
+ * @brief Tells whether the standard deviation of the given axes stays within a limit
+ *
+ * @param capture Capture
+ * @param first First axis
+ * @param stddev Standard deviation limit in raw units
+ * @return uint8_t TRUE when the three axes from first are within the limit
+ */
+static uint8_t is_still(const struct mpu6050_cal_capture * const capture, uint32_t first, int64_t stddev)
+{
+    if (capture->count < 2) return FALSE;
+
+    // Compared as m2 > stddev^2 * (n - 1) so no division is needed
+    const int64_t limit = ((stddev * stddev) << 16) * (capture->count - 1);
+    for (uint32_t i = first; i < first + 3; i++) {
+        if (capture->m2[i] > limit) return FALSE;
+    }
+
+    return TRUE;
+}
+
+/**
+ * @brief Corrects a sample
+ */
+static inline void correct(const struct mpu6050_cal * const cal, struct mpu6050_axis * const accel,
+    struct mpu6050_axis * const gyro)
+{
+    gyro->x_axis = saturate16(gyro->x_axis - cal->gyro_bias.x_axis);
+    gyro->y_axis = saturate16(gyro->y_axis - cal->gyro_bias.y_axis);
+    gyro->z_axis = saturate16(gyro->z_axis - cal->gyro_bias.z_axis);
+    // Both factors fit 16 bits, so the product fits 32
+    accel->x_axis = saturate16(((accel->x_axis - cal->accel_offset.x_axis) * cal->accel_gain[0] + (1 << 13)) >> 14);
+    accel->y_axis = saturate16(((accel->y_axis - cal->accel_offset.y_axis) * cal->accel_gain[1] + (1 << 13)) >> 14);
+    accel->z_axis = saturate16(((accel->z_axis - cal->accel_offset.z_axis) * cal->accel_gain[2] + (1 << 13)) >> 14);
+}
+
+void mpu6050_cal_init(struct mpu6050_cal * const cal)
+{
+    cal->gyro_bias = (struct mpu6050_axis){0, 0, 0};
+    cal->accel_offset = (struct mpu6050_axis){0, 0, 0};
+    for (int i = 0; i < 3; i++) cal->accel_gain[i] = MPU6050_CAL_GAIN_ONE;
+}
+
+void mpu6050_cal_capture_reset(struct mpu6050_cal_capture * const capture)
+{
+    capture->count = 0;
+    for (int i = 0; i < 6; i++) {
+        capture->mean[i] = 0;
+        capture->m2[i] = 0;
+    }
+}
+
+void mpu6050_cal_capture_add(struct mpu6050_cal_capture * const capture, const struct mpu6050_axis * const accel,
+    const struct mpu6050_axis * const gyro)
+{
+    const int16_t values[6] = {
+        accel->x_axis, accel->y_axis, accel->z_axis,
+        gyro->x_axis, gyro->y_axis, gyro->z_axis
+    };
+
+    capture->count++;
+    for (int i = 0; i < 6; i++) {
+        const int64_t x = (int64_t)values[i] << 16;
+        const int64_t delta = x - capture->mean[i];
+        capture->mean[i] += delta / (int64_t)capture->count;
+        // Both differences are taken to Q8 so their product stays in Q16 without overflowing
+        capture->m2[i] += (delta >> 8) * ((x - capture->mean[i]) >> 8);
+    }
+}
+
+int32_t mpu6050_cal_capture(struct mpu6050_cal_capture * const capture, uint32_t samples, uint32_t timeout)
+{
+    int32_t ret;
+    struct mpu6050_acq_reader reader;
+
+    mpu6050_cal_capture_reset(capture);
+    ret = mpu6050_acq_attach(&reader);
+    if (ret < 0) { goto exit; }
+
+    while (capture->count < samples) {
+        const struct mpu6050_sample *sample = mpu6050_acq_peek(&reader, timeout);
+        if (sample == NULL) {
+            ret = E_TIMEOUT;
+            goto detach;
+        }
+        mpu6050_cal_capture_add(capture, &sample->accel, &sample->gyro);
+        mpu6050_acq_release(&reader);
+    }
+    ret = E_SUCCESS;
+
+    detach:
+    mpu6050_acq_detach(&reader);
+
+    exit:
+    return ret;
+}
+
+int32_t mpu6050_cal_gyro_bias(const struct mpu6050_cal_capture * const capture, struct mpu6050_cal * const cal)
+{
+    if (!is_still(capture, 3, MPU6050_CAL_GYRO_STILL_STDDEV)) return E_SENSOR_MOVED;
+
+    cal->gyro_bias.x_axis = round_q16(capture->mean[3]);
+    cal->gyro_bias.y_axis = round_q16(capture->mean[4]);
+    cal->gyro_bias.z_axis = round_q16(capture->mean[5]);
+
+    return E_SUCCESS;
+}
+
+int32_t mpu6050_cal_six_add(struct mpu6050_cal_six * const six, const struct mpu6050_cal_capture * const capture)
+{
+    uint32_t axis = 0;
+    int32_t mean[3];
+
+    if (!is_still(capture, 0, MPU6050_CAL_ACCEL_STILL_STDDEV)) return E_SENSOR_MOVED;
+
+    for (uint32_t i = 0; i < 3; i++) {
+        mean[i] = round_q16(capture->mean[i]);
+        if (abs(mean[i]) > abs(mean[axis])) axis = i;
+    }
+
+    // The other axes must be under a quarter of the vertical one: tilted 14 degrees at most
+    for (uint32_t i = 0; i < 3; i++) {
+        if (i != axis && 4 * abs(mean[i]) > abs(mean[axis])) return E_INVALID_PARAMETER;
+    }
+
+    if (mean[axis] > 0) {
+        six->up[axis] = mean[axis];
+        six->done |= 1 << (2 * axis);
+        return 2 * axis;
+    } else {
+        six->down[axis] = mean[axis];
+        six->done |= 1 << (2 * axis + 1);
+        return 2 * axis + 1;
+    }
+}
+
+int32_t mpu6050_cal_six_finish(const struct mpu6050_cal_six * const six, struct mpu6050_cal * const cal)
+{
+    int16_t offset[3], gain[3];
+
+    if (six->done != 0x3f) return E_INVALID_PARAMETER;
+
+    for (int i = 0; i < 3; i++) {
+        const int32_t span = six->up[i] - six->down[i];
+        // Gains from 0.5 to just under 2.0 keep the correction within 32 bits
+        if (span <= MPU6050_CAL_ACCEL_1G || span > 4 * MPU6050_CAL_ACCEL_1G) return E_INVALID_PARAMETER;
+        offset[i] = (six->up[i] + six->down[i]) / 2;
+        gain[i] = ((2 * MPU6050_CAL_ACCEL_1G << 14) + span / 2) / span;
+    }
+
+    cal->accel_offset.x_axis = offset[0];
+    cal->accel_offset.y_axis = offset[1];
+    cal->accel_offset.z_axis = offset[2];
+    for (int i = 0; i < 3; i++) cal->accel_gain[i] = gain[i];
+
+    return E_SUCCESS;
+}
+
+void mpu6050_cal_apply(const struct mpu6050_cal * const cal, struct mpu6050_axis * const accel,
+    struct mpu6050_axis * const gyro)
+{
+    correct(cal, accel, gyro);
+}
+
+void mpu6050_cal_apply_batch(const struct mpu6050_cal * const cal, struct mpu6050_motion * const samples,
+    uint32_t count)
+{
+    // Calibration values stay in registers for the whole batch
+    const struct mpu6050_cal local = *cal;
+
+    for (uint32_t i = 0; i < count; i++) correct(&local, &samples[i].accel, &samples[i].gyro);
+}
+
+#ifdef FATFS_WRITE
+int32_t mpu6050_cal_save(const char *path, const struct mpu6050_cal * const cal)
+{
+    int32_t ret;
+    FIL file;
+    UINT bw;
+    struct cal_file record = {.magic = CAL_FILE_MAGIC, .cal = *cal};
+
+    record.crc = calc_crc16ccitt(&record, offsetof(struct cal_file, crc));
+
+    ret = ffresult_to_error(f_open(&file, path, FA_WRITE | FA_CREATE_ALWAYS));
+    if (ret < 0) { goto exit; }
+
+    ret = ffresult_to_error(f_write(&file, &record, sizeof(record), &bw));
+    if (ret == E_SUCCESS && bw != sizeof(record)) ret = E_NO_SPACE;
+    // The file must be closed even after a failed write, but that error is the one reported
+    const int32_t close_ret = ffresult_to_error(f_close(&file));
+    if (ret == E_SUCCESS) ret = close_ret;
+
+    exit:
+    return ret;
+}
+#endif // FATFS_WRITE
+
+int32_t mpu6050_cal_load(const char *path, struct mpu6050_cal * const cal)
+{
+    int32_t ret;
+    FIL file;
+    UINT br;
+    struct cal_file record;
+
+    ret = ffresult_to_error(f_open(&file, path, FA_READ));
+    if (ret < 0) { goto exit; }
+
+    ret = ffresult_to_error(f_read(&file, &record, sizeof(record), &br));
+    f_close(&file);
+    if (ret < 0) { goto exit; }
+
+    if (br != sizeof(record) || record.magic != CAL_FILE_MAGIC ||
+        record.crc != calc_crc16ccitt(&record, offsetof(struct cal_file, crc))) {
+        ret = E_INVALID_CRC;
+        goto exit;
+    }
+    *cal = record.cal;
+
+    exit:
+    return ret;
+}
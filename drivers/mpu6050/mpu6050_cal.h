@@ -0,0 +1,167 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#ifndef DRIVERS_MPU6050_MPU6050_CAL_H_
+#define DRIVERS_MPU6050_MPU6050_CAL_H_
+
+#include "drivers/mpu6050/mpu6050_driver.h"
+
+#include <stdint.h>
+
+/**
+ * @brief MPU6050 calibration.
+ *
+ * Captures gather the mean and variance of every axis in a single pass (Welford's algorithm) in 64 bits fixed point,
+ * so no sample is stored. A stationary capture gives the gyroscope bias. Six stationary captures, one with each axis
+ * pointing up and one with it pointing down, give the offset and the gain of every accelerometer axis. Captures
+ * taken while the sensor moves are rejected with E_SENSOR_MOVED.
+ *
+ * Corrections are integer only and are applied by the acquisition service (mpu6050_acq_set_calibration()) before
+ * samples are published, once per batch read from the FIFO, so readers get corrected samples. Captures must be taken
+ * with the correction disabled. A calibration is persisted as a small file protected by a CRC16.
+ *
+ * Values assume the ranges set by mpu6050_init(): +-2g for the accelerometer and +-2000 degrees/s for the gyroscope.
+ */
+
+/** Accelerometer raw value of 1g */
+#define MPU6050_CAL_ACCEL_1G 16384
+
+/** 1.0 as an accelerometer gain (Q14) */
+#define MPU6050_CAL_GAIN_ONE (1 << 14)
+
+/** Highest standard deviation of a stationary gyroscope axis in raw units (about 1.2 degrees/s) */
+#define MPU6050_CAL_GYRO_STILL_STDDEV 20
+
+/** Highest standard deviation of a stationary accelerometer axis in raw units (about 25mg) */
+#define MPU6050_CAL_ACCEL_STILL_STDDEV 400
+
+/** Corrections applied to raw samples */
+struct mpu6050_cal {
+    struct mpu6050_axis gyro_bias;      /** Subtracted from the gyroscope */
+    struct mpu6050_axis accel_offset;   /** Subtracted from the accelerometer */
+    int16_t accel_gain[3];              /** Multiplies the accelerometer after the offset, Q14 */
+};
+
+/** Streaming statistics of a capture. Axes are accelerometer x, y, z then gyroscope x, y, z */
+struct mpu6050_cal_capture {
+    uint32_t count;             /** Samples captured */
+    int64_t mean[6];            /** Mean, Q16 */
+    int64_t m2[6];              /** Sum of squared differences from the mean, Q16 */
+};
+
+/** Accelerometer means of the six positions */
+struct mpu6050_cal_six {
+    int32_t up[3];              /** Mean of each axis pointing up */
+    int32_t down[3];            /** Mean of each axis pointing down */
+    uint8_t done;               /** Bit 2 * axis set when the axis was captured up, bit 2 * axis + 1 down */
+};
+
+/**
+ * @brief Initializes a calibration that changes nothing
+ *
+ * @param cal Calibration
+ */
+extern void mpu6050_cal_init(struct mpu6050_cal * const cal);
+
+/**
+ * @brief Empties a capture
+ *
+ * @param capture Capture
+ */
+extern void mpu6050_cal_capture_reset(struct mpu6050_cal_capture * const capture);
+
+/**
+ * @brief Adds a sample to a capture
+ *
+ * @param capture Capture
+ * @param accel Raw accelerometer values
+ * @param gyro Raw gyroscope values
+ */
+extern void mpu6050_cal_capture_add(struct mpu6050_cal_capture * const capture, const struct mpu6050_axis * const accel,
+    const struct mpu6050_axis * const gyro);
+
+/**
+ * @brief Captures samples published by the acquisition service, which must be running without correction
+ *
+ * @param capture Capture. Emptied first
+ * @param samples Number of samples
+ * @param timeout Time to wait for each sample in ticks
+ * @return int32_t E_SUCCESS on success. E_TIMEOUT if samples stopped arriving
+ */
+extern int32_t mpu6050_cal_capture(struct mpu6050_cal_capture * const capture, uint32_t samples, uint32_t timeout);
+
+/**
+ * @brief Sets the gyroscope bias from a stationary capture
+ *
+ * @param capture Capture
+ * @param cal [out] Calibration. Only the gyroscope bias is changed
+ * @return int32_t E_SUCCESS on success. E_SENSOR_MOVED if the gyroscope was not still
+ */
+extern int32_t mpu6050_cal_gyro_bias(const struct mpu6050_cal_capture * const capture, struct mpu6050_cal * const cal);
+
+/**
+ * @brief Adds a stationary capture to the six positions. The position is the axis closest to vertical
+ *
+ * @param six Six positions. Must be zeroed before the first capture
+ * @param capture Capture
+ * @return int32_t Position captured: 2 * axis when up, 2 * axis + 1 when down. E_SENSOR_MOVED if the accelerometer
+ * was not still. E_INVALID_PARAMETER if no axis was close enough to vertical
+ */
+extern int32_t mpu6050_cal_six_add(struct mpu6050_cal_six * const six,
+    const struct mpu6050_cal_capture * const capture);
+
+/**
+ * @brief Sets the accelerometer offsets and gains from the six positions
+ *
+ * @param six Six positions
+ * @param cal [out] Calibration. Only the accelerometer is changed
+ * @return int32_t E_SUCCESS on success. E_INVALID_PARAMETER if a position is missing or a gain is out of range
+ */
+extern int32_t mpu6050_cal_six_finish(const struct mpu6050_cal_six * const six, struct mpu6050_cal * const cal);
+
+/**
+ * @brief Corrects a sample
+ *
+ * @param cal Calibration
+ * @param accel Accelerometer values, corrected in place
+ * @param gyro Gyroscope values, corrected in place
+ */
+extern void mpu6050_cal_apply(const struct mpu6050_cal * const cal, struct mpu6050_axis * const accel,
+    struct mpu6050_axis * const gyro);
+
+/**
+ * @brief Corrects a batch of samples
+ *
+ * @param cal Calibration
+ * @param samples Samples, corrected in place
+ * @param count Number of samples
+ */
+extern void mpu6050_cal_apply_batch(const struct mpu6050_cal * const cal, struct mpu6050_motion * const samples,
+    uint32_t count);
+
+#ifdef FATFS_WRITE
+/**
+ * @brief Saves a calibration to a file. Only built with FATFS_WRITE
+ *
+ * @param path Path of the file. It is replaced
+ * @param cal Calibration
+ * @return int32_t E_SUCCESS on success. E_NO_SPACE if the volume is full
+ */
+extern int32_t mpu6050_cal_save(const char *path, const struct mpu6050_cal * const cal);
+#endif // FATFS_WRITE
+
+/**
+ * @brief Loads a calibration from a file
+ *
+ * @param path Path of the file
+ * @param cal [out] Calibration. Untouched on error
+ * @return int32_t E_SUCCESS on success. E_INVALID_CRC if the file is corrupted
+ */
+extern int32_t mpu6050_cal_load(const char *path, struct mpu6050_cal * const cal);
+
+#endif // DRIVERS_MPU6050_MPU6050_CAL_H_
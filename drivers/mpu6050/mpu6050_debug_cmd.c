@@ -7,6 +7,9 @@
  */
 
 #include "drivers/mpu6050/mpu6050_driver.h"
+#include "drivers/mpu6050/mpu6050_acq.h"
+#include "drivers/mpu6050/mpu6050_fusion.h"
+#include "drivers/mpu6050/mpu6050_cal.h"
 
 #include "include/device/device.h"
 #include "include/device/i2c.h"
@@ -14,6 +17,7 @@
 
 #include "ulibc/include/ustdio.h"
 #include "ulibc/include/log.h"
+#include "ulibc/include/utils.h"
 
 #include "core/include/errors.h"
 
@@ -27,9 +31,16 @@
 
 #define TAG "mpu6050"
 
+/** Samples printed per second, whatever the sample rate */
+#define PRINT_RATE_HZ 4
+
 int mpu6050(int argc, char **argv)
 {
     int32_t ret;
+    struct mpu6050_acq_reader reader;
+    struct mpu6050_acq_stats stats;
+    uint32_t rate_hz = argc > 1 ? strtoul(argv[1], NULL, 10) : PRINT_RATE_HZ;
+    uint32_t batch = argc > 2 ? strtoul(argv[2], NULL, 10) : 0;
     const struct i2c_device *i2c = device_get_by_name("i2c1");
     if (i2c == NULL) {
         ERROR(TAG, "Could not get I2C device");
@@ -44,22 +55,239 @@ int mpu6050(int argc, char **argv)
         goto exit;
     }
 
+    ret = mpu6050_acq_attach(&reader);
+    if (ret < 0) { goto exit; }
+    if (batch > 0) {
+        ret = mpu6050_acq_start_fifo(i2c, device_get_by_name("cpu"), rate_hz, batch);
+        DBG(TAG, "mpu6050_acq_start_fifo(%u, %u)==%s", rate_hz, batch, error_to_str(ret));
+    } else {
+        ret = mpu6050_acq_start(i2c, device_get_by_name("cpu"), rate_hz);
+        DBG(TAG, "mpu6050_acq_start(%u)==%s", rate_hz, error_to_str(ret));
+    }
+    if (ret < 0) { goto detach; }
+
     uprintf("Press 'q' to quit reading\r\n");
     while (1) {
-        struct mpu6050_axis axis = {0,0,0};
-        mpu6050_read_accel_info(i2c, &axis);
-        uprintf("Accel read: x=%d, y=%d, z=%d\r\n", axis.x_axis, axis.y_axis, axis.z_axis);
-        memset(&axis, 0x00, sizeof(axis));
-        mpu6050_read_gyro_info(i2c, &axis);
-        uprintf("Gyro read: x=%d, y=%d, z=%d\r\n", axis.x_axis, axis.y_axis, axis.z_axis);
+        // Takes every sample published so far, then checks for 'q': at high rates there is always a sample waiting
+        const struct mpu6050_sample *sample = mpu6050_acq_peek(&reader, 250);
+        while (sample != NULL) {
+            if (sample->sequence % CHOOSE_MAX(rate_hz / PRINT_RATE_HZ, 1) == 0) {
+                uprintf("[%lu us] #%lu accel: x=%d, y=%d, z=%d gyro: x=%d, y=%d, z=%d\r\n", sample->timestamp_us,
+                    sample->sequence, sample->accel.x_axis, sample->accel.y_axis, sample->accel.z_axis,
+                    sample->gyro.x_axis, sample->gyro.y_axis, sample->gyro.z_axis);
+            }
+            mpu6050_acq_release(&reader);
+            sample = mpu6050_acq_peek(&reader, 0);
+        }
+
         int c = ugetchar();
         if (c == 'q' || c == 'Q') break;
-        vTaskDelay(250);
     }
+
+    mpu6050_acq_stop();
+    mpu6050_acq_get_stats(&stats);
+    uprintf("samples %lu, errors %lu, missed %lu, max jitter %lu us, reader overruns %lu\r\n", stats.samples,
+        stats.errors, stats.missed, stats.max_jitter_us, reader.overruns);
+    if (batch > 0) uprintf("FIFO reads %lu, FIFO overflows %lu\r\n", stats.wakeups, stats.overflows);
     ret = E_SUCCESS;
 
+    detach:
+    mpu6050_acq_detach(&reader);
+
+    exit:
+    return ret;
+}
+
+SHELL_DECLARE_COMMAND("mpu6050", mpu6050, "Samples the MPU6050 at [rate] Hz, through its FIFO [batch] samples at a time");
+/** Sample rate of the imu command */
+#define IMU_RATE_HZ 500
+
+/**
+ * @brief Prints a Q30 value with 4 decimal places
+ *
+ * @param name Name of the value
+ * @param value Value in Q30
+ */
+static void print_q30(const char *name, int32_t value)
+{
+    const int32_t scaled = ((int64_t)value * 10000) >> 30;
+    const uint32_t magnitude = scaled < 0 ? -scaled : scaled;
+    uprintf("%s=%s%lu.%04lu ", name, scaled < 0 ? "-" : "", magnitude / 10000, magnitude % 10000);
+}
+
+int imu(int argc, char **argv)
+{
+    int32_t ret;
+    struct fusion_quat q;
+    struct mpu6050_fusion_stats stats;
+    struct fusion_config config = {
+        .filter = argc > 1 && strcmp(argv[1], "madgwick") == 0 ? FUSION_MADGWICK : FUSION_COMPLEMENTARY,
+        .rate_hz = IMU_RATE_HZ,
+        .gyro_range_dps = 2000,
+    };
+    config.gain_milli = argc > 2 ? strtoul(argv[2], NULL, 10) : (config.filter == FUSION_MADGWICK ? 100 : 1000);
+    const struct cpu *cpu = device_get_by_name("cpu");
+    const struct i2c_device *i2c = device_get_by_name("i2c1");
+    if (i2c == NULL) {
+        ERROR(TAG, "Could not get I2C device");
+        ret = E_DEVICE_NOT_FOUND;
+        goto exit;
+    }
+
+    ret = mpu6050_init(i2c);
+    if (ret != E_SUCCESS) {
+        ret = E_NOT_INITIALIZED;
+        goto exit;
+    }
+
+    ret = mpu6050_acq_start(i2c, cpu, config.rate_hz);
+    if (ret < 0) { goto exit; }
+    ret = mpu6050_fusion_start(&config, cpu);
+    DBG(TAG, "mpu6050_fusion_start()==%s", error_to_str(ret));
+    if (ret < 0) { goto stop; }
+
+    uprintf("Press 'q' to quit reading\r\n");
+    while (1) {
+        vTaskDelay(configTICK_RATE_HZ / PRINT_RATE_HZ);
+        mpu6050_fusion_get(&q, NULL);
+        print_q30("w", q.w);
+        print_q30("x", q.x);
+        print_q30("y", q.y);
+        print_q30("z", q.z);
+        uprintf("\r\n");
+
+        int c = ugetchar();
+        if (c == 'q' || c == 'Q') break;
+    }
+
+    mpu6050_fusion_stop();
+    mpu6050_fusion_get_stats(&stats);
+    uprintf("updates %lu, gaps %lu, overruns %lu, max %lu cycles per update\r\n", stats.updates, stats.gaps,
+        stats.overruns, stats.max_cycles);
+    ret = E_SUCCESS;
+
+    stop:
+    mpu6050_acq_stop();
+
+    exit:
+    return ret;
+}
+
+SHELL_DECLARE_COMMAND("imu", imu, "Prints the MPU6050 orientation. [complementary|madgwick] [gain x1000]");
+
+/** Sample rate and length of calibration captures */
+#define IMUCAL_RATE_HZ 500
+#define IMUCAL_SAMPLES 1000
+
+/** File the calibration is saved to and loaded from when no path is given */
+#define IMUCAL_DEFAULT_PATH "imucal.bin"
+
+/** Calibration being built by imucal */
+static struct mpu6050_cal imucal_cal = {.accel_gain = {MPU6050_CAL_GAIN_ONE, MPU6050_CAL_GAIN_ONE, MPU6050_CAL_GAIN_ONE}};
+
+/**
+ * @brief Starts raw acquisition for a calibration capture
+ *
+ * @return int32_t E_SUCCESS on success
+ */
+static int32_t imucal_start(void)
+{
+    const struct i2c_device *i2c = device_get_by_name("i2c1");
+    if (i2c == NULL) return E_DEVICE_NOT_FOUND;
+    if (mpu6050_init(i2c) != E_SUCCESS) return E_NOT_INITIALIZED;
+
+    mpu6050_acq_set_calibration(NULL);
+    return mpu6050_acq_start(i2c, device_get_by_name("cpu"), IMUCAL_RATE_HZ);
+}
+
+/**
+ * @brief Captures the six positions, prompting for each one
+ *
+ * @return int32_t E_SUCCESS on success
+ */
+static int32_t imucal_six(void)
+{
+    static const char * const names[6] = {"+X", "-X", "+Y", "-Y", "+Z", "-Z"};
+    int32_t ret = E_SUCCESS;
+    struct mpu6050_cal_capture capture;
+    struct mpu6050_cal_six six = {0};
+
+    while (six.done != 0x3f) {
+        uprintf("Place the board still with a missing axis up:");
+        for (int i = 0; i < 6; i++) {
+            if (IS_BIT_CLEAR(six.done, 1 << i)) uprintf(" %s", names[i]);
+        }
+        uprintf(". Press a key when ready or 'q' to quit\r\n");
+
+        int c;
+        while ((c = ugetchar()) < 0) vTaskDelay(configTICK_RATE_HZ / 100);
+        if (c == 'q' || c == 'Q') return E_TIMEOUT;
+
+        ret = mpu6050_cal_capture(&capture, IMUCAL_SAMPLES, configTICK_RATE_HZ);
+        if (ret < 0) { goto exit; }
+        ret = mpu6050_cal_six_add(&six, &capture);
+        if (ret < 0) {
+            uprintf("Rejected: %s\r\n", error_to_str(ret));
+            continue;
+        }
+        uprintf("Got %s\r\n", names[ret]);
+    }
+    ret = mpu6050_cal_six_finish(&six, &imucal_cal);
+
+    exit:
+    return ret;
+}
+
+int imucal(int argc, char **argv)
+{
+    int32_t ret;
+    struct mpu6050_cal_capture capture;
+    const char *command = argc > 1 ? argv[1] : "show";
+    const char *path = argc > 2 ? argv[2] : IMUCAL_DEFAULT_PATH;
+
+    if (strcmp(command, "gyro") == 0 || strcmp(command, "six") == 0) {
+        ret = imucal_start();
+        if (ret < 0) { goto exit; }
+        if (strcmp(command, "gyro") == 0) {
+            uprintf("Keep the board still\r\n");
+            ret = mpu6050_cal_capture(&capture, IMUCAL_SAMPLES, configTICK_RATE_HZ);
+            if (ret == E_SUCCESS) ret = mpu6050_cal_gyro_bias(&capture, &imucal_cal);
+        } else {
+            ret = imucal_six();
+        }
+        mpu6050_acq_stop();
+        if (ret < 0) { goto exit; }
+        mpu6050_acq_set_calibration(&imucal_cal);
+#ifdef FATFS_WRITE
+    } else if (strcmp(command, "save") == 0) {
+        ret = mpu6050_cal_save(path, &imucal_cal);
+#endif
+    } else if (strcmp(command, "load") == 0) {
+        ret = mpu6050_cal_load(path, &imucal_cal);
+        if (ret == E_SUCCESS) mpu6050_acq_set_calibration(&imucal_cal);
+    } else if (strcmp(command, "off") == 0) {
+        mpu6050_acq_set_calibration(NULL);
+        ret = E_SUCCESS;
+    } else if (strcmp(command, "show") == 0) {
+        ret = E_SUCCESS;
+    } else {
+        ret = E_INVALID_PARAMETER;
+        goto exit;
+    }
+
+    uprintf("gyro bias: x=%d, y=%d, z=%d\r\n", imucal_cal.gyro_bias.x_axis, imucal_cal.gyro_bias.y_axis,
+        imucal_cal.gyro_bias.z_axis);
+    uprintf("accel offset: x=%d, y=%d, z=%d gain (1/16384): x=%d, y=%d, z=%d\r\n", imucal_cal.accel_offset.x_axis,
+        imucal_cal.accel_offset.y_axis, imucal_cal.accel_offset.z_axis, imucal_cal.accel_gain[0],
+        imucal_cal.accel_gain[1], imucal_cal.accel_gain[2]);
+
     exit:
+    DBG(TAG, "imucal %s==%s", command, error_to_str(ret));
     return ret;
 }
 
-SHELL_DECLARE_COMMAND("mpu6050", mpu6050, "Tests the MPU6050");
\ No newline at end of file
+#ifdef FATFS_WRITE
+SHELL_DECLARE_COMMAND("imucal", imucal, "Calibrates the MPU6050. gyro|six|save [path]|load [path]|off|show");
+#else
+SHELL_DECLARE_COMMAND("imucal", imucal, "Calibrates the MPU6050. gyro|six|load [path]|off|show");
+#endif
@@ -15,6 +15,25 @@
 
 #define MPU6050_ADDRESS 0x68
 
+#define MPU6050_SMPLRT_DIV      0x19
+#define MPU6050_CONFIG          0x1a
+#define MPU6050_CONFIG_DLPF_184 0x01
+
+/** Internal sample rate with the digital low pass filter enabled */
+#define MPU6050_DLPF_RATE_HZ    1000
+
+#define MPU6050_INT_ENABLE          0x38
+#define MPU6050_INT_DATA_RDY        0x01
+#define MPU6050_INT_STATUS          0x3a
+#define MPU6050_INT_FIFO_OFLOW      0x10
+
+#define MPU6050_USER_CTRL           0x6a
+#define MPU6050_USER_CTRL_FIFO_EN   0x40
+#define MPU6050_USER_CTRL_FIFO_RST  0x04
+
+#define MPU6050_FIFO_COUNT          0x72
+#define MPU6050_FIFO_R_W            0x74
+
 #define MPU6050_ACCEL_X_AXIS    0x3b
 #define MPU6050_ACCEL_Y_AXIS    0x3d
 #define MPU6050_ACCEL_Z_AXIS    0x3f
@@ -35,6 +54,30 @@ static const struct mpu6050_init_config config[4] = {
     {0x6b, 0x01}    /* Register 0x6b (107) Disables sleep */
 };
 
+static int32_t write_register(const struct i2c_device * const i2c, uint8_t reg, uint8_t value)
+{
+    struct i2c_transaction transaction = {
+        .i2c_device_addr = MPU6050_ADDRESS,
+        .i2c_device_reg = reg,
+        .transaction_size = sizeof(value),
+        .write_data = &value
+    };
+
+    return i2c_write(i2c, &transaction, 10000);
+}
+
+static int32_t read_registers(const struct i2c_device * const i2c, uint8_t reg, uint32_t size, void * const data)
+{
+    struct i2c_transaction transaction = {
+        .i2c_device_addr = MPU6050_ADDRESS,
+        .i2c_device_reg = reg,
+        .transaction_size = size,
+        .read_data = data
+    };
+
+    return i2c_read(i2c, &transaction, 10000);
+}
+
 int32_t mpu6050_init(const struct i2c_device * const i2c)
 {
     int32_t ret;
@@ -109,4 +152,105 @@ int32_t mpu6050_read_accel_info(const struct i2c_device * const i2c, struct mpu6
 
     exit:
     return ret;
-}
\ No newline at end of file
+}
+
+int32_t mpu6050_read_motion(const struct i2c_device * const i2c, struct mpu6050_axis *accel,
+    struct mpu6050_axis *gyro)
+{
+    int32_t ret;
+    // ACCEL_XOUT_H to GYRO_ZOUT_L: accelerometer, temperature and gyroscope
+    int16_t raw[7];
+
+    struct i2c_transaction transaction = {
+        .i2c_device_addr = MPU6050_ADDRESS,
+        .i2c_device_reg = MPU6050_ACCEL_X_AXIS,
+        .transaction_size = sizeof(raw),
+        .read_data = raw
+    };
+
+    if ((ret = i2c_read(i2c, &transaction, 10000)) < 0) goto exit;
+
+    accel->x_axis = REV16(raw[0]);
+    accel->y_axis = REV16(raw[1]);
+    accel->z_axis = REV16(raw[2]);
+    gyro->x_axis = REV16(raw[4]);
+    gyro->y_axis = REV16(raw[5]);
+    gyro->z_axis = REV16(raw[6]);
+
+    ret = E_SUCCESS;
+
+    exit:
+    return ret;
+}
+
+int32_t mpu6050_set_sample_rate(const struct i2c_device * const i2c, uint32_t rate_hz)
+{
+    int32_t ret;
+
+    if (rate_hz == 0 || MPU6050_DLPF_RATE_HZ % rate_hz != 0 || MPU6050_DLPF_RATE_HZ / rate_hz > 256) {
+        ret = E_INVALID_PARAMETER;
+        goto exit;
+    }
+
+    if ((ret = write_register(i2c, MPU6050_CONFIG, MPU6050_CONFIG_DLPF_184)) < 0) goto exit;
+    if ((ret = write_register(i2c, MPU6050_SMPLRT_DIV, MPU6050_DLPF_RATE_HZ / rate_hz - 1)) < 0) goto exit;
+    ret = E_SUCCESS;
+
+    exit:
+    return ret;
+}
+
+int32_t mpu6050_fifo_enable(const struct i2c_device * const i2c, uint8_t enable)
+{
+    int32_t ret;
+
+    // Reset is done with the FIFO disabled so no frame is written half way through it
+    if ((ret = write_register(i2c, MPU6050_USER_CTRL, MPU6050_USER_CTRL_FIFO_RST)) < 0) goto exit;
+    if (enable) {
+        if ((ret = write_register(i2c, MPU6050_USER_CTRL, MPU6050_USER_CTRL_FIFO_EN)) < 0) goto exit;
+    }
+    ret = E_SUCCESS;
+
+    exit:
+    return ret;
+}
+
+int32_t mpu6050_fifo_read(const struct i2c_device * const i2c, struct mpu6050_motion * const samples,
+    uint32_t max_samples)
+{
+    int32_t ret;
+    uint8_t int_status;
+    uint16_t fifo_count;
+
+    // Reading INT_STATUS also clears it
+    if ((ret = read_registers(i2c, MPU6050_INT_STATUS, sizeof(int_status), &int_status)) < 0) goto exit;
+    if (IS_BIT_SET(int_status, MPU6050_INT_FIFO_OFLOW)) {
+        if ((ret = mpu6050_fifo_enable(i2c, TRUE)) < 0) goto exit;
+        ret = E_RX_OVERRUN;
+        goto exit;
+    }
+
+    if ((ret = read_registers(i2c, MPU6050_FIFO_COUNT, sizeof(fifo_count), &fifo_count)) < 0) goto exit;
+    uint32_t count = CHOOSE_MIN(REV16(fifo_count) / sizeof(struct mpu6050_motion), max_samples);
+    if (count == 0) {
+        ret = 0;
+        goto exit;
+    }
+
+    // Frames have the layout of struct mpu6050_motion: they are read in place and only need byte swapping
+    if ((ret = read_registers(i2c, MPU6050_FIFO_R_W, count * sizeof(struct mpu6050_motion), samples)) < 0) goto exit;
+    int16_t *values = (int16_t *)samples;
+    for (uint32_t i = 0; i < count * sizeof(struct mpu6050_motion) / sizeof(int16_t); i++) {
+        values[i] = REV16(values[i]);
+    }
+    ret = count;
+
+    exit:
+    return ret;
+}
+
+int32_t mpu6050_data_ready_irq_enable(const struct i2c_device * const i2c, uint8_t enable)
+{
+    int32_t ret = write_register(i2c, MPU6050_INT_ENABLE, enable ? MPU6050_INT_DATA_RDY : 0x00);
+    return ret < 0 ? ret : E_SUCCESS;
+}
@@ -18,6 +18,18 @@ struct mpu6050_axis {
     int16_t z_axis;
 };
 
+/** One sample of accelerometer and gyroscope. Same layout as a frame of the MPU6050 FIFO */
+struct mpu6050_motion {
+    struct mpu6050_axis accel;
+    struct mpu6050_axis gyro;
+};
+
+/** Size of the MPU6050 FIFO in bytes */
+#define MPU6050_FIFO_SIZE 1024
+
+/** Number of whole samples the FIFO holds */
+#define MPU6050_FIFO_SAMPLES (MPU6050_FIFO_SIZE / sizeof(struct mpu6050_motion))
+
 /**
  * @brief Configures MPU6050 gyroscope and accelerometer MEMS sensor
  *
@@ -44,4 +56,56 @@ extern int32_t mpu6050_read_gyro_info(const struct i2c_device * const i2c, struc
  */
 extern int32_t mpu6050_read_accel_info(const struct i2c_device * const i2c, struct mpu6050_axis *axis);
 
+/**
+ * @brief Reads accelerometer and gyroscope in a single burst, so both belong to the same sample
+ *
+ * @param i2c I2C object
+ * @param accel [out] Accelerometer values
+ * @param gyro [out] Gyroscope values
+ * @return int32_t E_SUCCESS on success
+ */
+extern int32_t mpu6050_read_motion(const struct i2c_device * const i2c, struct mpu6050_axis *accel,
+    struct mpu6050_axis *gyro);
+
+/**
+ * @brief Sets the rate the MPU6050 updates its sensor registers. Enables the digital low pass filter (184Hz for the
+ * accelerometer, 188Hz for the gyroscope) which sets the internal sample rate to 1kHz
+ *
+ * @param i2c I2C object
+ * @param rate_hz Sample rate in Hz. Must divide 1000 and be at least 4Hz
+ * @return int32_t E_SUCCESS on success. E_INVALID_PARAMETER if rate_hz can not be generated
+ */
+extern int32_t mpu6050_set_sample_rate(const struct i2c_device * const i2c, uint32_t rate_hz);
+
+/**
+ * @brief Enables the FIFO, which gathers accelerometer and gyroscope at the sample rate, or disables it. Enabling
+ * also empties it
+ *
+ * @param i2c I2C object
+ * @param enable Non-zero to enable
+ * @return int32_t E_SUCCESS on success
+ */
+extern int32_t mpu6050_fifo_enable(const struct i2c_device * const i2c, uint8_t enable);
+
+/**
+ * @brief Reads every whole sample in the FIFO, up to max_samples, in a single I2C transfer. On overflow the FIFO is
+ * emptied, as samples are no longer aligned to its frames
+ *
+ * @param i2c I2C object
+ * @param samples [out] Samples, oldest first
+ * @param max_samples Size of samples
+ * @return int32_t Number of samples read. E_RX_OVERRUN if the FIFO overflowed. Negative on error
+ */
+extern int32_t mpu6050_fifo_read(const struct i2c_device * const i2c, struct mpu6050_motion * const samples,
+    uint32_t max_samples);
+
+/**
+ * @brief Enables or disables the data ready interrupt. The INT pin pulses for 50µs whenever a sample is ready
+ *
+ * @param i2c I2C object
+ * @param enable Non-zero to enable
+ * @return int32_t E_SUCCESS on success
+ */
+extern int32_t mpu6050_data_ready_irq_enable(const struct i2c_device * const i2c, uint8_t enable);
+
 #endif // DRIVERS_MPU6050_MPU6050_DRIVER_H_
\ No newline at end of file
@@ -0,0 +1,176 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#include "drivers/mpu6050/mpu6050_fusion.h"
+#include "drivers/mpu6050/mpu6050_acq.h"
+
+#include "libs/fusion/fusion.h"
+
+#include "include/device/cpu.h"
+#include "include/errors.h"
+
+#include "ulibc/include/utils.h"
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#define TAG "mpu6050_fusion"
+
+#define FUSION_TASK_SIZE 256
+#define FUSION_TASK_PRIORITY (tskIDLE_PRIORITY + 1)
+
+/** Ticks between checks for mpu6050_fusion_stop() when no sample arrives */
+#define FUSION_POLL_TICKS 100
+
+#if defined(__ARM_FP)
+#define FILTER struct fusion_float
+#define FILTER_INIT fusion_float_init
+#define FILTER_UPDATE fusion_float_update
+#else
+#define FILTER struct fusion
+#define FILTER_INIT fusion_init
+#define FILTER_UPDATE fusion_update
+#endif
+
+static StackType_t fusion_stack[FUSION_TASK_SIZE];
+static StaticTask_t fusion_tcb;
+static TaskHandle_t fusion_task_handle;
+
+static struct fusion_config fusion_config;
+static const struct cpu *fusion_cpu;
+static volatile uint8_t running;
+/** Incremented by every mpu6050_fusion_start() so the task picks up the new configuration */
+static volatile uint32_t generation;
+
+static struct fusion_quat orientation = {FUSION_Q30_ONE, 0, 0, 0};
+static uint32_t orientation_us;
+static struct mpu6050_fusion_stats fusion_stats;
+
+/**
+ * @brief Feeds one sample to the filter and publishes the orientation
+ *
+ * @param filter Filter
+ * @param sample Sample
+ */
+static void update(FILTER * const filter, const struct mpu6050_sample * const sample)
+{
+    const int16_t accel[3] = {sample->accel.x_axis, sample->accel.y_axis, sample->accel.z_axis};
+    const int16_t gyro[3] = {sample->gyro.x_axis, sample->gyro.y_axis, sample->gyro.z_axis};
+    struct fusion_quat q;
+    uint32_t start, end;
+
+    const uint8_t measure = fusion_cpu != NULL && cpu_get_cycle_counter(fusion_cpu, &start) == E_SUCCESS;
+    FILTER_UPDATE(filter, accel, gyro);
+    if (measure && cpu_get_cycle_counter(fusion_cpu, &end) == E_SUCCESS) {
+        fusion_stats.max_cycles = CHOOSE_MAX(fusion_stats.max_cycles, end - start);
+    }
+
+#if defined(__ARM_FP)
+    fusion_float_get_quat(filter, &q);
+#else
+    q = filter->q;
+#endif
+
+    taskENTER_CRITICAL();
+    orientation = q;
+    orientation_us = sample->timestamp_us;
+    taskEXIT_CRITICAL();
+    fusion_stats.updates++;
+}
+
+static void fusion_task(void *arg)
+{
+    (void)arg;
+    static FILTER filter;
+    struct fusion_config config;
+    struct mpu6050_acq_reader reader;
+    uint32_t current;
+
+    while (1) {
+        if (!running) ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        taskENTER_CRITICAL();
+        config = fusion_config;
+        current = generation;
+        taskEXIT_CRITICAL();
+
+        if (!running || FILTER_INIT(&filter, &config) != E_SUCCESS) continue;
+        // Readers are notified through the task that attaches them
+        if (mpu6050_acq_attach(&reader) != E_SUCCESS) {
+            running = FALSE;
+            continue;
+        }
+
+        uint32_t next_sequence = 0;
+        uint8_t first = TRUE;
+        while (running && generation == current) {
+            const struct mpu6050_sample *sample = mpu6050_acq_peek(&reader, FUSION_POLL_TICKS);
+            if (sample == NULL) continue;
+
+            if (!first && sample->sequence != next_sequence) fusion_stats.gaps += sample->sequence - next_sequence;
+            next_sequence = sample->sequence + 1;
+            first = FALSE;
+
+            update(&filter, sample);
+            mpu6050_acq_release(&reader);
+            fusion_stats.overruns = reader.overruns;
+        }
+        mpu6050_acq_detach(&reader);
+    }
+}
+
+int32_t mpu6050_fusion_start(const struct fusion_config * const config, const struct cpu * const cpu)
+{
+    int32_t ret;
+    FILTER filter;
+
+    // Validates the configuration before the task sees it
+    ret = FILTER_INIT(&filter, config);
+    if (ret < 0) { goto exit; }
+
+    taskENTER_CRITICAL();
+    fusion_config = *config;
+    fusion_cpu = cpu;
+    fusion_stats.updates = 0;
+    fusion_stats.gaps = 0;
+    fusion_stats.overruns = 0;
+    fusion_stats.max_cycles = 0;
+    generation++;
+    running = TRUE;
+    taskEXIT_CRITICAL();
+
+    if (fusion_task_handle == NULL) {
+        fusion_task_handle = xTaskCreateStatic(fusion_task, TAG, FUSION_TASK_SIZE, NULL, FUSION_TASK_PRIORITY,
+            fusion_stack, &fusion_tcb);
+    }
+    xTaskNotifyGive(fusion_task_handle);
+
+    exit:
+    return ret;
+}
+
+void mpu6050_fusion_stop(void)
+{
+    running = FALSE;
+}
+
+void mpu6050_fusion_get(struct fusion_quat * const q, uint32_t * const timestamp_us)
+{
+    taskENTER_CRITICAL();
+    *q = orientation;
+    if (timestamp_us != NULL) *timestamp_us = orientation_us;
+    taskEXIT_CRITICAL();
+}
+
+void mpu6050_fusion_get_stats(struct mpu6050_fusion_stats * const stats)
+{
+    *stats = fusion_stats;
+}
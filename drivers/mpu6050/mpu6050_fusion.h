@@ -0,0 +1,65 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#ifndef DRIVERS_MPU6050_MPU6050_FUSION_H_
+#define DRIVERS_MPU6050_MPU6050_FUSION_H_
+
+#include "libs/fusion/fusion.h"
+
+#include "include/device/cpu.h"
+
+#include <stdint.h>
+
+/**
+ * @brief Orientation of the MPU6050, updated at its sample rate.
+ *
+ * A task reads every sample of the acquisition service (mpu6050_acq_start() or mpu6050_acq_start_fifo()) and feeds
+ * it to a fusion filter. The task runs below the acquisition task and above the shell, so a filter that is too slow
+ * for the sample rate makes it skip samples (counted as overruns) instead of taking the CPU from the other tasks.
+ *
+ * The float filter is used when the CPU has an FPU (__ARM_FP), the fixed point one otherwise.
+ */
+
+/** Fusion statistics */
+struct mpu6050_fusion_stats {
+    uint32_t updates;           /** Samples fed to the filter */
+    uint32_t gaps;              /** Samples lost by the acquisition service */
+    uint32_t overruns;          /** Samples skipped because the task fell behind */
+    uint32_t max_cycles;        /** Longest filter update in CPU cycles. 0 without a cycle counter */
+};
+
+/**
+ * @brief Starts updating the orientation. Calling it again restarts from identity with the new configuration
+ *
+ * @param config Filter configuration. rate_hz must be the acquisition sample rate and gyro_range_dps 2000
+ * @param cpu CPU object whose cycle counter measures the updates or NULL
+ * @return int32_t Negative value on error
+ */
+extern int32_t mpu6050_fusion_start(const struct fusion_config * const config, const struct cpu * const cpu);
+
+/**
+ * @brief Stops updating the orientation. The last one is kept
+ */
+extern void mpu6050_fusion_stop(void);
+
+/**
+ * @brief Gets the latest orientation
+ *
+ * @param q [out] Orientation
+ * @param timestamp_us [out] Time of the sample it was computed from. May be NULL
+ */
+extern void mpu6050_fusion_get(struct fusion_quat * const q, uint32_t * const timestamp_us);
+
+/**
+ * @brief Gets fusion statistics
+ *
+ * @param stats [out] Statistics
+ */
+extern void mpu6050_fusion_get_stats(struct mpu6050_fusion_stats * const stats);
+
+#endif // DRIVERS_MPU6050_MPU6050_FUSION_H_
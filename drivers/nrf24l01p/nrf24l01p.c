@@ -22,6 +22,7 @@
 
 #include "FreeRTOS.h"
 #include "task.h"
+#include "semphr.h"
 
 #define DEFAULT_TIMEOUT 0
 
@@ -29,6 +30,83 @@
 
 #define ADDR_NOT_VALID(x) ((x) > 0x1d || ((x) >= 0x18 && (x) <= 0x1b))
 
+/** Single byte registers that are only changed by the driver and therefore can be kept in the shadow copy */
+#define REG_CACHEABLE(x) ((x) <= NRF24L01P_REG_RF_SETUP || \
+    ((x) >= NRF24L01P_REG_RX_PW_P0 && (x) <= NRF24L01P_REG_RX_PW_P5) || \
+    (x) == NRF24L01P_REG_DYNPD || (x) == NRF24L01P_REG_FEATURE)
+
+#define CMD_R_RX_PL_WID     0b01100000
+#define CMD_R_RX_PAYLOAD    0b01100001
+#define CMD_W_TX_PAYLOAD    0b10100000
+#define CMD_FLUSH_TX        0b11100001
+#define CMD_FLUSH_RX        0b11100010
+#define CMD_NOP             0b11111111
+
+/**
+ * @brief Stores a register value in the shadow copy if it is cacheable
+ */
+static void shadow_store(const struct nrf24l01p * const device, uint8_t addr, uint32_t size, const void * const reg)
+{
+    if (size != 1 || !REG_CACHEABLE(addr)) return;
+
+    device->shadow->regs[addr] = *(const uint8_t *)reg;
+    device->shadow->valid |= 1UL << addr;
+}
+
+void nrf24l01p_lock(const struct nrf24l01p * const device)
+{
+    // Double checked so only the first use pays for the critical section
+    if (device->shadow->lock == NULL) {
+        taskENTER_CRITICAL();
+        if (device->shadow->lock == NULL) {
+            device->shadow->lock = xSemaphoreCreateRecursiveMutexStatic(&device->shadow->lock_buffer);
+        }
+        taskEXIT_CRITICAL();
+    }
+
+    xSemaphoreTakeRecursive(device->shadow->lock, portMAX_DELAY);
+}
+
+void nrf24l01p_unlock(const struct nrf24l01p * const device)
+{
+    xSemaphoreGiveRecursive(device->shadow->lock);
+}
+
+/**
+ * @brief Sends a command to the nRF24L01+ keeping the STATUS byte that is clocked out with the command byte
+ *
+ * @param device nRF24L01+ device definition
+ * @param out Command byte followed by data to write
+ * @param in [out] STATUS followed by data read. May be NULL if only STATUS is needed
+ * @param size Size of out (and in) in bytes
+ * @return int32_t Negative value on error
+ */
+static int32_t command(const struct nrf24l01p * const device, const uint8_t * const out, uint8_t * const in,
+    uint32_t size)
+{
+    int32_t ret;
+    uint8_t status_only[1 + NRF24L01P_MAX_PAYLOAD];
+    uint8_t *read_data = in != NULL ? in : status_only;
+    struct spi_transaction transaction = {
+        .write_size = size,
+        .write_data = out,
+        .read_size = size,
+        .read_data = read_data,
+    };
+
+    nrf24l01p_lock(device);
+    gpio_write(device->cs_gpio, GPIO_LOW);
+    ret = spi_transact(device->spi_device, &transaction, DEFAULT_TIMEOUT);
+    gpio_write(device->cs_gpio, GPIO_HIGH);
+    if (ret < 0) { goto exit; }
+    device->shadow->status = read_data[0];
+    ret = E_SUCCESS;
+
+    exit:
+    nrf24l01p_unlock(device);
+    return ret;
+}
+
 static int32_t r_register(const struct nrf24l01p * const device, uint8_t addr, uint32_t size, void * const out)
 {
     int32_t ret;
@@ -47,19 +125,10 @@ static int32_t r_register(const struct nrf24l01p * const device, uint8_t addr, u
     }
 
     payload_out[0] = addr;
-    struct spi_transaction transaction = {
-        .write_size = 1 + size,
-        .write_data = payload_out,
-        .read_size = 1 + size,
-        .read_data = payload_in,
-    };
-
-    gpio_write(device->cs_gpio, GPIO_LOW);
-    ret = spi_transact(device->spi_device, &transaction, DEFAULT_TIMEOUT);
-    gpio_write(device->cs_gpio, GPIO_HIGH);
+    ret = command(device, payload_out, payload_in, 1 + size);
     if (ret < 0) { goto exit; }
-    // Copies data including status register
     memcpy(out, &payload_in[1], size);
+    shadow_store(device, addr, size, out);
 
     exit:
     return ret;
@@ -83,11 +152,27 @@ static int32_t w_register(const struct nrf24l01p * const device, uint8_t addr, u
     payload[0] = 0x20 | addr;
     memcpy(&payload[1], reg, size);
 
-    gpio_write(device->cs_gpio, GPIO_LOW);
-    ret = spi_write(device->spi_device, payload, 1 + size, DEFAULT_TIMEOUT);
-    gpio_write(device->cs_gpio, GPIO_HIGH);
+    ret = command(device, payload, NULL, 1 + size);
     if (ret < 0) { goto exit; }
-    ret = E_SUCCESS;
+    shadow_store(device, addr, size, reg);
+
+    exit:
+    return ret;
+}
+
+/**
+ * @brief Reads a single byte register from the shadow copy. Only goes to the bus when it is not cached yet
+ */
+static int32_t r_register_cached(const struct nrf24l01p * const device, uint8_t addr, uint8_t * const value)
+{
+    int32_t ret = E_SUCCESS;
+
+    if (REG_CACHEABLE(addr) && IS_BIT_SET(device->shadow->valid, 1UL << addr)) {
+        *value = device->shadow->regs[addr];
+        goto exit;
+    }
+
+    ret = r_register(device, addr, 1, value);
 
     exit:
     return ret;
@@ -96,30 +181,19 @@ static int32_t w_register(const struct nrf24l01p * const device, uint8_t addr, u
 static int32_t read_modify_write(const struct nrf24l01p * const device, uint8_t reg, uint8_t clear_mask, uint8_t set_mask)
 {
     int32_t ret;
-    uint8_t read_reg[2] = {reg, 0xff}, reg_value[2];
-    struct spi_transaction transaction = {
-        // .transaction_size = 2,
-        .write_size = sizeof(read_reg),
-        .write_data = &read_reg,
-        .read_size = sizeof(reg_value),
-        .read_data = reg_value
-    };
+    uint8_t old_value, new_value;
 
-    gpio_write(device->cs_gpio, GPIO_LOW);
-    ret = spi_transact(device->spi_device, &transaction, DEFAULT_TIMEOUT);
-    gpio_write(device->cs_gpio, GPIO_HIGH);
+    nrf24l01p_lock(device);
+    ret = r_register_cached(device, reg, &old_value);
     if (ret < 0) { goto exit; }
 
-    reg_value[1] &= ~clear_mask;
-    reg_value[1] |= set_mask;
-    uint8_t write_reg[2] = {reg | 0x20, reg_value[1]};
-    gpio_write(device->cs_gpio, GPIO_LOW);
-    ret = spi_write(device->spi_device, write_reg, sizeof(write_reg), DEFAULT_TIMEOUT);
-    gpio_write(device->cs_gpio, GPIO_HIGH);
-    if (ret < 0) { goto exit; }
-    ret = E_SUCCESS;
+    new_value = (old_value & ~clear_mask) | set_mask;
+    if (new_value == old_value) { goto exit; }
+
+    ret = w_register(device, reg, 1, &new_value);
 
     exit:
+    nrf24l01p_unlock(device);
     return ret;
 }
 
@@ -127,17 +201,26 @@ int32_t nrf24l01p_default_setup(const struct nrf24l01p * const device)
 {
     int32_t ret;
     struct configuration { uint8_t reg; uint8_t config; };
-    const struct configuration configuration[7] = {
-        {NRF24L01P_REG_CONFIG,      CONFIG_MASK_RX_DR | CONFIG_MASK_TX_DS | CONFIG_MASK_MAX_RT | CONFIG_PRIM_RX},
-        {NRF24L01P_REG_EN_AA,       0x00},
+    const struct configuration configuration[11] = {
+        // Only RX_DR drives the IRQ pin so the RX service task is woken up on packet arrival. TX_DS and MAX_RT are
+        // still reported in STATUS and only drive the pin while a stream is running
+        {NRF24L01P_REG_CONFIG,      CONFIG_MASK_TX_DS | CONFIG_MASK_MAX_RT | CONFIG_EN_RCR | CONFIG_PRIM_RX},
+        // Enhanced ShockBurst: auto-ack, up to 15 retransmissions 250µs apart and dynamic payload length
+        {NRF24L01P_REG_EN_AA,       EN_AA_ENNA_P1 | EN_AA_ENNA_P0},
         {NRF24L01P_REG_EN_RXADDR,   EN_RXADDR_ERX_P1 | EN_RXADDR_ERX_P0},
         {NRF24L01P_REG_SETUP_AW,    SETUP_AW_AW_5_BYTES},
-        {NRF24L01P_REG_SETUP_RETR,  0x03},
+        {NRF24L01P_REG_SETUP_RETR,  (0 << SETUP_RETR_ARD_SHIFT) | SETUP_RETR_ARC_MSK},
         {NRF24L01P_REG_RF_CH,       0x02},
         {NRF24L01P_REG_RF_SETUP,    RF_SETUP_RF_DR_HIGH | RF_SETUP_RF_PWR_0},
+        {NRF24L01P_REG_RX_PW_P0,    NRF24L01P_MAX_PAYLOAD},
+        {NRF24L01P_REG_RX_PW_P1,    NRF24L01P_MAX_PAYLOAD},
+        {NRF24L01P_REG_FEATURE,     FEATURE_EN_DPL},
+        {NRF24L01P_REG_DYNPD,       DYNPD_DPL_P1 | DYNPD_DPL_P0},
     };
 
+    nrf24l01p_lock(device);
     gpio_write(device->ce_gpio, 0);
+    device->shadow->valid = 0;
 
     for (int i = 0; i < ARRAY_SIZE(configuration); i++) {
         DBG(TAG, "Writing register [%.2x] with value [%.2x]", configuration[i].reg, configuration[i].config);
@@ -156,6 +239,7 @@ int32_t nrf24l01p_default_setup(const struct nrf24l01p * const device)
     }
 
     exit:
+    nrf24l01p_unlock(device);
     return ret;
 }
 
@@ -179,7 +263,19 @@ int32_t nrf24l01p_power_down(const struct nrf24l01p * const device)
 
 int32_t nrf24l01p_get_status(const struct nrf24l01p * const device, uint8_t * const status)
 {
-    return r_register(device, NRF24L01P_REG_STATUS, 1, status);
+    // NOP is the shortest command: STATUS is clocked out with the command byte
+    const uint8_t nop = CMD_NOP;
+    int32_t ret = command(device, &nop, NULL, sizeof(nop));
+    if (ret < 0) { goto exit; }
+    *status = device->shadow->status;
+
+    exit:
+    return ret;
+}
+
+uint8_t nrf24l01p_get_last_status(const struct nrf24l01p * const device)
+{
+    return device->shadow->status;
 }
 
 int32_t nrf24l01p_clear_status_irq(const struct nrf24l01p * const device, uint8_t irqs)
@@ -192,6 +288,7 @@ int32_t nrf24l01p_set_addr_p0(const struct nrf24l01p * const device, uint8_t add
     int32_t ret = E_SUCCESS;
     uint8_t size;
 
+    nrf24l01p_lock(device);
     if (addr_size < 3 || addr_size > 5) {
         ret = E_INVALID_PARAMETER;
         goto exit;
@@ -215,12 +312,165 @@ int32_t nrf24l01p_set_addr_p0(const struct nrf24l01p * const device, uint8_t add
     if (ret < 0) { goto exit; }
 
     exit:
+    nrf24l01p_unlock(device);
+    return ret;
+}
+
+int32_t nrf24l01p_set_rx_addr(const struct nrf24l01p * const device, uint8_t pipe, uint8_t addr_size,
+    const uint8_t * const addr)
+{
+    int32_t ret;
+    uint8_t aw;
+
+    nrf24l01p_lock(device);
+    if (pipe >= NRF24L01P_PIPES || addr == NULL) {
+        ret = E_INVALID_PARAMETER;
+        goto exit;
+    }
+
+    if (pipe >= 2) {
+        // Pipes 2 to 5 share the upper address bytes with pipe 1: only the LSB is written
+        if (addr_size != 1) {
+            ret = E_INVALID_PARAMETER;
+            goto exit;
+        }
+    } else {
+        ret = r_register_cached(device, NRF24L01P_REG_SETUP_AW, &aw);
+        if (ret < 0) { goto exit; }
+        if (addr_size != (aw & SETUP_AW_AW_MASK) + 2) {
+            ret = E_INVALID_PARAMETER;
+            goto exit;
+        }
+    }
+
+    ret = w_register(device, NRF24L01P_REG_RX_ADDR_P0 + pipe, addr_size, addr);
+
+    exit:
+    nrf24l01p_unlock(device);
+    return ret;
+}
+
+int32_t nrf24l01p_configure_pipe(const struct nrf24l01p * const device, uint8_t pipe,
+    const struct nrf24l01p_pipe_config * const config)
+{
+    int32_t ret;
+    const uint8_t bit = 1 << pipe;
+
+    nrf24l01p_lock(device);
+    if (pipe >= NRF24L01P_PIPES || config == NULL || config->width > NRF24L01P_MAX_PAYLOAD) {
+        ret = E_INVALID_PARAMETER;
+        goto exit;
+    }
+
+    // Every register is in the shadow copy: bits already in the wanted state are not written again
+    ret = read_modify_write(device, NRF24L01P_REG_EN_AA, config->auto_ack ? 0 : bit, config->auto_ack ? bit : 0);
+    if (ret < 0) { goto exit; }
+    ret = read_modify_write(device, NRF24L01P_REG_DYNPD, config->dynamic_payload ? 0 : bit,
+        config->dynamic_payload ? bit : 0);
+    if (ret < 0) { goto exit; }
+    if (config->dynamic_payload) {
+        ret = read_modify_write(device, NRF24L01P_REG_FEATURE, 0, FEATURE_EN_DPL);
+        if (ret < 0) { goto exit; }
+    }
+    // Static width of zero means pipe not used, even with dynamic payload length
+    ret = read_modify_write(device, NRF24L01P_REG_RX_PW_P0 + pipe, RX_PW_MSK,
+        config->width ? config->width : NRF24L01P_MAX_PAYLOAD);
+    if (ret < 0) { goto exit; }
+    ret = read_modify_write(device, NRF24L01P_REG_EN_RXADDR, config->enabled ? 0 : bit, config->enabled ? bit : 0);
+    if (ret < 0) { goto exit; }
+
+    exit:
+    nrf24l01p_unlock(device);
     return ret;
 }
 
 int32_t nrf24l01p_get_rx_pw_p0(const struct nrf24l01p * const device, uint8_t *rx_bytes_size)
 {
-    return r_register(device, NRF24L01P_REG_RX_PW_P0, 1, rx_bytes_size);
+    return nrf24l01p_get_rx_pw(device, 0, rx_bytes_size);
+}
+
+int32_t nrf24l01p_get_rx_pw(const struct nrf24l01p * const device, uint8_t pipe, uint8_t *rx_bytes_size)
+{
+    int32_t ret;
+
+    if (pipe >= NRF24L01P_PIPES) {
+        ret = E_INVALID_PARAMETER;
+        goto exit;
+    }
+
+    ret = r_register_cached(device, NRF24L01P_REG_RX_PW_P0 + pipe, rx_bytes_size);
+    if (ret < 0) { goto exit; }
+    *rx_bytes_size &= RX_PW_MSK;
+
+    exit:
+    return ret;
+}
+
+int32_t nrf24l01p_get_rx_payload_width(const struct nrf24l01p * const device, uint8_t pipe, uint8_t *rx_bytes_size)
+{
+    int32_t ret;
+    uint8_t dynpd, feature;
+    uint8_t cmd[2] = {CMD_R_RX_PL_WID, 0xff}, answer[2];
+
+    nrf24l01p_lock(device);
+    if (pipe >= NRF24L01P_PIPES) {
+        ret = E_INVALID_PARAMETER;
+        goto exit;
+    }
+
+    ret = r_register_cached(device, NRF24L01P_REG_FEATURE, &feature);
+    if (ret < 0) { goto exit; }
+    ret = r_register_cached(device, NRF24L01P_REG_DYNPD, &dynpd);
+    if (ret < 0) { goto exit; }
+
+    if (IS_BIT_CLEAR(feature, FEATURE_EN_DPL) || IS_BIT_CLEAR(dynpd, 1 << pipe)) {
+        ret = nrf24l01p_get_rx_pw(device, pipe, rx_bytes_size);
+        goto exit;
+    }
+
+    ret = command(device, cmd, answer, sizeof(cmd));
+    if (ret < 0) { goto exit; }
+    // A width above 32 bytes means the packet is corrupted and must be flushed
+    if (answer[1] > NRF24L01P_MAX_PAYLOAD) {
+        ret = E_INVALID_CRC;
+        goto exit;
+    }
+    *rx_bytes_size = answer[1];
+
+    exit:
+    nrf24l01p_unlock(device);
+    return ret;
+}
+
+int32_t nrf24l01p_set_tx_addr(const struct nrf24l01p * const device, uint8_t addr_size, const uint8_t * const addr)
+{
+    int32_t ret;
+    uint8_t aw;
+
+    nrf24l01p_lock(device);
+    if (addr == NULL) {
+        ret = E_INVALID_PARAMETER;
+        goto exit;
+    }
+
+    // TX_ADDR width is the same as SETUP_AW
+    ret = r_register_cached(device, NRF24L01P_REG_SETUP_AW, &aw);
+    if (ret < 0) { goto exit; }
+    if (addr_size != (aw & SETUP_AW_AW_MASK) + 2) {
+        ret = E_INVALID_PARAMETER;
+        goto exit;
+    }
+
+    ret = w_register(device, NRF24L01P_REG_TX_ADDR, addr_size, addr);
+
+    exit:
+    nrf24l01p_unlock(device);
+    return ret;
+}
+
+int32_t nrf24l01p_get_observe_tx(const struct nrf24l01p * const device, uint8_t *observe_tx)
+{
+    return r_register(device, NRF24L01P_REG_OBSERVE_TX, 1, observe_tx);
 }
 
 int32_t nrf24l01p_get_fifo_status(const struct nrf24l01p * const device, uint8_t *fifo_st)
@@ -231,7 +481,6 @@ int32_t nrf24l01p_get_fifo_status(const struct nrf24l01p * const device, uint8_t
 int32_t nrf24l01p_w_tx_payload(const struct nrf24l01p * const device, uint32_t size, const void * const data)
 {
     int32_t ret;
-    uint8_t fifo_st;
     uint8_t data_to_write[1 + 32];
 
     if (size > 32 || data == NULL) {
@@ -239,15 +488,15 @@ int32_t nrf24l01p_w_tx_payload(const struct nrf24l01p * const device, uint32_t s
         goto exit;
     }
 
-    if ((ret = r_register(device, NRF24L01P_REG_FIFO_STATUS, 1, &fifo_st)) < 0) { goto exit; }
-    if (fifo_st & FIFO_STATUS_TX_FULL) {
+    data_to_write[0] = CMD_W_TX_PAYLOAD;
+    memcpy(&data_to_write[1], data, size);
+    ret = command(device, data_to_write, NULL, 1 + size);
+    if (ret < 0) { goto exit; }
+    // STATUS is clocked out before the payload: if TX FIFO was already full the payload was discarded
+    if (device->shadow->status & STATUS_TX_FULL) {
         ret = E_TX_QUEUE_FULL;
         goto exit;
     }
-    data_to_write[0] = 0b10100000;
-    memcpy(&data_to_write[1], data, size);
-    if ((ret = spi_write(device->spi_device, data_to_write, 1 + size, 0)) < 0) { goto exit; }
-    if (ret > 0) { ret = E_SUCCESS; }
 
     exit:
     return ret;
@@ -256,30 +505,41 @@ int32_t nrf24l01p_w_tx_payload(const struct nrf24l01p * const device, uint32_t s
 int32_t nrf24l01p_r_rx_payload(const struct nrf24l01p * const device, uint32_t size, void * const data)
 {
     int32_t ret;
-    uint8_t fifo_st, data_to_read[1 + 32], data_to_write[1 + 32];
-    memset(data_to_write, 0xff, sizeof(data_to_write));
-    data_to_write[0] = 0b01100001;
+    uint8_t frame[1 + 32];
 
     if (size > 32 || data == NULL) {
         ret = E_INVALID_PARAMETER;
         goto exit;
     }
 
-    if ((ret = r_register(device, NRF24L01P_REG_FIFO_STATUS, 1, &fifo_st)) < 0) { goto exit; }
-    if (fifo_st & FIFO_STATUS_RX_EMPTY) {
-        ret = E_RX_QUEUE_EMPTY;
+    ret = nrf24l01p_r_rx_payload_in_place(device, size, frame);
+    if (ret < 0) { goto exit; }
+    memcpy(data, &frame[1], size);
+
+    exit:
+    return ret;
+}
+
+int32_t nrf24l01p_r_rx_payload_in_place(const struct nrf24l01p * const device, uint32_t size, uint8_t * const frame)
+{
+    int32_t ret;
+
+    if (size > 32 || frame == NULL) {
+        ret = E_INVALID_PARAMETER;
         goto exit;
     }
-    struct spi_transaction transaction = {
-        .write_size = 1 + size,
-        .write_data = data_to_write,
-        .read_size = 1 + size,
-        .read_data = data_to_read
-    };
 
-    if ((ret = spi_transact(device->spi_device, &transaction, 0)) < 0) { goto exit; }
-    memcpy(data, &data_to_read[1], size);
-    ret = E_SUCCESS;
+    // Bytes clocked out after the command are ignored by the radio, so overwriting them while shifting in the
+    // payload is harmless
+    memset(frame, 0xff, 1 + size);
+    frame[0] = CMD_R_RX_PAYLOAD;
+    ret = command(device, frame, frame, 1 + size);
+    if (ret < 0) { goto exit; }
+    // STATUS is clocked out before the payload: RX_P_NO tells whether there was anything to read
+    if (((device->shadow->status & STATUS_RX_P_NO_MSK) >> STATUS_RX_P_NO_SHIFT) == STATUS_RX_P_NO_EMPTY) {
+        ret = E_RX_QUEUE_EMPTY;
+        goto exit;
+    }
 
     exit:
     return ret;
@@ -287,22 +547,14 @@ int32_t nrf24l01p_r_rx_payload(const struct nrf24l01p * const device, uint32_t s
 
 int32_t nrf24l01p_flush_tx(const struct nrf24l01p * const device)
 {
-    int32_t ret;
-    const uint8_t opcode = 0b11100001;
-    ret = spi_write(device->spi_device, &opcode, sizeof(opcode), 0);
-    if (ret > 0) { ret = E_SUCCESS; }
-
-    return ret;
+    const uint8_t opcode = CMD_FLUSH_TX;
+    return command(device, &opcode, NULL, sizeof(opcode));
 }
 
 int32_t nrf24l01p_flush_rx(const struct nrf24l01p * const device)
 {
-int32_t ret;
-    const uint8_t opcode = 0b11100010;
-    ret = spi_write(device->spi_device, &opcode, sizeof(opcode), 0);
-    if (ret > 0) { ret = E_SUCCESS; }
-
-    return ret;
+    const uint8_t opcode = CMD_FLUSH_RX;
+    return command(device, &opcode, NULL, sizeof(opcode));
 }
 
 void nrf24l01p_transmit(const struct nrf24l01p * const device)
@@ -331,4 +583,14 @@ int32_t nrf24l01p_enable_tx_mode(const struct nrf24l01p * const device)
 int32_t nrf24l01p_disable_tx_mode(const struct nrf24l01p * const device)
 {
     return read_modify_write(device, NRF24L01P_REG_CONFIG, 0, CONFIG_PRIM_RX);
+}
+
+int32_t nrf24l01p_mask_irq(const struct nrf24l01p * const device, uint8_t mask)
+{
+    return read_modify_write(device, NRF24L01P_REG_CONFIG, 0, mask);
+}
+
+int32_t nrf24l01p_unmask_irq(const struct nrf24l01p * const device, uint8_t mask)
+{
+    return read_modify_write(device, NRF24L01P_REG_CONFIG, mask, 0);
 }
\ No newline at end of file
@@ -15,12 +15,67 @@
 
 #include <stdint.h>
 
+#include "FreeRTOS.h"
+#include "semphr.h"
+#include "task.h"
+
+/** Maximum payload size in bytes */
+#define NRF24L01P_MAX_PAYLOAD 32
+
+/** Number of data pipes */
+#define NRF24L01P_PIPES 6
+
+/** Size of the nRF24L01+ register map */
+#define NRF24L01P_REGISTERS 0x1e
+
+/**
+ * @brief Shadow copy of the nRF24L01+ configuration registers. Avoids reading a register before changing some of
+ * its bits. Also holds the lock that serializes the tasks using the radio. Must be kept between uses of the same
+ * radio and zero initialized
+ */
+struct nrf24l01p_shadow {
+    uint8_t regs[NRF24L01P_REGISTERS];  /** Register values, indexed by address */
+    uint32_t valid;                     /** Bit n is set when regs[n] holds the value of register n */
+    uint8_t status;                     /** STATUS as clocked out by the last command */
+    SemaphoreHandle_t lock;             /** Recursive mutex of the radio. Created on first use */
+    StaticSemaphore_t lock_buffer;      /** Storage of lock */
+    TaskHandle_t volatile tx_waiter;    /** Task waiting for TX_DS or MAX_RT, woken by nrf24l01p_tx_irq_handler() */
+};
+
+/**
+ * @brief Configuration of a data pipe
+ */
+struct nrf24l01p_pipe_config {
+    uint8_t enabled;            /** Non-zero to receive on this pipe */
+    uint8_t auto_ack;           /** Non-zero to acknowledge packets (Enhanced ShockBurst) */
+    uint8_t dynamic_payload;    /** Non-zero to use dynamic payload length */
+    uint8_t width;              /** Payload width when dynamic_payload is zero. Zero means 32 bytes */
+};
+
 struct nrf24l01p {
     const struct spi_device * const spi_device;
     const struct gpio_device * const ce_gpio;
     const struct gpio_device * const cs_gpio;
+    struct nrf24l01p_shadow * const shadow;
 };
 
+/**
+ * @brief Takes the lock of the radio. Every function of the driver takes it while it talks to the radio, so a
+ * sequence of commands (read-modify-write, draining the RX FIFO, a TX burst) is never interleaved with the commands
+ * of another task. Hold it to make a longer sequence atomic. Recursive: must be released as many times as taken.
+ * Must not be called from an ISR
+ *
+ * @param device nRF24L01+ device definition
+ */
+extern void nrf24l01p_lock(const struct nrf24l01p * const device);
+
+/**
+ * @brief Releases the lock taken with nrf24l01p_lock()
+ *
+ * @param device nRF24L01+ device definition
+ */
+extern void nrf24l01p_unlock(const struct nrf24l01p * const device);
+
 /**
  * @brief Configures nRF24L01+ to the driver default configuration
  *
@@ -54,6 +109,14 @@ extern int32_t nrf24l01p_power_down(const struct nrf24l01p * const device);
  */
 extern int32_t nrf24l01p_get_status(const struct nrf24l01p * const device, uint8_t * const status);
 
+/**
+ * @brief Gets the STATUS register as clocked out by the last command sent to the nRF24L01+. Does not touch the bus
+ *
+ * @param device nRF24L01+ device definition
+ * @return uint8_t STATUS register
+ */
+extern uint8_t nrf24l01p_get_last_status(const struct nrf24l01p * const device);
+
 /**
  * @brief Clears nRF24L01+ status IRQ flags
  * 
@@ -73,6 +136,30 @@ extern int32_t nrf24l01p_clear_status_irq(const struct nrf24l01p * const device,
  */
 extern int32_t nrf24l01p_set_addr_p0(const struct nrf24l01p * const device, uint8_t addr_size, const uint8_t * const addr);
 
+/**
+ * @brief Sets the address of a pipe
+ *
+ * @param device nRF24L01+ device definition
+ * @param pipe Pipe number from 0 to 5
+ * @param addr_size Address size. Pipes 0 and 1 take the size set in SETUP_AW. Pipes 2 to 5 only take the LSB (size 1)
+ * as they share the other bytes with pipe 1
+ * @param addr Address
+ * @return int32_t Negative value on error
+ */
+extern int32_t nrf24l01p_set_rx_addr(const struct nrf24l01p * const device, uint8_t pipe, uint8_t addr_size,
+    const uint8_t * const addr);
+
+/**
+ * @brief Configures a pipe: enabled, auto-ack, dynamic payload length and payload width
+ *
+ * @param device nRF24L01+ device definition
+ * @param pipe Pipe number from 0 to 5
+ * @param config Pipe configuration
+ * @return int32_t Negative value on error
+ */
+extern int32_t nrf24l01p_configure_pipe(const struct nrf24l01p * const device, uint8_t pipe,
+    const struct nrf24l01p_pipe_config * const config);
+
 /**
  * @brief Gets packet size as received by PIPE0
  *
@@ -82,6 +169,47 @@ extern int32_t nrf24l01p_set_addr_p0(const struct nrf24l01p * const device, uint
  */
 extern int32_t nrf24l01p_get_rx_pw_p0(const struct nrf24l01p * const device, uint8_t *rx_bytes_size);
 
+/**
+ * @brief Gets packet size as received by a pipe
+ *
+ * @param device nRF24L01+ device definition.
+ * @param pipe Pipe number from 0 to 5
+ * @param rx_bytes_size [out] Size in bytes of the received packet.
+ * @return int32_t Negative value on error.
+ */
+extern int32_t nrf24l01p_get_rx_pw(const struct nrf24l01p * const device, uint8_t pipe, uint8_t *rx_bytes_size);
+
+/**
+ * @brief Gets the size of the packet at the head of the RX FIFO. Uses R_RX_PL_WID when dynamic payload length is
+ * enabled for the pipe and RX_PW_Px otherwise
+ *
+ * @param device nRF24L01+ device definition.
+ * @param pipe Pipe that received the packet, as reported by STATUS RX_P_NO
+ * @param rx_bytes_size [out] Size in bytes of the received packet.
+ * @return int32_t Negative value on error. E_INVALID_CRC if the packet is corrupted and the RX FIFO must be flushed
+ */
+extern int32_t nrf24l01p_get_rx_payload_width(const struct nrf24l01p * const device, uint8_t pipe,
+    uint8_t *rx_bytes_size);
+
+/**
+ * @brief Sets the address packets are transmitted to. For auto-ack, PIPE0 must be set to the same address
+ *
+ * @param device nRF24L01+ device definition
+ * @param addr_size Address size. Must match the size configured in SETUP_AW
+ * @param addr Address
+ * @return int32_t Negative value on error
+ */
+extern int32_t nrf24l01p_set_tx_addr(const struct nrf24l01p * const device, uint8_t addr_size, const uint8_t * const addr);
+
+/**
+ * @brief Reads OBSERVE_TX: lost packets (PLOS_CNT) and retransmissions of the current packet (ARC_CNT)
+ *
+ * @param device nRF24L01+ device definition
+ * @param observe_tx [out] OBSERVE_TX register
+ * @return int32_t Negative value on error
+ */
+extern int32_t nrf24l01p_get_observe_tx(const struct nrf24l01p * const device, uint8_t *observe_tx);
+
 /**
  * @brief Gets nRF24L01+ FIFO status
  *
@@ -97,7 +225,7 @@ extern int32_t nrf24l01p_get_fifo_status(const struct nrf24l01p * const device,
  * @param device nRF24L01+ device definition
  * @param size Size, in bytes, of data to write. Up to 32 bytes
  * @param data Data to write
- * @return int32_t Negative value on error. If queue is full returns with E_TX_QUEUE_FULL
+ * @return int32_t Negative value on error. If queue was full the payload is discarded and returns with E_TX_QUEUE_FULL
  */
 extern int32_t nrf24l01p_w_tx_payload(const struct nrf24l01p * const device, uint32_t size, const void * const data);
 
@@ -111,6 +239,18 @@ extern int32_t nrf24l01p_w_tx_payload(const struct nrf24l01p * const device, uin
  */
 extern int32_t nrf24l01p_r_rx_payload(const struct nrf24l01p * const device, uint32_t size, void * const data);
 
+/**
+ * @brief Reads a packet from RX queue without copying it. The SPI transfer runs in place over frame: frame[0] holds
+ * the command and receives STATUS, the payload lands right after it
+ *
+ * @param device nRF24L01+ device definition
+ * @param size Size, in bytes, of data to read. Up to 32 bytes
+ * @param frame [in,out] Buffer of 1 + size bytes
+ * @return int32_t Negative value on error. If queue is empty returns with E_RX_QUEUE_EMPTY
+ */
+extern int32_t nrf24l01p_r_rx_payload_in_place(const struct nrf24l01p * const device, uint32_t size,
+    uint8_t * const frame);
+
 /**
  * @brief Clears TX queue
  *
@@ -142,4 +282,22 @@ extern int32_t nrf24l01p_enable_tx_mode(const struct nrf24l01p * const device);
 
 extern int32_t nrf24l01p_disable_tx_mode(const struct nrf24l01p * const device);
 
+/**
+ * @brief Keeps interrupt sources from driving the IRQ pin. Their STATUS flags are still set
+ *
+ * @param device nRF24L01+ device definition
+ * @param mask CONFIG_MASK_RX_DR, CONFIG_MASK_TX_DS and/or CONFIG_MASK_MAX_RT
+ * @return int32_t Negative value on error
+ */
+extern int32_t nrf24l01p_mask_irq(const struct nrf24l01p * const device, uint8_t mask);
+
+/**
+ * @brief Lets interrupt sources drive the IRQ pin
+ *
+ * @param device nRF24L01+ device definition
+ * @param mask CONFIG_MASK_RX_DR, CONFIG_MASK_TX_DS and/or CONFIG_MASK_MAX_RT
+ * @return int32_t Negative value on error
+ */
+extern int32_t nrf24l01p_unmask_irq(const struct nrf24l01p * const device, uint8_t mask);
+
 #endif // DRIVERS_NRF24L01P_NRF24L01P_H_
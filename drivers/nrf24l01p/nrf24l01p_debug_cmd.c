@@ -13,6 +13,10 @@
 #include "include/device/spi.h"
 
 #include "drivers/nrf24l01p/nrf24l01p.h"
+#include "drivers/nrf24l01p/nrf24l01p_rx.h"
+#include "drivers/nrf24l01p/nrf24l01p_tx.h"
+
+#include "libs/pbuf/pbuf.h"
 
 #include "ulibc/include/ustdio.h"
 #include "ulibc/include/log.h"
@@ -21,14 +25,21 @@
 
 #include "components/vez-shell/include/vez-shell.h"
 
+#include <stdlib.h>
+#include <string.h>
+
 #define TAG "nrf24l"
 
+// Kept between commands so that register changes do not need to read the register first
+static struct nrf24l01p_shadow nrf_shadow;
+
 int nrf24l01p(int argc, char **argv)
 {
     struct nrf24l01p nrf = {
         .spi_device = device_get_by_name("spi1"),
         .ce_gpio = device_get_by_name("nrf24l01p_ce"),
-        .cs_gpio = device_get_by_name("spi1_cs")
+        .cs_gpio = device_get_by_name("spi1_cs"),
+        .shadow = &nrf_shadow
     };
 
     nrf24l01p_default_setup(&nrf);
@@ -38,34 +49,94 @@ int nrf24l01p(int argc, char **argv)
 
 SHELL_DECLARE_COMMAND("nrf24l01p", nrf24l01p, "Initializes the nRF24L01+");
 
+int nrf24l01p_pipe(int argc, char **argv)
+{
+    struct nrf24l01p nrf = {
+        .spi_device = device_get_by_name("spi1"),
+        .ce_gpio = device_get_by_name("nrf24l01p_ce"),
+        .cs_gpio = device_get_by_name("spi1_cs"),
+        .shadow = &nrf_shadow
+    };
+    struct nrf24l01p_pipe_config config = {.enabled = 1, .auto_ack = 1, .dynamic_payload = 1};
+    uint8_t addr[5];
+    int32_t ret;
+
+    if (argc < 3) {
+        uprintf("Usage: %s <pipe> <address in hex, LSB first> [static width]\r\n", argv[0]);
+        ret = E_INVALID_PARAMETER;
+        goto exit;
+    }
+
+    uint8_t pipe = strtoul(argv[1], NULL, 10);
+    uint32_t addr_size = strlen(argv[2]) / 2;
+    if (addr_size == 0 || addr_size > sizeof(addr)) {
+        ret = E_INVALID_PARAMETER;
+        goto exit;
+    }
+    for (uint32_t i = 0; i < addr_size; i++) {
+        char byte[3] = {argv[2][2 * i], argv[2][2 * i + 1], '\0'};
+        addr[i] = strtoul(byte, NULL, 16);
+    }
+    if (argc > 3) {
+        config.dynamic_payload = 0;
+        config.width = strtoul(argv[3], NULL, 10);
+    }
+
+    ret = nrf24l01p_set_rx_addr(&nrf, pipe, addr_size, addr);
+    if (ret < 0) { goto exit; }
+    ret = nrf24l01p_configure_pipe(&nrf, pipe, &config);
+
+    exit:
+    return ret;
+}
+
+SHELL_DECLARE_COMMAND("nrf24l01p_pipe", nrf24l01p_pipe, "Configures and enables a pipe");
+
 int nrf24l01p_rx(int argc, char **argv)
 {
     struct nrf24l01p nrf = {
         .spi_device = device_get_by_name("spi1"),
         .ce_gpio = device_get_by_name("nrf24l01p_ce"),
-        .cs_gpio = device_get_by_name("spi1_cs")
+        .cs_gpio = device_get_by_name("spi1_cs"),
+        .shadow = &nrf_shadow
     };
     int32_t ret;
 
-    nrf24l01p_disable_tx_mode(&nrf);
-    ret = nrf24l01p_enable_rx_mode(&nrf);
+    ret = nrf24l01p_rx_start(&nrf);
+    if (ret < 0) { goto exit; }
+    ret = nrf24l01p_disable_tx_mode(&nrf);
+    if (ret < 0) { goto exit; }
+    ret = nrf24l01p_standby_1(&nrf);
     if (ret < 0) { goto exit; }
+    nrf24l01p_enable_receiver(&nrf);
 
     while (1) {
-        uint8_t sz;
-        ret = nrf24l01p_get_rx_pw_p0(&nrf, &sz);
-        if (ret < 0) { goto exit; }
-        DBG(TAG, "nrf24l01p_get_rx_pw_0() == %u", sz);
-        nrf24l01p_flush_rx(&nrf);
+        struct nrf24l01p_packet packet;
+        if (nrf24l01p_rx_receive(&packet, 250) == E_SUCCESS) {
+            uprintf("[%lu] pipe %u, %u bytes\r\n", packet.timestamp, packet.pipe, packet.buffer->size);
+            HEXDUMP(packet.buffer->payload, packet.buffer->size);
+            pbuf_free(packet.buffer);
+        }
 
         int c = ugetchar();
         if (c == 'q' || c == 'Q') break;
-        vTaskDelay(250);
     }
 
+    struct nrf24l01p_rx_stats stats;
+    nrf24l01p_rx_get_stats(&stats);
+    uprintf("irqs %lu, received %lu, dropped %lu, errors %lu\r\n", stats.irqs, stats.received, stats.dropped,
+        stats.errors);
+    for (int i = 0; i < NRF24L01P_PIPES; i++) {
+        uprintf("pipe %d: %lu packets\r\n", i, stats.pipe_received[i]);
+    }
+    const struct pbuf_pool *pool = nrf24l01p_rx_get_pool();
+    uprintf("buffers: %u of %u free, at least %u free, %lu allocation failures\r\n", pool->available, pool->count,
+        pool->min_available, pool->failures);
+
     exit:
 
-    nrf24l01p_disable_rx_mode(&nrf);
+    nrf24l01p_disable_receiver(&nrf);
+    nrf24l01p_rx_stop();
     return ret;
 }
 
@@ -76,24 +147,40 @@ int nrf24l01p_tx(int argc, char **argv)
     struct nrf24l01p nrf = {
         .spi_device = device_get_by_name("spi1"),
         .ce_gpio = device_get_by_name("nrf24l01p_ce"),
-        .cs_gpio = device_get_by_name("spi1_cs")
+        .cs_gpio = device_get_by_name("spi1_cs"),
+        .shadow = &nrf_shadow
     };
+    struct nrf24l01p_stream stream;
+    uint8_t payload[NRF24L01P_MAX_PAYLOAD];
+    uint32_t count = 1000;
     int32_t ret;
 
-    nrf24l01p_disable_rx_mode(&nrf);
-    ret = nrf24l01p_enable_tx_mode(&nrf);
+    if (argc > 1) count = strtoul(argv[1], NULL, 10);
+
+    nrf24l01p_disable_receiver(&nrf);
+    ret = nrf24l01p_standby_1(&nrf);
+    if (ret < 0) { goto exit; }
+    ret = nrf24l01p_stream_start(&nrf, &stream);
     if (ret < 0) { goto exit; }
 
-    while (1) {
-        int c = ugetchar();
-        if (c == 'q' || c == 'Q') break;
-        vTaskDelay(250);
+    for (uint32_t i = 0; i < count; i++) {
+        memset(payload, i, sizeof(payload));
+        ret = nrf24l01p_stream_write(&nrf, &stream, sizeof(payload), payload, 100);
+        if (ret < 0) {
+            uprintf("Packet %lu failed: %s\r\n", i, error_to_str(ret));
+            if (ret != E_TIMEOUT) break;
+        }
     }
 
+    ret = nrf24l01p_stream_stop(&nrf, &stream, 100);
+    uprintf("%lu of %lu packets acknowledged in %lu ms: %lu packets/s, %lu MAX_RT (%lu discarded), ARC %lu/%lu samples\r\n",
+        stream.packets, stream.written, stream.stop_tick - stream.start_tick, nrf24l01p_stream_rate(&stream),
+        stream.max_rt, stream.discarded, stream.arc_sum, stream.arc_samples);
+
     exit:
 
     nrf24l01p_disable_tx_mode(&nrf);
     return ret;
 }
 
-SHELL_DECLARE_COMMAND("nrf24l01p_tx", nrf24l01p_tx, "Transmits a packet");
+SHELL_DECLARE_COMMAND("nrf24l01p_tx", nrf24l01p_tx, "Streams [count] packets and reports the rate");
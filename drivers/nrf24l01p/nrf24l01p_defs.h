@@ -44,6 +44,7 @@
 
 #define NRF24L01P_REG_SETUP_RETR    0x04
 #define SETUP_RETR_ARD_MSK          0b11110000
+#define SETUP_RETR_ARD_SHIFT        4
 #define SETUP_RETR_ARC_MSK          0b00001111
 
 #define NRF24L01P_REG_RF_CH         0x05
@@ -65,10 +66,13 @@
 #define STATUS_TX_DS                BIT(5)
 #define STATUS_MAX_RT               BIT(4)
 #define STATUS_RX_P_NO_MSK          0b00001110
+#define STATUS_RX_P_NO_SHIFT        1
+#define STATUS_RX_P_NO_EMPTY        7
 #define STATUS_TX_FULL              BIT(0)
 
 #define NRF24L01P_REG_OBSERVE_TX    0x08
 #define OBSERVE_TX_PLOS_CNT_MASK    0b11110000
+#define OBSERVE_TX_PLOS_CNT_SHIFT   4
 #define OBSERVE_TX_ARC_CNT          0b00001111
 
 #define NRF24L01P_REG_RPD           0x09
@@ -88,6 +92,7 @@
 #define NRF24L01P_REG_RX_PW_P3      0x14
 #define NRF24L01P_REG_RX_PW_P4      0x15
 #define NRF24L01P_REG_RX_PW_P5      0x16
+#define RX_PW_MSK                   0b00111111
 
 #define NRF24L01P_REG_FIFO_STATUS   0x17
 #define FIFO_STATUS_TX_REUSE        BIT(6)
@@ -0,0 +1,688 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#include "drivers/nrf24l01p/nrf24l01p_emu.h"
+#include "drivers/nrf24l01p/nrf24l01p_defs.h"
+
+#include "include/errors.h"
+#include "include/device/gpio.h"
+#include "include/device/spi.h"
+#include "include/device/transaction.h"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#define CMD_R_REGISTER          0b00000000
+#define CMD_W_REGISTER          0b00100000
+#define CMD_REGISTER_MSK        0b11100000
+#define CMD_R_RX_PL_WID         0b01100000
+#define CMD_R_RX_PAYLOAD        0b01100001
+#define CMD_W_TX_PAYLOAD        0b10100000
+#define CMD_W_TX_PAYLOAD_NOACK  0b10110000
+#define CMD_FLUSH_TX            0b11100001
+#define CMD_FLUSH_RX            0b11100010
+
+#define STATUS_IRQ_MSK          (STATUS_RX_DR | STATUS_TX_DS | STATUS_MAX_RT)
+
+/** PLL settling time before every packet */
+#define SETTLE_NS               130000ULL
+
+/** Index of each address in struct nrf24l01p_emu addr[] */
+#define ADDR_P0                 0
+#define ADDR_P1                 1
+#define ADDR_TX                 2
+
+static struct nrf24l01p_emu *peer_of(const struct nrf24l01p_emu * const emu)
+{
+    return emu->channel->radios[0] == emu ? emu->channel->radios[1] : emu->channel->radios[0];
+}
+
+static uint32_t random_next(struct nrf24l01p_emu_channel * const channel)
+{
+    // xorshift32
+    uint32_t x = channel->rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    channel->rng = x;
+    return x;
+}
+
+static uint32_t address_width(const struct nrf24l01p_emu * const emu)
+{
+    return (emu->regs[NRF24L01P_REG_SETUP_AW] & SETUP_AW_AW_MASK) + 2;
+}
+
+static uint32_t data_rate(const struct nrf24l01p_emu * const emu)
+{
+    if (emu->regs[NRF24L01P_REG_RF_SETUP] & RF_SETUP_RF_DR_LOW) return 250000;
+    if (emu->regs[NRF24L01P_REG_RF_SETUP] & RF_SETUP_RF_DR_HIGH) return 2000000;
+    return 1000000;
+}
+
+/** Size of a packet on air in bits: preamble, address, 9 bits packet control field, payload and CRC */
+static uint32_t air_bits(const struct nrf24l01p_emu * const emu, uint32_t payload)
+{
+    uint32_t crc = emu->regs[NRF24L01P_REG_CONFIG] & CONFIG_CRO ? 2 : 1;
+    return 8 * (1 + address_width(emu) + payload + crc) + 9;
+}
+
+/** Time from the start of a transmission until the last bit is on air */
+static uint64_t air_time_ns(const struct nrf24l01p_emu * const emu, uint32_t payload)
+{
+    return SETTLE_NS + (uint64_t)air_bits(emu, payload) * 1000000000ULL / data_rate(emu);
+}
+
+static uint64_t retransmit_delay_ns(const struct nrf24l01p_emu * const emu)
+{
+    return ((emu->regs[NRF24L01P_REG_SETUP_RETR] >> SETUP_RETR_ARD_SHIFT) + 1) * 250000ULL;
+}
+
+/**
+ * @brief Decides whether a packet survives the channel
+ *
+ * @return uint32_t Non-zero if the packet arrives intact
+ */
+static uint32_t channel_pass(struct nrf24l01p_emu_channel * const channel, uint32_t bits)
+{
+    channel->frames++;
+
+    if (random_next(channel) % 1000 < channel->loss_per_mille) {
+        channel->lost++;
+        return 0;
+    }
+
+    uint64_t error_ppm = (uint64_t)bits * channel->bit_error_ppm;
+    if (error_ppm > 1000000) error_ppm = 1000000;
+    if (random_next(channel) % 1000000 < error_ppm) {
+        channel->corrupted++;
+        return 0;
+    }
+
+    return 1;
+}
+
+static uint8_t status(const struct nrf24l01p_emu * const emu)
+{
+    uint8_t st = emu->regs[NRF24L01P_REG_STATUS] & STATUS_IRQ_MSK;
+    st |= (emu->rx_count ? emu->rx_fifo[0].pipe : STATUS_RX_P_NO_EMPTY) << STATUS_RX_P_NO_SHIFT;
+    if (emu->tx_count == NRF24L01P_EMU_FIFO_DEPTH) st |= STATUS_TX_FULL;
+    return st;
+}
+
+static uint8_t fifo_status(const struct nrf24l01p_emu * const emu)
+{
+    uint8_t st = 0;
+    if (emu->tx_count == NRF24L01P_EMU_FIFO_DEPTH) st |= FIFO_STATUS_TX_FULL;
+    if (emu->tx_count == 0) st |= FIFO_STATUS_TX_EMPTY;
+    if (emu->rx_count == NRF24L01P_EMU_FIFO_DEPTH) st |= FIFO_STATUS_RX_FULL;
+    if (emu->rx_count == 0) st |= FIFO_STATUS_RX_EMPTY;
+    return st;
+}
+
+/**
+ * @brief Updates the IRQ pin and calls irq_handler on its falling edge
+ */
+static void update_irq(struct nrf24l01p_emu * const emu)
+{
+    uint8_t config = emu->regs[NRF24L01P_REG_CONFIG];
+    uint8_t flags = emu->regs[NRF24L01P_REG_STATUS];
+    uint32_t active = ((flags & STATUS_RX_DR) && !(config & CONFIG_MASK_RX_DR)) ||
+        ((flags & STATUS_TX_DS) && !(config & CONFIG_MASK_TX_DS)) ||
+        ((flags & STATUS_MAX_RT) && !(config & CONFIG_MASK_MAX_RT));
+
+    if (active && !emu->irq && emu->irq_handler != NULL) {
+        emu->irq = active;
+        emu->irq_handler(emu->irq_arg);
+    }
+    emu->irq = active;
+}
+
+static void set_flag(struct nrf24l01p_emu * const emu, uint8_t flag)
+{
+    emu->regs[NRF24L01P_REG_STATUS] |= flag;
+    update_irq(emu);
+}
+
+static void fifo_pop(struct nrf24l01p_emu_fifo_entry * const fifo, uint32_t * const count)
+{
+    if (*count == 0) return;
+    memmove(&fifo[0], &fifo[1], (NRF24L01P_EMU_FIFO_DEPTH - 1) * sizeof(fifo[0]));
+    (*count)--;
+}
+
+/**
+ * @brief Checks whether a pipe of the receiver listens to the transmitter address
+ *
+ * @return int32_t Pipe number or negative if no pipe matches
+ */
+static int32_t match_pipe(const struct nrf24l01p_emu * const rx, const struct nrf24l01p_emu * const tx)
+{
+    const uint32_t aw = address_width(rx);
+    const uint8_t *tx_addr = tx->addr[ADDR_TX];
+
+    if (aw != address_width(tx)) return -1;
+
+    for (int32_t pipe = 0; pipe < 6; pipe++) {
+        if (!(rx->regs[NRF24L01P_REG_EN_RXADDR] & (1 << pipe))) continue;
+
+        if (pipe < 2) {
+            if (memcmp(rx->addr[pipe], tx_addr, aw) == 0) return pipe;
+        } else {
+            // Pipes 2 to 5 only own the LSB. Other bytes come from pipe 1
+            if (rx->regs[NRF24L01P_REG_RX_ADDR_P0 + pipe] == tx_addr[0] &&
+                memcmp(&rx->addr[ADDR_P1][1], &tx_addr[1], aw - 1) == 0) return pipe;
+        }
+    }
+
+    return -1;
+}
+
+/**
+ * @brief Hands a packet to the receiver
+ *
+ * @return uint32_t Non-zero if the receiver acknowledges it
+ */
+static uint32_t receive_packet(struct nrf24l01p_emu * const rx, const struct nrf24l01p_emu * const tx,
+    const struct nrf24l01p_emu_fifo_entry * const entry)
+{
+    const uint8_t config = rx->regs[NRF24L01P_REG_CONFIG];
+
+    if (!(config & CONFIG_PWR_UP) || !(config & CONFIG_PRIM_RX) || !rx->ce) return 0;
+    if (rx->regs[NRF24L01P_REG_RF_CH] != tx->regs[NRF24L01P_REG_RF_CH]) return 0;
+    if (data_rate(rx) != data_rate(tx)) return 0;
+
+    int32_t pipe = match_pipe(rx, tx);
+    if (pipe < 0) return 0;
+
+    const uint32_t dynamic = (rx->regs[NRF24L01P_REG_FEATURE] & FEATURE_EN_DPL) &&
+        (rx->regs[NRF24L01P_REG_DYNPD] & (1 << pipe));
+    // A static width that does not match the packet fails the CRC check
+    if (!dynamic && (rx->regs[NRF24L01P_REG_RX_PW_P0 + pipe] & RX_PW_MSK) != entry->size) return 0;
+
+    const uint32_t ack = (rx->regs[NRF24L01P_REG_EN_AA] & (1 << pipe)) && !entry->no_ack;
+    uint16_t sum = entry->size;
+    for (uint32_t i = 0; i < entry->size; i++) sum = (sum << 1 | sum >> 15) ^ entry->data[i];
+
+    // A retransmission of a packet whose ACK got lost: acknowledged again but not stored
+    if (ack && rx->last_pid[pipe] == tx->pid && rx->last_sum[pipe] == sum) {
+        rx->rx_duplicates++;
+        return 1;
+    }
+
+    if (rx->rx_count == NRF24L01P_EMU_FIFO_DEPTH) {
+        rx->rx_overflows++;
+        return 0;
+    }
+
+    rx->rx_packets++;
+    rx->rx_fifo[rx->rx_count] = *entry;
+    rx->rx_fifo[rx->rx_count].pipe = pipe;
+    if (rx->invalid_pipe_period && (rx->rx_packets % rx->invalid_pipe_period) == 0) {
+        rx->rx_fifo[rx->rx_count].pipe = 6;
+    }
+    rx->rx_count++;
+    rx->last_pid[pipe] = tx->pid;
+    rx->last_sum[pipe] = sum;
+    set_flag(rx, STATUS_RX_DR);
+
+    return ack;
+}
+
+static void start_attempt(struct nrf24l01p_emu * const emu, uint64_t t)
+{
+    emu->tx_attempts++;
+    emu->tx_end_ns = t + air_time_ns(emu, emu->tx_fifo[0].size);
+    emu->event_ns = emu->tx_end_ns + emu->channel->latency_us * 1000ULL;
+    emu->tx_state = NRF24L01P_EMU_TX_AIR;
+}
+
+/**
+ * @brief Starts transmitting the next payload if the radio is a powered up PTX with CE HIGH
+ */
+static void check_start(struct nrf24l01p_emu * const emu, uint64_t t)
+{
+    const uint8_t config = emu->regs[NRF24L01P_REG_CONFIG];
+
+    if (emu->tx_state != NRF24L01P_EMU_TX_IDLE || emu->tx_count == 0 || !emu->ce) return;
+    if (!(config & CONFIG_PWR_UP) || (config & CONFIG_PRIM_RX)) return;
+    // Transmission halts while MAX_RT is set
+    if (emu->regs[NRF24L01P_REG_STATUS] & STATUS_MAX_RT) return;
+
+    emu->pid = (emu->pid + 1) & 0x03;
+    emu->arc_cnt = 0;
+    start_attempt(emu, t);
+}
+
+static void payload_done(struct nrf24l01p_emu * const emu, uint64_t t)
+{
+    fifo_pop(emu->tx_fifo, &emu->tx_count);
+    emu->tx_packets++;
+    emu->tx_state = NRF24L01P_EMU_TX_IDLE;
+    set_flag(emu, STATUS_TX_DS);
+    check_start(emu, t);
+}
+
+static void process_event(struct nrf24l01p_emu * const emu)
+{
+    struct nrf24l01p_emu_channel *channel = emu->channel;
+    const uint64_t t = emu->event_ns;
+
+    switch (emu->tx_state) {
+        case NRF24L01P_EMU_TX_AIR: {
+            const struct nrf24l01p_emu_fifo_entry *entry = &emu->tx_fifo[0];
+            const uint32_t wants_ack = (emu->regs[NRF24L01P_REG_EN_AA] & EN_AA_ENNA_P0) && !entry->no_ack;
+            uint32_t acked = 0;
+
+            if (channel_pass(channel, air_bits(emu, entry->size))) {
+                acked = receive_packet(peer_of(emu), emu, entry);
+            }
+
+            if (!wants_ack) {
+                payload_done(emu, t);
+                break;
+            }
+
+            // The ACK goes back to pipe 0 of the transmitter
+            uint64_t ack_arrival = t + air_time_ns(emu, 0) + channel->latency_us * 1000ULL;
+            if (acked && channel_pass(channel, air_bits(emu, 0)) &&
+                memcmp(emu->addr[ADDR_P0], emu->addr[ADDR_TX], address_width(emu)) == 0 &&
+                ack_arrival <= emu->tx_end_ns + retransmit_delay_ns(emu)) {
+                emu->tx_state = NRF24L01P_EMU_TX_ACK;
+                emu->event_ns = ack_arrival;
+            } else {
+                emu->tx_state = NRF24L01P_EMU_TX_RETRY;
+                emu->event_ns = emu->tx_end_ns + retransmit_delay_ns(emu);
+            }
+            break;
+        }
+
+        case NRF24L01P_EMU_TX_ACK: {
+            payload_done(emu, t);
+            break;
+        }
+
+        case NRF24L01P_EMU_TX_RETRY: {
+            if (emu->arc_cnt >= (emu->regs[NRF24L01P_REG_SETUP_RETR] & SETUP_RETR_ARC_MSK)) {
+                if (emu->plos_cnt < 15) emu->plos_cnt++;
+                emu->tx_state = NRF24L01P_EMU_TX_IDLE;
+                set_flag(emu, STATUS_MAX_RT);
+                break;
+            }
+            emu->arc_cnt++;
+            start_attempt(emu, t);
+            break;
+        }
+
+        default: break;
+    }
+}
+
+/**
+ * @brief Processes every air event up to the channel clock, in time order
+ */
+static void run(struct nrf24l01p_emu_channel * const channel)
+{
+    // Events may raise IRQs, whose handlers must not re-enter
+    if (channel->running) return;
+    channel->running = 1;
+
+    while (1) {
+        struct nrf24l01p_emu *next = NULL;
+        for (int i = 0; i < 2; i++) {
+            struct nrf24l01p_emu *emu = channel->radios[i];
+            if (emu->tx_state == NRF24L01P_EMU_TX_IDLE || emu->event_ns > channel->now_ns) continue;
+            if (next == NULL || emu->event_ns < next->event_ns) next = emu;
+        }
+        if (next == NULL) break;
+        process_event(next);
+    }
+
+    channel->running = 0;
+}
+
+static void write_register(struct nrf24l01p_emu * const emu, uint8_t addr, const uint8_t * const data, uint32_t size)
+{
+    if (size == 0) return;
+
+    switch (addr) {
+        case NRF24L01P_REG_STATUS: {
+            // Flags are cleared by writing 1
+            emu->regs[addr] &= ~(data[0] & STATUS_IRQ_MSK);
+            update_irq(emu);
+            break;
+        }
+        case NRF24L01P_REG_RX_ADDR_P0:
+        case NRF24L01P_REG_RX_ADDR_P1:
+        case NRF24L01P_REG_TX_ADDR: {
+            int index = addr == NRF24L01P_REG_TX_ADDR ? ADDR_TX : addr - NRF24L01P_REG_RX_ADDR_P0;
+            memcpy(emu->addr[index], data, size > 5 ? 5 : size);
+            break;
+        }
+        case NRF24L01P_REG_RF_CH: {
+            emu->regs[addr] = data[0];
+            emu->plos_cnt = 0;
+            break;
+        }
+        case NRF24L01P_REG_OBSERVE_TX:
+        case NRF24L01P_REG_RPD:
+        case NRF24L01P_REG_FIFO_STATUS: break;
+        default: {
+            if (addr < NRF24L01P_EMU_REGISTERS) emu->regs[addr] = data[0];
+            if (addr == NRF24L01P_REG_CONFIG) update_irq(emu);
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Fills the bytes clocked out after the command byte
+ */
+static void prepare_output(struct nrf24l01p_emu * const emu, uint8_t cmd)
+{
+    memset(&emu->out[1], 0x00, sizeof(emu->out) - 1);
+    emu->out_len = sizeof(emu->out);
+
+    if ((cmd & CMD_REGISTER_MSK) == CMD_R_REGISTER) {
+        uint8_t addr = cmd & ~CMD_REGISTER_MSK;
+        switch (addr) {
+            case NRF24L01P_REG_RX_ADDR_P0:
+            case NRF24L01P_REG_RX_ADDR_P1:
+            case NRF24L01P_REG_TX_ADDR: {
+                int index = addr == NRF24L01P_REG_TX_ADDR ? ADDR_TX : addr - NRF24L01P_REG_RX_ADDR_P0;
+                memcpy(&emu->out[1], emu->addr[index], 5);
+                break;
+            }
+            case NRF24L01P_REG_STATUS: emu->out[1] = status(emu); break;
+            case NRF24L01P_REG_FIFO_STATUS: emu->out[1] = fifo_status(emu); break;
+            case NRF24L01P_REG_OBSERVE_TX: emu->out[1] = emu->plos_cnt << OBSERVE_TX_PLOS_CNT_SHIFT | emu->arc_cnt; break;
+            default: if (addr < NRF24L01P_EMU_REGISTERS) emu->out[1] = emu->regs[addr]; break;
+        }
+    } else if (cmd == CMD_R_RX_PAYLOAD && emu->rx_count) {
+        memcpy(&emu->out[1], emu->rx_fifo[0].data, emu->rx_fifo[0].size);
+    } else if (cmd == CMD_R_RX_PL_WID && emu->rx_count) {
+        emu->out[1] = emu->rx_fifo[0].size;
+    }
+}
+
+/**
+ * @brief Executes the command received while CS was LOW
+ */
+static void execute_command(struct nrf24l01p_emu * const emu)
+{
+    if (emu->cmd_len == 0) return;
+
+    const uint8_t cmd = emu->cmd[0];
+    const uint32_t size = emu->cmd_len - 1;
+
+    if ((cmd & CMD_REGISTER_MSK) == CMD_W_REGISTER) {
+        write_register(emu, cmd & ~CMD_REGISTER_MSK, &emu->cmd[1], size);
+    } else if (cmd == CMD_W_TX_PAYLOAD || cmd == CMD_W_TX_PAYLOAD_NOACK) {
+        // A payload written to a full TX FIFO is discarded
+        if (emu->tx_count < NRF24L01P_EMU_FIFO_DEPTH && size > 0) {
+            struct nrf24l01p_emu_fifo_entry *entry = &emu->tx_fifo[emu->tx_count++];
+            entry->size = size;
+            entry->no_ack = cmd == CMD_W_TX_PAYLOAD_NOACK;
+            memcpy(entry->data, &emu->cmd[1], size);
+        }
+    } else if (cmd == CMD_R_RX_PAYLOAD) {
+        if (size > 0) fifo_pop(emu->rx_fifo, &emu->rx_count);
+    } else if (cmd == CMD_FLUSH_TX) {
+        emu->tx_count = 0;
+    } else if (cmd == CMD_FLUSH_RX) {
+        emu->rx_count = 0;
+    }
+
+    check_start(emu, emu->channel->now_ns);
+}
+
+/**
+ * @brief Full duplex exchange of one byte. STATUS is clocked out with the command byte
+ */
+static uint8_t exchange(struct nrf24l01p_emu * const emu, uint8_t in)
+{
+    uint8_t out = 0xff;
+
+    emu->channel->now_ns += emu->channel->spi_byte_ns;
+    run(emu->channel);
+
+    if (!emu->cs_low) return out;
+
+    if (emu->cmd_len == 0) {
+        out = status(emu);
+        prepare_output(emu, in);
+    } else if (emu->cmd_len < emu->out_len) {
+        out = emu->out[emu->cmd_len];
+    }
+
+    if (emu->cmd_len < sizeof(emu->cmd)) emu->cmd[emu->cmd_len++] = in;
+
+    return out;
+}
+
+static int32_t emu_spi_init(const struct spi_device * const spi)
+{
+    (void)spi;
+    return E_SUCCESS;
+}
+
+static int32_t emu_spi_write(const struct spi_device * const spi, const void *data, uint32_t size, uint32_t timeout)
+{
+    (void)timeout;
+    struct nrf24l01p_emu *emu = (struct nrf24l01p_emu *)spi->priv;
+    const uint8_t *udata = (const uint8_t *)data;
+
+    for (uint32_t i = 0; i < size; i++) exchange(emu, udata[i]);
+
+    return size;
+}
+
+static int32_t emu_spi_read(const struct spi_device * const spi, void *data, uint32_t size, uint32_t timeout)
+{
+    (void)timeout;
+    struct nrf24l01p_emu *emu = (struct nrf24l01p_emu *)spi->priv;
+    uint8_t *udata = (uint8_t *)data;
+
+    for (uint32_t i = 0; i < size; i++) udata[i] = exchange(emu, 0xff);
+
+    return size;
+}
+
+static int32_t emu_spi_transact(const struct spi_device * const spi, struct spi_transaction * const transaction,
+    uint32_t timeout)
+{
+    (void)timeout;
+    struct nrf24l01p_emu *emu = (struct nrf24l01p_emu *)spi->priv;
+    const uint8_t *wdata = (const uint8_t *)transaction->write_data;
+    uint8_t *rdata = (uint8_t *)transaction->read_data;
+    uint32_t size = transaction->write_size > transaction->read_size ? transaction->write_size : transaction->read_size;
+
+    for (uint32_t i = 0; i < size; i++) {
+        uint8_t out = exchange(emu, i < transaction->write_size ? wdata[i] : 0xff);
+        if (i < transaction->read_size) rdata[i] = out;
+    }
+
+    return E_SUCCESS;
+}
+
+const struct spi_operations nrf24l01p_emu_spi_ops = {
+    .spi_init = emu_spi_init,
+    .spi_write_op = emu_spi_write,
+    .spi_read_op = emu_spi_read,
+    .spi_transact_op = emu_spi_transact,
+};
+
+static int32_t emu_gpio_init(const struct gpio_device * const gpio)
+{
+    (void)gpio;
+    return E_SUCCESS;
+}
+
+static void emu_cs_write(const struct gpio_device * const gpio, int32_t value)
+{
+    struct nrf24l01p_emu *emu = (struct nrf24l01p_emu *)gpio->priv;
+    uint32_t cs_low = (value == GPIO_LOW);
+
+    // Commands are executed on the rising edge of CS
+    if (emu->cs_low && !cs_low) execute_command(emu);
+    if (!emu->cs_low && cs_low) emu->cmd_len = 0;
+    emu->cs_low = cs_low;
+}
+
+static int32_t emu_cs_read(const struct gpio_device * const gpio)
+{
+    const struct nrf24l01p_emu *emu = (const struct nrf24l01p_emu *)gpio->priv;
+    return !emu->cs_low;
+}
+
+static void emu_cs_toggle(const struct gpio_device * const gpio)
+{
+    emu_cs_write(gpio, emu_cs_read(gpio) ? GPIO_LOW : GPIO_HIGH);
+}
+
+const struct gpio_operations nrf24l01p_emu_cs_ops = {
+    .gpio_init = emu_gpio_init,
+    .gpio_write_op = emu_cs_write,
+    .gpio_read_op = emu_cs_read,
+    .gpio_toggle_op = emu_cs_toggle,
+};
+
+static void emu_ce_write(const struct gpio_device * const gpio, int32_t value)
+{
+    struct nrf24l01p_emu *emu = (struct nrf24l01p_emu *)gpio->priv;
+
+    emu->ce = (value != GPIO_LOW);
+    check_start(emu, emu->channel->now_ns);
+}
+
+static int32_t emu_ce_read(const struct gpio_device * const gpio)
+{
+    const struct nrf24l01p_emu *emu = (const struct nrf24l01p_emu *)gpio->priv;
+    return emu->ce;
+}
+
+static void emu_ce_toggle(const struct gpio_device * const gpio)
+{
+    emu_ce_write(gpio, emu_ce_read(gpio) ? GPIO_LOW : GPIO_HIGH);
+}
+
+const struct gpio_operations nrf24l01p_emu_ce_ops = {
+    .gpio_init = emu_gpio_init,
+    .gpio_write_op = emu_ce_write,
+    .gpio_read_op = emu_ce_read,
+    .gpio_toggle_op = emu_ce_toggle,
+};
+
+static void emu_irq_write(const struct gpio_device * const gpio, int32_t value)
+{
+    (void)gpio;
+    (void)value;
+}
+
+static int32_t emu_irq_read(const struct gpio_device * const gpio)
+{
+    const struct nrf24l01p_emu *emu = (const struct nrf24l01p_emu *)gpio->priv;
+    // IRQ is active LOW
+    return !emu->irq;
+}
+
+static void emu_irq_toggle(const struct gpio_device * const gpio)
+{
+    (void)gpio;
+}
+
+const struct gpio_operations nrf24l01p_emu_irq_ops = {
+    .gpio_init = emu_gpio_init,
+    .gpio_write_op = emu_irq_write,
+    .gpio_read_op = emu_irq_read,
+    .gpio_toggle_op = emu_irq_toggle,
+};
+
+/**
+ * @brief Puts a radio in its power on state
+ */
+static void reset(struct nrf24l01p_emu * const emu, struct nrf24l01p_emu_channel * const channel)
+{
+    static const uint8_t reset_regs[NRF24L01P_EMU_REGISTERS] = {
+        [NRF24L01P_REG_CONFIG] = 0x08,
+        [NRF24L01P_REG_EN_AA] = 0x3f,
+        [NRF24L01P_REG_EN_RXADDR] = 0x03,
+        [NRF24L01P_REG_SETUP_AW] = 0x03,
+        [NRF24L01P_REG_SETUP_RETR] = 0x03,
+        [NRF24L01P_REG_RF_CH] = 0x02,
+        [NRF24L01P_REG_RF_SETUP] = 0x0e,
+        [NRF24L01P_REG_RX_ADDR_P2] = 0xc3,
+        [NRF24L01P_REG_RX_ADDR_P3] = 0xc4,
+        [NRF24L01P_REG_RX_ADDR_P4] = 0xc5,
+        [NRF24L01P_REG_RX_ADDR_P5] = 0xc6,
+    };
+
+    memcpy(emu->regs, reset_regs, sizeof(emu->regs));
+    memset(emu->addr[ADDR_P0], 0xe7, 5);
+    memset(emu->addr[ADDR_P1], 0xc2, 5);
+    memset(emu->addr[ADDR_TX], 0xe7, 5);
+
+    emu->channel = channel;
+    emu->tx_packets = 0;
+    emu->tx_attempts = 0;
+    emu->rx_packets = 0;
+    emu->rx_duplicates = 0;
+    emu->rx_overflows = 0;
+    emu->cs_low = 0;
+    emu->ce = 0;
+    emu->irq = 0;
+    emu->cmd_len = 0;
+    emu->out_len = 0;
+    emu->tx_count = 0;
+    emu->rx_count = 0;
+    emu->tx_state = NRF24L01P_EMU_TX_IDLE;
+    emu->pid = 0;
+    emu->arc_cnt = 0;
+    emu->plos_cnt = 0;
+    // No PID matches 0xff: the first packet of each pipe is never taken as a duplicate
+    memset(emu->last_pid, 0xff, sizeof(emu->last_pid));
+    memset(emu->last_sum, 0x00, sizeof(emu->last_sum));
+}
+
+int32_t nrf24l01p_emu_connect(struct nrf24l01p_emu_channel * const channel, struct nrf24l01p_emu * const a,
+    struct nrf24l01p_emu * const b)
+{
+    int32_t ret = E_SUCCESS;
+
+    if (channel == NULL || a == NULL || b == NULL || a == b) {
+        ret = E_INVALID_PARAMETER;
+        goto exit;
+    }
+
+    channel->frames = 0;
+    channel->lost = 0;
+    channel->corrupted = 0;
+    channel->now_ns = 0;
+    channel->rng = channel->seed ? channel->seed : 1;
+    channel->running = 0;
+    channel->radios[0] = a;
+    channel->radios[1] = b;
+
+    reset(a, channel);
+    reset(b, channel);
+
+    exit:
+    return ret;
+}
+
+void nrf24l01p_emu_advance(struct nrf24l01p_emu_channel * const channel, uint64_t ns)
+{
+    channel->now_ns += ns;
+    run(channel);
+}
+
+uint64_t nrf24l01p_emu_now(const struct nrf24l01p_emu_channel * const channel)
+{
+    return channel->now_ns;
+}
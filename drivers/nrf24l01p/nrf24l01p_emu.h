@@ -0,0 +1,171 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#ifndef DRIVERS_NRF24L01P_NRF24L01P_EMU_H_
+#define DRIVERS_NRF24L01P_NRF24L01P_EMU_H_
+
+#include "include/device/gpio.h"
+#include "include/device/spi.h"
+
+#include <stdint.h>
+
+/**
+ * @brief Host-side emulation of a pair of nRF24L01+ radios.
+ *
+ * Each radio provides a spi_device and gpio_devices for CS, CE and the IRQ pin, so the driver in nrf24l01p.c runs
+ * unmodified on top of it:
+ *
+ *     static struct nrf24l01p_emu_channel channel = {.latency_us = 1, .loss_per_mille = 10, .spi_byte_ns = 1000};
+ *     static struct nrf24l01p_emu radio_a, radio_b;
+ *     const struct spi_device spi_a = {.ops = &nrf24l01p_emu_spi_ops, .priv = &radio_a};
+ *     const struct gpio_device cs_a = {.ops = &nrf24l01p_emu_cs_ops, .priv = &radio_a};
+ *     const struct gpio_device ce_a = {.ops = &nrf24l01p_emu_ce_ops, .priv = &radio_a};
+ *     nrf24l01p_emu_connect(&channel, &radio_a, &radio_b);
+ *
+ * Time is virtual: every SPI byte advances the channel clock by spi_byte_ns and nrf24l01p_emu_advance() advances it
+ * by any amount (e.g. from a vTaskDelay() stub). Air time follows the configured data rate, address width, CRC and
+ * payload, plus 130µs of settling for every packet. Enhanced ShockBurst is emulated: auto-ack with PID based
+ * duplicate detection, auto-retransmit after ARD and MAX_RT after ARC retransmissions. A packet or ACK is lost with
+ * loss_per_mille probability, or corrupted (and dropped by the CRC check) with a probability given by bit_error_ppm
+ * and its length in bits. With the same seed, a run is fully reproducible.
+ *
+ * Not emulated: ACK payloads, REUSE_TX_PL, RPD and the power-up delay.
+ *
+ * tests/nrf24l01p_emu_test.c runs the streaming transmitter and the RX service over it (make -C tests).
+ */
+
+/** Number of registers in the register map */
+#define NRF24L01P_EMU_REGISTERS 0x1e
+
+/** Depth of the TX and RX FIFOs */
+#define NRF24L01P_EMU_FIFO_DEPTH 3
+
+/** Channel model connecting two radios */
+struct nrf24l01p_emu_channel {
+    /* Configuration. Must be filled before nrf24l01p_emu_connect() */
+
+    uint32_t latency_us;        /** Delay added to every packet and ACK. Counts twice against ARD */
+    uint32_t loss_per_mille;    /** Probability, in 1/1000, of a packet or ACK being lost */
+    uint32_t bit_error_ppm;     /** Bit error rate in parts per million. A corrupted packet fails its CRC */
+    uint32_t spi_byte_ns;       /** Time taken by each SPI byte (1000 for a 8MHz SPI) */
+    uint32_t seed;              /** Seed of the random generator. Zero is replaced by 1 */
+
+    /* Statistics */
+
+    uint32_t frames;            /** Packets and ACKs put on air */
+    uint32_t lost;              /** Packets and ACKs lost */
+    uint32_t corrupted;         /** Packets and ACKs dropped because of bit errors */
+
+    /* Private state. Do not touch */
+
+    uint64_t now_ns;
+    uint32_t rng;
+    uint32_t running;
+    struct nrf24l01p_emu *radios[2];
+};
+
+/** State of the transmitter of an emulated radio */
+enum nrf24l01p_emu_tx_state {
+    NRF24L01P_EMU_TX_IDLE,      /** Not transmitting */
+    NRF24L01P_EMU_TX_AIR,       /** Packet on air, arrives at the peer on event_ns */
+    NRF24L01P_EMU_TX_ACK,       /** Waiting for ACK, which arrives on event_ns */
+    NRF24L01P_EMU_TX_RETRY,     /** ACK did not arrive, retransmits on event_ns */
+};
+
+struct nrf24l01p_emu_fifo_entry {
+    uint8_t data[32];
+    uint8_t size;
+    uint8_t pipe;               /** RX: pipe that received it */
+    uint8_t no_ack;             /** TX: written with W_TX_PAYLOAD_NOACK */
+};
+
+struct nrf24l01p_emu {
+    /**
+     * @brief Called on the falling edge of the IRQ pin. Must not access the radio: it runs in the middle of an
+     * SPI transfer or of nrf24l01p_emu_advance()
+     */
+    void (*irq_handler)(void *arg);
+    void *irq_arg;
+
+    /** Every Nth packet put in the RX FIFO reports the unused pipe number 6 in STATUS. Zero disables it */
+    uint32_t invalid_pipe_period;
+
+    /* Statistics */
+
+    uint32_t tx_packets;        /** Payloads acknowledged (or sent, without auto-ack) */
+    uint32_t tx_attempts;       /** Transmissions including retransmissions */
+    uint32_t rx_packets;        /** Payloads put in the RX FIFO */
+    uint32_t rx_duplicates;     /** Retransmitted payloads acknowledged but discarded */
+    uint32_t rx_overflows;      /** Packets not acknowledged because the RX FIFO was full */
+
+    /* Private state. Do not touch */
+
+    struct nrf24l01p_emu_channel *channel;
+    uint8_t regs[NRF24L01P_EMU_REGISTERS];
+    uint8_t addr[3][5];         /** RX_ADDR_P0, RX_ADDR_P1 and TX_ADDR */
+    uint32_t cs_low;
+    uint32_t ce;
+    uint32_t irq;
+    uint8_t cmd[1 + 32];
+    uint32_t cmd_len;
+    uint8_t out[1 + 32];
+    uint32_t out_len;
+    struct nrf24l01p_emu_fifo_entry tx_fifo[NRF24L01P_EMU_FIFO_DEPTH];
+    uint32_t tx_count;
+    struct nrf24l01p_emu_fifo_entry rx_fifo[NRF24L01P_EMU_FIFO_DEPTH];
+    uint32_t rx_count;
+    enum nrf24l01p_emu_tx_state tx_state;
+    uint64_t event_ns;
+    uint64_t tx_end_ns;
+    uint8_t pid;
+    uint8_t arc_cnt;
+    uint8_t plos_cnt;
+    uint8_t last_pid[6];
+    uint16_t last_sum[6];
+};
+
+/** SPI operations of an emulated radio. priv must point to a struct nrf24l01p_emu */
+extern const struct spi_operations nrf24l01p_emu_spi_ops;
+
+/** CS pin of an emulated radio. priv must point to a struct nrf24l01p_emu */
+extern const struct gpio_operations nrf24l01p_emu_cs_ops;
+
+/** CE pin of an emulated radio. priv must point to a struct nrf24l01p_emu */
+extern const struct gpio_operations nrf24l01p_emu_ce_ops;
+
+/** IRQ pin of an emulated radio (read only). priv must point to a struct nrf24l01p_emu */
+extern const struct gpio_operations nrf24l01p_emu_irq_ops;
+
+/**
+ * @brief Resets two radios to their power on state and connects them through a channel
+ *
+ * @param channel Channel model
+ * @param a First radio
+ * @param b Second radio
+ * @return int32_t E_SUCCESS on success
+ */
+extern int32_t nrf24l01p_emu_connect(struct nrf24l01p_emu_channel * const channel, struct nrf24l01p_emu * const a,
+    struct nrf24l01p_emu * const b);
+
+/**
+ * @brief Advances the channel clock, processing every air event on the way
+ *
+ * @param channel Channel model
+ * @param ns Nanoseconds to advance
+ */
+extern void nrf24l01p_emu_advance(struct nrf24l01p_emu_channel * const channel, uint64_t ns);
+
+/**
+ * @brief Gets the channel clock
+ *
+ * @param channel Channel model
+ * @return uint64_t Nanoseconds since nrf24l01p_emu_connect()
+ */
+extern uint64_t nrf24l01p_emu_now(const struct nrf24l01p_emu_channel * const channel);
+
+#endif // DRIVERS_NRF24L01P_NRF24L01P_EMU_H_
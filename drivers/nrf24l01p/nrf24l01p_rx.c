@@ -0,0 +1,291 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#include "drivers/nrf24l01p/nrf24l01p_rx.h"
+#include "drivers/nrf24l01p/nrf24l01p.h"
+#include "drivers/nrf24l01p/nrf24l01p_defs.h"
+
+#include "include/errors.h"
+
+#include "libs/pbuf/pbuf.h"
+
+#include "ulibc/include/log.h"
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+
+#define TAG "nrf24l01p_rx"
+
+/** Depth of the nRF24L01+ RX FIFO */
+#define RX_FIFO_DEPTH 3
+
+#define RX_TASK_SIZE 256
+#define RX_TASK_PRIORITY (tskIDLE_PRIORITY + 2)
+
+static StackType_t rx_stack[RX_TASK_SIZE];
+static StaticTask_t rx_tcb;
+static TaskHandle_t rx_task_handle;
+
+static uint8_t rx_queue_storage[NRF24L01P_RX_QUEUE_LENGTH * sizeof(struct nrf24l01p_packet)];
+static StaticQueue_t rx_queue_buffer;
+static QueueHandle_t rx_queue;
+
+PBUF_POOL_DEFINE(rx_pool, NRF24L01P_RX_BUFFERS, NRF24L01P_MAX_PAYLOAD, NRF24L01P_RX_HEADROOM);
+
+static const struct nrf24l01p * volatile rx_device;
+/** Set by the task while it uses rx_device, so nrf24l01p_rx_stop() knows when the device is free */
+static volatile uint8_t rx_busy;
+/** Task waiting in nrf24l01p_rx_stop() for the service task to let go of the device */
+static TaskHandle_t rx_stopper;
+static volatile uint32_t rx_irq_timestamp;
+static struct nrf24l01p_rx_stats rx_stats;
+
+/** Where the packets of each pipe go. A pipe without callback nor queue uses rx_queue */
+static struct {
+    nrf24l01p_rx_callback callback;
+    void *arg;
+    QueueHandle_t queue;
+} rx_routes[NRF24L01P_PIPES];
+
+/**
+ * @brief Delivers a packet to the route of its pipe. Ownership of the buffer goes along with it
+ *
+ * @param packet Received packet
+ */
+static void route_packet(const struct nrf24l01p_packet * const packet)
+{
+    if (rx_routes[packet->pipe].callback != NULL) {
+        rx_routes[packet->pipe].callback(packet, rx_routes[packet->pipe].arg);
+        pbuf_free(packet->buffer);
+    } else {
+        QueueHandle_t queue = rx_routes[packet->pipe].queue != NULL ? rx_routes[packet->pipe].queue : rx_queue;
+        if (xQueueSend(queue, packet, 0) != pdTRUE) {
+            pbuf_free(packet->buffer);
+            rx_stats.dropped++;
+            return;
+        }
+    }
+
+    rx_stats.received++;
+    rx_stats.pipe_received[packet->pipe]++;
+}
+
+/**
+ * @brief Reads every packet in the RX FIFO into the queue. The lock of the radio must be held
+ *
+ * @param device nRF24L01+ device definition
+ * @param timestamp Tick count of the IRQ
+ * @return int32_t Negative value on error
+ */
+static int32_t drain_rx_fifo(const struct nrf24l01p * const device, uint32_t timestamp)
+{
+    int32_t ret;
+    uint8_t status, size;
+    struct nrf24l01p_packet packet;
+
+    // RX_DR is cleared before reading: a packet arriving while draining raises the IRQ again.
+    // The STATUS clocked out by this write already tells which pipe is at the head of the RX FIFO
+    ret = nrf24l01p_clear_status_irq(device, STATUS_RX_DR);
+    if (ret < 0) { goto exit; }
+    status = nrf24l01p_get_last_status(device);
+
+    for (int i = 0; i < RX_FIFO_DEPTH; i++) {
+        packet.pipe = (status & STATUS_RX_P_NO_MSK) >> STATUS_RX_P_NO_SHIFT;
+        if (packet.pipe == STATUS_RX_P_NO_EMPTY) break;
+        if (packet.pipe >= NRF24L01P_PIPES) {
+            WARN(TAG, "Invalid pipe number %u. Flushing RX FIFO", packet.pipe);
+            ret = nrf24l01p_flush_rx(device);
+            rx_stats.errors++;
+            goto exit;
+        }
+
+        ret = nrf24l01p_get_rx_payload_width(device, packet.pipe, &size);
+        if (ret == E_INVALID_CRC) {
+            ret = nrf24l01p_flush_rx(device);
+            rx_stats.errors++;
+            goto exit;
+        }
+        if (ret < 0) { goto exit; }
+
+        packet.buffer = pbuf_alloc(&rx_pool);
+        if (packet.buffer == NULL) {
+            // Left in the FIFO the packets would stall the radio, as no new RX_DR would be raised for them
+            ret = nrf24l01p_flush_rx(device);
+            rx_stats.dropped++;
+            goto exit;
+        }
+
+        // The command byte and STATUS take the last byte of headroom, the payload lands in place
+        ret = nrf24l01p_r_rx_payload_in_place(device, size, pbuf_push_header(packet.buffer, 1));
+        pbuf_pull_header(packet.buffer, 1);
+        if (ret < 0) {
+            pbuf_free(packet.buffer);
+            goto exit;
+        }
+        pbuf_put(packet.buffer, size);
+        packet.timestamp = timestamp;
+
+        route_packet(&packet);
+
+        ret = nrf24l01p_get_status(device, &status);
+        if (ret < 0) { goto exit; }
+    }
+
+    exit:
+    return ret;
+}
+
+static void rx_task(void *arg)
+{
+    (void)arg;
+
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        taskENTER_CRITICAL();
+        const struct nrf24l01p *device = rx_device;
+        rx_busy = device != NULL;
+        taskEXIT_CRITICAL();
+        if (device == NULL) continue;
+
+        rx_stats.irqs++;
+        // A TX burst or a configuration change of another task must not be split by the draining
+        nrf24l01p_lock(device);
+        if (drain_rx_fifo(device, rx_irq_timestamp) < 0) {
+            rx_stats.errors++;
+        }
+        nrf24l01p_unlock(device);
+
+        taskENTER_CRITICAL();
+        rx_busy = 0;
+        TaskHandle_t stopper = rx_stopper;
+        rx_stopper = NULL;
+        taskEXIT_CRITICAL();
+        if (stopper != NULL) xTaskNotifyGive(stopper);
+    }
+}
+
+int32_t nrf24l01p_rx_start(const struct nrf24l01p * const device)
+{
+    int32_t ret = E_SUCCESS;
+
+    if (device == NULL) {
+        ret = E_INVALID_PARAMETER;
+        goto exit;
+    }
+
+    if (rx_device != device) nrf24l01p_rx_stop();
+
+    if (rx_task_handle == NULL) {
+        rx_queue = xQueueCreateStatic(NRF24L01P_RX_QUEUE_LENGTH, sizeof(struct nrf24l01p_packet), rx_queue_storage,
+            &rx_queue_buffer);
+        rx_task_handle = xTaskCreateStatic(rx_task, TAG, RX_TASK_SIZE, NULL, RX_TASK_PRIORITY, rx_stack, &rx_tcb);
+    }
+
+    rx_device = device;
+    ret = nrf24l01p_unmask_irq(device, CONFIG_MASK_RX_DR);
+
+    exit:
+    return ret;
+}
+
+void nrf24l01p_rx_stop(void)
+{
+    taskENTER_CRITICAL();
+    const struct nrf24l01p *device = rx_device;
+    rx_device = NULL;
+    const uint8_t busy = rx_busy;
+    if (busy) rx_stopper = xTaskGetCurrentTaskHandle();
+    taskEXIT_CRITICAL();
+
+    if (device == NULL) return;
+
+    // The task may be draining the device: wait until it lets go of it
+    if (busy) {
+        while (rx_busy) ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+
+    // A late IRQ must not wake the task for a device it no longer services
+    nrf24l01p_mask_irq(device, CONFIG_MASK_RX_DR);
+}
+
+void nrf24l01p_rx_irq_handler(void)
+{
+    BaseType_t higher_priority_task_woken = pdFALSE;
+
+    if (rx_task_handle == NULL) return;
+
+    rx_irq_timestamp = xTaskGetTickCountFromISR();
+    vTaskNotifyGiveFromISR(rx_task_handle, &higher_priority_task_woken);
+    portYIELD_FROM_ISR(higher_priority_task_woken);
+}
+
+int32_t nrf24l01p_rx_receive(struct nrf24l01p_packet * const packet, uint32_t timeout)
+{
+    int32_t ret = E_SUCCESS;
+
+    if (rx_queue == NULL) {
+        ret = E_NOT_INITIALIZED;
+        goto exit;
+    }
+
+    if (xQueueReceive(rx_queue, packet, timeout) != pdTRUE) {
+        ret = E_RX_QUEUE_EMPTY;
+        goto exit;
+    }
+
+    exit:
+    return ret;
+}
+
+int32_t nrf24l01p_rx_set_callback(uint8_t pipe, nrf24l01p_rx_callback callback, void *arg)
+{
+    int32_t ret = E_SUCCESS;
+
+    if (pipe >= NRF24L01P_PIPES) {
+        ret = E_INVALID_PARAMETER;
+        goto exit;
+    }
+
+    // Callback is cleared first so the RX task never calls it with the wrong argument
+    rx_routes[pipe].callback = NULL;
+    rx_routes[pipe].arg = arg;
+    rx_routes[pipe].callback = callback;
+
+    exit:
+    return ret;
+}
+
+int32_t nrf24l01p_rx_set_queue(uint8_t pipe, QueueHandle_t queue)
+{
+    int32_t ret = E_SUCCESS;
+
+    if (pipe >= NRF24L01P_PIPES) {
+        ret = E_INVALID_PARAMETER;
+        goto exit;
+    }
+
+    rx_routes[pipe].queue = queue;
+
+    exit:
+    return ret;
+}
+
+const struct pbuf_pool *nrf24l01p_rx_get_pool(void)
+{
+    return &rx_pool;
+}
+
+void nrf24l01p_rx_get_stats(struct nrf24l01p_rx_stats * const stats)
+{
+    *stats = rx_stats;
+}
@@ -0,0 +1,131 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#ifndef DRIVERS_NRF24L01P_NRF24L01P_RX_H_
+#define DRIVERS_NRF24L01P_NRF24L01P_RX_H_
+
+#include "drivers/nrf24l01p/nrf24l01p.h"
+
+#include "libs/pbuf/pbuf.h"
+
+#include <stdint.h>
+
+#include "FreeRTOS.h"
+#include "queue.h"
+
+/**
+ * @brief Interrupt driven receive service for the nRF24L01+.
+ *
+ * The platform must route the falling edge of the nRF24L01+ IRQ pin to nrf24l01p_rx_irq_handler(). The handler
+ * only wakes the service task, which drains the RX FIFO and routes every packet by the pipe that received it:
+ * to a callback, to a queue of its own or, when the pipe has no route, to the shared queue that consumers block on
+ * with nrf24l01p_rx_receive().
+ *
+ * Payloads are read straight into buffers of a pbuf pool and only a pointer travels through the queues. Whoever
+ * receives a packet owns its buffer and must release it with pbuf_free(). NRF24L01P_RX_HEADROOM bytes are free in
+ * front of the payload, so a consumer can prepend its own header without copying the payload.
+ */
+
+/** Number of packets the receive queue holds */
+#define NRF24L01P_RX_QUEUE_LENGTH 16
+
+/** Number of buffers for received packets, shared by every route */
+#define NRF24L01P_RX_BUFFERS 24
+
+/** Bytes free in front of the payload of a received packet */
+#define NRF24L01P_RX_HEADROOM 12
+
+/** Received packet */
+struct nrf24l01p_packet {
+    uint32_t timestamp;     /** Tick count when the IRQ was raised */
+    uint8_t pipe;           /** Pipe that received the packet */
+    struct pbuf *buffer;    /** Payload. Released by the receiver with pbuf_free() */
+};
+
+/** Receive service statistics */
+struct nrf24l01p_rx_stats {
+    uint32_t irqs;      /** Number of IRQs handled */
+    uint32_t received;  /** Number of packets delivered */
+    uint32_t dropped;   /** Number of packets lost because the queue was full or there was no free buffer */
+    uint32_t errors;    /** Number of SPI errors and invalid pipe numbers */
+    uint32_t pipe_received[NRF24L01P_PIPES]; /** Number of packets delivered per pipe */
+};
+
+/**
+ * @brief Receives the packets of a pipe. Called from the RX service task: must not block
+ *
+ * @param packet Received packet. Only valid during the call: take a reference with pbuf_ref() to keep its buffer
+ * @param arg Argument given to nrf24l01p_rx_set_callback()
+ */
+typedef void (*nrf24l01p_rx_callback)(const struct nrf24l01p_packet * const packet, void *arg);
+
+/**
+ * @brief Starts the receive service task and unmasks RX_DR. Calling it again only changes the device being serviced:
+ * the previous one is stopped first
+ *
+ * @param device nRF24L01+ device definition. Must live until nrf24l01p_rx_stop()
+ * @return int32_t Negative value on error
+ */
+extern int32_t nrf24l01p_rx_start(const struct nrf24l01p * const device);
+
+/**
+ * @brief Stops servicing the device and masks RX_DR. Returns once the service task no longer uses the device, so
+ * it may be released right after. Packets already in the queue are kept. Must not be called from a receive callback
+ * nor with the lock of the device held
+ */
+extern void nrf24l01p_rx_stop(void);
+
+/**
+ * @brief Must be called from the ISR of the nRF24L01+ IRQ pin
+ */
+extern void nrf24l01p_rx_irq_handler(void);
+
+/**
+ * @brief Waits for a received packet
+ *
+ * @param packet [out] Received packet. Its buffer must be released with pbuf_free()
+ * @param timeout Time to wait in ticks
+ * @return int32_t E_SUCCESS on success. E_RX_QUEUE_EMPTY on timeout
+ */
+extern int32_t nrf24l01p_rx_receive(struct nrf24l01p_packet * const packet, uint32_t timeout);
+
+/**
+ * @brief Routes the packets of a pipe to a callback. Should be called while the receiver is disabled
+ *
+ * @param pipe Pipe number from 0 to 5
+ * @param callback Callback. NULL removes the route
+ * @param arg Argument passed to callback
+ * @return int32_t Negative value on error
+ */
+extern int32_t nrf24l01p_rx_set_callback(uint8_t pipe, nrf24l01p_rx_callback callback, void *arg);
+
+/**
+ * @brief Routes the packets of a pipe to a queue of struct nrf24l01p_packet. Should be called while the receiver is
+ * disabled
+ *
+ * @param pipe Pipe number from 0 to 5
+ * @param queue Queue. NULL removes the route
+ * @return int32_t Negative value on error
+ */
+extern int32_t nrf24l01p_rx_set_queue(uint8_t pipe, QueueHandle_t queue);
+
+/**
+ * @brief Gets the pool holding the received packets, to check how close it got to exhaustion
+ *
+ * @return const struct pbuf_pool* Buffer pool
+ */
+extern const struct pbuf_pool *nrf24l01p_rx_get_pool(void);
+
+/**
+ * @brief Gets receive service statistics
+ *
+ * @param stats [out] Statistics
+ */
+extern void nrf24l01p_rx_get_stats(struct nrf24l01p_rx_stats * const stats);
+
+#endif // DRIVERS_NRF24L01P_NRF24L01P_RX_H_
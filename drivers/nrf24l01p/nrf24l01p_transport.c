@@ -0,0 +1,403 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#include "drivers/nrf24l01p/nrf24l01p_transport.h"
+#include "drivers/nrf24l01p/nrf24l01p.h"
+#include "drivers/nrf24l01p/nrf24l01p_defs.h"
+#include "drivers/nrf24l01p/nrf24l01p_rx.h"
+#include "drivers/nrf24l01p/nrf24l01p_tx.h"
+
+#include "include/device/gpio.h"
+#include "include/errors.h"
+
+#include "libs/crc16/crc16.h"
+#include "libs/pbuf/pbuf.h"
+
+#include "ulibc/include/utils.h"
+#include "ulibc/include/log.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#define TAG "nrf24l01p_transport"
+
+#define FRAME_TYPE_MSK      0b00000011
+#define FRAME_TYPE_DATA     0b00000000
+#define FRAME_TYPE_SACK     0b00000001
+#define FRAME_ACK_REQ       BIT(4)  /** DATA: sender waits for a SACK after this frame */
+#define FRAME_LAST          BIT(5)  /** DATA: last fragment of the message */
+#define FRAME_DONE          BIT(6)  /** SACK: message received and CRC16 matches */
+#define FRAME_REJECTED      BIT(7)  /** SACK: message has an invalid CRC16 or does not fit in the receiver buffer */
+
+/** SACK frame: header followed by the bitmap of received fragments */
+#define SACK_SIZE (NRF24L01P_TRANSPORT_HEADER_SIZE + 4)
+
+/** Size of the CRC16 sent after the message */
+#define CRC_SIZE 2
+
+static void put_header(uint8_t * const frame, uint8_t flags, uint8_t id, uint16_t index)
+{
+    frame[0] = flags;
+    frame[1] = id;
+    frame[2] = index & 0xff;
+    frame[3] = index >> 8;
+}
+
+static uint16_t get_index(const uint8_t * const frame)
+{
+    return frame[2] | frame[3] << 8;
+}
+
+/** Shifts a window bitmap. Shifting 32 bits or more clears it */
+static uint32_t shift_window(uint32_t bitmap, uint32_t amount)
+{
+    return amount >= NRF24L01P_TRANSPORT_WINDOW ? 0 : bitmap >> amount;
+}
+
+/**
+ * @brief Copies part of the sent byte stream: the message followed by its CRC16 in big endian
+ */
+static void get_stream_bytes(const uint8_t * const data, uint32_t size, uint16_t crc16, uint32_t offset,
+    uint32_t len, uint8_t * const out)
+{
+    for (uint32_t i = 0; i < len; i++) {
+        uint32_t pos = offset + i;
+        if (pos < size) out[i] = data[pos];
+        else out[i] = pos == size ? crc16 >> 8 : crc16 & 0xff;
+    }
+}
+
+static int32_t send_sack(struct nrf24l01p_transport * const transport, uint8_t flags, uint8_t id, uint32_t base,
+    uint32_t bitmap)
+{
+    int32_t ret;
+    uint8_t frame[SACK_SIZE];
+
+    put_header(frame, FRAME_TYPE_SACK | flags, id, base);
+    frame[4] = bitmap & 0xff;
+    frame[5] = (bitmap >> 8) & 0xff;
+    frame[6] = (bitmap >> 16) & 0xff;
+    frame[7] = bitmap >> 24;
+
+    ret = transport->ops->tx_begin_op(transport);
+    if (ret < 0) { goto exit; }
+    // A lost SACK is recovered by the sender asking again
+    transport->ops->tx_frame_op(transport, frame, sizeof(frame));
+    ret = transport->ops->tx_end_op(transport);
+    if (ret < 0) { goto exit; }
+    transport->stats.sacks++;
+
+    exit:
+    return ret;
+}
+
+int32_t nrf24l01p_transport_send(struct nrf24l01p_transport * const transport, const void * const data,
+    uint32_t size)
+{
+    int32_t ret;
+    uint8_t frame[NRF24L01P_MAX_PAYLOAD];
+    const uint8_t *udata = (const uint8_t *)data;
+
+    if (data == NULL || size > NRF24L01P_TRANSPORT_MAX_MESSAGE) {
+        ret = E_INVALID_PARAMETER;
+        goto exit;
+    }
+
+    const uint16_t crc16 = calc_crc16ccitt(data, size);
+    const uint32_t total = size + CRC_SIZE;
+    const uint32_t count = (total + NRF24L01P_TRANSPORT_FRAGMENT_SIZE - 1) / NRF24L01P_TRANSPORT_FRAGMENT_SIZE;
+    // Fragments from base on are tracked with bitmaps: bit i refers to fragment base + i
+    uint32_t base = 0, acked = 0, sent = 0;
+    uint32_t timeouts = 0;
+    const uint8_t id = ++transport->msg_id;
+
+    while (1) {
+        int32_t last = -1;
+        for (uint32_t i = 0; i < NRF24L01P_TRANSPORT_WINDOW && base + i < count; i++) {
+            if (IS_BIT_CLEAR(acked, 1UL << i)) last = i;
+        }
+
+        ret = transport->ops->tx_begin_op(transport);
+        if (ret < 0) { goto exit; }
+
+        if (last < 0) {
+            // Every fragment arrived but the final SACK got lost: asks for it again
+            uint32_t index = count - 1;
+            uint32_t len = total - index * NRF24L01P_TRANSPORT_FRAGMENT_SIZE;
+            put_header(frame, FRAME_TYPE_DATA | FRAME_LAST | FRAME_ACK_REQ, id, index);
+            get_stream_bytes(udata, size, crc16, index * NRF24L01P_TRANSPORT_FRAGMENT_SIZE, len,
+                &frame[NRF24L01P_TRANSPORT_HEADER_SIZE]);
+            transport->ops->tx_frame_op(transport, frame, NRF24L01P_TRANSPORT_HEADER_SIZE + len);
+            transport->stats.frames_sent++;
+            transport->stats.retransmissions++;
+        }
+
+        for (int32_t i = 0; i <= last; i++) {
+            if (IS_BIT_SET(acked, 1UL << i)) continue;
+
+            uint32_t index = base + i;
+            uint32_t offset = index * NRF24L01P_TRANSPORT_FRAGMENT_SIZE;
+            uint32_t len = CHOOSE_MIN(NRF24L01P_TRANSPORT_FRAGMENT_SIZE, total - offset);
+            uint8_t flags = FRAME_TYPE_DATA;
+            if (index == count - 1) flags |= FRAME_LAST;
+            if (i == last) flags |= FRAME_ACK_REQ;
+
+            put_header(frame, flags, id, index);
+            get_stream_bytes(udata, size, crc16, offset, len, &frame[NRF24L01P_TRANSPORT_HEADER_SIZE]);
+            // A frame the link could not deliver is sent again after the next SACK
+            transport->ops->tx_frame_op(transport, frame, NRF24L01P_TRANSPORT_HEADER_SIZE + len);
+
+            transport->stats.frames_sent++;
+            if (IS_BIT_SET(sent, 1UL << i)) transport->stats.retransmissions++;
+            sent |= 1UL << i;
+        }
+
+        ret = transport->ops->tx_end_op(transport);
+        if (ret < 0) { goto exit; }
+
+        // Waits for the SACK of this message. Anything else is ignored
+        while (1) {
+            struct pbuf *rx;
+            ret = transport->ops->rx_frame_op(transport, &rx, transport->timeout);
+            if (ret == E_RX_QUEUE_EMPTY) {
+                transport->stats.timeouts++;
+                if (++timeouts > transport->retries) {
+                    ret = E_TIMEOUT;
+                    goto exit;
+                }
+                break;
+            }
+            if (ret < 0) { goto exit; }
+            // A SACK is short: it is taken out so the buffer goes back to the pool right away
+            memcpy(frame, rx->payload, CHOOSE_MIN(rx->size, SACK_SIZE));
+            pbuf_free(rx);
+            if (ret < SACK_SIZE || (frame[0] & FRAME_TYPE_MSK) != FRAME_TYPE_SACK || frame[1] != id) continue;
+
+            transport->stats.sacks++;
+            if (IS_BIT_SET(frame[0], FRAME_REJECTED)) {
+                ret = E_INVALID_CRC;
+                goto exit;
+            }
+            if (IS_BIT_SET(frame[0], FRAME_DONE)) {
+                ret = size;
+                goto exit;
+            }
+
+            uint32_t sack_base = get_index(frame);
+            uint32_t sack_bitmap = frame[4] | frame[5] << 8 | frame[6] << 16 | (uint32_t)frame[7] << 24;
+            // SACKs never go backwards. An older one is a duplicate
+            if (sack_base < base) continue;
+
+            sent = shift_window(sent, sack_base - base);
+            if (sack_base != base || sack_bitmap != acked) timeouts = 0;
+            base = sack_base;
+            acked = sack_bitmap;
+            break;
+        }
+    }
+
+    exit:
+    return ret;
+}
+
+int32_t nrf24l01p_transport_receive(struct nrf24l01p_transport * const transport, void * const buffer,
+    uint32_t capacity)
+{
+    int32_t ret;
+    struct pbuf *rx = NULL;
+    uint8_t *ubuffer = (uint8_t *)buffer;
+    // The CRC16 may not fit in buffer: the bytes past its end are kept here
+    uint8_t tail[CRC_SIZE];
+    uint32_t base = 0, received = 0, count = 0, total = 0, timeouts = 0;
+    uint32_t started = FALSE;
+    uint8_t id = 0;
+
+    if (buffer == NULL) {
+        ret = E_INVALID_PARAMETER;
+        goto exit;
+    }
+
+    while (1) {
+        // The previous frame is done with
+        pbuf_free(rx);
+        rx = NULL;
+
+        ret = transport->ops->rx_frame_op(transport, &rx, transport->timeout);
+        if (ret == E_RX_QUEUE_EMPTY) {
+            if (!started) { goto exit; }
+            // A lost SACK leaves the sender silent for its own timeout: giving up earlier would drop the fragments
+            // already acknowledged, which the sender never sends again
+            if (++timeouts > transport->retries) {
+                ret = E_TIMEOUT;
+                goto exit;
+            }
+            continue;
+        }
+        if (ret < 0) { goto exit; }
+        timeouts = 0;
+
+        const uint8_t *frame = rx->payload;
+        uint32_t frame_size = ret;
+        if (frame_size < NRF24L01P_TRANSPORT_HEADER_SIZE || (frame[0] & FRAME_TYPE_MSK) != FRAME_TYPE_DATA) continue;
+
+        uint8_t flags = frame[0];
+        uint8_t frame_id = frame[1];
+        uint32_t index = get_index(frame);
+        uint32_t len = frame_size - NRF24L01P_TRANSPORT_HEADER_SIZE;
+
+        if ((!started || frame_id != id) && transport->done_valid && frame_id == transport->done_id) {
+            // The sender missed the final SACK of the previous message
+            if (IS_BIT_SET(flags, FRAME_ACK_REQ)) {
+                ret = send_sack(transport, FRAME_DONE, frame_id, 0, 0);
+                if (ret < 0) { goto exit; }
+            }
+            continue;
+        }
+
+        if (!started || frame_id != id) {
+            // A new message. If another one was in progress its sender gave up on it
+            started = TRUE;
+            id = frame_id;
+            base = received = count = total = 0;
+        }
+
+        if (index >= base && index < base + NRF24L01P_TRANSPORT_WINDOW && IS_BIT_CLEAR(received, 1UL << (index - base))) {
+            uint32_t offset = index * NRF24L01P_TRANSPORT_FRAGMENT_SIZE;
+
+            if (IS_BIT_CLEAR(flags, FRAME_LAST) && len != NRF24L01P_TRANSPORT_FRAGMENT_SIZE) continue;
+            if (IS_BIT_SET(flags, FRAME_LAST) && offset + len < CRC_SIZE) continue;
+
+            if (offset + len > capacity + CRC_SIZE) {
+                WARN(TAG, "Message does not fit in %lu bytes", capacity);
+                send_sack(transport, FRAME_REJECTED, id, base, received);
+                ret = E_INVALID_PARAMETER;
+                goto exit;
+            }
+
+            // The fragment goes from the receive buffer straight to its place in the caller buffer
+            uint32_t in_buffer = offset < capacity ? CHOOSE_MIN(len, capacity - offset) : 0;
+            memcpy(&ubuffer[offset], &frame[NRF24L01P_TRANSPORT_HEADER_SIZE], in_buffer);
+            for (uint32_t i = in_buffer; i < len; i++) {
+                tail[offset + i - capacity] = frame[NRF24L01P_TRANSPORT_HEADER_SIZE + i];
+            }
+
+            if (IS_BIT_SET(flags, FRAME_LAST)) {
+                count = index + 1;
+                total = offset + len;
+            }
+
+            received |= 1UL << (index - base);
+            while (IS_BIT_SET(received, 1)) {
+                received >>= 1;
+                base++;
+            }
+        }
+
+        if (count != 0 && base >= count) {
+            uint32_t size = total - CRC_SIZE;
+            uint8_t crc_bytes[CRC_SIZE];
+            for (uint32_t i = 0; i < CRC_SIZE; i++) {
+                uint32_t pos = size + i;
+                crc_bytes[i] = pos < capacity ? ubuffer[pos] : tail[pos - capacity];
+            }
+
+            if (calc_crc16ccitt(buffer, size) != (crc_bytes[0] << 8 | crc_bytes[1])) {
+                WARN(TAG, "Message %u has an invalid CRC16", id);
+                send_sack(transport, FRAME_REJECTED, id, base, 0);
+                ret = E_INVALID_CRC;
+                goto exit;
+            }
+
+            transport->done_id = id;
+            transport->done_valid = TRUE;
+            ret = send_sack(transport, FRAME_DONE, id, base, 0);
+            if (ret < 0) { goto exit; }
+            ret = size;
+            goto exit;
+        }
+
+        if (IS_BIT_SET(flags, FRAME_ACK_REQ)) {
+            ret = send_sack(transport, 0, id, base, received);
+            if (ret < 0) { goto exit; }
+        }
+    }
+
+    exit:
+    pbuf_free(rx);
+    return ret;
+}
+
+/*
+ * nRF24L01+ operations
+ */
+
+static int32_t radio_tx_begin(struct nrf24l01p_transport * const transport)
+{
+    int32_t ret;
+    struct nrf24l01p_transport_radio *radio = (struct nrf24l01p_transport_radio *)transport->priv;
+
+    // Held until radio_tx_end(): the RX service must not drain the radio in the middle of the burst
+    nrf24l01p_lock(radio->device);
+    gpio_write(radio->device->ce_gpio, GPIO_LOW);
+    ret = nrf24l01p_stream_start(radio->device, &radio->stream);
+    if (ret < 0) {
+        // There is no radio_tx_end() after a failed start
+        gpio_write(radio->device->ce_gpio, GPIO_HIGH);
+        nrf24l01p_unlock(radio->device);
+    }
+
+    return ret;
+}
+
+static int32_t radio_tx_frame(struct nrf24l01p_transport * const transport, const void * const frame, uint32_t size)
+{
+    struct nrf24l01p_transport_radio *radio = (struct nrf24l01p_transport_radio *)transport->priv;
+
+    return nrf24l01p_stream_write(radio->device, &radio->stream, size, frame, transport->timeout);
+}
+
+static int32_t radio_tx_end(struct nrf24l01p_transport * const transport)
+{
+    int32_t ret;
+    struct nrf24l01p_transport_radio *radio = (struct nrf24l01p_transport_radio *)transport->priv;
+
+    ret = nrf24l01p_stream_stop(radio->device, &radio->stream, transport->timeout);
+    // Frames lost on MAX_RT are recovered by the protocol
+    if (ret < 0 && ret != E_TIMEOUT) { goto exit; }
+
+    ret = nrf24l01p_disable_tx_mode(radio->device);
+    if (ret < 0) { goto exit; }
+    gpio_write(radio->device->ce_gpio, GPIO_HIGH);
+
+    exit:
+    nrf24l01p_unlock(radio->device);
+    return ret;
+}
+
+static int32_t radio_rx_frame(struct nrf24l01p_transport * const transport, struct pbuf ** const frame,
+    uint32_t timeout)
+{
+    int32_t ret;
+    struct nrf24l01p_packet packet;
+
+    ret = nrf24l01p_rx_receive(&packet, timeout);
+    if (ret < 0) { goto exit; }
+    // The RX service read the payload into this buffer: it is handed over as is
+    *frame = packet.buffer;
+    ret = packet.buffer->size;
+
+    exit:
+    return ret;
+}
+
+const struct nrf24l01p_transport_operations nrf24l01p_transport_radio_ops = {
+    .tx_begin_op = radio_tx_begin,
+    .tx_frame_op = radio_tx_frame,
+    .tx_end_op = radio_tx_end,
+    .rx_frame_op = radio_rx_frame,
+};
@@ -0,0 +1,146 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#ifndef DRIVERS_NRF24L01P_NRF24L01P_TRANSPORT_H_
+#define DRIVERS_NRF24L01P_NRF24L01P_TRANSPORT_H_
+
+#include "drivers/nrf24l01p/nrf24l01p.h"
+#include "drivers/nrf24l01p/nrf24l01p_tx.h"
+
+#include "libs/pbuf/pbuf.h"
+
+#include <stdint.h>
+
+/**
+ * @brief Reliable message transport over 32 bytes frames.
+ *
+ * A message is sent followed by its CRC16-CCITT (big endian) and split in fragments of
+ * NRF24L01P_TRANSPORT_FRAGMENT_SIZE bytes. Every frame starts with a 4 bytes header:
+ *
+ *     byte 0: frame type and flags
+ *     byte 1: message id
+ *     byte 2-3: fragment index (DATA) or first missing fragment (SACK), little endian
+ *
+ * The sender transmits every fragment of a window of NRF24L01P_TRANSPORT_WINDOW fragments that was not acknowledged
+ * yet and requests an acknowledgment on the last one. The receiver answers with a selective acknowledgment (SACK):
+ * the first missing fragment and a 32 bits bitmap of the fragments received after it. The receiver copies every
+ * fragment from the buffer the radio read it into straight to its place in the caller buffer, which is the only copy
+ * of the payload, and checks the CRC16 once the message is complete.
+ *
+ * Frames are moved by the operations in struct nrf24l01p_transport_operations, so the protocol runs over the radio
+ * (nrf24l01p_transport_radio_ops) or anything else that moves frames.
+ */
+
+/** Size of the frame header */
+#define NRF24L01P_TRANSPORT_HEADER_SIZE 4
+
+/** Payload bytes carried by each DATA frame */
+#define NRF24L01P_TRANSPORT_FRAGMENT_SIZE (NRF24L01P_MAX_PAYLOAD - NRF24L01P_TRANSPORT_HEADER_SIZE)
+
+/** Number of fragments sent before waiting for a SACK. Limited by the SACK bitmap */
+#define NRF24L01P_TRANSPORT_WINDOW 32
+
+/** Largest message that can be sent */
+#define NRF24L01P_TRANSPORT_MAX_MESSAGE (0xffffUL * NRF24L01P_TRANSPORT_FRAGMENT_SIZE - 2)
+
+struct nrf24l01p_transport;
+
+/**
+ * @brief Operations used to move frames
+ */
+struct nrf24l01p_transport_operations {
+    /**
+     * @brief Prepares to transmit a burst of frames
+     *
+     * @return Negative on error.
+     */
+    int32_t (*tx_begin_op)(struct nrf24l01p_transport * const transport);
+
+    /**
+     * @brief Transmits one frame. A frame that could not be delivered should be reported with a negative value: the
+     * protocol recovers it
+     *
+     * @return Negative on error.
+     */
+    int32_t (*tx_frame_op)(struct nrf24l01p_transport * const transport, const void * const frame, uint32_t size);
+
+    /**
+     * @brief Finishes a burst of frames and gets ready to receive
+     *
+     * @return Negative on error.
+     */
+    int32_t (*tx_end_op)(struct nrf24l01p_transport * const transport);
+
+    /**
+     * @brief Waits for a frame. The frame is handed over in the buffer it was received in, so it is not copied
+     *
+     * @param frame [out] Received frame. Released by the caller with pbuf_free()
+     * @return Size of the frame in bytes. E_RX_QUEUE_EMPTY on timeout. Negative on error.
+     */
+    int32_t (*rx_frame_op)(struct nrf24l01p_transport * const transport, struct pbuf ** const frame, uint32_t timeout);
+};
+
+/** Transport statistics */
+struct nrf24l01p_transport_stats {
+    uint32_t frames_sent;       /** DATA frames sent, including retransmissions */
+    uint32_t retransmissions;   /** DATA frames sent more than once */
+    uint32_t sacks;             /** SACK frames sent or received */
+    uint32_t timeouts;          /** Times a SACK did not arrive in time */
+};
+
+struct nrf24l01p_transport {
+    const struct nrf24l01p_transport_operations *ops;
+    void *priv;                 /** Operations specific object */
+    uint32_t timeout;           /** Time in ticks to wait for a frame */
+    uint32_t retries;           /** Consecutive timeouts before giving up */
+
+    uint8_t msg_id;             /** Id of the last message sent */
+    uint8_t done_id;            /** Id of the last message received */
+    uint8_t done_valid;         /** Non-zero if done_id is valid */
+    struct nrf24l01p_transport_stats stats;
+};
+
+/**
+ * @brief Object used by nrf24l01p_transport_radio_ops as transport->priv
+ */
+struct nrf24l01p_transport_radio {
+    const struct nrf24l01p *device;     /** Radio. Its RX service must be running */
+    struct nrf24l01p_stream stream;     /** Stream used for each burst */
+};
+
+/**
+ * Moves frames using the nRF24L01+ streaming transmitter and RX service. The radio is locked from tx_begin_op to
+ * tx_end_op so a burst is not interleaved with other users of the radio
+ */
+extern const struct nrf24l01p_transport_operations nrf24l01p_transport_radio_ops;
+
+/**
+ * @brief Sends a message and waits until the receiver acknowledges all of it
+ *
+ * @param transport Transport object
+ * @param data Message
+ * @param size Size of the message in bytes. Up to NRF24L01P_TRANSPORT_MAX_MESSAGE
+ * @return int32_t Number of bytes sent. E_TIMEOUT if the receiver stopped answering. E_INVALID_CRC if the receiver
+ * rejected the message
+ */
+extern int32_t nrf24l01p_transport_send(struct nrf24l01p_transport * const transport, const void * const data,
+    uint32_t size);
+
+/**
+ * @brief Receives a message straight into a buffer
+ *
+ * @param transport Transport object
+ * @param buffer [out] Message
+ * @param capacity Size of buffer in bytes
+ * @return int32_t Size of the message. E_RX_QUEUE_EMPTY if nothing arrived. E_TIMEOUT if the sender went silent in
+ * the middle of the message for more than transport->retries timeouts. E_INVALID_CRC if the message was corrupted. E_INVALID_PARAMETER if it does not fit in buffer
+ */
+extern int32_t nrf24l01p_transport_receive(struct nrf24l01p_transport * const transport, void * const buffer,
+    uint32_t capacity);
+
+#endif // DRIVERS_NRF24L01P_NRF24L01P_TRANSPORT_H_
@@ -0,0 +1,280 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#include "drivers/nrf24l01p/nrf24l01p_tx.h"
+#include "drivers/nrf24l01p/nrf24l01p.h"
+#include "drivers/nrf24l01p/nrf24l01p_defs.h"
+
+#include "include/device/gpio.h"
+#include "include/errors.h"
+
+#include "ulibc/include/utils.h"
+#include "ulibc/include/log.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#define TAG "nrf24l01p_tx"
+
+/** Depth of the nRF24L01+ TX FIFO */
+#define TX_FIFO_DEPTH 3
+
+/**
+ * @brief Updates the number of acknowledged payloads. Every payload written that is neither discarded nor still in
+ * the TX FIFO was acknowledged
+ *
+ * @param stream Stream object
+ * @param in_fifo Number of payloads in the TX FIFO, as just read from the radio
+ */
+static void update_acked(struct nrf24l01p_stream * const stream, uint32_t in_fifo)
+{
+    stream->packets = stream->written - stream->discarded - in_fifo;
+}
+
+/**
+ * @brief Counts the payloads in the TX FIFO by filling it up with dummy payloads. Only valid while the radio does
+ * not transmit, as after MAX_RT, and the TX FIFO must be flushed afterwards
+ *
+ * @param device nRF24L01+ device definition
+ * @param count [out] Number of payloads that were in the TX FIFO
+ * @return int32_t Negative value on error
+ */
+static int32_t count_tx_fifo(const struct nrf24l01p * const device, uint32_t * const count)
+{
+    int32_t ret;
+    uint8_t status;
+    const uint8_t dummy = 0;
+    uint32_t free_slots = 0;
+
+    ret = nrf24l01p_get_status(device, &status);
+    while (ret == E_SUCCESS && IS_BIT_CLEAR(status, STATUS_TX_FULL) && free_slots < TX_FIFO_DEPTH) {
+        ret = nrf24l01p_w_tx_payload(device, sizeof(dummy), &dummy);
+        if (ret < 0) { goto exit; }
+        free_slots++;
+        ret = nrf24l01p_get_status(device, &status);
+    }
+    *count = TX_FIFO_DEPTH - free_slots;
+
+    exit:
+    return ret;
+}
+
+/**
+ * @brief Discards the TX FIFO after MAX_RT and clears the flag so the radio transmits again. The lock of the radio
+ * must be held
+ *
+ * @param device nRF24L01+ device definition
+ * @param stream Stream object
+ * @return int32_t E_TIMEOUT or negative value on SPI error
+ */
+static int32_t handle_max_rt(const struct nrf24l01p * const device, struct nrf24l01p_stream * const stream)
+{
+    int32_t ret;
+    uint32_t in_fifo;
+
+    stream->max_rt++;
+    WARN(TAG, "Packet not acknowledged. Flushing TX FIFO");
+
+    // The radio halts on MAX_RT, so the payloads it is about to lose can be counted
+    ret = count_tx_fifo(device, &in_fifo);
+    if (ret < 0) { goto exit; }
+    ret = nrf24l01p_flush_tx(device);
+    if (ret < 0) { goto exit; }
+    stream->discarded += in_fifo;
+    update_acked(stream, 0);
+    ret = nrf24l01p_clear_status_irq(device, STATUS_MAX_RT | STATUS_TX_DS);
+    if (ret < 0) { goto exit; }
+    ret = E_TIMEOUT;
+
+    exit:
+    return ret;
+}
+
+/**
+ * @brief Reads STATUS and clears TX_DS in the same transfer. Clearing TX_DS releases the IRQ pin, so the next payload
+ * sent pulls it down again and wakes the waiting task
+ *
+ * @param device nRF24L01+ device definition
+ * @param status [out] STATUS right before clearing
+ * @return int32_t Negative value on error
+ */
+static int32_t rearm_tx_irq(const struct nrf24l01p * const device, uint8_t * const status)
+{
+    int32_t ret;
+
+    ret = nrf24l01p_clear_status_irq(device, STATUS_TX_DS);
+    if (ret < 0) { goto exit; }
+    *status = nrf24l01p_get_last_status(device);
+
+    exit:
+    return ret;
+}
+
+/**
+ * @brief Sleeps until the radio sends a payload (TX_DS) or gives up on one (MAX_RT). The lock of the radio must be
+ * held: it is released while sleeping so other tasks can use the radio
+ *
+ * @param device nRF24L01+ device definition
+ * @param status STATUS read by rearm_tx_irq()
+ * @param ticks Longest sleep
+ */
+static void wait_tx_irq(const struct nrf24l01p * const device, uint8_t status, uint32_t ticks)
+{
+    // A received payload holds the shared IRQ pin down until the RX service clears RX_DR, so no edge would come
+    if (IS_BIT_SET(status, STATUS_RX_DR)) ticks = 1;
+
+    nrf24l01p_unlock(device);
+    ulTaskNotifyTake(pdTRUE, ticks);
+    nrf24l01p_lock(device);
+}
+
+/**
+ * @brief Stops waking the calling task from nrf24l01p_tx_irq_handler()
+ *
+ * @param device nRF24L01+ device definition
+ */
+static void release_tx_irq(const struct nrf24l01p * const device)
+{
+    device->shadow->tx_waiter = NULL;
+    // Drops a notification that came after the last wait
+    ulTaskNotifyTake(pdTRUE, 0);
+}
+
+int32_t nrf24l01p_stream_start(const struct nrf24l01p * const device, struct nrf24l01p_stream * const stream)
+{
+    int32_t ret;
+
+    memset(stream, 0, sizeof(*stream));
+
+    nrf24l01p_lock(device);
+    ret = nrf24l01p_enable_tx_mode(device);
+    if (ret < 0) { goto exit; }
+    ret = nrf24l01p_unmask_irq(device, CONFIG_MASK_TX_DS | CONFIG_MASK_MAX_RT);
+    if (ret < 0) { goto exit; }
+    // Also refreshes the STATUS copy used to track the TX FIFO
+    ret = nrf24l01p_clear_status_irq(device, STATUS_MAX_RT | STATUS_TX_DS);
+    if (ret < 0) { goto exit; }
+
+    // With CE HIGH the radio leaves Standby-II as soon as there is something in the TX FIFO
+    gpio_write(device->ce_gpio, GPIO_HIGH);
+    stream->start_tick = xTaskGetTickCount();
+
+    exit:
+    nrf24l01p_unlock(device);
+    return ret;
+}
+
+int32_t nrf24l01p_stream_write(const struct nrf24l01p * const device, struct nrf24l01p_stream * const stream,
+    uint32_t size, const void * const data, uint32_t timeout)
+{
+    int32_t ret;
+    uint8_t status, observe_tx;
+    const uint32_t start = xTaskGetTickCount();
+
+    device->shadow->tx_waiter = xTaskGetCurrentTaskHandle();
+    nrf24l01p_lock(device);
+    while (1) {
+        // The STATUS clocked out by the last W_TX_PAYLOAD predates its own payload. Writing on that stale copy could
+        // hit a full FIFO, which might or might not take the payload if a slot frees up during the transfer
+        ret = rearm_tx_irq(device, &status);
+        if (ret < 0) { goto exit; }
+
+        if (IS_BIT_SET(status, STATUS_MAX_RT)) {
+            ret = handle_max_rt(device, stream);
+            goto exit;
+        }
+
+        if (IS_BIT_CLEAR(status, STATUS_TX_FULL)) {
+            ret = nrf24l01p_w_tx_payload(device, size, data);
+            if (ret == E_SUCCESS) stream->written++;
+            goto exit;
+        }
+
+        const uint32_t elapsed = xTaskGetTickCount() - start;
+        if (elapsed > timeout) {
+            ret = E_TX_QUEUE_FULL;
+            goto exit;
+        }
+        // Samples the retransmissions of the packet on air
+        ret = nrf24l01p_get_observe_tx(device, &observe_tx);
+        if (ret < 0) { goto exit; }
+        stream->arc_sum += observe_tx & OBSERVE_TX_ARC_CNT;
+        stream->arc_samples++;
+        update_acked(stream, TX_FIFO_DEPTH);
+
+        // Each slot takes a few hundred µs of air time: the task sleeps until one frees up
+        wait_tx_irq(device, status, timeout - elapsed + 1);
+    }
+
+    exit:
+    nrf24l01p_unlock(device);
+    release_tx_irq(device);
+    return ret;
+}
+
+int32_t nrf24l01p_stream_stop(const struct nrf24l01p * const device, struct nrf24l01p_stream * const stream,
+    uint32_t timeout)
+{
+    int32_t ret;
+    uint8_t status, fifo_st;
+    const uint32_t start = xTaskGetTickCount();
+
+    device->shadow->tx_waiter = xTaskGetCurrentTaskHandle();
+    nrf24l01p_lock(device);
+    while (1) {
+        ret = rearm_tx_irq(device, &status);
+        if (ret < 0) { goto exit; }
+        if (IS_BIT_SET(status, STATUS_MAX_RT)) {
+            ret = handle_max_rt(device, stream);
+            goto exit;
+        }
+        ret = nrf24l01p_get_fifo_status(device, &fifo_st);
+        if (ret < 0) { goto exit; }
+        if (IS_BIT_SET(fifo_st, FIFO_STATUS_TX_EMPTY)) {
+            update_acked(stream, 0);
+            break;
+        }
+        const uint32_t elapsed = xTaskGetTickCount() - start;
+        if (elapsed > timeout) {
+            ret = E_TIMEOUT;
+            goto exit;
+        }
+        wait_tx_irq(device, status, timeout - elapsed + 1);
+    }
+
+    exit:
+    gpio_write(device->ce_gpio, GPIO_LOW);
+    stream->stop_tick = xTaskGetTickCount();
+    // Errors are ignored: the stream result matters more to the caller
+    nrf24l01p_mask_irq(device, CONFIG_MASK_TX_DS | CONFIG_MASK_MAX_RT);
+    nrf24l01p_unlock(device);
+    release_tx_irq(device);
+    return ret;
+}
+
+void nrf24l01p_tx_irq_handler(const struct nrf24l01p * const device)
+{
+    BaseType_t higher_priority_task_woken = pdFALSE;
+    const TaskHandle_t waiter = device->shadow->tx_waiter;
+
+    if (waiter == NULL) return;
+
+    vTaskNotifyGiveFromISR(waiter, &higher_priority_task_woken);
+    portYIELD_FROM_ISR(higher_priority_task_woken);
+}
+
+uint32_t nrf24l01p_stream_rate(const struct nrf24l01p_stream * const stream)
+{
+    uint32_t ticks = stream->stop_tick - stream->start_tick;
+    if (ticks == 0) ticks = 1;
+
+    return (uint32_t)(((uint64_t)stream->packets * configTICK_RATE_HZ) / ticks);
+}
@@ -0,0 +1,91 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#ifndef DRIVERS_NRF24L01P_NRF24L01P_TX_H_
+#define DRIVERS_NRF24L01P_NRF24L01P_TX_H_
+
+#include "drivers/nrf24l01p/nrf24l01p.h"
+
+#include <stdint.h>
+
+/**
+ * @brief Streaming transmitter for the nRF24L01+.
+ *
+ * CE is held HIGH for the whole stream so the radio sends a packet as soon as it is in the TX FIFO, and
+ * nrf24l01p_stream_write() keeps the 3 slots of the TX FIFO full. Relies on Enhanced ShockBurst (auto-ack and
+ * auto-retransmit) as configured by nrf24l01p_default_setup(): a packet that is not acknowledged after every
+ * retransmission raises MAX_RT, which flushes the TX FIFO and is reported to the caller.
+ *
+ * TX_DS and MAX_RT are unmasked for the length of the stream. The platform must route the falling edge of the IRQ
+ * pin of each radio to nrf24l01p_tx_irq_handler(), along with nrf24l01p_rx_irq_handler() as they share the pin: a
+ * task waiting for a free slot or for the TX FIFO to empty sleeps until its radio sends or gives up on a payload.
+ */
+
+/** Statistics of a stream */
+struct nrf24l01p_stream {
+    uint32_t packets;       /** Payloads acknowledged. Exact once nrf24l01p_stream_stop() finds the TX FIFO empty */
+    uint32_t written;       /** Payloads written to the TX FIFO */
+    uint32_t discarded;     /** Payloads flushed from the TX FIFO on MAX_RT */
+    uint32_t max_rt;        /** MAX_RT events. Each one discards up to 3 payloads */
+    uint32_t arc_sum;       /** Sum of ARC_CNT values, sampled whenever a write finds the TX FIFO full */
+    uint32_t arc_samples;   /** Number of ARC_CNT samples. The writer wakes as soon as a payload leaves, so a sample
+                                mostly catches the next payload in its first attempt: only heavy retrying shows up */
+    uint32_t start_tick;    /** Tick count when the stream was started */
+    uint32_t stop_tick;     /** Tick count when the stream was stopped */
+};
+
+/**
+ * @brief Puts the nRF24L01+ in TX mode, unmasks TX_DS and MAX_RT and raises CE
+ *
+ * @param device nRF24L01+ device definition. Must be powered up
+ * @param stream Stream object
+ * @return int32_t Negative value on error
+ */
+extern int32_t nrf24l01p_stream_start(const struct nrf24l01p * const device, struct nrf24l01p_stream * const stream);
+
+/**
+ * @brief Writes a payload to the TX FIFO, sleeping until the radio sends a payload while it is full
+ *
+ * @param device nRF24L01+ device definition
+ * @param stream Stream object
+ * @param size Size of data. Up to 32 bytes
+ * @param data Payload
+ * @param timeout Time in ticks to wait for a free slot
+ * @return int32_t E_SUCCESS on success. E_TX_QUEUE_FULL on timeout. E_TIMEOUT if a payload hit MAX_RT: the TX FIFO
+ * was flushed and this payload was not written
+ */
+extern int32_t nrf24l01p_stream_write(const struct nrf24l01p * const device, struct nrf24l01p_stream * const stream,
+    uint32_t size, const void * const data, uint32_t timeout);
+
+/**
+ * @brief Waits for the TX FIFO to be sent, lowers CE and masks TX_DS and MAX_RT again
+ *
+ * @param device nRF24L01+ device definition
+ * @param stream Stream object
+ * @param timeout Time in ticks to wait for the TX FIFO to empty
+ * @return int32_t Negative value on error. E_TIMEOUT if a payload hit MAX_RT
+ */
+extern int32_t nrf24l01p_stream_stop(const struct nrf24l01p * const device, struct nrf24l01p_stream * const stream,
+    uint32_t timeout);
+
+/**
+ * @brief Must be called from the ISR of the nRF24L01+ IRQ pin
+ *
+ * @param device nRF24L01+ device definition of the radio that raised the IRQ
+ */
+extern void nrf24l01p_tx_irq_handler(const struct nrf24l01p * const device);
+
+/**
+ * @brief Calculates the stream rate
+ *
+ * @param stream Stream object, after nrf24l01p_stream_stop()
+ * @return uint32_t Acknowledged payloads per second
+ */
+extern uint32_t nrf24l01p_stream_rate(const struct nrf24l01p_stream * const stream);
+
+#endif // DRIVERS_NRF24L01P_NRF24L01P_TX_H_
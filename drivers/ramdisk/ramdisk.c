@@ -0,0 +1,85 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#include "drivers/ramdisk/ramdisk.h"
+
+#include "include/device/blockdev.h"
+#include "include/errors.h"
+
+#include <stdint.h>
+#include <string.h>
+
+static int32_t ramdisk_init(const struct blockdev_device * const bdev)
+{
+    const struct ramdisk *ramdisk = (const struct ramdisk *)bdev->priv;
+    return ramdisk->storage != NULL ? E_SUCCESS : E_NOT_INITIALIZED;
+}
+
+static int32_t ramdisk_check_range(const struct ramdisk *ramdisk, uint32_t block, uint32_t count)
+{
+    if (block >= ramdisk->block_count || count > ramdisk->block_count - block) return E_INVALID_PARAMETER;
+    return E_SUCCESS;
+}
+
+static int32_t ramdisk_read(const struct blockdev_device * const bdev, uint32_t block, uint32_t count, void *data)
+{
+    const struct ramdisk *ramdisk = (const struct ramdisk *)bdev->priv;
+    int32_t ret = ramdisk_check_range(ramdisk, block, count);
+    if (ret < 0) goto exit;
+
+    memcpy(data, &ramdisk->storage[block * ramdisk->block_size], count * ramdisk->block_size);
+    ret = count * ramdisk->block_size;
+
+    exit:
+    return ret;
+}
+
+static int32_t ramdisk_write(const struct blockdev_device * const bdev, uint32_t block, uint32_t count,
+    const void *data)
+{
+    const struct ramdisk *ramdisk = (const struct ramdisk *)bdev->priv;
+    int32_t ret = ramdisk_check_range(ramdisk, block, count);
+    if (ret < 0) goto exit;
+
+    memcpy(&ramdisk->storage[block * ramdisk->block_size], data, count * ramdisk->block_size);
+    ret = count * ramdisk->block_size;
+
+    exit:
+    return ret;
+}
+
+static int32_t ramdisk_trim(const struct blockdev_device * const bdev, uint32_t block, uint32_t count)
+{
+    const struct ramdisk *ramdisk = (const struct ramdisk *)bdev->priv;
+    return ramdisk_check_range(ramdisk, block, count);
+}
+
+static int32_t ramdisk_flush(const struct blockdev_device * const bdev)
+{
+    (void)bdev;
+    return E_SUCCESS;
+}
+
+static int32_t ramdisk_geometry(const struct blockdev_device * const bdev, struct blockdev_geometry *geometry)
+{
+    const struct ramdisk *ramdisk = (const struct ramdisk *)bdev->priv;
+
+    geometry->block_size = ramdisk->block_size;
+    geometry->block_count = ramdisk->block_count;
+    return E_SUCCESS;
+}
+
+const struct blockdev_operations ramdisk_blockdev_ops = {
+    .blockdev_init = ramdisk_init,
+    .blockdev_read_op = ramdisk_read,
+    .blockdev_write_op = ramdisk_write,
+    .blockdev_trim_op = ramdisk_trim,
+    .blockdev_flush_op = ramdisk_flush,
+    .blockdev_geometry_op = ramdisk_geometry,
+    .blockdev_submit_op = blockdev_submit_sync,
+};
@@ -0,0 +1,33 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#ifndef DRIVERS_RAMDISK_RAMDISK_H_
+#define DRIVERS_RAMDISK_RAMDISK_H_
+
+#include "include/device/blockdev.h"
+
+#include <stdint.h>
+
+/**
+ * @brief A block device stored in RAM. Has no latency, which is useful to measure filesystem overhead alone
+ */
+struct ramdisk {
+    /** Storage with at least block_size * block_count bytes */
+    uint8_t * const storage;
+    /** Size of a block in bytes */
+    const uint32_t block_size;
+    /** Number of blocks */
+    const uint32_t block_count;
+};
+
+/**
+ * @brief Block device operations for a RAM disk. priv must point to a const struct ramdisk
+ */
+extern const struct blockdev_operations ramdisk_blockdev_ops;
+
+#endif // DRIVERS_RAMDISK_RAMDISK_H_
@@ -13,16 +13,30 @@
 
 #include <stdint.h>
 
+/**
+ * @brief How the CRC16 of data blocks is calculated
+ */
+enum sdcard_crc_mode {
+    /** CRC16 is calculated over the whole block before writing or after reading it (default) */
+    SDCARD_CRC_BLOCK = 0,
+    /** No CRC16 is calculated. Integrity must be checked by a higher layer. Can not be used with crc_check */
+    SDCARD_CRC_OFF,
+};
+
 struct sdcard {
     /** Private implementation-specific object */
     const void *priv;
+    /** CRC calculation for data blocks */
+    enum sdcard_crc_mode crc_mode;
+    /** Non-zero makes the SDCARD check the CRC of the commands and blocks it receives (CMD59) */
+    uint8_t crc_check;
 };
 
 /**
  * @brief Configures SDCARD as SPI mode
  *
  * @param sdcard SDCARD object
- * @return int32_t E_SUCCESS on success
+ * @return int32_t E_SUCCESS on success. E_INVALID_PARAMETER if crc_check is set with SDCARD_CRC_OFF
  */
 extern int32_t sdcard_init(const struct sdcard * const sdcard);
 
@@ -46,4 +60,37 @@ extern int32_t sdcard_read_block(const struct sdcard * const sdcard, uint32_t bl
  */
 extern int32_t sdcard_write_block(const struct sdcard * const sdcard, uint32_t block_number, const void * const blk);
 
+/**
+ * @brief Reads consecutive blocks from the SDCARD in a single multiple block transfer (CMD18)
+ *
+ * @param sdcard SDCARD object
+ * @param block_number First block to read from
+ * @param count Number of blocks to read
+ * @param blk [output] Block data. Must hold count blocks
+ * @return int32_t Number of bytes read. Negative on error
+ */
+extern int32_t sdcard_read_blocks(const struct sdcard * const sdcard, uint32_t block_number, uint32_t count,
+    void * const blk);
+
+/**
+ * @brief Writes consecutive blocks to the SDCARD in a single multiple block transfer (CMD25)
+ *
+ * @param sdcard SDCARD object
+ * @param block_number First block to write to
+ * @param count Number of blocks to write
+ * @param blk [in] Block data with count blocks
+ * @return int32_t Number of bytes written. Negative on error
+ */
+extern int32_t sdcard_write_blocks(const struct sdcard * const sdcard, uint32_t block_number, uint32_t count,
+    const void * const blk);
+
+/**
+ * @brief Gets the capacity of the SDCARD, as read from its CSD register
+ *
+ * @param sdcard SDCARD object
+ * @param block_count [out] Number of 512 bytes blocks
+ * @return int32_t E_SUCCESS on success
+ */
+extern int32_t sdcard_get_block_count(const struct sdcard * const sdcard, uint32_t * const block_count);
+
 #endif // DRIVERS_SDCARD_SDCARD_H_
\ No newline at end of file
@@ -0,0 +1,65 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#include "drivers/sdcard/sdcard_blockdev.h"
+#include "drivers/sdcard/sdcard.h"
+
+#include "include/device/blockdev.h"
+#include "include/errors.h"
+
+#include <stdint.h>
+
+#define SDCARD_BLOCK_SIZE 512
+
+static int32_t sdcard_bdev_init(const struct blockdev_device * const bdev)
+{
+    return sdcard_init((const struct sdcard *)bdev->priv);
+}
+
+static int32_t sdcard_bdev_read(const struct blockdev_device * const bdev, uint32_t block, uint32_t count, void *data)
+{
+    return sdcard_read_blocks((const struct sdcard *)bdev->priv, block, count, data);
+}
+
+static int32_t sdcard_bdev_write(const struct blockdev_device * const bdev, uint32_t block, uint32_t count,
+    const void *data)
+{
+    return sdcard_write_blocks((const struct sdcard *)bdev->priv, block, count, data);
+}
+
+static int32_t sdcard_bdev_trim(const struct blockdev_device * const bdev, uint32_t block, uint32_t count)
+{
+    // Trim is only a hint. The driver does not implement erase commands yet
+    (void)bdev;
+    (void)block;
+    (void)count;
+    return E_SUCCESS;
+}
+
+static int32_t sdcard_bdev_flush(const struct blockdev_device * const bdev)
+{
+    // Writes only return after the SDCARD is no longer busy
+    (void)bdev;
+    return E_SUCCESS;
+}
+
+static int32_t sdcard_bdev_geometry(const struct blockdev_device * const bdev, struct blockdev_geometry *geometry)
+{
+    geometry->block_size = SDCARD_BLOCK_SIZE;
+    return sdcard_get_block_count((const struct sdcard *)bdev->priv, &geometry->block_count);
+}
+
+const struct blockdev_operations sdcard_blockdev_ops = {
+    .blockdev_init = sdcard_bdev_init,
+    .blockdev_read_op = sdcard_bdev_read,
+    .blockdev_write_op = sdcard_bdev_write,
+    .blockdev_trim_op = sdcard_bdev_trim,
+    .blockdev_flush_op = sdcard_bdev_flush,
+    .blockdev_geometry_op = sdcard_bdev_geometry,
+    .blockdev_submit_op = blockdev_submit_sync,
+};
@@ -0,0 +1,19 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#ifndef DRIVERS_SDCARD_SDCARD_BLOCKDEV_H_
+#define DRIVERS_SDCARD_SDCARD_BLOCKDEV_H_
+
+#include "include/device/blockdev.h"
+
+/**
+ * @brief Block device operations backed by the SDCARD driver. priv must point to a const struct sdcard
+ */
+extern const struct blockdev_operations sdcard_blockdev_ops;
+
+#endif // DRIVERS_SDCARD_SDCARD_BLOCKDEV_H_
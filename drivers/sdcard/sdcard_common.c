@@ -14,6 +14,19 @@
 
 #include <stdint.h>
 
+// CRC7 of the frames below were calculated with calc_crc7()
+const uint8_t sdcard_cmd0_frame[6]      = {0x40, 0x00, 0x00, 0x00, 0x00, 0x95};
+const uint8_t sdcard_cmd8_frame[6]      = {0x48, 0x00, 0x00, 0x01, 0x5a, 0x9b};
+const uint8_t sdcard_cmd9_frame[6]      = {0x49, 0x00, 0x00, 0x00, 0x00, 0xaf};
+const uint8_t sdcard_cmd12_frame[6]     = {0x4c, 0x00, 0x00, 0x00, 0x00, 0x61};
+const uint8_t sdcard_cmd13_frame[6]     = {0x4d, 0x00, 0x00, 0x00, 0x00, 0x0d};
+const uint8_t sdcard_cmd16_frame[6]     = {0x50, 0x00, 0x00, 0x02, 0x00, 0x15};
+const uint8_t sdcard_acmd41_frame[6]    = {0x69, 0x40, 0x00, 0x00, 0x00, 0x77};
+const uint8_t sdcard_cmd55_frame[6]     = {0x77, 0x00, 0x00, 0x00, 0x00, 0x65};
+const uint8_t sdcard_cmd58_frame[6]     = {0x7a, 0x00, 0x00, 0x00, 0x00, 0xfd};
+const uint8_t sdcard_cmd59_off_frame[6] = {0x7b, 0x00, 0x00, 0x00, 0x00, 0x91};
+const uint8_t sdcard_cmd59_on_frame[6]  = {0x7b, 0x00, 0x00, 0x00, 0x01, 0x83};
+
 uint8_t sdcard_calc_crc7(const void * const data, uint32_t size)
 {
     return calc_crc7(data, size);
@@ -33,4 +46,15 @@ void sdcard_build_command(uint8_t cmd, uint32_t data, uint8_t *output)
     output[4] = (data & 0x000000ff);
     uint8_t crc7 = sdcard_calc_crc7(&output[0], 5) << 1;
     output[5] =  crc7 | 0x01;
+}
+
+void sdcard_build_addr_command(uint8_t cmd, uint32_t addr, uint8_t *output, uint32_t need_crc)
+{
+    output[0] = (cmd & 0x3f) | 0x40;
+    output[1] = (addr & 0xff000000) >> 24;
+    output[2] = (addr & 0x00ff0000) >> 16;
+    output[3] = (addr & 0x0000ff00) >> 8;
+    output[4] = (addr & 0x000000ff);
+    // The end bit is mandatory even if the CRC is not checked
+    output[5] = need_crc ? (sdcard_calc_crc7(&output[0], 5) << 1) | 0x01 : 0xff;
 }
\ No newline at end of file
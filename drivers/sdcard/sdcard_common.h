@@ -42,4 +42,32 @@ extern uint16_t sdcard_calc_crc16(const void * const data, uint32_t size);
  */
 extern void sdcard_build_command(uint8_t cmd, uint32_t data, uint8_t *output);
 
+/**
+ * @brief Builds a SDCARD command that carries an address (CMD17, CMD18, CMD24, CMD25). CRC7 is only calculated
+ * when the SDCARD is checking it (CMD59), otherwise the last byte (CRC7 and end bit) is
+ * sent as 0xff
+ *
+ * @param cmd Command number
+ * @param addr Block or byte address for the command
+ * @param output [out] Buffer contaning the command
+ * @param need_crc Non-zero to calculate CRC7
+ */
+extern void sdcard_build_addr_command(uint8_t cmd, uint32_t addr, uint8_t *output, uint32_t need_crc);
+
+/*
+ * Pre-built frames (with CRC7) for commands whose argument never changes. These can be sent directly instead of
+ * calling sdcard_build_command()
+ */
+extern const uint8_t sdcard_cmd0_frame[6];      /** CMD0 GO_IDLE_STATE */
+extern const uint8_t sdcard_cmd8_frame[6];      /** CMD8 SEND_IF_COND, 2.7V to 3.6V and check pattern 0x5a */
+extern const uint8_t sdcard_cmd9_frame[6];      /** CMD9 SEND_CSD */
+extern const uint8_t sdcard_cmd12_frame[6];     /** CMD12 STOP_TRANSMISSION */
+extern const uint8_t sdcard_cmd13_frame[6];     /** CMD13 SEND_STATUS */
+extern const uint8_t sdcard_cmd16_frame[6];     /** CMD16 SET_BLOCKLEN to 512 bytes */
+extern const uint8_t sdcard_acmd41_frame[6];    /** ACMD41 SD_SEND_OP_COND with HCS set */
+extern const uint8_t sdcard_cmd55_frame[6];     /** CMD55 APP_CMD */
+extern const uint8_t sdcard_cmd58_frame[6];     /** CMD58 READ_OCR */
+extern const uint8_t sdcard_cmd59_off_frame[6]; /** CMD59 CRC_ON_OFF turning CRC off */
+extern const uint8_t sdcard_cmd59_on_frame[6];  /** CMD59 CRC_ON_OFF turning CRC on */
+
 #endif // DRIVERS_SDCARD_SDCARD_COMMON_H_
\ No newline at end of file
@@ -11,20 +11,32 @@
 #include "core/include/device/device.h"
 #include "core/include/device/spi.h"
 
+#include "libs/pbuf/pbuf.h"
+
 #include "ulibc/include/ustdio.h"
 #include "ulibc/include/log.h"
+#include "ulibc/include/utils.h"
 
 #include "components/vez-shell/include/vez-shell.h"
 
 #include "drivers/sdcard/sdcard.h"
 #include "drivers/sdcard/sdcard_spi_impl.h"
 
+#define SDCARD_INTERNAL
+#include "drivers/sdcard/sdcard_common.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+
 #include <stdlib.h>
 #include <stdint.h>
 #include <string.h>
 
 #define TAG "sdcard"
 
+/** Blocks are kept out of the shell task stack */
+PBUF_POOL_DEFINE(block_pool, 1, 512, 0);
+
 int sdcard(int argc, char **argv)
 {
     const struct sdcard_spi_priv priv = {
@@ -34,19 +46,24 @@ int sdcard(int argc, char **argv)
     const struct sdcard sdcard = {
         .priv = &priv
     };
-    uint8_t block[512];
+    struct pbuf *block = pbuf_alloc(&block_pool);
+    if (block == NULL) {
+        ERROR(TAG, "Out of block buffers");
+        return E_NO_MEMORY;
+    }
 
     int32_t ret = sdcard_init(&sdcard);
     DBG(TAG, "sdcard_init(): %s", error_to_str(ret));
     if (ret < 0) goto exit;
 
-    ret = sdcard_read_block(&sdcard, 0, block);
+    ret = sdcard_read_block(&sdcard, 0, pbuf_put(block, 512));
     DBG(TAG, "sdcard_read_block(): %s", error_to_str(ret));
     if (ret < 0) goto exit;
     DBG(TAG, "Amount read: %d", ret);
-    HEXDUMP(block, sizeof(block));
+    HEXDUMP(block->payload, block->size);
 
     exit:
+    pbuf_free(block);
     return E_SUCCESS;
 }
 
@@ -56,8 +73,12 @@ int sdwrite(int argc, char **argv)
 {
     uint8_t garbage = strtol(argv[0], NULL, 16);
     DBG(TAG, "Writing %.2x on SDCARD block 0", garbage);
-    uint8_t block[512];
-    memset(block, garbage, sizeof(block));
+    struct pbuf *block = pbuf_alloc(&block_pool);
+    if (block == NULL) {
+        ERROR(TAG, "Out of block buffers");
+        return E_NO_MEMORY;
+    }
+    memset(pbuf_put(block, 512), garbage, block->size);
 
     const struct sdcard_spi_priv priv = {
         .spi = device_get_by_name("spi1"),
@@ -71,13 +92,57 @@ int sdwrite(int argc, char **argv)
     DBG(TAG, "sdcard_init(): %s", error_to_str(ret));
     if (ret < 0) goto exit;
 
-    ret = sdcard_write_block(&sdcard, 0, block);
+    ret = sdcard_write_block(&sdcard, 0, block->payload);
     DBG(TAG, "sdcard_write_block(): %s", error_to_str(ret));
     if (ret < 0) goto exit;
     DBG(TAG, "Amount written: %d", ret);
 
     exit:
+    pbuf_free(block);
+    return E_SUCCESS;
+}
+
+SHELL_DECLARE_COMMAND("sdwrite", sdwrite, "Writes a full block to the SDCARD");
+
+int sdbench(int argc, char **argv)
+{
+    const uint32_t rounds = 10000;
+    uint8_t cmd[6];
+    volatile uint8_t sink = 0;
+    TickType_t start;
+
+    uprintf("Building %u command frames per method\r\n", rounds);
+
+    start = xTaskGetTickCount();
+    for (uint32_t i = 0; i < rounds; i++) {
+        sdcard_build_command(55, 0, cmd);
+        sink ^= cmd[5];
+    }
+    uprintf("sdcard_build_command(): %u ticks\r\n", xTaskGetTickCount() - start);
+
+    start = xTaskGetTickCount();
+    for (uint32_t i = 0; i < rounds; i++) {
+        sdcard_build_addr_command(17, i, cmd, TRUE);
+        sink ^= cmd[5];
+    }
+    uprintf("sdcard_build_addr_command() with CRC7: %u ticks\r\n", xTaskGetTickCount() - start);
+
+    start = xTaskGetTickCount();
+    for (uint32_t i = 0; i < rounds; i++) {
+        sdcard_build_addr_command(17, i, cmd, FALSE);
+        sink ^= cmd[5];
+    }
+    uprintf("sdcard_build_addr_command() without CRC7: %u ticks\r\n", xTaskGetTickCount() - start);
+
+    start = xTaskGetTickCount();
+    for (uint32_t i = 0; i < rounds; i++) {
+        const uint8_t *frame = sdcard_cmd55_frame;
+        sink ^= frame[5];
+    }
+    uprintf("Pre-built frame: %u ticks\r\n", xTaskGetTickCount() - start);
+
+    (void)sink;
     return E_SUCCESS;
 }
 
-SHELL_DECLARE_COMMAND("sdwrite", sdwrite, "Writes a full block to the SDCARD");
\ No newline at end of file
+SHELL_DECLARE_COMMAND("sdbench", sdbench, "Measures the cost of building SDCARD command frames");
\ No newline at end of file
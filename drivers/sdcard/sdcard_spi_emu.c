@@ -0,0 +1,527 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#include "drivers/sdcard/sdcard_spi_emu.h"
+
+#include "include/errors.h"
+#include "include/device/gpio.h"
+#include "include/device/spi.h"
+#include "include/device/transaction.h"
+
+#include "libs/crc7/crc7.h"
+#include "libs/crc16/crc16.h"
+
+#include "ulibc/include/utils.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define BLOCK_SIZE 512
+
+// R1 bits
+#define R1_IDLE_STATE               0x01
+#define R1_ILLEGAL_COMMAND          0x04
+#define R1_CRC_ERROR                0x08
+#define R1_ADDRESS_ERROR            0x20
+#define R1_PARAMETER_ERROR          0x40
+
+// Tokens
+#define TOKEN_START_BLOCK           0xfe
+#define TOKEN_START_BLOCK_MULTI     0xfc
+#define TOKEN_STOP_TRAN             0xfd
+#define TOKEN_DATA_ERROR_RANGE      0x08
+#define DATA_RESPONSE_ACCEPTED      0x05
+#define DATA_RESPONSE_CRC_ERROR     0x0b
+#define DATA_RESPONSE_WRITE_ERROR   0x0d
+
+static void queue_reset(struct sdcard_spi_emu * const emu)
+{
+    emu->out_len = 0;
+    emu->out_pos = 0;
+}
+
+static void queue_push(struct sdcard_spi_emu * const emu, uint8_t byte)
+{
+    if (emu->out_len < sizeof(emu->out)) emu->out[emu->out_len++] = byte;
+}
+
+static uint8_t r1(const struct sdcard_spi_emu * const emu)
+{
+    return emu->ready ? 0x00 : R1_IDLE_STATE;
+}
+
+/**
+ * @brief Converts a command argument to a block number according to the card addressing
+ *
+ * @return int32_t E_SUCCESS when the address is aligned and inside the image
+ */
+static int32_t arg_to_block(const struct sdcard_spi_emu * const emu, uint32_t arg, uint32_t *block)
+{
+    if (!emu->high_capacity) {
+        if (arg % BLOCK_SIZE) return E_INVALID_PARAMETER;
+        arg /= BLOCK_SIZE;
+    }
+    if (arg >= emu->blocks) return E_INVALID_PARAMETER;
+
+    *block = arg;
+    return E_SUCCESS;
+}
+
+/**
+ * @brief Queues the next block to be read: access time, start block token, data and CRC16
+ */
+static void queue_block(struct sdcard_spi_emu * const emu)
+{
+    if (emu->block >= emu->blocks) {
+        queue_push(emu, TOKEN_DATA_ERROR_RANGE);
+        emu->state = SDCARD_EMU_IDLE;
+        return;
+    }
+
+    uint32_t access = emu->access_bytes > SDCARD_EMU_MAX_ACCESS_BYTES ? SDCARD_EMU_MAX_ACCESS_BYTES : emu->access_bytes;
+    for (uint32_t i = 0; i < access; i++) queue_push(emu, 0xff);
+    queue_push(emu, TOKEN_START_BLOCK);
+
+    uint8_t *data = &emu->out[emu->out_len];
+    if (fseek(emu->image, (long)emu->block * BLOCK_SIZE, SEEK_SET) != 0 ||
+        fread(data, 1, BLOCK_SIZE, emu->image) != BLOCK_SIZE) {
+        memset(data, 0x00, BLOCK_SIZE);
+    }
+    emu->out_len += BLOCK_SIZE;
+
+    uint16_t crc16 = calc_crc16ccitt(data, BLOCK_SIZE);
+    emu->blocks_read++;
+    if (emu->read_crc_error_period && (emu->blocks_read % emu->read_crc_error_period) == 0) {
+        crc16 ^= 0xffff;
+        emu->crc_errors++;
+    }
+    queue_push(emu, crc16 >> 8);
+    queue_push(emu, crc16 & 0xff);
+
+    emu->block++;
+}
+
+/**
+ * @brief Finds how a SDSC card tells its capacity: the smallest shift that lets C_SIZE (12 bits) count the blocks
+ *
+ * The capacity is (C_SIZE + 1) * 2^(C_SIZE_MULT + 2) * 2^READ_BL_LEN bytes, so the shift in blocks is
+ * C_SIZE_MULT + 2 + READ_BL_LEN - 9. C_SIZE_MULT grows first, then READ_BL_LEN goes from 9 up to 11 as in 2GB
+ * and 4GB cards
+ *
+ * @return uint32_t Shift, from 2 to 11. Above 11 when the image is too large for a SDSC card
+ */
+static uint32_t csd_v1_shift(uint32_t blocks)
+{
+    uint32_t shift = 2;
+
+    while ((blocks >> shift) > 4096) shift++;
+
+    return shift;
+}
+
+/**
+ * @brief Queues the CSD register as a data block. Version 2.0 for SDHC and version 1.0 for SDSC. The capacity is
+ * rounded down to what the CSD can encode; sdcard_spi_emu_open() rejects images it can not encode at all
+ */
+static void queue_csd(struct sdcard_spi_emu * const emu)
+{
+    uint8_t csd[16] = {0};
+
+    if (emu->high_capacity) {
+        // C_SIZE [69:48], capacity is (C_SIZE + 1) * 512KiB
+        uint32_t c_size = emu->blocks / 1024 - 1;
+        csd[0] = 0x40;
+        csd[5] = 0x59; // CCC and READ_BL_LEN = 9
+        csd[7] = (c_size >> 16) & 0x3f;
+        csd[8] = (c_size >> 8) & 0xff;
+        csd[9] = c_size & 0xff;
+    } else {
+        // C_SIZE [73:62], C_SIZE_MULT [49:47] and READ_BL_LEN [83:80]
+        uint32_t shift = csd_v1_shift(emu->blocks);
+        uint32_t c_size_mult = CHOOSE_MIN(shift - 2, 7);
+        uint32_t read_bl_len = 9 + shift - 2 - c_size_mult;
+        uint32_t c_size = (emu->blocks >> shift) - 1;
+        csd[5] = 0x50 | read_bl_len;
+        csd[6] = (c_size >> 10) & 0x03;
+        csd[7] = (c_size >> 2) & 0xff;
+        csd[8] = (c_size & 0x03) << 6;
+        csd[9] = (c_size_mult >> 1) & 0x03;
+        csd[10] = (c_size_mult & 0x01) << 7;
+    }
+
+    queue_push(emu, TOKEN_START_BLOCK);
+    for (uint32_t i = 0; i < sizeof(csd); i++) queue_push(emu, csd[i]);
+    uint16_t crc16 = calc_crc16ccitt(csd, sizeof(csd));
+    queue_push(emu, crc16 >> 8);
+    queue_push(emu, crc16 & 0xff);
+}
+
+static void execute_command(struct sdcard_spi_emu * const emu)
+{
+    const uint8_t index = emu->cmd[0] & 0x3f;
+    const uint32_t arg = (uint32_t)emu->cmd[1] << 24 | (uint32_t)emu->cmd[2] << 16 | (uint32_t)emu->cmd[3] << 8 | emu->cmd[4];
+    const uint32_t app_cmd = emu->app_cmd;
+    uint32_t block;
+
+    emu->commands++;
+    emu->app_cmd = 0;
+
+    // Any pending data (e.g. CMD12 in the middle of a CMD18) is dropped. One byte of NCR precedes the response
+    queue_reset(emu);
+    queue_push(emu, 0xff);
+
+    // CMD0 and CMD8 are always checked. The rest only when CMD59 turned CRC on
+    if (emu->crc_on || index == 0 || index == 8) {
+        if (((calc_crc7(emu->cmd, 5) << 1) | 0x01) != emu->cmd[5]) {
+            emu->crc_errors++;
+            queue_push(emu, r1(emu) | R1_CRC_ERROR);
+            return;
+        }
+    }
+
+    switch (index) {
+        case 0:
+            emu->ready = 0;
+            emu->crc_on = 0;
+            emu->acmd41_left = emu->init_acmd41_count;
+            emu->state = SDCARD_EMU_IDLE;
+            queue_push(emu, r1(emu));
+            break;
+
+        case 8:
+            queue_push(emu, r1(emu));
+            queue_push(emu, 0x00);
+            queue_push(emu, 0x00);
+            queue_push(emu, (arg >> 8) & 0x0f);
+            queue_push(emu, arg & 0xff);
+            break;
+
+        case 9:
+            queue_push(emu, r1(emu));
+            queue_csd(emu);
+            break;
+
+        case 12:
+            emu->state = SDCARD_EMU_IDLE;
+            queue_push(emu, r1(emu));
+            break;
+
+        case 13:
+            queue_push(emu, r1(emu));
+            queue_push(emu, 0x00);
+            break;
+
+        case 16:
+            queue_push(emu, arg == BLOCK_SIZE ? r1(emu) : r1(emu) | R1_PARAMETER_ERROR);
+            break;
+
+        case 17:
+        case 18:
+        case 24:
+        case 25:
+            if (!emu->ready) {
+                queue_push(emu, r1(emu) | R1_ILLEGAL_COMMAND);
+                break;
+            }
+            if (arg_to_block(emu, arg, &block) < 0) {
+                queue_push(emu, r1(emu) | R1_ADDRESS_ERROR);
+                break;
+            }
+            queue_push(emu, r1(emu));
+            emu->block = block;
+            if (index == 17) {
+                queue_block(emu);
+            } else if (index == 18) {
+                emu->state = SDCARD_EMU_READ_MULTI;
+            } else {
+                emu->multi_write = (index == 25);
+                emu->state = SDCARD_EMU_WRITE_TOKEN;
+            }
+            break;
+
+        case 41:
+            if (!app_cmd) {
+                queue_push(emu, r1(emu) | R1_ILLEGAL_COMMAND);
+                break;
+            }
+            if (emu->acmd41_left) emu->acmd41_left--;
+            else emu->ready = 1;
+            queue_push(emu, r1(emu));
+            break;
+
+        case 55:
+            emu->app_cmd = 1;
+            queue_push(emu, r1(emu));
+            break;
+
+        case 58:
+            // OCR: power up status and CCS (bits 31 and 30), 2.7V to 3.6V window
+            queue_push(emu, r1(emu));
+            queue_push(emu, emu->ready ? (0x80 | (emu->high_capacity ? 0x40 : 0x00)) : 0x00);
+            queue_push(emu, 0xff);
+            queue_push(emu, 0x80);
+            queue_push(emu, 0x00);
+            break;
+
+        case 59:
+            emu->crc_on = arg & 0x01;
+            queue_push(emu, r1(emu));
+            break;
+
+        default:
+            queue_push(emu, r1(emu) | R1_ILLEGAL_COMMAND);
+            break;
+    }
+}
+
+static void receive_block(struct sdcard_spi_emu * const emu)
+{
+    uint16_t crc16 = (uint16_t)emu->data[BLOCK_SIZE] << 8 | emu->data[BLOCK_SIZE + 1];
+    uint32_t bad_crc = emu->crc_on && crc16 != calc_crc16ccitt(emu->data, BLOCK_SIZE);
+    emu->blocks_received++;
+    uint32_t injected = emu->write_crc_error_period && (emu->blocks_received % emu->write_crc_error_period) == 0;
+
+    queue_reset(emu);
+    if (bad_crc || injected) {
+        emu->crc_errors++;
+        queue_push(emu, DATA_RESPONSE_CRC_ERROR);
+    } else if (emu->block >= emu->blocks ||
+        fseek(emu->image, (long)emu->block * BLOCK_SIZE, SEEK_SET) != 0 ||
+        fwrite(emu->data, 1, BLOCK_SIZE, emu->image) != BLOCK_SIZE) {
+        queue_push(emu, DATA_RESPONSE_WRITE_ERROR);
+    } else {
+        emu->blocks_written++;
+        queue_push(emu, DATA_RESPONSE_ACCEPTED);
+        emu->busy_left = emu->busy_bytes;
+    }
+
+    emu->block++;
+    emu->state = emu->multi_write ? SDCARD_EMU_WRITE_TOKEN : SDCARD_EMU_IDLE;
+}
+
+/**
+ * @brief Consumes a byte sent by the host (MOSI)
+ */
+static void feed(struct sdcard_spi_emu * const emu, uint8_t byte)
+{
+    switch (emu->state) {
+        case SDCARD_EMU_WRITE_TOKEN:
+            if (byte == TOKEN_START_BLOCK || (emu->multi_write && byte == TOKEN_START_BLOCK_MULTI)) {
+                emu->data_len = 0;
+                emu->state = SDCARD_EMU_WRITE_DATA;
+            } else if (emu->multi_write && byte == TOKEN_STOP_TRAN) {
+                queue_reset(emu);
+                queue_push(emu, 0xff);
+                emu->busy_left = emu->busy_bytes;
+                emu->state = SDCARD_EMU_IDLE;
+            }
+            break;
+
+        case SDCARD_EMU_WRITE_DATA:
+            emu->data[emu->data_len++] = byte;
+            if (emu->data_len == sizeof(emu->data)) receive_block(emu);
+            break;
+
+        case SDCARD_EMU_IDLE:
+        case SDCARD_EMU_READ_MULTI:
+        default:
+            // Commands start with 01b. Anything else between commands is ignored
+            if (emu->cmd_len == 0 && (byte & 0xc0) != 0x40) break;
+            emu->cmd[emu->cmd_len++] = byte;
+            if (emu->cmd_len == sizeof(emu->cmd)) {
+                emu->cmd_len = 0;
+                execute_command(emu);
+            }
+            break;
+    }
+}
+
+/**
+ * @brief Produces the byte the card puts on MISO for the current clock
+ */
+static uint8_t next_out(struct sdcard_spi_emu * const emu)
+{
+    if (emu->out_pos < emu->out_len) return emu->out[emu->out_pos++];
+
+    if (emu->busy_left) {
+        emu->busy_left--;
+        return 0x00;
+    }
+
+    if (emu->state == SDCARD_EMU_READ_MULTI) {
+        queue_reset(emu);
+        queue_block(emu);
+        return emu->out_pos < emu->out_len ? emu->out[emu->out_pos++] : 0xff;
+    }
+
+    return 0xff;
+}
+
+/**
+ * @brief Full duplex exchange of one byte. The answer to a byte can only appear on the next clock
+ */
+static uint8_t exchange(struct sdcard_spi_emu * const emu, uint8_t in)
+{
+    emu->bus_bytes++;
+    if (!emu->cs_low) return 0xff;
+
+    uint8_t out = next_out(emu);
+    feed(emu, in);
+    return out;
+}
+
+static int32_t emu_spi_init(const struct spi_device * const spi)
+{
+    (void)spi;
+    return E_SUCCESS;
+}
+
+static int32_t emu_spi_write(const struct spi_device * const spi, const void *data, uint32_t size, uint32_t timeout)
+{
+    (void)timeout;
+    struct sdcard_spi_emu *emu = (struct sdcard_spi_emu *)spi->priv;
+    const uint8_t *udata = (const uint8_t *)data;
+
+    for (uint32_t i = 0; i < size; i++) exchange(emu, udata[i]);
+
+    return size;
+}
+
+static int32_t emu_spi_read(const struct spi_device * const spi, void *data, uint32_t size, uint32_t timeout)
+{
+    (void)timeout;
+    struct sdcard_spi_emu *emu = (struct sdcard_spi_emu *)spi->priv;
+    uint8_t *udata = (uint8_t *)data;
+
+    for (uint32_t i = 0; i < size; i++) udata[i] = exchange(emu, 0xff);
+
+    return size;
+}
+
+static int32_t emu_spi_transact(const struct spi_device * const spi, struct spi_transaction * const transaction,
+    uint32_t timeout)
+{
+    (void)timeout;
+    struct sdcard_spi_emu *emu = (struct sdcard_spi_emu *)spi->priv;
+    const uint8_t *wdata = (const uint8_t *)transaction->write_data;
+    uint8_t *rdata = (uint8_t *)transaction->read_data;
+    uint32_t size = transaction->write_size > transaction->read_size ? transaction->write_size : transaction->read_size;
+
+    for (uint32_t i = 0; i < size; i++) {
+        uint8_t out = exchange(emu, i < transaction->write_size ? wdata[i] : 0xff);
+        if (i < transaction->read_size) rdata[i] = out;
+    }
+
+    return E_SUCCESS;
+}
+
+const struct spi_operations sdcard_spi_emu_spi_ops = {
+    .spi_init = emu_spi_init,
+    .spi_write_op = emu_spi_write,
+    .spi_read_op = emu_spi_read,
+    .spi_transact_op = emu_spi_transact,
+};
+
+static int32_t emu_cs_init(const struct gpio_device * const gpio)
+{
+    (void)gpio;
+    return E_SUCCESS;
+}
+
+static void emu_cs_write(const struct gpio_device * const gpio, int32_t value)
+{
+    struct sdcard_spi_emu *emu = (struct sdcard_spi_emu *)gpio->priv;
+
+    emu->cs_low = (value == GPIO_LOW);
+    // A partially received command is lost when the card is deselected
+    if (!emu->cs_low) emu->cmd_len = 0;
+}
+
+static int32_t emu_cs_read(const struct gpio_device * const gpio)
+{
+    const struct sdcard_spi_emu *emu = (const struct sdcard_spi_emu *)gpio->priv;
+    return !emu->cs_low;
+}
+
+static void emu_cs_toggle(const struct gpio_device * const gpio)
+{
+    emu_cs_write(gpio, emu_cs_read(gpio) ? GPIO_LOW : GPIO_HIGH);
+}
+
+const struct gpio_operations sdcard_spi_emu_cs_ops = {
+    .gpio_init = emu_cs_init,
+    .gpio_write_op = emu_cs_write,
+    .gpio_read_op = emu_cs_read,
+    .gpio_toggle_op = emu_cs_toggle,
+};
+
+int32_t sdcard_spi_emu_open(struct sdcard_spi_emu * const emu, const char *path)
+{
+    int32_t ret = E_SUCCESS;
+
+    if (emu == NULL || path == NULL) {
+        ret = E_INVALID_PARAMETER;
+        goto exit;
+    }
+
+    emu->image = fopen(path, "r+b");
+    if (emu->image == NULL) {
+        ret = E_DEVICE_NOT_FOUND;
+        goto exit;
+    }
+
+    fseek(emu->image, 0, SEEK_END);
+    long size = ftell(emu->image);
+    if (size <= 0 || (size % BLOCK_SIZE) != 0) {
+        fclose(emu->image);
+        emu->image = NULL;
+        ret = E_INVALID_PARAMETER;
+        goto exit;
+    }
+
+    // The CSD must be able to tell the capacity: 512KiB units for SDHC, up to 4GiB for SDSC
+    if (size > 0x100000000L) {
+        fclose(emu->image);
+        emu->image = NULL;
+        ret = E_INVALID_PARAMETER;
+        goto exit;
+    }
+    emu->blocks = size / BLOCK_SIZE;
+    if (emu->high_capacity ? emu->blocks < 1024 : (emu->blocks < 4 || csd_v1_shift(emu->blocks) > 11)) {
+        fclose(emu->image);
+        emu->image = NULL;
+        ret = E_INVALID_PARAMETER;
+        goto exit;
+    }
+
+    emu->commands = 0;
+    emu->bus_bytes = 0;
+    emu->blocks_read = 0;
+    emu->blocks_written = 0;
+    emu->crc_errors = 0;
+    emu->blocks_received = 0;
+    emu->cs_low = 0;
+    emu->ready = 0;
+    emu->app_cmd = 0;
+    emu->crc_on = 0;
+    emu->acmd41_left = emu->init_acmd41_count;
+    emu->state = SDCARD_EMU_IDLE;
+    emu->cmd_len = 0;
+    emu->busy_left = 0;
+    queue_reset(emu);
+
+    exit:
+    return ret;
+}
+
+void sdcard_spi_emu_close(struct sdcard_spi_emu * const emu)
+{
+    if (emu->image != NULL) fclose(emu->image);
+    emu->image = NULL;
+}
@@ -0,0 +1,113 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#ifndef DRIVERS_SDCARD_SDCARD_SPI_EMU_H_
+#define DRIVERS_SDCARD_SDCARD_SPI_EMU_H_
+
+#include "include/device/gpio.h"
+#include "include/device/spi.h"
+
+#include <stdint.h>
+#include <stdio.h>
+
+/**
+ * @brief Host-side emulation of a SDCARD speaking the SPI-mode protocol over a disk image file.
+ *
+ * The emulator provides a spi_device and a gpio_device (the chip select) that can be handed to
+ * sdcard_spi_impl.c through struct sdcard_spi_priv:
+ *
+ *     static struct sdcard_spi_emu emu = {.high_capacity = 1, .busy_bytes = 64};
+ *     const struct spi_device spi = {.ops = &sdcard_spi_emu_spi_ops, .priv = &emu};
+ *     const struct gpio_device cs = {.ops = &sdcard_spi_emu_cs_ops, .priv = &emu};
+ *     sdcard_spi_emu_open(&emu, "card.img");
+ *
+ * Supported commands: CMD0, CMD8, CMD9, CMD12, CMD13, CMD16, CMD17, CMD18, CMD24, CMD25, CMD55, ACMD41, CMD58 and CMD59.
+ */
+
+/** Maximum number of 0xff bytes before the start block token of a read */
+#define SDCARD_EMU_MAX_ACCESS_BYTES 8
+
+/** Internal state of the emulated card */
+enum sdcard_spi_emu_state {
+    SDCARD_EMU_IDLE,            /** Waiting for a command */
+    SDCARD_EMU_READ_MULTI,      /** Streaming blocks after CMD18 until CMD12 */
+    SDCARD_EMU_WRITE_TOKEN,     /** Waiting for a start block token after CMD24/CMD25 */
+    SDCARD_EMU_WRITE_DATA,      /** Receiving block data and CRC16 */
+};
+
+struct sdcard_spi_emu {
+    /* Configuration. Must be filled before sdcard_spi_emu_open() */
+
+    /** Non-zero emulates a SDHC card (block addressing), zero emulates a SDSC card (byte addressing) */
+    uint32_t high_capacity;
+    /** Number of ACMD41 the card answers as still idle before being ready */
+    uint32_t init_acmd41_count;
+    /** Number of 0xff bytes the card sends before the start block token of a read (up to SDCARD_EMU_MAX_ACCESS_BYTES) */
+    uint32_t access_bytes;
+    /** Number of busy (0x00) bytes the card sends after receiving a block */
+    uint32_t busy_bytes;
+    /** Every Nth block read is sent with a corrupted CRC16. Zero disables it */
+    uint32_t read_crc_error_period;
+    /** Every Nth block written is answered with a CRC error token. Zero disables it */
+    uint32_t write_crc_error_period;
+
+    /* Statistics */
+
+    uint32_t commands;          /** Number of commands received */
+    uint32_t blocks_read;       /** Number of blocks sent to the host */
+    uint32_t blocks_written;    /** Number of blocks written to the image */
+    uint32_t crc_errors;        /** Number of CRC errors (detected or injected) */
+    uint32_t bus_bytes;         /** Number of bytes clocked on the bus, selected or not */
+
+    /* Private state. Do not touch */
+
+    FILE *image;
+    uint32_t blocks;
+    uint32_t cs_low;
+    uint32_t ready;
+    uint32_t app_cmd;
+    uint32_t crc_on;
+    uint32_t acmd41_left;
+    enum sdcard_spi_emu_state state;
+    uint32_t multi_write;
+    uint32_t block;
+    uint32_t blocks_received;
+    uint8_t cmd[6];
+    uint32_t cmd_len;
+    uint8_t data[512 + 2];
+    uint32_t data_len;
+    uint8_t out[2 + SDCARD_EMU_MAX_ACCESS_BYTES + 1 + 512 + 2];
+    uint32_t out_len;
+    uint32_t out_pos;
+    uint32_t busy_left;
+};
+
+/** SPI operations of the emulated card. priv must point to a struct sdcard_spi_emu */
+extern const struct spi_operations sdcard_spi_emu_spi_ops;
+
+/** Chip select operations of the emulated card. priv must point to the same struct sdcard_spi_emu */
+extern const struct gpio_operations sdcard_spi_emu_cs_ops;
+
+/**
+ * @brief Opens the disk image used as card storage. Its size defines the card capacity
+ *
+ * @param emu Emulator object
+ * @param path Path to the image file. Must exist and be a multiple of 512 bytes. SDHC images must hold at least
+ * 512KiB, SDSC images from 2KiB up to 4GiB
+ * @return int32_t E_SUCCESS on success. E_INVALID_PARAMETER if the CSD can not tell the size of the image
+ */
+extern int32_t sdcard_spi_emu_open(struct sdcard_spi_emu * const emu, const char *path);
+
+/**
+ * @brief Closes the disk image
+ *
+ * @param emu Emulator object
+ */
+extern void sdcard_spi_emu_close(struct sdcard_spi_emu * const emu);
+
+#endif // DRIVERS_SDCARD_SDCARD_SPI_EMU_H_
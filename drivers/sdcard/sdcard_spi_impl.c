@@ -31,9 +31,21 @@
 /** SDCARD Start of transmission byte */
 #define SDCARD_SOT 0xfe
 
+/** SDCARD Start of transmission byte for each block of a multiple block write */
+#define SDCARD_SOT_MULTI 0xfc
+
+/** SDCARD Stop transmission byte of a multiple block write */
+#define SDCARD_STOP_TRAN 0xfd
+
 /** Number maximum of bytes that the SDCARD takes to start block reading */
 #define SOT_MAX_DELAY_IN_BYTES 32
 
+// Data response token
+#define DATA_RESPONSE_MASK          0x1f
+#define DATA_RESPONSE_ACCEPTED      0x05
+#define DATA_RESPONSE_CRC_ERROR     0x0b
+#define DATA_RESPONSE_WRITE_ERROR   0x0d
+
 // R1 bits
 #define R1_READY_STATE              0x00
 #define R1_IDLE_STATE               0x01
@@ -178,17 +190,21 @@ int32_t sdcard_init(const struct sdcard * const sdcard)
     int32_t ret = E_SUCCESS;
     const struct sdcard_spi_priv *priv = (const struct sdcard_spi_priv *)sdcard->priv;
     uint8_t r1, r3r7[5];
-    uint8_t cmd[DEFAULT_SIZE_CMD];
-    uint32_t hcs = 0x00000000;
     int32_t need_to_set_block_size = FALSE;
 
+    sdcard_shift_count = 0;
+
+    if (sdcard->crc_check && sdcard->crc_mode == SDCARD_CRC_OFF) {
+        ret = E_INVALID_PARAMETER;
+        goto exit;
+    }
+
     // Sends 80 clock cycles with CS low
     gpio_write(priv->cs, GPIO_HIGH);
     spi_write(priv->spi, idle_80clock, sizeof(idle_80clock), 0);
 
     // Sends CMD0
-    sdcard_build_command(0, 0x00000000, cmd);
-    ret = send_cmd_and_get_r1_response(sdcard, cmd, &r1);
+    ret = send_cmd_and_get_r1_response(sdcard, sdcard_cmd0_frame, &r1);
     DBG(TAG, "r1_response(): %s", error_to_str(ret));
     if (ret < 0) goto exit;
     if (r1 != R1_IDLE_STATE) {
@@ -197,8 +213,7 @@ int32_t sdcard_init(const struct sdcard * const sdcard)
     }
 
     // Sends CMD8
-    sdcard_build_command(8, 0x0000015a, cmd);
-    ret = send_cmd_and_get_r3_r7_response(sdcard, cmd, &r3r7[0]);
+    ret = send_cmd_and_get_r3_r7_response(sdcard, sdcard_cmd8_frame, &r3r7[0]);
     DBG(TAG, "r1_r3_response(): %s", error_to_str(ret));
     if (ret < 0) goto exit;
     HEXDUMP(r3r7, sizeof(r3r7));
@@ -214,25 +229,21 @@ int32_t sdcard_init(const struct sdcard * const sdcard)
         ret = E_HARDWARE_CONFIG_FAILED;
         goto exit;
     }
-    hcs = 0x40000000;
-
     // Sends CMD55 and CMD41
     int retry = 2048;
     do {
-        sdcard_build_command(55, 0, cmd);
-        ret = send_cmd_and_get_r1_response(sdcard, cmd, &r1);
+        ret = send_cmd_and_get_r1_response(sdcard, sdcard_cmd55_frame, &r1);
         if (ret == E_TIMEOUT) continue;
         if (r1 != R1_IDLE_STATE) continue;
 
-        sdcard_build_command(41, hcs, cmd);
-        ret = send_cmd_and_get_r1_response(sdcard, cmd, &r1);
+        // HCS is always set since CMD8 was accepted
+        ret = send_cmd_and_get_r1_response(sdcard, sdcard_acmd41_frame, &r1);
         if (ret == E_TIMEOUT) continue;
         if (r1 == R1_READY_STATE) break;
     } while(--retry);
 
     // Sends CMD58
-    sdcard_build_command(58, 0, cmd);
-    ret = send_cmd_and_get_r3_r7_response(sdcard, cmd, r3r7);
+    ret = send_cmd_and_get_r3_r7_response(sdcard, sdcard_cmd58_frame, r3r7);
     DBG(TAG, "r1_r3_response(): %s", error_to_str(ret));
     if (ret < 0) goto exit;
     HEXDUMP(r3r7, sizeof(r3r7));
@@ -240,43 +251,48 @@ int32_t sdcard_init(const struct sdcard * const sdcard)
         ret = E_HARDWARE_CONFIG_FAILED;
         goto exit;
     }
-    if (IS_BIT_CLEAR(r3r7[0], 0x40)) {
+    // CCS is bit 30 of the OCR, that comes right after R1
+    if (IS_BIT_CLEAR(r3r7[1], 0x40)) {
         // SDCARD is byte-oriented
         need_to_set_block_size = TRUE;
     }
 
     if (need_to_set_block_size) {
-        sdcard_build_command(16, DEFAULT_BLOCK_SIZE, cmd);
-        ret = send_cmd_and_get_r1_response(sdcard, cmd, &r1);
+        ret = send_cmd_and_get_r1_response(sdcard, sdcard_cmd16_frame, &r1);
         DBG(TAG, "r1_r3_response(): %s", error_to_str(ret));
         if (ret < 0) goto exit;
         sdcard_shift_count = 9;
     }
 
+    // Sends CMD59 to turn CRC checking on the SDCARD on. SPI mode starts with it off
+    if (sdcard->crc_check) {
+        ret = send_cmd_and_get_r1_response(sdcard, sdcard_cmd59_on_frame, &r1);
+        DBG(TAG, "r1_response(): %s", error_to_str(ret));
+        if (ret < 0) goto exit;
+        if (r1 != R1_READY_STATE) {
+            ret = E_HARDWARE_CONFIG_FAILED;
+            goto exit;
+        }
+    }
+
     exit:
     return ret;
 }
 
-int32_t sdcard_read_block(const struct sdcard * const sdcard, uint32_t block_number, void * const blk)
+/**
+ * @brief Waits for the start block token and receives a data block with its CRC16. CS must already be LOW
+ *
+ * @param sdcard SDCARD object
+ * @param blk [out] Block data
+ * @return int32_t Number of bytes read. Negative on error
+ */
+static int32_t receive_data_block(const struct sdcard * const sdcard, void * const blk)
 {
-    int32_t ret = E_SUCCESS;
-    uint8_t cmd[DEFAULT_SIZE_CMD];
-    uint8_t r1, rxd;
+    int32_t ret;
     const struct sdcard_spi_priv *priv = (const struct sdcard_spi_priv *)sdcard->priv;
+    uint8_t rxd;
     uint16_t crc16;
 
-    // Sends CMD17 to read single block
-    if (sdcard_shift_count) block_number <<= sdcard_shift_count;
-    sdcard_build_command(17, block_number, cmd);
-    ret = send_cmd_and_get_r1_response(sdcard, cmd, &r1);
-    if (ret < 0) goto exit;
-    if (r1 != R1_READY_STATE) {
-        ret = E_INVALID_HARDWARE;
-        goto exit;
-    }
-
-    gpio_write(priv->cs, GPIO_LOW);
-
     int32_t retry = SOT_MAX_DELAY_IN_BYTES;
     do {
         ret = spi_read(priv->spi, &rxd, sizeof(rxd), 0);
@@ -288,22 +304,149 @@ int32_t sdcard_read_block(const struct sdcard * const sdcard, uint32_t block_num
         goto exit;
     }
 
-    int32_t amount_read = spi_read(priv->spi, blk, 512, 0);
-    if (amount_read < 0) goto exit;
+    int32_t amount_read = spi_read(priv->spi, blk, DEFAULT_BLOCK_SIZE, 0);
+    if (amount_read < 0) {
+        ret = amount_read;
+        goto exit;
+    }
+    uint16_t block_crc16 = 0x0000;
+    if (sdcard->crc_mode == SDCARD_CRC_BLOCK) block_crc16 = sdcard_calc_crc16(blk, DEFAULT_BLOCK_SIZE);
+
+    // CRC16 must be clocked out even if not checked
     ret = spi_read(priv->spi, &crc16, sizeof(crc16), 0);
     if (ret < 0) goto exit;
     crc16 = REV16(crc16); // SDCARD is BIG ENDIAN therefore must revert for this is little endian
 
     // Checks CRC16
-    uint16_t block_crc16 = sdcard_calc_crc16(blk, 512);
+    if (sdcard->crc_mode != SDCARD_CRC_OFF) {
+        DBG(TAG, "crc16 == %.4x, block_crc16 = %.4x", crc16, block_crc16);
+        if (block_crc16 != crc16) {
+            ret = E_INVALID_CRC;
+            goto exit;
+        }
+    }
 
-    DBG(TAG, "crc16 == %.4x, block_crc16 = %.4x", crc16, block_crc16);
-    if (block_crc16 != crc16) {
-        ret = E_INVALID_CRC;
+    ret = amount_read;
+
+    exit:
+    return ret;
+}
+
+/**
+ * @brief Waits until the SDCARD releases the bus (stops sending busy bytes). CS must already be LOW
+ *
+ * @param sdcard SDCARD object
+ * @return int32_t E_SUCCESS on success
+ */
+static int32_t wait_not_busy(const struct sdcard * const sdcard)
+{
+    int32_t ret;
+    const struct sdcard_spi_priv *priv = (const struct sdcard_spi_priv *)sdcard->priv;
+    uint8_t bsy;
+
+    int32_t retry = 2048;
+    do {
+        ret = spi_read(priv->spi, &bsy, sizeof(bsy), 0);
+        if (ret < 0) goto exit;
+        if (bsy == 0xff) break;
+    } while(--retry);
+
+    ret = retry == 0 ? E_TIMEOUT : E_SUCCESS;
+
+    exit:
+    return ret;
+}
+
+/**
+ * @brief Sends a data block with its CRC16 and waits for the SDCARD to write it. CS must already be LOW
+ *
+ * @param sdcard SDCARD object
+ * @param token Start block token
+ * @param blk [in] Block data
+ * @return int32_t Number of bytes written. Negative on error
+ */
+static int32_t send_data_block(const struct sdcard * const sdcard, uint8_t token, const void * const blk)
+{
+    int32_t ret;
+    const struct sdcard_spi_priv *priv = (const struct sdcard_spi_priv *)sdcard->priv;
+    uint8_t drt;
+
+    uint16_t crc16 = 0xffff;
+    if (sdcard->crc_mode == SDCARD_CRC_BLOCK) crc16 = sdcard_calc_crc16(blk, DEFAULT_BLOCK_SIZE);
+
+    // Sends Start Block Token to begin transmission
+    ret = spi_write(priv->spi, &token, sizeof(token), 0);
+    if (ret < 0) goto exit;
+
+    // Sends block data to SDCARD
+    int32_t amount_written = spi_write(priv->spi, blk, DEFAULT_BLOCK_SIZE, 0);
+    if (amount_written < 0) {
+        ret = amount_written;
         goto exit;
     }
+    crc16 = REV16(crc16); // SDCARD is BIG ENDIAN
+    ret = spi_write(priv->spi, &crc16, sizeof(crc16), 0);
+    if (ret < 0) goto exit;
 
-    ret = amount_read;
+    // Checks data response token
+    ret = spi_read(priv->spi, &drt, sizeof(drt), 0);
+    if (ret < 0) goto exit;
+    switch (drt & DATA_RESPONSE_MASK) {
+        case DATA_RESPONSE_ACCEPTED: break;
+        case DATA_RESPONSE_CRC_ERROR: { ret = E_INVALID_CRC; goto exit; }
+        default: { ret = E_INVALID_HARDWARE; goto exit; }
+    }
+
+    // Waits for data being written to the SDCARD
+    ret = wait_not_busy(sdcard);
+    if (ret < 0) goto exit;
+
+    ret = amount_written;
+
+    exit:
+    return ret;
+}
+
+/**
+ * @brief Sends CMD13 and checks that the SDCARD reports no error after a write
+ *
+ * @param sdcard SDCARD object
+ * @return int32_t E_SUCCESS on success
+ */
+static int32_t check_write_status(const struct sdcard * const sdcard)
+{
+    uint8_t r2[2];
+
+    int32_t ret = send_cmd_and_get_r2_response(sdcard, sdcard_cmd13_frame, r2);
+    if (ret < 0) goto exit;
+    if (r2[1]) {
+        ret = E_INVALID_PARAMETER;
+        goto exit;
+    }
+
+    exit:
+    return ret;
+}
+
+int32_t sdcard_read_block(const struct sdcard * const sdcard, uint32_t block_number, void * const blk)
+{
+    int32_t ret = E_SUCCESS;
+    uint8_t cmd[DEFAULT_SIZE_CMD];
+    uint8_t r1;
+    const struct sdcard_spi_priv *priv = (const struct sdcard_spi_priv *)sdcard->priv;
+
+    // Sends CMD17 to read single block
+    if (sdcard_shift_count) block_number <<= sdcard_shift_count;
+    sdcard_build_addr_command(17, block_number, cmd, sdcard->crc_check);
+    ret = send_cmd_and_get_r1_response(sdcard, cmd, &r1);
+    if (ret < 0) goto exit;
+    if (r1 != R1_READY_STATE) {
+        ret = E_INVALID_HARDWARE;
+        goto exit;
+    }
+
+    gpio_write(priv->cs, GPIO_LOW);
+    ret = receive_data_block(sdcard, blk);
 
     exit:
     gpio_write(priv->cs, GPIO_HIGH);
@@ -314,12 +457,12 @@ int32_t sdcard_write_block(const struct sdcard * const sdcard, uint32_t block_nu
 {
     int32_t ret = E_SUCCESS;
     uint8_t cmd[DEFAULT_SIZE_CMD];
-    uint8_t r1, r2[2], sbt, bsy;
+    uint8_t r1;
     const struct sdcard_spi_priv *priv = (const struct sdcard_spi_priv *)sdcard->priv;
 
     // Sends CMD24 to write single block
     if (sdcard_shift_count) block_number <<= sdcard_shift_count;
-    sdcard_build_command(24, block_number, cmd);
+    sdcard_build_addr_command(24, block_number, cmd, sdcard->crc_check);
     ret = send_cmd_and_get_r1_response(sdcard, cmd, &r1);
     if (ret < 0) goto exit;
     if (r1 != R1_READY_STATE) {
@@ -327,47 +470,224 @@ int32_t sdcard_write_block(const struct sdcard * const sdcard, uint32_t block_nu
         goto exit;
     }
 
-    uint16_t crc16 = sdcard_calc_crc16(blk, 512);
+    gpio_write(priv->cs, GPIO_LOW);
+    int32_t amount_written = send_data_block(sdcard, SDCARD_SOT, blk);
+    gpio_write(priv->cs, GPIO_HIGH);
+    if (amount_written < 0) {
+        ret = amount_written;
+        goto exit;
+    }
+
+    ret = check_write_status(sdcard);
+    if (ret < 0) goto exit;
+
+    ret = amount_written;
+
+    exit:
+    gpio_write(priv->cs, GPIO_HIGH);
+    return ret;
+}
+
+int32_t sdcard_read_blocks(const struct sdcard * const sdcard, uint32_t block_number, uint32_t count,
+    void * const blk)
+{
+    int32_t ret = E_SUCCESS;
+    uint8_t cmd[DEFAULT_SIZE_CMD];
+    uint8_t r1, rxd;
+    const struct sdcard_spi_priv *priv = (const struct sdcard_spi_priv *)sdcard->priv;
+    uint8_t *ublk = (uint8_t *)blk;
+
+    if (count == 0) goto exit;
+    if (count == 1) {
+        ret = sdcard_read_block(sdcard, block_number, blk);
+        goto exit;
+    }
+
+    // Sends CMD18 to read multiple blocks. The SDCARD streams blocks until CMD12
+    if (sdcard_shift_count) block_number <<= sdcard_shift_count;
+    sdcard_build_addr_command(18, block_number, cmd, sdcard->crc_check);
+    ret = send_cmd_and_get_r1_response(sdcard, cmd, &r1);
+    if (ret < 0) goto exit;
+    if (r1 != R1_READY_STATE) {
+        ret = E_INVALID_HARDWARE;
+        goto exit;
+    }
 
     gpio_write(priv->cs, GPIO_LOW);
 
-    // Sends Start Block Token to begin transmission. The variable rxd is reused
-    sbt = SDCARD_SOT;
-    spi_write(priv->spi, &sbt, sizeof(sbt), 0);
+    int32_t amount_read = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        ret = receive_data_block(sdcard, &ublk[i * DEFAULT_BLOCK_SIZE]);
+        if (ret < 0) break;
+        amount_read += ret;
+    }
 
-    // Sends block data to SDCARD
-    int32_t amount_written = spi_write(priv->spi, blk, 512, 0);
-    if (amount_written < 0) {
-        ret = amount_written;
+    // Sends CMD12 even on error so that the SDCARD stops streaming. A stuff byte comes before R1
+    int32_t stop = spi_write(priv->spi, sdcard_cmd12_frame, DEFAULT_SIZE_CMD, 0);
+    if (stop >= 0) stop = spi_read(priv->spi, &rxd, sizeof(rxd), 0);
+    if (stop >= 0) {
+        int retry = 8;
+        do {
+            stop = spi_read(priv->spi, &rxd, sizeof(rxd), 0);
+            if (stop < 0 || (rxd & 0x80) == 0) break;
+        } while (--retry);
+        if (retry == 0) stop = E_TIMEOUT;
+    }
+    if (stop >= 0) stop = wait_not_busy(sdcard);
+
+    if (ret < 0) goto exit;
+    if (stop < 0) {
+        ret = stop;
         goto exit;
     }
-    ret = spi_write(priv->spi, &crc16, sizeof(crc16), 0);
+
+    ret = amount_read;
+
+    exit:
+    gpio_write(priv->cs, GPIO_HIGH);
+    return ret;
+}
+
+int32_t sdcard_write_blocks(const struct sdcard * const sdcard, uint32_t block_number, uint32_t count,
+    const void * const blk)
+{
+    int32_t ret = E_SUCCESS;
+    uint8_t cmd[DEFAULT_SIZE_CMD];
+    uint8_t r1;
+    const struct sdcard_spi_priv *priv = (const struct sdcard_spi_priv *)sdcard->priv;
+    const uint8_t *ublk = (const uint8_t *)blk;
+
+    if (count == 0) goto exit;
+    if (count == 1) {
+        ret = sdcard_write_block(sdcard, block_number, blk);
+        goto exit;
+    }
+
+    // Sends CMD25 to write multiple blocks. Each block starts with a multi-block token until Stop Tran token
+    if (sdcard_shift_count) block_number <<= sdcard_shift_count;
+    sdcard_build_addr_command(25, block_number, cmd, sdcard->crc_check);
+    ret = send_cmd_and_get_r1_response(sdcard, cmd, &r1);
+    if (ret < 0) goto exit;
+    if (r1 != R1_READY_STATE) {
+        ret = E_INVALID_HARDWARE;
+        goto exit;
+    }
+
+    gpio_write(priv->cs, GPIO_LOW);
+
+    int32_t amount_written = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        ret = send_data_block(sdcard, SDCARD_SOT_MULTI, &ublk[i * DEFAULT_BLOCK_SIZE]);
+        if (ret < 0) break;
+        amount_written += ret;
+    }
+
+    // Stop Tran token is sent even on error. The SDCARD goes busy right after the byte that follows it
+    const uint8_t stop_tran[2] = {SDCARD_STOP_TRAN, 0xff};
+    int32_t stop = spi_write(priv->spi, stop_tran, sizeof(stop_tran), 0);
+    if (stop >= 0) stop = wait_not_busy(sdcard);
+    gpio_write(priv->cs, GPIO_HIGH);
+
     if (ret < 0) goto exit;
+    if (stop < 0) {
+        ret = stop;
+        goto exit;
+    }
 
-    // Waits for data being written to the SDCARD
-    int32_t retry = 2048;
+    ret = check_write_status(sdcard);
+    if (ret < 0) goto exit;
+
+    ret = amount_written;
+
+    exit:
+    gpio_write(priv->cs, GPIO_HIGH);
+    return ret;
+}
+
+/**
+ * @brief Extracts bits [msb:lsb] from the 128 bits CSD register
+ */
+static uint32_t csd_bits(const uint8_t *csd, uint32_t msb, uint32_t lsb)
+{
+    uint32_t value = 0;
+
+    for (uint32_t bit = msb + 1; bit-- > lsb;) {
+        value = (value << 1) | ((csd[15 - bit / 8] >> (bit % 8)) & 0x01);
+    }
+
+    return value;
+}
+
+int32_t sdcard_get_block_count(const struct sdcard * const sdcard, uint32_t * const block_count)
+{
+    int32_t ret = E_SUCCESS;
+    uint8_t r1, rxd, csd[16];
+    const struct sdcard_spi_priv *priv = (const struct sdcard_spi_priv *)sdcard->priv;
+    uint16_t crc16;
+
+    if (block_count == NULL) {
+        ret = E_INVALID_PARAMETER;
+        goto exit;
+    }
+
+    // Sends CMD9 to read the CSD register. It comes as a data block
+    ret = send_cmd_and_get_r1_response(sdcard, sdcard_cmd9_frame, &r1);
+    if (ret < 0) goto exit;
+    if (r1 != R1_READY_STATE) {
+        ret = E_INVALID_HARDWARE;
+        goto exit;
+    }
+
+    gpio_write(priv->cs, GPIO_LOW);
+
+    int32_t retry = SOT_MAX_DELAY_IN_BYTES;
     do {
-        ret = spi_read(priv->spi, &bsy, sizeof(bsy), 0);
+        ret = spi_read(priv->spi, &rxd, sizeof(rxd), 0);
         if (ret < 0) goto exit;
-        if (bsy == 0xff) break;
-    } while(--retry);
-
+        if (rxd == SDCARD_SOT) break;
+    } while (--retry);
     if (retry == 0) {
         ret = E_TIMEOUT;
         goto exit;
     }
 
-    // Sends CMD13 to fetch status
-    sdcard_build_command(13, 0, cmd);
-    ret = send_cmd_and_get_r2_response(sdcard, cmd, r2);   
+    ret = spi_read(priv->spi, csd, sizeof(csd), 0);
     if (ret < 0) goto exit;
-    if (r2[1]) {
-        ret = E_INVALID_PARAMETER;
+    ret = spi_read(priv->spi, &crc16, sizeof(crc16), 0);
+    if (ret < 0) goto exit;
+    crc16 = REV16(crc16);
+    if (sdcard->crc_mode != SDCARD_CRC_OFF && sdcard_calc_crc16(csd, sizeof(csd)) != crc16) {
+        ret = E_INVALID_CRC;
         goto exit;
     }
 
-    ret = amount_written;
+    switch (csd_bits(csd, 127, 126)) {
+        case 0: {
+            // CSD version 1.0 (SDSC): (C_SIZE + 1) * 2^(C_SIZE_MULT + 2) * 2^READ_BL_LEN bytes. Counted in 512 byte
+            // blocks because 4GB cards (READ_BL_LEN = 11) do not fit 32 bits in bytes
+            uint32_t c_size = csd_bits(csd, 73, 62);
+            uint32_t c_size_mult = csd_bits(csd, 49, 47);
+            uint32_t read_bl_len = csd_bits(csd, 83, 80);
+            if (read_bl_len < 9 || read_bl_len > 11) {
+                ret = E_INVALID_HARDWARE;
+                goto exit;
+            }
+            *block_count = (c_size + 1) << (c_size_mult + 2 + read_bl_len - 9);
+            break;
+        }
+
+        case 1:
+            // CSD version 2.0 (SDHC/SDXC): (C_SIZE + 1) * 512KiB
+            *block_count = (csd_bits(csd, 69, 48) + 1) << 10;
+            break;
+
+        default:
+            ret = E_INVALID_HARDWARE;
+            goto exit;
+    }
+    ret = E_SUCCESS;
 
     exit:
+    gpio_write(priv->cs, GPIO_HIGH);
     return ret;
 }
\ No newline at end of file
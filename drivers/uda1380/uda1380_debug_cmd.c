@@ -15,17 +15,50 @@
 
 #include "ulibc/include/ustdio.h"
 #include "ulibc/include/log.h"
+#include "ulibc/include/utils.h"
 
 #include "core/include/errors.h"
 
+#include "libs/audio/nco.h"
+#include "libs/audio/wav_player.h"
+#ifdef FATFS_WRITE
+#include "libs/audio/wav_recorder.h"
+#endif
+
 #include "components/vez-shell/include/vez-shell.h"
 
+#include "FreeRTOS.h"
+#include "task.h"
+
 #include <stdint.h>
 #include <stdlib.h>
-#include <math.h>
+#include <string.h>
 
 #define TAG "uda1380"
 
+/** Test tone: 1kHz for 10s at 8kHz */
+#define TONE_RATE_HZ 8000
+#define TONE_FREQUENCY_HZ 1000
+#define TONE_SAMPLES 80000
+#define TONE_AMPLITUDE 10000
+
+/** Samples generated at once */
+#define TONE_BLOCK 80
+
+/** Buffer fill printed while playing */
+#define PLAY_PRINT_RATE_HZ 1
+
+/** Volume change per key press: 2dB */
+#define PLAY_VOLUME_STEP 8
+
+/** Sample rate set by uda1380_init() */
+#define CODEC_RATE_HZ 8000
+
+#ifdef FATFS_WRITE
+/** Longest recording by default */
+#define REC_DEFAULT_SECONDS 60
+#endif
+
 int uda1380(int argc, char **argv)
 {
     int32_t ret;
@@ -49,15 +82,131 @@ int uda1380(int argc, char **argv)
         goto exit;
     }
 
-    const float w = 2.0f * M_PI * 1000.0f / 8000.0f;
-    for(int i = 0; i < 80000; i++) {
-        union {int16_t s; uint16_t u;} sample;
-        sample.s = (int16_t)(10000.0f*sinf(w * i));
-        uda1380_write_blocking(i2s3, sample.u, sample.u);
+    struct nco nco;
+    int16_t block[TONE_BLOCK];
+    nco_init(&nco, TONE_FREQUENCY_HZ, TONE_RATE_HZ, TONE_AMPLITUDE);
+    for (int i = 0; i < TONE_SAMPLES; i += TONE_BLOCK) {
+        nco_generate(&nco, block, TONE_BLOCK, 1);
+        for (int j = 0; j < TONE_BLOCK; j++) uda1380_write_blocking(i2s3, block[j], block[j]);
+    }
+
+    exit:
+    return ret;
+}
+
+SHELL_DECLARE_COMMAND("uda1380", uda1380, "Tests UDA1380");
+int play(int argc, char **argv)
+{
+    int32_t ret;
+    struct wav_format format;
+    struct wav_player_stats stats;
+    uint32_t attenuation = 0;
+    uint8_t mute = FALSE;
+    const struct i2c_device *i2c = device_get_by_name("i2c1");
+    const struct i2s_device *i2s3 = device_get_by_name("i2s3");
+
+    if (argc < 2) {
+        ret = E_INVALID_PARAMETER;
+        goto exit;
+    }
+    if (i2c == NULL || i2s3 == NULL) {
+        ERROR(TAG, "Could not get I2C or I2S device");
+        ret = E_DEVICE_NOT_FOUND;
+        goto exit;
+    }
+
+    ret = uda1380_init(i2c);
+    if (ret < 0) { goto exit; }
+    ret = wav_player_start(argv[1], i2s3, CODEC_RATE_HZ, &format);
+    if (ret < 0) { goto exit; }
+    uprintf("%lu Hz, %u bits, %u channels, %lu bytes. Press '+'/'-' for volume, 'm' to mute, 'q' to stop\r\n",
+        format.rate_hz, format.bits, format.channels, format.data_size);
+
+    while (wav_player_is_playing()) {
+        vTaskDelay(configTICK_RATE_HZ / PLAY_PRINT_RATE_HZ);
+        wav_player_get_stats(&stats);
+        uprintf("fill %lu bytes, underruns %lu\r\n", stats.fill, stats.underruns);
+
+        int c = ugetchar();
+        if (c == 'q' || c == 'Q') break;
+        // Only the changed register is written: playback is not disturbed
+        if (c == '+' || c == '-') {
+            attenuation = c == '+' ? CHOOSE_MAX(attenuation, PLAY_VOLUME_STEP) - PLAY_VOLUME_STEP :
+                CHOOSE_MIN(attenuation + PLAY_VOLUME_STEP, UINT8_MAX);
+            ret = uda1380_set_volume(i2c, attenuation, attenuation);
+            // The player must still be stopped
+            if (ret < 0) break;
+        } else if (c == 'm' || c == 'M') {
+            mute = !mute;
+            ret = uda1380_set_mute(i2c, mute);
+            if (ret < 0) break;
+        }
+    }
+
+    wav_player_stop();
+    // Leaves the codec unmuted for the next user. An earlier error takes precedence
+    if (mute) {
+        const int32_t unmute = uda1380_set_mute(i2c, FALSE);
+        if (ret >= 0) ret = unmute;
+    }
+    wav_player_get_stats(&stats);
+    uprintf("frames %lu, buffers %lu, underruns %lu, read errors %lu, min fill %lu bytes, slowest read %lu ticks\r\n",
+        stats.frames, stats.buffers, stats.underruns, stats.read_errors, stats.min_fill, stats.max_read_ticks);
+
+    exit:
+    DBG(TAG, "play==%s", error_to_str(ret));
+    return ret;
+}
+
+SHELL_DECLARE_COMMAND("play", play, "Plays a WAV file through the UDA1380. play <path>");
+
+#ifdef FATFS_WRITE
+int rec(int argc, char **argv)
+{
+    int32_t ret;
+    struct wav_recorder_stats stats;
+    const struct i2c_device *i2c = device_get_by_name("i2c1");
+    const struct i2s_device *i2s3 = device_get_by_name("i2s3");
+    const uint32_t seconds = argc > 2 ? strtoul(argv[2], NULL, 10) : REC_DEFAULT_SECONDS;
+    const enum uda1380_input input = argc > 3 && strcmp(argv[3], "mic") == 0 ? UDA1380_INPUT_MIC : UDA1380_INPUT_LINE;
+
+    if (argc < 2) {
+        ret = E_INVALID_PARAMETER;
+        goto exit;
+    }
+    if (i2c == NULL || i2s3 == NULL) {
+        ERROR(TAG, "Could not get I2C or I2S device");
+        ret = E_DEVICE_NOT_FOUND;
+        goto exit;
+    }
+
+    ret = uda1380_init(i2c);
+    if (ret < 0) { goto exit; }
+    ret = uda1380_set_input(i2c, input);
+    if (ret < 0) { goto exit; }
+    // The microphone is mono
+    ret = wav_recorder_start(argv[1], i2s3, CODEC_RATE_HZ, input == UDA1380_INPUT_MIC ? 1 : 2, seconds);
+    if (ret < 0) { goto exit; }
+    uprintf("Recording. Press 'q' to stop\r\n");
+
+    while (wav_recorder_is_recording()) {
+        vTaskDelay(configTICK_RATE_HZ / PLAY_PRINT_RATE_HZ);
+        wav_recorder_get_stats(&stats);
+        uprintf("%lu frames, overruns %lu\r\n", stats.frames, stats.overruns);
+
+        int c = ugetchar();
+        if (c == 'q' || c == 'Q') break;
     }
 
+    ret = wav_recorder_stop();
+    wav_recorder_get_stats(&stats);
+    uprintf("frames %lu, overruns %lu, max fill %lu blocks, slowest write %lu ticks\r\n", stats.frames,
+        stats.overruns, stats.max_fill, stats.max_write_ticks);
+
     exit:
+    DBG(TAG, "rec==%s", error_to_str(ret));
     return ret;
 }
 
-SHELL_DECLARE_COMMAND("uda1380", uda1380, "Tests UDA1380");
\ No newline at end of file
+SHELL_DECLARE_COMMAND("rec", rec, "Records a WAV file from the UDA1380. rec <path> [seconds] [line|mic]");
+#endif // FATFS_WRITE
@@ -18,6 +18,9 @@
 
 #define UDA1380_WRITE_ADDRESS     0x18
 
+/** Timeout of I2C transactions in ms */
+#define UDA1380_I2C_TIMEOUT       10000
+
 #define UDA1380_REG_EVALCLK       0x00
 #define UDA1380_REG_I2S           0x01
 #define UDA1380_REG_PWRCTRL       0x02
@@ -33,6 +36,16 @@
 #define UDA1380_REG_ADC           0x22
 #define UDA1380_REG_AGC           0x23
 
+/** UDA1380_REG_ADC fields */
+#define UDA1380_ADC_VGA_MAX       0x0f00 /** Full microphone amplifier gain */
+#define UDA1380_ADC_SEL_LNA       0x0008 /** Left ADC takes the low noise amplifier instead of line in */
+#define UDA1380_ADC_SEL_MIC       0x0004 /** Right ADC takes the microphone instead of line in */
+#define UDA1380_ADC_SKIP_DCFIL    0x0002 /** Bypasses the DC filter ahead of the decimator */
+#define UDA1380_ADC_EN_DCFIL      0x0001 /** Enables the DC filter after the decimator */
+
+/** UDA1380_REG_MSTRMUTE fields */
+#define UDA1380_MSTRMUTE_MTM      0x4000 /** Master mute */
+
 #define UDA1380_REG_L3            0x7f
 #define UDA1380_REG_HEADPHONE     0x18
 #define UDA1380_REG_DEC           0x28
@@ -110,40 +123,122 @@ static const uint8_t uda1380_startup_sequence[14][3] = {
     {UDA1380_REG_AGC,         0x00, 0x00}, /** AGC */
 };
 
-int32_t uda1380_init(const struct i2c_device *i2c)
+/** Registers kept in the cache, in address order */
+static const uint8_t cached_registers[] = {
+    UDA1380_REG_EVALCLK, UDA1380_REG_I2S, UDA1380_REG_PWRCTRL, UDA1380_REG_ANAMIX, UDA1380_REG_HEADAMP,
+    UDA1380_REG_MSTRVOL, UDA1380_REG_MIXVOL, UDA1380_REG_MODEBBT, UDA1380_REG_MSTRMUTE, UDA1380_REG_MIXSDO,
+    UDA1380_REG_DECVOL, UDA1380_REG_PGA, UDA1380_REG_ADC, UDA1380_REG_AGC,
+};
+
+/** Values last written, or about to be, to the registers */
+static uint16_t cache[ARRAY_SIZE(cached_registers)];
+/** Bit i is set when cache[i] was not written yet */
+static uint32_t dirty;
+
+/**
+ * @brief Index of a register in the cache
+ *
+ * @param reg Register
+ * @return int32_t Index. E_INVALID_PARAMETER if the register is not cached
+ */
+static int32_t cache_index(uint8_t reg)
 {
-    int32_t ret;
+    for (uint32_t i = 0; i < ARRAY_SIZE(cached_registers); i++) {
+        if (cached_registers[i] == reg) return i;
+    }
 
-    for(int i = 0; i < ARRAY_SIZE(uda1380_startup_sequence); i++) {
-        struct i2c_transaction transaction = {
-            .i2c_device_addr = UDA1380_WRITE_ADDRESS,
-            .i2c_device_reg = uda1380_startup_sequence[i][0],
-            .transaction_size = 2,
-            .write_data = &uda1380_startup_sequence[i][1]
-        };
+    return E_INVALID_PARAMETER;
+}
 
-        ret = i2c_write(i2c, &transaction, 10000);
-        if (ret < 0) {
-            ERROR("uda1380", "i2c_write(): error: %s\r\n", error_to_str(ret));
-            goto exit;
+/**
+ * @brief Changes a register in the cache. It is marked dirty only when its value changes
+ *
+ * @param reg Register. Must be cached
+ * @param value Value
+ */
+static void cache_set(uint8_t reg, uint16_t value)
+{
+    const int32_t index = cache_index(reg);
+
+    if (index < 0 || cache[index] == value) return;
+    cache[index] = value;
+    dirty |= 1 << index;
+}
+
+/**
+ * @brief Number of dirty registers with consecutive addresses from a cache index
+ */
+static uint32_t dirty_run(uint32_t first)
+{
+    uint32_t count = 1;
+
+    while (first + count < ARRAY_SIZE(cached_registers) && IS_BIT_SET(dirty, 1 << (first + count)) &&
+        cached_registers[first + count] == cached_registers[first] + count) {
+        count++;
+    }
+
+    return count;
+}
+
+#if !(RELEASE)
+/**
+ * @brief Reads back a run of registers and reports the ones that differ from the cache
+ */
+static void verify_run(const struct i2c_device *i2c, uint32_t first, uint32_t count)
+{
+    uint8_t values[2 * ARRAY_SIZE(cached_registers)];
+    struct i2c_transaction transaction = {
+        .i2c_device_addr = UDA1380_WRITE_ADDRESS,
+        .i2c_device_reg = cached_registers[first],
+        .transaction_size = 2 * count,
+        .read_data = values
+    };
+
+    int32_t ret = i2c_read(i2c, &transaction, UDA1380_I2C_TIMEOUT);
+    if (ret < 0) {
+        ERROR("uda1380", "i2c_read(): error: %s\r\n", error_to_str(ret));
+        return;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        const uint16_t value = values[2 * i] << 8 | values[2 * i + 1];
+        if (value != cache[first + i]) {
+            DBG("uda1380", "Register %.2x=%.4x, wrote %.4x", cached_registers[first + i], value, cache[first + i]);
         }
     }
+}
+#endif
 
-    for (int i = 0; i < ARRAY_SIZE(uda1380_startup_sequence); i++) {
-        uint8_t values[2];
+int32_t uda1380_flush(const struct i2c_device *i2c)
+{
+    int32_t ret = E_SUCCESS;
+    uint8_t data[2 * ARRAY_SIZE(cached_registers)];
+
+    for (uint32_t i = 0; i < ARRAY_SIZE(cached_registers); i++) {
+        if (IS_BIT_CLEAR(dirty, 1 << i)) continue;
+
+        // The register address auto increments, so a run of registers goes in a single transaction
+        const uint32_t count = dirty_run(i);
+        for (uint32_t j = 0; j < count; j++) {
+            data[2 * j] = cache[i + j] >> 8;
+            data[2 * j + 1] = cache[i + j] & 0xff;
+        }
         struct i2c_transaction transaction = {
             .i2c_device_addr = UDA1380_WRITE_ADDRESS,
-            .i2c_device_reg = uda1380_startup_sequence[i][0],
-            .transaction_size = 2,
-            .read_data = &values[0]
+            .i2c_device_reg = cached_registers[i],
+            .transaction_size = 2 * count,
+            .write_data = data
         };
 
-        ret = i2c_read(i2c, &transaction, 10000);
+        ret = i2c_write(i2c, &transaction, UDA1380_I2C_TIMEOUT);
         if (ret < 0) {
-            ERROR("uda1380", "i2c_read(): error: %s\r\n", error_to_str(ret));
+            ERROR("uda1380", "i2c_write(): error: %s\r\n", error_to_str(ret));
             goto exit;
         }
-        DBG("uda1380", "Register %.2x=[%.2x %.2x]", uda1380_startup_sequence[i][0], values[0], values[1]);
+        dirty &= ~(((1 << count) - 1) << i);
+#if !(RELEASE)
+        verify_run(i2c, i, count);
+#endif
+        i += count - 1;
     }
     ret = E_SUCCESS;
 
@@ -151,7 +246,80 @@ int32_t uda1380_init(const struct i2c_device *i2c)
     return ret;
 }
 
+int32_t uda1380_init(const struct i2c_device *i2c)
+{
+    int32_t ret;
+    const int32_t power = cache_index(UDA1380_REG_PWRCTRL);
+
+    for (int i = 0; i < ARRAY_SIZE(uda1380_startup_sequence); i++) {
+        const int32_t index = cache_index(uda1380_startup_sequence[i][0]);
+        cache[index] = uda1380_startup_sequence[i][1] << 8 | uda1380_startup_sequence[i][2];
+    }
+
+    // As in the startup sequence, the blocks are powered before anything else is configured, so PWRCTRL is not
+    // part of the run that starts at EVALCLK
+    dirty = 1 << power;
+    ret = uda1380_flush(i2c);
+    if (ret < 0) { goto exit; }
+
+    // The codec may have been reset: every register is written
+    dirty = ((1 << ARRAY_SIZE(cached_registers)) - 1) & ~(1 << power);
+    ret = uda1380_flush(i2c);
+
+    exit:
+    return ret;
+}
+
+int32_t uda1380_set_volume(const struct i2c_device *i2c, uint8_t left, uint8_t right)
+{
+    cache_set(UDA1380_REG_MSTRVOL, right << 8 | left);
+    return uda1380_flush(i2c);
+}
+
+int32_t uda1380_set_mute(const struct i2c_device *i2c, uint8_t mute)
+{
+    const int32_t index = cache_index(UDA1380_REG_MSTRMUTE);
+    const uint16_t value = cache[index];
+
+    cache_set(UDA1380_REG_MSTRMUTE, mute ? value | UDA1380_MSTRMUTE_MTM : value & ~UDA1380_MSTRMUTE_MTM);
+    return uda1380_flush(i2c);
+}
+
 void uda1380_write_blocking(const struct i2s_device *i2s, uint16_t l_ch, uint16_t r_ch)
 {
     i2s_write(i2s, l_ch, r_ch);
-}
\ No newline at end of file
+}
+
+int32_t uda1380_set_input(const struct i2c_device *i2c, enum uda1380_input input)
+{
+    // The ADC offset is removed after the decimator, where the filter sees the full resolution samples
+    uint16_t value = UDA1380_ADC_VGA_MAX | UDA1380_ADC_SKIP_DCFIL | UDA1380_ADC_EN_DCFIL;
+
+    switch (input) {
+        case UDA1380_INPUT_LINE: break;
+        case UDA1380_INPUT_MIC: value |= UDA1380_ADC_SEL_LNA | UDA1380_ADC_SEL_MIC; break;
+        default: return E_INVALID_PARAMETER;
+    }
+
+    cache_set(UDA1380_REG_ADC, value);
+    return uda1380_flush(i2c);
+}
+
+int32_t uda1380_capture_start(const struct i2c_device *i2c, const struct i2s_device *i2s,
+    enum uda1380_input input, int16_t * const buffer, uint32_t frames, i2s_block_callback callback, void *arg)
+{
+    int32_t ret;
+
+    ret = uda1380_set_input(i2c, input);
+    if (ret < 0) { goto exit; }
+
+    ret = i2s_capture_start(i2s, buffer, frames, callback, arg);
+
+    exit:
+    return ret;
+}
+
+int32_t uda1380_capture_stop(const struct i2s_device *i2s)
+{
+    return i2s_capture_stop(i2s);
+}
@@ -14,14 +14,58 @@
 #include "include/device/i2c.h"
 #include "include/device/i2s.h"
 
+/** Input of the ADC */
+enum uda1380_input {
+    UDA1380_INPUT_LINE,         /** Line in on both channels */
+    UDA1380_INPUT_MIC,          /** Microphone, through the low noise amplifier at full gain */
+};
+
+/**
+ * @brief UDA1380 driver.
+ *
+ * Registers are kept in a cache. Changes only mark the registers whose value changes as dirty, and
+ * uda1380_flush() writes each run of dirty registers with consecutive addresses in a single I2C transaction, so a
+ * volume or mute change costs a single 2 bytes write. Debug builds read every write back and report the registers
+ * that differ.
+ *
+ * The cache is not protected: the codec must be configured from a single task.
+ */
+
 /**
- * @brief Configures and starts UDA1380 I2S CODEC
+ * @brief Configures and starts UDA1380 I2S CODEC. Every register is written
  *
  * @param i2c I2C device object
  * @return int32_t E_SUCCESS on success
  */
 extern int32_t uda1380_init(const struct i2c_device *i2c);
 
+/**
+ * @brief Writes the registers changed in the cache
+ *
+ * @param i2c I2C device object
+ * @return int32_t E_SUCCESS on success. Registers not written stay dirty
+ */
+extern int32_t uda1380_flush(const struct i2c_device *i2c);
+
+/**
+ * @brief Sets the master volume
+ *
+ * @param i2c I2C device object
+ * @param left Attenuation of the left channel in steps of 0.25dB. 0 is full volume, 0xfc and up mute
+ * @param right Attenuation of the right channel
+ * @return int32_t E_SUCCESS on success
+ */
+extern int32_t uda1380_set_volume(const struct i2c_device *i2c, uint8_t left, uint8_t right);
+
+/**
+ * @brief Mutes or unmutes the output
+ *
+ * @param i2c I2C device object
+ * @param mute TRUE to mute
+ * @return int32_t E_SUCCESS on success
+ */
+extern int32_t uda1380_set_mute(const struct i2c_device *i2c, uint8_t mute);
+
 /**
  * @brief Writes data do UDA1380 I2S blocking
  *
@@ -30,4 +74,36 @@ extern int32_t uda1380_init(const struct i2c_device *i2c);
  */
 extern void uda1380_write_blocking(const struct i2s_device *i2s, uint16_t l_ch, uint16_t r_ch);
 
+/**
+ * @brief Selects the input of the ADC
+ *
+ * @param i2c I2C device object
+ * @param input Input
+ * @return int32_t E_SUCCESS on success
+ */
+extern int32_t uda1380_set_input(const struct i2c_device *i2c, enum uda1380_input input);
+
+/**
+ * @brief Selects the input of the ADC and starts capturing it. See i2s_capture_start()
+ *
+ * @param i2c I2C device object
+ * @param i2s I2S device object. Must support capture
+ * @param input Input
+ * @param buffer Capture buffer of 2 * frames stereo frames
+ * @param frames Frames of each block
+ * @param callback Called from interrupt context with every block captured
+ * @param arg Argument of callback
+ * @return int32_t E_SUCCESS on success. E_UNIMPEMENTED if the I2S device can not receive
+ */
+extern int32_t uda1380_capture_start(const struct i2c_device *i2c, const struct i2s_device *i2s,
+    enum uda1380_input input, int16_t * const buffer, uint32_t frames, i2s_block_callback callback, void *arg);
+
+/**
+ * @brief Stops capturing
+ *
+ * @param i2s I2S device object
+ * @return int32_t E_SUCCESS on success
+ */
+extern int32_t uda1380_capture_stop(const struct i2s_device *i2s);
+
 #endif // DRIVERS_UDA_1380_UDA1380_DRIVER_H_
\ No newline at end of file
@@ -0,0 +1,168 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#include "libs/audio/audio.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__ARM_FEATURE_SIMD32)
+#include <arm_acle.h>
+#endif
+
+/**
+ * @brief Saturates a value to 16 bits
+ */
+static inline int16_t saturate16(int32_t value)
+{
+#if defined(__ARM_FEATURE_SIMD32)
+    return __ssat(value, 16);
+#else
+    if (value > INT16_MAX) return INT16_MAX;
+    if (value < INT16_MIN) return INT16_MIN;
+    return value;
+#endif
+}
+
+#if defined(__ARM_FEATURE_SIMD32)
+/**
+ * @brief Loads two consecutive samples as a SIMD pair. Cortex-M4 loads words from any alignment
+ */
+static inline int16x2_t load_pair(const int16_t *samples)
+{
+    int16x2_t pair;
+    memcpy(&pair, samples, sizeof(pair));
+    return pair;
+}
+
+/**
+ * @brief Stores a SIMD pair as two consecutive samples
+ */
+static inline void store_pair(int16_t *samples, int16x2_t pair)
+{
+    memcpy(samples, &pair, sizeof(pair));
+}
+#endif
+
+void audio_interleave(const int16_t *left, const int16_t *right, int16_t *stereo, uint32_t frames)
+{
+    for (uint32_t i = 0; i < frames; i++) {
+        stereo[2 * i] = left[i];
+        stereo[2 * i + 1] = right[i];
+    }
+}
+
+void audio_deinterleave(const int16_t *stereo, int16_t *left, int16_t *right, uint32_t frames)
+{
+    for (uint32_t i = 0; i < frames; i++) {
+        left[i] = stereo[2 * i];
+        right[i] = stereo[2 * i + 1];
+    }
+}
+
+void audio_mono_to_stereo(const int16_t *mono, int16_t *stereo, uint32_t frames)
+{
+    for (uint32_t i = 0; i < frames; i++) {
+        stereo[2 * i] = mono[i];
+        stereo[2 * i + 1] = mono[i];
+    }
+}
+
+void audio_mix_into(int16_t *dst, const int16_t *src, uint32_t count)
+{
+    uint32_t i = 0;
+
+#if defined(__ARM_FEATURE_SIMD32)
+    for (; i + 2 <= count; i += 2) store_pair(&dst[i], __qadd16(load_pair(&dst[i]), load_pair(&src[i])));
+#endif
+    for (; i < count; i++) dst[i] = saturate16(dst[i] + src[i]);
+}
+
+void audio_mix(int16_t *out, const int16_t * const *sources, uint32_t n_sources, uint32_t count)
+{
+    uint32_t i = 0;
+
+    if (n_sources == 0) {
+        memset(out, 0, count * sizeof(int16_t));
+        return;
+    }
+
+#if defined(__ARM_FEATURE_SIMD32)
+    // A single saturating add is exact for two sources
+    if (n_sources == 2) {
+        for (; i + 2 <= count; i += 2) {
+            store_pair(&out[i], __qadd16(load_pair(&sources[0][i]), load_pair(&sources[1][i])));
+        }
+    }
+#endif
+    for (; i < count; i++) {
+        int32_t sum = 0;
+        for (uint32_t j = 0; j < n_sources; j++) sum += sources[j][i];
+        out[i] = saturate16(sum);
+    }
+}
+
+void audio_gain(const int16_t *in, int16_t *out, uint32_t count, int16_t gain)
+{
+    for (uint32_t i = 0; i < count; i++) out[i] = saturate16((in[i] * gain + (1 << 14)) >> 15);
+}
+
+void audio_gain_ramp(const int16_t *in, int16_t *out, uint32_t frames, uint32_t channels, int16_t start,
+    int16_t end)
+{
+    if (frames == 0) return;
+
+    // Gain with 15 more fraction bits, so small steps over long blocks are not lost
+    int32_t gain = (int32_t)start * 32768;
+    const int32_t step = ((int32_t)end - start) * 32768 / (int32_t)frames;
+
+    for (uint32_t i = 0; i < frames; i++) {
+        const int32_t g = gain >> 15;
+        for (uint32_t c = 0; c < channels; c++, in++, out++) *out = saturate16((*in * g + (1 << 14)) >> 15);
+        gain += step;
+    }
+}
+
+int64_t audio_dot(const int16_t *a, const int16_t *b, uint32_t count)
+{
+    int64_t sum = 0;
+    uint32_t i = 0;
+
+#if defined(__ARM_FEATURE_SIMD32)
+    // Two multiply-accumulates per instruction into a 64 bits accumulator
+    for (; i + 2 <= count; i += 2) sum = __smlald(load_pair(&a[i]), load_pair(&b[i]), sum);
+#endif
+    for (; i < count; i++) sum += (int32_t)a[i] * b[i];
+
+    return sum;
+}
+
+void audio_s16_to_s24(const int16_t *in, int32_t *out, uint32_t count)
+{
+    // Backwards, so out may start where in does
+    for (uint32_t i = count; i > 0; i--) out[i - 1] = (int32_t)in[i - 1] * 256;
+}
+
+void audio_s24_to_s16(const int32_t *in, int16_t *out, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++) out[i] = saturate16((in[i] + 128) >> 8);
+}
+
+void audio_s24le_to_s16(const uint8_t *in, int16_t *out, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++, in += 3) {
+        // The sample goes to the top 24 bits so the shift back extends its sign
+        const int32_t sample = (int32_t)((uint32_t)in[0] << 8 | (uint32_t)in[1] << 16 | (uint32_t)in[2] << 24) >> 8;
+        out[i] = saturate16((sample + 128) >> 8);
+    }
+}
+
+void audio_u8_to_s16(const uint8_t *in, int16_t *out, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++) out[i] = ((int16_t)in[i] - 128) * 256;
+}
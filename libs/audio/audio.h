@@ -0,0 +1,145 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#ifndef LIBS_AUDIO_AUDIO_H_
+#define LIBS_AUDIO_AUDIO_H_
+
+#include <stdint.h>
+
+/**
+ * @brief Block audio processing.
+ *
+ * Every function works on a whole block of samples, so the call overhead is paid once per block and the loops can be
+ * unrolled. Samples are signed 16 bits, stereo is interleaved (left first) and gains are Q15. Results saturate
+ * instead of wrapping around.
+ *
+ * On cores with the DSP extension (__ARM_FEATURE_SIMD32, Cortex-M4 and up) two samples are processed per
+ * instruction with the ACLE SIMD intrinsics (__qadd16, __smlald, __ssat). Elsewhere, the Cortex-M3 and the host
+ * included, the same functions run plain C that gives bit exact results.
+ */
+
+/**
+ * @brief Interleaves two channels into a stereo block
+ *
+ * @param left Left channel
+ * @param right Right channel
+ * @param stereo [out] Stereo block of 2 * frames samples
+ * @param frames Number of frames
+ */
+extern void audio_interleave(const int16_t *left, const int16_t *right, int16_t *stereo, uint32_t frames);
+
+/**
+ * @brief Splits a stereo block into two channels
+ *
+ * @param stereo Stereo block of 2 * frames samples
+ * @param left [out] Left channel
+ * @param right [out] Right channel
+ * @param frames Number of frames
+ */
+extern void audio_deinterleave(const int16_t *stereo, int16_t *left, int16_t *right, uint32_t frames);
+
+/**
+ * @brief Copies a mono block to both channels of a stereo block
+ *
+ * @param mono Mono block
+ * @param stereo [out] Stereo block of 2 * frames samples. May not overlap mono
+ * @param frames Number of frames
+ */
+extern void audio_mono_to_stereo(const int16_t *mono, int16_t *stereo, uint32_t frames);
+
+/**
+ * @brief Adds a block to another, saturating
+ *
+ * @param dst Block added to, in place
+ * @param src Block to add
+ * @param count Number of samples
+ */
+extern void audio_mix_into(int16_t *dst, const int16_t *src, uint32_t count);
+
+/**
+ * @brief Mixes several blocks. The sum saturates once, at the end, so sources that cancel each other do not clip
+ *
+ * @param out [out] Mix. May be one of the sources
+ * @param sources Blocks to mix
+ * @param n_sources Number of sources
+ * @param count Number of samples of each block
+ */
+extern void audio_mix(int16_t *out, const int16_t * const *sources, uint32_t n_sources, uint32_t count);
+
+/**
+ * @brief Multiplies a block by a constant gain
+ *
+ * @param in Input block
+ * @param out [out] Output block. May be in
+ * @param count Number of samples
+ * @param gain Gain, Q15
+ */
+extern void audio_gain(const int16_t *in, int16_t *out, uint32_t count, int16_t gain);
+
+/**
+ * @brief Multiplies a block by a gain that changes linearly from start to end, to fade or change volume without
+ * clicks. Every channel of a frame gets the same gain
+ *
+ * @param in Input block
+ * @param out [out] Output block. May be in
+ * @param frames Number of frames
+ * @param channels Samples per frame
+ * @param start Gain of the first frame, Q15
+ * @param end Gain reached after the last frame, Q15
+ */
+extern void audio_gain_ramp(const int16_t *in, int16_t *out, uint32_t frames, uint32_t channels, int16_t start,
+    int16_t end);
+
+/**
+ * @brief Dot product of two blocks, the core of FIR filters
+ *
+ * @param a First block
+ * @param b Second block
+ * @param count Number of samples
+ * @return int64_t Sum of a[i] * b[i]
+ */
+extern int64_t audio_dot(const int16_t *a, const int16_t *b, uint32_t count);
+
+/**
+ * @brief Converts 16 bits samples to 24 bits samples held in 32 bits
+ *
+ * @param in 16 bits samples
+ * @param out [out] 24 bits samples, sign extended. May start where in does
+ * @param count Number of samples
+ */
+extern void audio_s16_to_s24(const int16_t *in, int32_t *out, uint32_t count);
+
+/**
+ * @brief Converts 24 bits samples held in 32 bits to 16 bits samples, rounding and saturating
+ *
+ * @param in 24 bits samples, sign extended
+ * @param out [out] 16 bits samples. May be in
+ * @param count Number of samples
+ */
+extern void audio_s24_to_s16(const int32_t *in, int16_t *out, uint32_t count);
+
+/**
+ * @brief Converts packed 24 bits little endian samples (3 bytes each, as in WAV files) to 16 bits samples, rounding
+ * and saturating
+ *
+ * @param in Packed 24 bits samples
+ * @param out [out] 16 bits samples. May be in
+ * @param count Number of samples
+ */
+extern void audio_s24le_to_s16(const uint8_t *in, int16_t *out, uint32_t count);
+
+/**
+ * @brief Converts 8 bits unsigned samples (as in WAV files) to 16 bits samples
+ *
+ * @param in 8 bits samples, 128 is silence
+ * @param out [out] 16 bits samples. May not overlap in
+ * @param count Number of samples
+ */
+extern void audio_u8_to_s16(const uint8_t *in, int16_t *out, uint32_t count);
+
+#endif // LIBS_AUDIO_AUDIO_H_
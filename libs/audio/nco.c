@@ -0,0 +1,108 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#include "libs/audio/nco.h"
+
+#include "include/errors.h"
+
+#include <stdint.h>
+
+/** 32767 * sin(pi / 2 * i / 256) */
+static const int16_t quarter_sine[NCO_TABLE_SIZE] = {
+    0, 201, 402, 603, 804, 1005, 1206, 1407, 1608, 1809, 2009, 2210,
+    2410, 2611, 2811, 3012, 3212, 3412, 3612, 3811, 4011, 4210, 4410, 4609,
+    4808, 5007, 5205, 5404, 5602, 5800, 5998, 6195, 6393, 6590, 6786, 6983,
+    7179, 7375, 7571, 7767, 7962, 8157, 8351, 8545, 8739, 8933, 9126, 9319,
+    9512, 9704, 9896, 10087, 10278, 10469, 10659, 10849, 11039, 11228, 11417, 11605,
+    11793, 11980, 12167, 12353, 12539, 12725, 12910, 13094, 13279, 13462, 13645, 13828,
+    14010, 14191, 14372, 14553, 14732, 14912, 15090, 15269, 15446, 15623, 15800, 15976,
+    16151, 16325, 16499, 16673, 16846, 17018, 17189, 17360, 17530, 17700, 17869, 18037,
+    18204, 18371, 18537, 18703, 18868, 19032, 19195, 19357, 19519, 19680, 19841, 20000,
+    20159, 20317, 20475, 20631, 20787, 20942, 21096, 21250, 21403, 21554, 21705, 21856,
+    22005, 22154, 22301, 22448, 22594, 22739, 22884, 23027, 23170, 23311, 23452, 23592,
+    23731, 23870, 24007, 24143, 24279, 24413, 24547, 24680, 24811, 24942, 25072, 25201,
+    25329, 25456, 25582, 25708, 25832, 25955, 26077, 26198, 26319, 26438, 26556, 26674,
+    26790, 26905, 27019, 27133, 27245, 27356, 27466, 27575, 27683, 27790, 27896, 28001,
+    28105, 28208, 28310, 28411, 28510, 28609, 28706, 28803, 28898, 28992, 29085, 29177,
+    29268, 29358, 29447, 29534, 29621, 29706, 29791, 29874, 29956, 30037, 30117, 30195,
+    30273, 30349, 30424, 30498, 30571, 30643, 30714, 30783, 30852, 30919, 30985, 31050,
+    31113, 31176, 31237, 31297, 31356, 31414, 31470, 31526, 31580, 31633, 31685, 31736,
+    31785, 31833, 31880, 31926, 31971, 32014, 32057, 32098, 32137, 32176, 32213, 32250,
+    32285, 32318, 32351, 32382, 32412, 32441, 32469, 32495, 32521, 32545, 32567, 32589,
+    32609, 32628, 32646, 32663, 32678, 32692, 32705, 32717, 32728, 32737, 32745, 32752,
+    32757, 32761, 32765, 32766, 32767,
+};
+
+/**
+ * @brief Converts a frequency to a phase increment
+ *
+ * @param frequency_hz Frequency
+ * @param rate_hz Sample rate
+ * @param step [out] Phase increment
+ * @return int32_t E_SUCCESS on success. E_INVALID_PARAMETER for a zero rate or a frequency not under half of it
+ */
+static int32_t frequency_to_step(uint32_t frequency_hz, uint32_t rate_hz, uint32_t * const step)
+{
+    if (rate_hz == 0 || frequency_hz >= rate_hz / 2) return E_INVALID_PARAMETER;
+
+    *step = (uint32_t)((((uint64_t)frequency_hz << 32) + rate_hz / 2) / rate_hz);
+    return E_SUCCESS;
+}
+
+/**
+ * @brief Sine of a phase, inlined in the generation loop
+ */
+static inline int16_t sine(uint32_t phase)
+{
+    // The two top bits select the quadrant. Odd quadrants run the table backwards: ~phase mirrors the phase within
+    // the quadrant, off by a single count, so the index never goes past the last interval
+    const uint32_t offset = (phase & 0x40000000) ? ~phase : phase;
+    const uint32_t index = (offset >> 22) & 0xff;
+    const int32_t fraction = (offset >> 7) & 0x7fff;
+    const int32_t a = quarter_sine[index];
+    const int32_t value = a + (((quarter_sine[index + 1] - a) * fraction) >> 15);
+
+    return (phase & 0x80000000) ? -value : value;
+}
+
+int32_t nco_init(struct nco * const nco, uint32_t frequency_hz, uint32_t rate_hz, int16_t amplitude)
+{
+    int32_t ret = frequency_to_step(frequency_hz, rate_hz, &nco->step);
+    if (ret < 0) return ret;
+
+    nco->phase = 0;
+    nco->amplitude = amplitude;
+
+    return E_SUCCESS;
+}
+
+int32_t nco_set_frequency(struct nco * const nco, uint32_t frequency_hz, uint32_t rate_hz)
+{
+    return frequency_to_step(frequency_hz, rate_hz, &nco->step);
+}
+
+int16_t nco_sine(uint32_t phase)
+{
+    return sine(phase);
+}
+
+void nco_generate(struct nco * const nco, int16_t * const buffer, uint32_t count, uint32_t stride)
+{
+    uint32_t phase = nco->phase;
+    const uint32_t step = nco->step;
+    const int32_t amplitude = nco->amplitude;
+    int16_t *out = buffer;
+
+    for (uint32_t i = 0; i < count; i++) {
+        *out = (sine(phase) * amplitude + (1 << 14)) >> 15;
+        out += stride;
+        phase += step;
+    }
+
+    nco->phase = phase;
+}
@@ -0,0 +1,70 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#ifndef LIBS_AUDIO_NCO_H_
+#define LIBS_AUDIO_NCO_H_
+
+#include <stdint.h>
+
+/**
+ * @brief Numerically controlled oscillator.
+ *
+ * A 32 bits phase accumulator steps around the circle once every 2^32 counts, so the frequency resolution is
+ * rate / 2^32 and the phase wraps around for free. The sine comes from a table of a quarter wave with 256 intervals,
+ * linearly interpolated: within 2 LSB of a 16 bits sine, with two multiplies per sample and no float.
+ */
+
+/** Samples of the quarter wave table. The last one is sin(pi / 2) */
+#define NCO_TABLE_SIZE 257
+
+struct nco {
+    uint32_t phase;             /** Current phase. 2^32 is a full turn */
+    uint32_t step;              /** Phase increment per sample */
+    int16_t amplitude;          /** Peak value of the output */
+};
+
+/**
+ * @brief Initializes an oscillator at phase 0
+ *
+ * @param nco Oscillator
+ * @param frequency_hz Frequency of the tone. Must be under half the sample rate
+ * @param rate_hz Sample rate
+ * @param amplitude Peak value of the output
+ * @return int32_t E_SUCCESS on success. E_INVALID_PARAMETER for a zero rate or a frequency not under half of it
+ */
+extern int32_t nco_init(struct nco * const nco, uint32_t frequency_hz, uint32_t rate_hz, int16_t amplitude);
+
+/**
+ * @brief Changes the frequency keeping the phase, so the waveform has no discontinuity
+ *
+ * @param nco Oscillator
+ * @param frequency_hz Frequency of the tone. Must be under half the sample rate
+ * @param rate_hz Sample rate
+ * @return int32_t E_SUCCESS on success. E_INVALID_PARAMETER for a zero rate or a frequency not under half of it
+ */
+extern int32_t nco_set_frequency(struct nco * const nco, uint32_t frequency_hz, uint32_t rate_hz);
+
+/**
+ * @brief Sine of a phase
+ *
+ * @param phase Phase. 2^32 is a full turn
+ * @return int16_t Sine in Q15
+ */
+extern int16_t nco_sine(uint32_t phase);
+
+/**
+ * @brief Generates the next samples of the oscillator
+ *
+ * @param nco Oscillator
+ * @param buffer Where samples are written
+ * @param count Number of samples
+ * @param stride Distance between two samples in buffer. 1 for mono, 2 for a channel of interleaved stereo
+ */
+extern void nco_generate(struct nco * const nco, int16_t * const buffer, uint32_t count, uint32_t stride);
+
+#endif // LIBS_AUDIO_NCO_H_
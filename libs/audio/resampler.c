@@ -0,0 +1,133 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#include "libs/audio/resampler.h"
+#include "libs/audio/audio.h"
+
+#include "include/errors.h"
+
+#include "ulibc/include/utils.h"
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+/** Cutoff of the filter relative to the lower Nyquist frequency */
+#define RESAMPLER_CUTOFF 0.9f
+
+#define PI 3.14159265358979f
+
+/**
+ * @brief Greatest common divisor
+ */
+static uint32_t gcd(uint32_t a, uint32_t b)
+{
+    while (b != 0) {
+        const uint32_t r = a % b;
+        a = b;
+        b = r;
+    }
+
+    return a;
+}
+
+/**
+ * @brief Saturates a value to 16 bits
+ */
+static inline int16_t saturate16(int32_t value)
+{
+    if (value > INT16_MAX) return INT16_MAX;
+    if (value < INT16_MIN) return INT16_MIN;
+    return value;
+}
+
+uint32_t resampler_coeffs_size(uint32_t in_rate_hz, uint32_t out_rate_hz, uint32_t taps)
+{
+    if (in_rate_hz == 0 || out_rate_hz == 0) return 0;
+
+    return out_rate_hz / gcd(in_rate_hz, out_rate_hz) * taps;
+}
+
+int32_t resampler_init(struct resampler * const resampler, uint32_t in_rate_hz, uint32_t out_rate_hz,
+    uint32_t taps, int16_t * const coeffs, uint32_t coeffs_size, int16_t * const history)
+{
+    const uint32_t size = resampler_coeffs_size(in_rate_hz, out_rate_hz, taps);
+
+    if (size == 0 || size > coeffs_size) return E_INVALID_PARAMETER;
+
+    const uint32_t divisor = gcd(in_rate_hz, out_rate_hz);
+    const uint32_t up = out_rate_hz / divisor;
+    const uint32_t down = in_rate_hz / divisor;
+
+    // Prototype filter at up times the input rate, with a gain of up to make up for the zeros inserted
+    const float cutoff = RESAMPLER_CUTOFF / (2.0f * CHOOSE_MAX(up, down));
+    const float center = (size - 1) / 2.0f;
+    for (uint32_t phase = 0; phase < up; phase++) {
+        for (uint32_t k = 0; k < taps; k++) {
+            const uint32_t i = phase + k * up;
+            const float x = i - center;
+            const float sinc = x == 0.0f ? 1.0f : sinf(2.0f * PI * cutoff * x) / (2.0f * PI * cutoff * x);
+            const float window = size == 1 ? 1.0f :
+                0.42f - 0.5f * cosf(2.0f * PI * i / (size - 1)) + 0.08f * cosf(4.0f * PI * i / (size - 1));
+            const float h = 2.0f * cutoff * up * sinc * window;
+            // Reversed, so the newest input meets the first coefficient of the prototype
+            coeffs[phase * taps + taps - 1 - k] = saturate16(lrintf(h * 32768.0f));
+        }
+    }
+
+    resampler->up = up;
+    resampler->down = down;
+    resampler->taps = taps;
+    resampler->coeffs = coeffs;
+    resampler->history = history;
+    resampler_reset(resampler);
+
+    return E_SUCCESS;
+}
+
+void resampler_reset(struct resampler * const resampler)
+{
+    memset(resampler->history, 0, 2 * resampler->taps * sizeof(int16_t));
+    resampler->position = 0;
+    resampler->phase = 0;
+}
+
+uint32_t resampler_max_output(const struct resampler * const resampler, uint32_t count)
+{
+    return (count * resampler->up + resampler->down - 1) / resampler->down + 1;
+}
+
+uint32_t resampler_process(struct resampler * const resampler, const int16_t *in, uint32_t count,
+    uint32_t in_stride, int16_t *out, uint32_t out_stride)
+{
+    const uint32_t taps = resampler->taps;
+    const uint32_t up = resampler->up;
+    const uint32_t down = resampler->down;
+    int16_t * const history = resampler->history;
+    uint32_t position = resampler->position;
+    uint32_t phase = resampler->phase;
+    uint32_t produced = 0;
+
+    for (uint32_t i = 0; i < count; i++, in += in_stride) {
+        history[position] = *in;
+        history[position + taps] = *in;
+        position = position + 1 == taps ? 0 : position + 1;
+
+        // Every output between this input and the next one
+        for (; phase < up; phase += down, produced++, out += out_stride) {
+            const int64_t sum = audio_dot(&history[position], &resampler->coeffs[phase * taps], taps);
+            *out = saturate16((int32_t)((sum + (1 << 14)) >> 15));
+        }
+        phase -= up;
+    }
+
+    resampler->position = position;
+    resampler->phase = phase;
+
+    return produced;
+}
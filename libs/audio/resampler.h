@@ -0,0 +1,95 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#ifndef LIBS_AUDIO_RESAMPLER_H_
+#define LIBS_AUDIO_RESAMPLER_H_
+
+#include <stdint.h>
+
+/**
+ * @brief Polyphase sample rate converter.
+ *
+ * The ratio out_rate / in_rate is reduced to up / down. Conceptually the input is upsampled by up, low pass filtered
+ * and decimated by down; only the outputs kept are computed, each one a dot product (audio_dot()) of taps input
+ * samples with one of the up phases of the filter.
+ *
+ * The filter is a Blackman windowed sinc of up * taps coefficients, Q15, computed by resampler_init(). Its cutoff
+ * sits at 90% of the lower Nyquist frequency. More taps give a sharper filter: downsampling by a large ratio needs
+ * about ratio times more taps than upsampling for the same rejection.
+ *
+ * Nothing is allocated: the caller gives the storage of the coefficients (up * taps, see resampler_coeffs_size())
+ * and of the history (2 * taps samples). A resampler handles one channel; interleaved channels are handled with one
+ * resampler each and the stride arguments.
+ */
+
+struct resampler {
+    uint32_t up;                /** Interpolation factor: phases of the filter */
+    uint32_t down;              /** Decimation factor */
+    uint32_t taps;              /** Coefficients per phase */
+    const int16_t *coeffs;      /** up phases of taps coefficients, Q15, reversed to match the history */
+    int16_t *history;           /** Last taps inputs, stored twice so any window is contiguous */
+    uint32_t position;          /** Oldest sample of the window in history */
+    uint32_t phase;             /** Phase of the next output after the newest input */
+};
+
+/**
+ * @brief Number of coefficients of a converter
+ *
+ * @param in_rate_hz Input sample rate
+ * @param out_rate_hz Output sample rate
+ * @param taps Coefficients per phase
+ * @return uint32_t Number of coefficients. 0 for a zero rate
+ */
+extern uint32_t resampler_coeffs_size(uint32_t in_rate_hz, uint32_t out_rate_hz, uint32_t taps);
+
+/**
+ * @brief Initializes a converter with a silent history
+ *
+ * @param resampler Converter
+ * @param in_rate_hz Input sample rate
+ * @param out_rate_hz Output sample rate
+ * @param taps Coefficients per phase. Filter length in input samples
+ * @param coeffs Storage of the coefficients
+ * @param coeffs_size Number of coefficients coeffs holds
+ * @param history Storage of the history: 2 * taps samples
+ * @return int32_t E_SUCCESS on success. E_INVALID_PARAMETER for a zero rate or taps, or coeffs too small
+ */
+extern int32_t resampler_init(struct resampler * const resampler, uint32_t in_rate_hz, uint32_t out_rate_hz,
+    uint32_t taps, int16_t * const coeffs, uint32_t coeffs_size, int16_t * const history);
+
+/**
+ * @brief Clears the history, to start a new stream
+ *
+ * @param resampler Converter
+ */
+extern void resampler_reset(struct resampler * const resampler);
+
+/**
+ * @brief Most outputs given by a block of inputs
+ *
+ * @param resampler Converter
+ * @param count Number of inputs
+ * @return uint32_t Most outputs
+ */
+extern uint32_t resampler_max_output(const struct resampler * const resampler, uint32_t count);
+
+/**
+ * @brief Converts a block. Every input is consumed
+ *
+ * @param resampler Converter
+ * @param in Inputs
+ * @param count Number of inputs
+ * @param in_stride Distance between two inputs. 1 for mono, 2 for a channel of interleaved stereo
+ * @param out [out] Outputs. Must hold resampler_max_output() outputs
+ * @param out_stride Distance between two outputs
+ * @return uint32_t Number of outputs
+ */
+extern uint32_t resampler_process(struct resampler * const resampler, const int16_t *in, uint32_t count,
+    uint32_t in_stride, int16_t *out, uint32_t out_stride);
+
+#endif // LIBS_AUDIO_RESAMPLER_H_
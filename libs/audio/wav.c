@@ -0,0 +1,219 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#include "libs/audio/wav.h"
+
+#include "include/errors.h"
+
+#include "libs/ffresult/ffresult.h"
+
+#include "ulibc/include/utils.h"
+
+#include "components/fatfs/source/ff.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#define WAV_FORMAT_PCM 0x0001
+#define WAV_FORMAT_EXTENSIBLE 0xfffe
+
+/** Bytes of the largest "fmt " chunk read: WAVE_FORMAT_EXTENSIBLE */
+#define WAV_FMT_SIZE 40
+
+/** Offsets of the header of files written */
+#define HEADER_RIFF_SIZE 4
+#define HEADER_FMT 12
+#define HEADER_JUNK 36
+#define HEADER_DATA (WAV_HEADER_SIZE - 8)
+#define HEADER_DATA_SIZE (WAV_HEADER_SIZE - 4)
+
+/** A chunk that ends at an odd offset is followed by a pad byte */
+#define CHUNK_PADDED(size) ((size) + ((size) & 1))
+
+/**
+ * @brief Reads a little endian 16 bits value
+ */
+static uint16_t le16(const uint8_t *data)
+{
+    return data[0] | data[1] << 8;
+}
+
+/**
+ * @brief Reads a little endian 32 bits value
+ */
+static uint32_t le32(const uint8_t *data)
+{
+    return data[0] | data[1] << 8 | data[2] << 16 | (uint32_t)data[3] << 24;
+}
+
+/**
+ * @brief Writes a little endian 16 bits value
+ */
+static void put_le16(uint8_t *data, uint16_t value)
+{
+    data[0] = value;
+    data[1] = value >> 8;
+}
+
+/**
+ * @brief Writes a little endian 32 bits value
+ */
+static void put_le32(uint8_t *data, uint32_t value)
+{
+    put_le16(&data[0], value);
+    put_le16(&data[2], value >> 16);
+}
+
+/**
+ * @brief Reads exactly size bytes
+ *
+ * @return int32_t E_SUCCESS on success. E_INVALID_FORMAT if the file ends before
+ */
+static int32_t read_exactly(FIL * const file, void *data, uint32_t size)
+{
+    UINT br;
+    int32_t ret = ffresult_to_error(f_read(file, data, size, &br));
+
+    if (ret == E_SUCCESS && br != size) ret = E_INVALID_FORMAT;
+    return ret;
+}
+
+/**
+ * @brief Parses a "fmt " chunk
+ *
+ * @param fmt Chunk contents
+ * @param size Bytes of the chunk read
+ * @param format [out] Format
+ * @return int32_t E_SUCCESS on success. E_INVALID_FORMAT if the format is not supported
+ */
+static int32_t parse_fmt(const uint8_t *fmt, uint32_t size, struct wav_format * const format)
+{
+    uint16_t tag = le16(&fmt[0]);
+
+    // The sub format GUID of WAVE_FORMAT_EXTENSIBLE starts with the format tag
+    if (tag == WAV_FORMAT_EXTENSIBLE && size >= WAV_FMT_SIZE) tag = le16(&fmt[24]);
+    if (tag != WAV_FORMAT_PCM) return E_INVALID_FORMAT;
+
+    format->channels = le16(&fmt[2]);
+    format->rate_hz = le32(&fmt[4]);
+    format->bits = le16(&fmt[14]);
+
+    if (format->channels < 1 || format->channels > 2 || format->rate_hz == 0) return E_INVALID_FORMAT;
+    if (format->bits != 8 && format->bits != 16 && format->bits != 24) return E_INVALID_FORMAT;
+    if (le16(&fmt[12]) != format->channels * format->bits / 8) return E_INVALID_FORMAT;
+
+    return E_SUCCESS;
+}
+
+int32_t wav_open(FIL * const file, const char *path, struct wav_format * const format)
+{
+    int32_t ret;
+    uint8_t header[12];
+    uint8_t fmt[WAV_FMT_SIZE];
+    uint8_t has_fmt = FALSE;
+
+    ret = ffresult_to_error(f_open(file, path, FA_READ));
+    if (ret < 0) { goto exit; }
+
+    ret = read_exactly(file, header, 12);
+    if (ret < 0) { goto close; }
+    if (memcmp(&header[0], "RIFF", 4) != 0 || memcmp(&header[8], "WAVE", 4) != 0) {
+        ret = E_INVALID_FORMAT;
+        goto close;
+    }
+
+    while (1) {
+        ret = read_exactly(file, header, 8);
+        if (ret < 0) { goto close; }
+        const uint32_t size = le32(&header[4]);
+        const FSIZE_t next = f_tell(file) + CHUNK_PADDED(size);
+
+        if (memcmp(header, "fmt ", 4) == 0) {
+            if (size < 16) {
+                ret = E_INVALID_FORMAT;
+                goto close;
+            }
+            const uint32_t fmt_size = CHOOSE_MIN(size, WAV_FMT_SIZE);
+            ret = read_exactly(file, fmt, fmt_size);
+            if (ret < 0) { goto close; }
+            ret = parse_fmt(fmt, fmt_size, format);
+            if (ret < 0) { goto close; }
+            has_fmt = TRUE;
+        } else if (memcmp(header, "data", 4) == 0) {
+            if (!has_fmt) {
+                ret = E_INVALID_FORMAT;
+                goto close;
+            }
+            format->data_offset = f_tell(file);
+            // Recorders that were cut short leave a size larger than the file, or 0xffffffff
+            format->data_size = CHOOSE_MIN(size, f_size(file) - format->data_offset);
+            ret = E_SUCCESS;
+            goto exit;
+        }
+
+        ret = ffresult_to_error(f_lseek(file, next));
+        if (ret < 0) { goto close; }
+    }
+
+    close:
+    f_close(file);
+
+    exit:
+    return ret;
+}
+
+void wav_make_header(uint8_t * const header, const struct wav_format * const format)
+{
+    const uint16_t frame_size = format->channels * format->bits / 8;
+
+    memset(header, 0, WAV_HEADER_SIZE);
+    memcpy(&header[0], "RIFF", 4);
+    put_le32(&header[HEADER_RIFF_SIZE], WAV_HEADER_SIZE - 8 + format->data_size);
+    memcpy(&header[8], "WAVE", 4);
+
+    memcpy(&header[HEADER_FMT], "fmt ", 4);
+    put_le32(&header[HEADER_FMT + 4], 16);
+    put_le16(&header[HEADER_FMT + 8], WAV_FORMAT_PCM);
+    put_le16(&header[HEADER_FMT + 10], format->channels);
+    put_le32(&header[HEADER_FMT + 12], format->rate_hz);
+    put_le32(&header[HEADER_FMT + 16], format->rate_hz * frame_size);
+    put_le16(&header[HEADER_FMT + 20], frame_size);
+    put_le16(&header[HEADER_FMT + 22], format->bits);
+
+    memcpy(&header[HEADER_JUNK], "JUNK", 4);
+    put_le32(&header[HEADER_JUNK + 4], HEADER_DATA - HEADER_JUNK - 8);
+
+    memcpy(&header[HEADER_DATA], "data", 4);
+    put_le32(&header[HEADER_DATA_SIZE], format->data_size);
+}
+
+#ifdef FATFS_WRITE
+int32_t wav_set_data_size(const char *path, uint32_t data_size)
+{
+    int32_t ret;
+    FIL file;
+    UINT bw;
+    uint8_t size[4];
+
+    ret = ffresult_to_error(f_open(&file, path, FA_WRITE));
+    if (ret < 0) { goto exit; }
+
+    put_le32(size, WAV_HEADER_SIZE - 8 + data_size);
+    ret = ffresult_to_error(f_lseek(&file, HEADER_RIFF_SIZE));
+    if (ret == E_SUCCESS) ret = ffresult_to_error(f_write(&file, size, sizeof(size), &bw));
+    put_le32(size, data_size);
+    if (ret == E_SUCCESS) ret = ffresult_to_error(f_lseek(&file, HEADER_DATA_SIZE));
+    if (ret == E_SUCCESS) ret = ffresult_to_error(f_write(&file, size, sizeof(size), &bw));
+    // The file must be closed even after a failed write, but that error is the one reported
+    const int32_t close_ret = ffresult_to_error(f_close(&file));
+    if (ret == E_SUCCESS) ret = close_ret;
+
+    exit:
+    return ret;
+}
+#endif // FATFS_WRITE
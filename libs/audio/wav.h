@@ -0,0 +1,68 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#ifndef LIBS_AUDIO_WAV_H_
+#define LIBS_AUDIO_WAV_H_
+
+#include "components/fatfs/source/ff.h"
+
+#include <stdint.h>
+
+/**
+ * @brief WAV files.
+ *
+ * Only uncompressed PCM is supported: 8 bits unsigned or 16 and 24 bits signed little endian samples, mono or
+ * stereo. Chunks other than "fmt " and "data" are skipped.
+ *
+ * Files written here have a header of a whole sector, padded with a "JUNK" chunk, so the samples start sector aligned.
+ */
+
+/** Bytes of the header of files written */
+#define WAV_HEADER_SIZE 512
+
+/** Format of the samples of a WAV file */
+struct wav_format {
+    uint32_t rate_hz;           /** Sample rate */
+    uint16_t channels;          /** 1 for mono, 2 for stereo */
+    uint16_t bits;              /** Bits per sample: 8, 16 or 24 */
+    uint32_t data_offset;       /** Offset of the first sample in the file */
+    uint32_t data_size;         /** Bytes of samples */
+};
+
+/**
+ * @brief Opens a WAV file and reads its header
+ *
+ * @param file [out] File, positioned at the first sample. Left closed on error
+ * @param path Path of the file
+ * @param format [out] Format of the samples
+ * @return int32_t E_SUCCESS on success. E_INVALID_FORMAT if the file is not a WAV file or its samples are not in a
+ * supported format
+ */
+extern int32_t wav_open(FIL * const file, const char *path, struct wav_format * const format);
+
+/**
+ * @brief Builds the header of a WAV file. Samples follow it
+ *
+ * @param header [out] Header of WAV_HEADER_SIZE bytes
+ * @param format Format. data_offset is ignored
+ */
+extern void wav_make_header(uint8_t * const header, const struct wav_format * const format);
+
+#ifdef FATFS_WRITE
+/**
+ * @brief Updates the sizes in the header of a WAV file written with wav_make_header(), once the number of samples
+ * is known. Only built with FATFS_WRITE
+ *
+ * @param path Path of the file
+ * @param data_size Bytes of samples
+ * @return int32_t E_SUCCESS on success
+ */
+extern int32_t wav_set_data_size(const char *path, uint32_t data_size);
+#endif // FATFS_WRITE
+
+#endif // LIBS_AUDIO_WAV_H_
@@ -0,0 +1,344 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#include "libs/audio/wav_player.h"
+#include "libs/audio/wav.h"
+#include "libs/audio/audio.h"
+#include "libs/audio/resampler.h"
+
+#include "include/device/i2s.h"
+#include "include/errors.h"
+
+#include "ulibc/include/utils.h"
+
+#include "components/fatfs/source/ff.h"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#define TAG "wav_player"
+
+#define READER_TASK_SIZE 384
+#define READER_TASK_PRIORITY (tskIDLE_PRIORITY + 1)
+#define OUTPUT_TASK_SIZE 256
+#define OUTPUT_TASK_PRIORITY (tskIDLE_PRIORITY + 3)
+
+/** Ticks between checks for wav_player_stop() while waiting */
+#define PLAYER_POLL_TICKS 10
+
+#define SECTOR_SIZE 512
+
+struct buffer {
+    uint32_t length;            /** Bytes of whole frames in data */
+    uint8_t data[WAV_PLAYER_BUFFER_SIZE] __attribute__((aligned(4)));
+};
+
+static StackType_t reader_stack[READER_TASK_SIZE];
+static StaticTask_t reader_tcb;
+static TaskHandle_t reader_task_handle;
+static StackType_t output_stack[OUTPUT_TASK_SIZE];
+static StaticTask_t output_tcb;
+static TaskHandle_t output_task_handle;
+
+static FIL file;
+static struct wav_format format;
+static const struct i2s_device *player_i2s;
+
+static struct buffer buffers[WAV_PLAYER_BUFFERS];
+/** Buffers filled by the reader and not yet played */
+static volatile uint32_t filled;
+/** Set by the reader once the last buffer is filled */
+static volatile uint8_t end_of_file;
+static volatile uint8_t stop_requested;
+/** Set by wav_player_start() and cleared by each task when it is done with the file */
+static volatile uint8_t reader_busy;
+static volatile uint8_t output_busy;
+
+/** One converter per channel of the output. Both share the coefficients */
+static struct resampler resamplers[2];
+static int16_t resampler_coeffs[WAV_PLAYER_RESAMPLER_COEFFS];
+static int16_t resampler_history[2][2 * WAV_PLAYER_RESAMPLER_TAPS];
+static uint8_t resampling;
+
+static struct wav_player_stats player_stats;
+
+/**
+ * @brief Bytes of the first read. It ends at a sector boundary when that leaves whole frames, so every later read
+ * covers whole sectors
+ */
+static uint32_t first_read_size(uint32_t frame_size)
+{
+    const uint32_t gap = SECTOR_SIZE - format.data_offset % SECTOR_SIZE;
+
+    if (gap != SECTOR_SIZE && gap % frame_size == 0) return gap;
+    return WAV_PLAYER_BUFFER_SIZE;
+}
+
+static void reader_task(void *arg)
+{
+    (void)arg;
+
+    while (1) {
+        while (!reader_busy) ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        const uint32_t frame_size = format.channels * format.bits / 8;
+        uint32_t remaining = format.data_size - format.data_size % frame_size;
+        uint32_t size = first_read_size(frame_size);
+        uint32_t index = 0;
+
+        while (!stop_requested && remaining > 0) {
+            if (filled == WAV_PLAYER_BUFFERS) {
+                ulTaskNotifyTake(pdTRUE, PLAYER_POLL_TICKS);
+                continue;
+            }
+
+            struct buffer * const buffer = &buffers[index];
+            UINT br;
+            const TickType_t start = xTaskGetTickCount();
+            if (f_read(&file, buffer->data, CHOOSE_MIN(size, remaining), &br) != FR_OK || br == 0) {
+                player_stats.read_errors++;
+                break;
+            }
+            player_stats.max_read_ticks = CHOOSE_MAX(player_stats.max_read_ticks, xTaskGetTickCount() - start);
+
+            // A file shorter than its header says may end in the middle of a frame
+            buffer->length = br - br % frame_size;
+            remaining = br < CHOOSE_MIN(size, remaining) ? 0 : remaining - br;
+            size = WAV_PLAYER_BUFFER_SIZE;
+            index = (index + 1) % WAV_PLAYER_BUFFERS;
+
+            taskENTER_CRITICAL();
+            filled++;
+            player_stats.fill += buffer->length;
+            player_stats.buffers++;
+            taskEXIT_CRITICAL();
+            xTaskNotifyGive(output_task_handle);
+        }
+
+        f_close(&file);
+        end_of_file = TRUE;
+        reader_busy = FALSE;
+        xTaskNotifyGive(output_task_handle);
+    }
+}
+
+/**
+ * @brief Converts a block of frames to 16 bits stereo
+ *
+ * @param data Frames in the format of the file
+ * @param frames Number of frames. At most WAV_PLAYER_BLOCK_FRAMES
+ * @param stereo Scratch block of WAV_PLAYER_BLOCK_FRAMES stereo frames
+ * @param mono Scratch block of WAV_PLAYER_BLOCK_FRAMES mono frames
+ * @return const int16_t* Converted frames. 16 bits stereo frames are returned as they are, without a copy
+ */
+static const int16_t *convert(const uint8_t *data, uint32_t frames, int16_t *stereo, int16_t *mono)
+{
+    const int16_t *samples = (const int16_t *)data;
+    int16_t * const out = format.channels == 1 ? mono : stereo;
+
+    if (format.bits == 8) {
+        audio_u8_to_s16(data, out, frames * format.channels);
+        samples = out;
+    } else if (format.bits == 24) {
+        audio_s24le_to_s16(data, out, frames * format.channels);
+        samples = out;
+    }
+
+    if (format.channels == 1) {
+        audio_mono_to_stereo(samples, stereo, frames);
+        samples = stereo;
+    }
+
+    return samples;
+}
+
+/**
+ * @brief Sets up the sample rate conversion from the rate of the file
+ *
+ * @param out_rate_hz Rate of the output. 0 to play at the rate of the file
+ * @return int32_t E_SUCCESS on success. E_INVALID_FORMAT if the ratio needs more coefficients than available
+ */
+static int32_t setup_resampling(uint32_t out_rate_hz)
+{
+    int32_t ret;
+
+    resampling = out_rate_hz != 0 && out_rate_hz != format.rate_hz;
+    if (!resampling) return E_SUCCESS;
+
+    // Ratios with many phases get a shorter filter so the coefficients fit
+    const uint32_t phases = resampler_coeffs_size(format.rate_hz, out_rate_hz, 1);
+    const uint32_t taps = CHOOSE_MIN(WAV_PLAYER_RESAMPLER_TAPS, WAV_PLAYER_RESAMPLER_COEFFS / phases);
+    if (taps < WAV_PLAYER_RESAMPLER_MIN_TAPS) return E_INVALID_FORMAT;
+
+    ret = resampler_init(&resamplers[0], format.rate_hz, out_rate_hz, taps, resampler_coeffs,
+        ARRAY_SIZE(resampler_coeffs), resampler_history[0]);
+    if (ret < 0) return E_INVALID_FORMAT;
+    // A single input must not give more outputs than a block holds
+    if (resampler_max_output(&resamplers[0], 1) >= WAV_PLAYER_BLOCK_FRAMES) return E_INVALID_FORMAT;
+    resamplers[1] = resamplers[0];
+    resamplers[1].history = resampler_history[1];
+    resampler_reset(&resamplers[1]);
+
+    return E_SUCCESS;
+}
+
+/**
+ * @brief Plays a buffer block by block
+ *
+ * @param buffer Buffer
+ */
+static void play(const struct buffer * const buffer)
+{
+    static int16_t stereo[2 * WAV_PLAYER_BLOCK_FRAMES];
+    static int16_t mono[WAV_PLAYER_BLOCK_FRAMES];
+    static int16_t resampled[2 * WAV_PLAYER_BLOCK_FRAMES];
+    const uint32_t frame_size = format.channels * format.bits / 8;
+    const uint8_t *data = buffer->data;
+    uint32_t frames = buffer->length / frame_size;
+    /** Frames in resampled not written yet */
+    uint32_t pending = 0;
+
+    while (frames > 0 && !stop_requested) {
+        // The scratch blocks hold WAV_PLAYER_BLOCK_FRAMES frames whatever the ratio
+        uint32_t block = CHOOSE_MIN(frames, WAV_PLAYER_BLOCK_FRAMES);
+
+        if (resampling) {
+            // Inputs are limited so their outputs fit what is left of resampled, which is written once full. When
+            // downsampling it takes several blocks to fill
+            const uint32_t up = resamplers[0].up;
+            const uint32_t down = resamplers[0].down;
+            const uint32_t room = WAV_PLAYER_BLOCK_FRAMES - pending;
+            uint32_t fit = room > 1 ? (room - 1) * down / up : 0;
+            if (fit == 0) {
+                i2s_write_block(player_i2s, resampled, pending);
+                pending = 0;
+                fit = (WAV_PLAYER_BLOCK_FRAMES - 1) * down / up;
+            }
+            block = CHOOSE_MIN(block, fit);
+        }
+
+        const int16_t *samples = convert(data, block, stereo, mono);
+        if (resampling) {
+            resampler_process(&resamplers[0], &samples[0], block, 2, &resampled[2 * pending], 2);
+            pending += resampler_process(&resamplers[1], &samples[1], block, 2, &resampled[2 * pending + 1], 2);
+        } else {
+            i2s_write_block(player_i2s, samples, block);
+        }
+        data += block * frame_size;
+        frames -= block;
+        player_stats.frames += block;
+    }
+
+    if (pending > 0 && !stop_requested) i2s_write_block(player_i2s, resampled, pending);
+}
+
+static void output_task(void *arg)
+{
+    (void)arg;
+
+    while (1) {
+        while (!output_busy) ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        // Starts with every buffer filled, so the first slow read does not underrun
+        while (!stop_requested && !end_of_file && filled < WAV_PLAYER_BUFFERS) {
+            ulTaskNotifyTake(pdTRUE, PLAYER_POLL_TICKS);
+        }
+
+        uint32_t index = 0;
+        uint8_t first = TRUE;
+        uint8_t starved = FALSE;
+        while (!stop_requested) {
+            if (filled == 0) {
+                if (end_of_file) break;
+                // Waits for the reader instead of writing silence: at this priority that would starve the reader
+                if (!starved) player_stats.underruns++;
+                starved = TRUE;
+                ulTaskNotifyTake(pdTRUE, PLAYER_POLL_TICKS);
+                continue;
+            }
+            starved = FALSE;
+
+            player_stats.min_fill = first ? player_stats.fill : CHOOSE_MIN(player_stats.min_fill, player_stats.fill);
+            first = FALSE;
+
+            const struct buffer * const buffer = &buffers[index];
+            play(buffer);
+            index = (index + 1) % WAV_PLAYER_BUFFERS;
+
+            taskENTER_CRITICAL();
+            filled--;
+            player_stats.fill -= buffer->length;
+            taskEXIT_CRITICAL();
+            xTaskNotifyGive(reader_task_handle);
+        }
+
+        output_busy = FALSE;
+    }
+}
+
+int32_t wav_player_start(const char *path, const struct i2s_device * const i2s, uint32_t out_rate_hz,
+    struct wav_format * const format_out)
+{
+    int32_t ret;
+
+    if (reader_busy || output_busy) {
+        ret = E_TX_QUEUE_FULL;
+        goto exit;
+    }
+
+    ret = wav_open(&file, path, &format);
+    if (ret < 0) { goto exit; }
+    if (format_out != NULL) *format_out = format;
+    ret = setup_resampling(out_rate_hz);
+    if (ret < 0) {
+        f_close(&file);
+        goto exit;
+    }
+
+    player_i2s = i2s;
+    memset(&player_stats, 0, sizeof(player_stats));
+    filled = 0;
+    end_of_file = FALSE;
+    stop_requested = FALSE;
+    reader_busy = TRUE;
+    output_busy = TRUE;
+
+    if (reader_task_handle == NULL) {
+        reader_task_handle = xTaskCreateStatic(reader_task, TAG "_rd", READER_TASK_SIZE, NULL, READER_TASK_PRIORITY,
+            reader_stack, &reader_tcb);
+        output_task_handle = xTaskCreateStatic(output_task, TAG "_out", OUTPUT_TASK_SIZE, NULL, OUTPUT_TASK_PRIORITY,
+            output_stack, &output_tcb);
+    }
+    xTaskNotifyGive(reader_task_handle);
+    xTaskNotifyGive(output_task_handle);
+
+    exit:
+    return ret;
+}
+
+void wav_player_stop(void)
+{
+    stop_requested = TRUE;
+    while (reader_busy || output_busy) vTaskDelay(1);
+}
+
+uint8_t wav_player_is_playing(void)
+{
+    return output_busy;
+}
+
+void wav_player_get_stats(struct wav_player_stats * const stats)
+{
+    taskENTER_CRITICAL();
+    *stats = player_stats;
+    taskEXIT_CRITICAL();
+}
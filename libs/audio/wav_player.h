@@ -0,0 +1,94 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#ifndef LIBS_AUDIO_WAV_PLAYER_H_
+#define LIBS_AUDIO_WAV_PLAYER_H_
+
+#include "libs/audio/wav.h"
+
+#include "include/device/i2s.h"
+
+#include <stdint.h>
+
+/**
+ * @brief WAV player service.
+ *
+ * A reader task streams the samples from the card into two buffers (ping-pong) while an output task, at a higher
+ * priority, drains the other one to I2S in blocks of WAV_PLAYER_BLOCK_FRAMES frames, converting them to 16 bits
+ * stereo on the way. Buffers are a whole number of sectors and reads start at a sector boundary whenever the frame
+ * size allows, so FatFs transfers them straight from the card without going through its sector window.
+ *
+ * When the output finds no filled buffer it counts an underrun and blocks until the reader fills one, so the reader
+ * gets the CPU it is short of. The I2S output pauses meanwhile. Files at another sample rate than the codec are
+ * converted on the way by a polyphase resampler per channel.
+ *
+ * The reader only runs while the output task is blocked in i2s_write_block(), so the I2S device should implement
+ * i2s_write_block_op with DMA. Written frame by frame, a polled I2S keeps the CPU busy and starves the reader.
+ */
+
+/** Buffers of samples read from the card */
+#define WAV_PLAYER_BUFFERS 2
+
+/** Bytes of a buffer. 3 sectors hold whole frames of every supported format */
+#define WAV_PLAYER_BUFFER_SIZE 1536
+
+/** Frames written to I2S at once */
+#define WAV_PLAYER_BLOCK_FRAMES 128
+
+/** Filter length of the sample rate conversion. Enough for 44.1kHz to 8kHz */
+#define WAV_PLAYER_RESAMPLER_TAPS 64
+
+/** Ratios with more phases than fit get shorter filters, down to this length */
+#define WAV_PLAYER_RESAMPLER_MIN_TAPS 16
+
+/** Coefficients of the sample rate conversion: 44.1kHz to 8kHz takes 80 phases */
+#define WAV_PLAYER_RESAMPLER_COEFFS (80 * WAV_PLAYER_RESAMPLER_TAPS)
+
+struct wav_player_stats {
+    uint32_t frames;            /** Frames played */
+    uint32_t buffers;           /** Buffers read from the card */
+    uint32_t underruns;         /** Times the output had to wait because no buffer was ready */
+    uint32_t read_errors;       /** Reads that failed and ended the playback */
+    uint32_t fill;              /** Bytes buffered and not played yet */
+    uint32_t min_fill;          /** Lowest fill seen when a buffer was taken, after the initial fill */
+    uint32_t max_read_ticks;    /** Slowest read of a buffer */
+};
+
+/**
+ * @brief Starts playing a WAV file. Returns once the header is read; playback goes on in the background
+ *
+ * @param path Path of the file
+ * @param i2s I2S device connected to the codec, which must already be initialized
+ * @param out_rate_hz Sample rate of the codec. 0 to play at the rate of the file
+ * @param format [out] Format of the file. May be NULL
+ * @return int32_t E_SUCCESS on success. E_INVALID_FORMAT if the file can not be played or converted to out_rate_hz.
+ * E_TX_QUEUE_FULL if a file is still playing
+ */
+extern int32_t wav_player_start(const char *path, const struct i2s_device * const i2s, uint32_t out_rate_hz,
+    struct wav_format * const format);
+
+/**
+ * @brief Stops the playback and waits for both tasks to finish it
+ */
+extern void wav_player_stop(void);
+
+/**
+ * @brief Tells whether a file is playing
+ *
+ * @return uint8_t TRUE while playing
+ */
+extern uint8_t wav_player_is_playing(void);
+
+/**
+ * @brief Gets statistics of the current or last playback
+ *
+ * @param stats [out] Statistics
+ */
+extern void wav_player_get_stats(struct wav_player_stats * const stats);
+
+#endif // LIBS_AUDIO_WAV_PLAYER_H_
@@ -0,0 +1,225 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#include "libs/audio/wav_recorder.h"
+#include "libs/audio/wav.h"
+
+#include "libs/ffstream/ffstream.h"
+
+#include "include/device/i2s.h"
+#include "include/errors.h"
+
+#include "ulibc/include/utils.h"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#ifndef FATFS_WRITE
+#error "wav_recorder needs FatFs write support (FATFS_WRITE)"
+#endif
+
+#define TAG "wav_recorder"
+
+#define WRITER_TASK_SIZE 384
+#define WRITER_TASK_PRIORITY (tskIDLE_PRIORITY + 2)
+
+/** Ticks between checks for wav_recorder_stop() when no block arrives */
+#define RECORDER_POLL_TICKS 10
+
+static StackType_t writer_stack[WRITER_TASK_SIZE];
+static StaticTask_t writer_tcb;
+static TaskHandle_t writer_task_handle;
+
+static struct ffstream stream;
+static uint8_t stream_buffer[WAV_RECORDER_STREAM_SIZE] __attribute__((aligned(4)));
+static char recorder_path[WAV_RECORDER_PATH_SIZE];
+static const struct i2s_device *recorder_i2s;
+static uint16_t recorder_channels;
+static uint32_t recorder_max_frames;
+
+/** Both halves of the capture buffer */
+static int16_t capture_buffer[2 * 2 * WAV_RECORDER_BLOCK_FRAMES];
+/** Ring of blocks. Only the interrupt moves head and only the writer moves tail */
+static int16_t blocks[WAV_RECORDER_BLOCKS][2 * WAV_RECORDER_BLOCK_FRAMES];
+static uint32_t block_frames[WAV_RECORDER_BLOCKS];
+static volatile uint32_t head;
+static volatile uint32_t tail;
+
+static volatile uint8_t stop_requested;
+/** Set by wav_recorder_start() and cleared by the writer once the file is complete */
+static volatile uint8_t recording;
+static int32_t recorder_result;
+
+static struct wav_recorder_stats recorder_stats;
+
+static void capture_callback(const struct i2s_device * const i2s, const int16_t *stereo, uint32_t frames, void *arg)
+{
+    (void)i2s;
+    (void)arg;
+    BaseType_t higher_priority_task_woken = pdFALSE;
+
+    if (head - tail == WAV_RECORDER_BLOCKS) {
+        recorder_stats.overruns++;
+        return;
+    }
+
+    const uint32_t slot = head % WAV_RECORDER_BLOCKS;
+    frames = CHOOSE_MIN(frames, WAV_RECORDER_BLOCK_FRAMES);
+    if (recorder_channels == 1) {
+        for (uint32_t i = 0; i < frames; i++) blocks[slot][i] = stereo[2 * i];
+    } else {
+        memcpy(blocks[slot], stereo, frames * 2 * sizeof(int16_t));
+    }
+    block_frames[slot] = frames;
+    head++;
+
+    vTaskNotifyGiveFromISR(writer_task_handle, &higher_priority_task_woken);
+    portYIELD_FROM_ISR(higher_priority_task_woken);
+}
+
+/**
+ * @brief Writes the blocks waiting in the ring
+ *
+ * @return int32_t E_SUCCESS on success. E_TX_QUEUE_FULL once the longest recording is reached
+ */
+static int32_t drain(void)
+{
+    int32_t ret = E_SUCCESS;
+
+    recorder_stats.max_fill = CHOOSE_MAX(recorder_stats.max_fill, head - tail);
+    while (tail != head) {
+        const uint32_t slot = tail % WAV_RECORDER_BLOCKS;
+        const uint32_t frames = CHOOSE_MIN(block_frames[slot], recorder_max_frames - recorder_stats.frames);
+
+        const TickType_t start = xTaskGetTickCount();
+        ret = ffstream_write(&stream, blocks[slot], frames * recorder_channels * sizeof(int16_t));
+        recorder_stats.max_write_ticks = CHOOSE_MAX(recorder_stats.max_write_ticks, xTaskGetTickCount() - start);
+        if (ret < 0) break;
+
+        recorder_stats.frames += frames;
+        tail++;
+        if (recorder_stats.frames == recorder_max_frames) {
+            ret = E_TX_QUEUE_FULL;
+            break;
+        }
+    }
+
+    return ret < 0 ? ret : E_SUCCESS;
+}
+
+static void writer_task(void *arg)
+{
+    (void)arg;
+    int32_t ret;
+
+    while (1) {
+        while (!recording) ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        do {
+            ulTaskNotifyTake(pdTRUE, RECORDER_POLL_TICKS);
+            ret = drain();
+        } while (ret == E_SUCCESS && !stop_requested);
+
+        i2s_capture_stop(recorder_i2s);
+        // Blocks captured before the capture stopped still belong to the recording
+        if (ret == E_SUCCESS) ret = drain();
+        if (ret == E_TX_QUEUE_FULL) ret = E_SUCCESS;
+
+        const int32_t close_ret = ffstream_close(&stream);
+        if (ret == E_SUCCESS) ret = close_ret;
+        if (ret == E_SUCCESS) {
+            ret = wav_set_data_size(recorder_path, recorder_stats.frames * recorder_channels * sizeof(int16_t));
+        }
+
+        recorder_result = ret;
+        recording = FALSE;
+    }
+}
+
+int32_t wav_recorder_start(const char *path, const struct i2s_device * const i2s, uint32_t rate_hz,
+    uint16_t channels, uint32_t seconds)
+{
+    int32_t ret;
+    static uint8_t header[WAV_HEADER_SIZE];
+
+    if (recording) {
+        ret = E_TX_QUEUE_FULL;
+        goto exit;
+    }
+    if ((channels != 1 && channels != 2) || rate_hz == 0 || seconds == 0 ||
+        strlen(path) >= sizeof(recorder_path)) {
+        ret = E_INVALID_PARAMETER;
+        goto exit;
+    }
+
+    const uint32_t frame_size = channels * sizeof(int16_t);
+    const struct wav_format format = {
+        .rate_hz = rate_hz,
+        .channels = channels,
+        .bits = 16,
+        .data_size = 0,
+    };
+    strcpy(recorder_path, path);
+    recorder_i2s = i2s;
+    recorder_channels = channels;
+    recorder_max_frames = rate_hz * seconds;
+    memset(&recorder_stats, 0, sizeof(recorder_stats));
+    head = 0;
+    tail = 0;
+    stop_requested = FALSE;
+
+    ret = ffstream_open(&stream, path, WAV_HEADER_SIZE + (FSIZE_t)recorder_max_frames * frame_size, stream_buffer,
+        sizeof(stream_buffer));
+    if (ret < 0) { goto exit; }
+    // The header fills a sector, so samples stay sector aligned
+    wav_make_header(header, &format);
+    ret = ffstream_write(&stream, header, sizeof(header));
+    if (ret < 0) { goto close; }
+
+    if (writer_task_handle == NULL) {
+        writer_task_handle = xTaskCreateStatic(writer_task, TAG, WRITER_TASK_SIZE, NULL, WRITER_TASK_PRIORITY,
+            writer_stack, &writer_tcb);
+    }
+
+    ret = i2s_capture_start(i2s, capture_buffer, WAV_RECORDER_BLOCK_FRAMES, capture_callback, NULL);
+    if (ret < 0) { goto close; }
+
+    recording = TRUE;
+    xTaskNotifyGive(writer_task_handle);
+    goto exit;
+
+    close:
+    ffstream_close(&stream);
+
+    exit:
+    return ret;
+}
+
+int32_t wav_recorder_stop(void)
+{
+    stop_requested = TRUE;
+    while (recording) vTaskDelay(1);
+
+    return recorder_result;
+}
+
+uint8_t wav_recorder_is_recording(void)
+{
+    return recording;
+}
+
+void wav_recorder_get_stats(struct wav_recorder_stats * const stats)
+{
+    taskENTER_CRITICAL();
+    *stats = recorder_stats;
+    taskEXIT_CRITICAL();
+}
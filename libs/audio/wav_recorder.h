@@ -0,0 +1,86 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#ifndef LIBS_AUDIO_WAV_RECORDER_H_
+#define LIBS_AUDIO_WAV_RECORDER_H_
+
+#include "include/device/i2s.h"
+
+#include <stdint.h>
+
+/**
+ * @brief WAV recorder service.
+ *
+ * The I2S device captures blocks of WAV_RECORDER_BLOCK_FRAMES frames into the two halves of a buffer. The block
+ * callback, in interrupt context, copies each one into a ring of WAV_RECORDER_BLOCKS blocks (keeping only the left
+ * channel for mono files) and wakes a writer task that streams the ring to the card through ffstream: the file is
+ * pre-allocated for the longest recording and written in whole sectors. The ring absorbs the latency of the card;
+ * blocks captured while it is full are dropped and counted as overruns.
+ *
+ * Samples are 16 bits. The sample rate is the one the codec and the I2S device are configured for: the recorder only
+ * writes it in the header.
+ *
+ * Needs FatFs write support, so it is only built when the Makefile enables FATFS_WRITE, and an I2S device that
+ * implements the capture operations.
+ */
+
+/** Frames captured per block */
+#define WAV_RECORDER_BLOCK_FRAMES 128
+
+/** Blocks waiting to be written to the card */
+#define WAV_RECORDER_BLOCKS 16
+
+/** Bytes gathered before each write to the card. Multiple of the sector size */
+#define WAV_RECORDER_STREAM_SIZE 4096
+
+/** Longest path of a recording */
+#define WAV_RECORDER_PATH_SIZE 64
+
+struct wav_recorder_stats {
+    uint32_t frames;            /** Frames written */
+    uint32_t overruns;          /** Blocks dropped because the ring was full */
+    uint32_t max_fill;          /** Most blocks waiting in the ring */
+    uint32_t max_write_ticks;   /** Slowest write of a block */
+};
+
+/**
+ * @brief Creates a WAV file and starts recording into it in the background
+ *
+ * @param path Path of the file. It is replaced
+ * @param i2s I2S device connected to the codec, which must already be initialized. Must support capture
+ * @param rate_hz Sample rate the codec is running at
+ * @param channels 1 for mono (left channel), 2 for stereo
+ * @param seconds Longest recording. Recording stops by itself once reached
+ * @return int32_t E_SUCCESS on success. E_TX_QUEUE_FULL if still recording. E_UNIMPEMENTED if the I2S device can
+ * not receive
+ */
+extern int32_t wav_recorder_start(const char *path, const struct i2s_device * const i2s, uint32_t rate_hz,
+    uint16_t channels, uint32_t seconds);
+
+/**
+ * @brief Stops recording, writes what is left and completes the header
+ *
+ * @return int32_t E_SUCCESS when the file was completed
+ */
+extern int32_t wav_recorder_stop(void);
+
+/**
+ * @brief Tells whether a recording is going on
+ *
+ * @return uint8_t TRUE while recording
+ */
+extern uint8_t wav_recorder_is_recording(void);
+
+/**
+ * @brief Gets statistics of the current or last recording
+ *
+ * @param stats [out] Statistics
+ */
+extern void wav_recorder_get_stats(struct wav_recorder_stats * const stats);
+
+#endif // LIBS_AUDIO_WAV_RECORDER_H_
@@ -45,9 +45,9 @@ static uint16_t crc16ccitt_table[256] = {
     0x6E17, 0x7E36, 0x4E55, 0x5E74, 0x2E93, 0x3EB2, 0x0ED1, 0x1EF0
 };
 
-uint16_t calc_crc16ccitt(const void * const data, uint32_t size)
+uint16_t update_crc16ccitt(uint16_t crc, const void * const data, uint32_t size)
 {
-    uint16_t crc16ccitt = CRC16CCITT_DEFAULT_INIT;
+    uint16_t crc16ccitt = crc;
     const uint8_t * udata = (const uint8_t *)data;
 
     for(uint32_t i = 0; i < size; i++) {
@@ -57,3 +57,8 @@ uint16_t calc_crc16ccitt(const void * const data, uint32_t size)
     return crc16ccitt;
 }
 
+uint16_t calc_crc16ccitt(const void * const data, uint32_t size)
+{
+    return update_crc16ccitt(CRC16CCITT_DEFAULT_INIT, data, size);
+}
+
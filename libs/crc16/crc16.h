@@ -20,4 +20,15 @@
  */
 extern uint16_t calc_crc16ccitt(const void * const data, uint32_t size);
 
+/**
+ * @brief Continues a CRC16-CCITT calculation over another chunk of data. Calling it over consecutive chunks
+ * starting with crc = 0x0000 yields the same value as calc_crc16ccitt() over the whole data
+ *
+ * @param crc CRC16-CCITT of the previous chunks (0x0000 for the first one)
+ * @param data Data to calculate the CRC
+ * @param size Size of data in bytes
+ * @return uint16_t Value of the CRC16-CCITT
+ */
+extern uint16_t update_crc16ccitt(uint16_t crc, const void * const data, uint32_t size);
+
 #endif // LIBS_CRC16_CRC16_H_
\ No newline at end of file
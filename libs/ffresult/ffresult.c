@@ -0,0 +1,32 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#include "libs/ffresult/ffresult.h"
+
+#include "include/errors.h"
+
+#include "components/fatfs/source/ff.h"
+
+#include <stdint.h>
+
+int32_t ffresult_to_error(FRESULT fr)
+{
+    switch (fr) {
+        case FR_OK: return E_SUCCESS;
+        case FR_DISK_ERR:
+        case FR_INT_ERR:
+        case FR_NO_FILESYSTEM: return E_INVALID_HARDWARE;
+        case FR_NOT_READY:
+        case FR_NOT_ENABLED: return E_NOT_INITIALIZED;
+        case FR_NO_FILE:
+        case FR_NO_PATH: return E_DEVICE_NOT_FOUND;
+        case FR_TIMEOUT: return E_TIMEOUT;
+        case FR_DENIED: return E_NO_SPACE;
+        default: return E_INVALID_PARAMETER;
+    }
+}
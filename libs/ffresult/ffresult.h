@@ -0,0 +1,27 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#ifndef LIBS_FFRESULT_FFRESULT_H_
+#define LIBS_FFRESULT_FFRESULT_H_
+
+#include "components/fatfs/source/ff.h"
+
+#include <stdint.h>
+
+/**
+ * @brief Converts a FatFs result to the equivalent error code
+ *
+ * FR_DENIED (volume full or no contiguous free space) becomes E_NO_SPACE, a missing file or directory becomes
+ * E_DEVICE_NOT_FOUND. Results with no equivalent become E_INVALID_PARAMETER
+ *
+ * @param fr FatFs result
+ * @return int32_t Error code
+ */
+extern int32_t ffresult_to_error(FRESULT fr);
+
+#endif // LIBS_FFRESULT_FFRESULT_H_
@@ -0,0 +1,171 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#include "libs/ffstream/ffstream.h"
+
+#include "include/errors.h"
+#include "libs/ffresult/ffresult.h"
+#include "ulibc/include/utils.h"
+
+#include "components/fatfs/source/ff.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#if FF_FS_READONLY
+#error "ffstream needs FatFs write support (FF_FS_READONLY = 0)"
+#endif
+
+#if !FF_USE_EXPAND
+#error "ffstream needs f_expand() (FF_USE_EXPAND = 1)"
+#endif
+
+/**
+ * @brief Writes the first size bytes of the buffer to the file
+ *
+ * @param stream Stream object
+ * @param data Data to write
+ * @param size Amount of bytes to write
+ * @return int32_t E_SUCCESS on success
+ */
+static int32_t write_file(struct ffstream * const stream, const void *data, uint32_t size)
+{
+    UINT bw;
+
+    int32_t ret = ffresult_to_error(f_write(&stream->file, data, size, &bw));
+    if (ret < 0) goto exit;
+    if (bw != size) ret = E_NO_SPACE;
+
+    exit:
+    return ret;
+}
+
+int32_t ffstream_open(struct ffstream * const stream, const char *path, FSIZE_t capacity,
+    uint8_t * const buffer, uint32_t buffer_size)
+{
+    int32_t ret;
+
+    if (buffer == NULL || buffer_size == 0 || (buffer_size % FF_MAX_SS) != 0) {
+        ret = E_INVALID_PARAMETER;
+        goto exit;
+    }
+
+    stream->buffer = buffer;
+    stream->buffer_size = buffer_size;
+    stream->buffered = 0;
+    stream->capacity = capacity;
+    stream->written = 0;
+
+    ret = ffresult_to_error(f_open(&stream->file, path, FA_WRITE | FA_CREATE_ALWAYS));
+    if (ret < 0) goto exit;
+
+    // Allocates every cluster now in a single contiguous run. Fails if the volume has no such free run
+    ret = ffresult_to_error(f_expand(&stream->file, capacity, 1));
+    if (ret < 0) goto close;
+
+#if FF_USE_FASTSEEK
+    // A contiguous file fits in a single fragment of the link map
+    stream->linkmap[0] = ARRAY_SIZE(stream->linkmap);
+    stream->file.cltbl = stream->linkmap;
+    ret = ffresult_to_error(f_lseek(&stream->file, CREATE_LINKMAP));
+    if (ret < 0) {
+        stream->file.cltbl = NULL;
+        goto close;
+    }
+#endif // FF_USE_FASTSEEK
+
+    goto exit;
+
+    close:
+    f_close(&stream->file);
+
+    exit:
+    return ret;
+}
+
+int32_t ffstream_write(struct ffstream * const stream, const void *data, uint32_t size)
+{
+    int32_t ret;
+    const uint8_t *udata = (const uint8_t *)data;
+    uint32_t left = size;
+
+    if (stream->written + size > stream->capacity || stream->written + size < stream->written) {
+        ret = E_NO_SPACE;
+        goto exit;
+    }
+
+    while (left > 0) {
+        // Whole buffers are sent straight from data when nothing is pending: saves a copy
+        if (stream->buffered == 0 && left >= stream->buffer_size) {
+            uint32_t direct = left - (left % stream->buffer_size);
+            ret = write_file(stream, udata, direct);
+            if (ret < 0) goto exit;
+            udata += direct;
+            left -= direct;
+            continue;
+        }
+
+        uint32_t chunk = CHOOSE_MIN(left, stream->buffer_size - stream->buffered);
+        memcpy(&stream->buffer[stream->buffered], udata, chunk);
+        stream->buffered += chunk;
+        udata += chunk;
+        left -= chunk;
+
+        if (stream->buffered == stream->buffer_size) {
+            ret = write_file(stream, stream->buffer, stream->buffer_size);
+            if (ret < 0) goto exit;
+            stream->buffered = 0;
+        }
+    }
+
+    stream->written += size;
+    ret = size;
+
+    exit:
+    return ret;
+}
+
+int32_t ffstream_sync(struct ffstream * const stream)
+{
+    int32_t ret = E_SUCCESS;
+    uint32_t sectors = stream->buffered - (stream->buffered % FF_MAX_SS);
+
+    if (sectors) {
+        ret = write_file(stream, stream->buffer, sectors);
+        if (ret < 0) goto exit;
+        stream->buffered -= sectors;
+        memmove(stream->buffer, &stream->buffer[sectors], stream->buffered);
+    }
+
+    ret = ffresult_to_error(f_sync(&stream->file));
+
+    exit:
+    return ret;
+}
+
+int32_t ffstream_close(struct ffstream * const stream)
+{
+    int32_t ret = E_SUCCESS;
+
+    if (stream->buffered) {
+        ret = write_file(stream, stream->buffer, stream->buffered);
+        if (ret < 0) goto exit;
+        stream->buffered = 0;
+    }
+
+#if FF_USE_FASTSEEK
+    // Truncation walks the FAT chain to release the clusters past the written data
+    stream->file.cltbl = NULL;
+#endif
+    ret = ffresult_to_error(f_truncate(&stream->file));
+
+    exit:
+    if (ret == E_SUCCESS) ret = ffresult_to_error(f_close(&stream->file));
+    else f_close(&stream->file);
+    return ret;
+}
@@ -0,0 +1,86 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#ifndef LIBS_FFSTREAM_FFSTREAM_H_
+#define LIBS_FFSTREAM_FFSTREAM_H_
+
+#include "components/fatfs/source/ff.h"
+
+#include <stdint.h>
+
+/**
+ * @brief Sequential FatFs writer for data loggers.
+ *
+ * The file is pre-allocated as a single contiguous cluster run with f_expand() so no cluster is searched and no FAT
+ * entry is written while streaming. When FF_USE_FASTSEEK is enabled a cluster link map is also created so FatFs does
+ * not walk the FAT chain at every cluster boundary.
+ *
+ * Data is gathered in a buffer whose size is a multiple of the sector size and handed to f_write() only when full.
+ * As the file pointer is always sector aligned, FatFs sends the buffer straight to disk_write() as a multiple sector
+ * transfer instead of copying it sector by sector through its window.
+ *
+ * Needs a FatFs port with write support and f_expand() (FF_FS_READONLY = 0, FF_USE_EXPAND = 1). Only built when the
+ * Makefile enables FATFS_WRITE.
+ */
+
+/** Number of items of the cluster link map. A contiguous file needs a single fragment: 1 + 2 + 1 items */
+#define FFSTREAM_LINKMAP_ITEMS 4
+
+struct ffstream {
+    FIL file;                   /** FatFs file object */
+    uint8_t *buffer;            /** Sector aligned buffer */
+    uint32_t buffer_size;       /** Size of buffer. Multiple of FF_MAX_SS */
+    uint32_t buffered;          /** Amount of bytes waiting in buffer */
+    FSIZE_t capacity;           /** Pre-allocated size of the file */
+    FSIZE_t written;            /** Amount of bytes accepted by ffstream_write() */
+#if FF_USE_FASTSEEK
+    DWORD linkmap[FFSTREAM_LINKMAP_ITEMS]; /** Cluster link map of the file */
+#endif
+};
+
+/**
+ * @brief Creates (or truncates) a file and pre-allocates it contiguously
+ *
+ * @param stream Stream object
+ * @param path Path of the file
+ * @param capacity Maximum size of the file in bytes
+ * @param buffer Buffer used to gather writes. Must live until ffstream_close()
+ * @param buffer_size Size of buffer. Must be a non-zero multiple of FF_MAX_SS
+ * @return int32_t E_SUCCESS on success
+ */
+extern int32_t ffstream_open(struct ffstream * const stream, const char *path, FSIZE_t capacity,
+    uint8_t * const buffer, uint32_t buffer_size);
+
+/**
+ * @brief Appends data to the stream. Only full buffers are written to the file
+ *
+ * @param stream Stream object
+ * @param data Data to append
+ * @param size Size of data in bytes
+ * @return int32_t Amount of bytes accepted. E_NO_SPACE if the pre-allocated size would be exceeded
+ */
+extern int32_t ffstream_write(struct ffstream * const stream, const void *data, uint32_t size);
+
+/**
+ * @brief Writes every full sector of the buffer and syncs the file. The incomplete tail sector stays in the buffer
+ * so the file pointer remains sector aligned
+ *
+ * @param stream Stream object
+ * @return int32_t E_SUCCESS on success
+ */
+extern int32_t ffstream_sync(struct ffstream * const stream);
+
+/**
+ * @brief Writes the remaining data, releases the unused pre-allocated clusters and closes the file
+ *
+ * @param stream Stream object
+ * @return int32_t E_SUCCESS on success
+ */
+extern int32_t ffstream_close(struct ffstream * const stream);
+
+#endif // LIBS_FFSTREAM_FFSTREAM_H_
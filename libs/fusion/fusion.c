@@ -0,0 +1,207 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#include "libs/fusion/fusion.h"
+
+#include "include/errors.h"
+
+#include <stdint.h>
+#include <math.h>
+
+/** pi / 180 * 2^24, rounded: converts degrees/s per 32768 raw units to half a rad per raw unit in Q40 */
+#define DEG_TO_HALF_RAD_Q40 ((uint64_t)(3.14159265358979323846 / 180 * (1 << 24) + 0.5))
+
+/**
+ * @brief Multiplies two Q30 values
+ */
+static inline int32_t mul_q30(int32_t a, int32_t b)
+{
+    return (int32_t)(((int64_t)a * b) >> 30);
+}
+
+/**
+ * @brief Reciprocal square root
+ *
+ * @param m Value in Q30, from 0.25 to 1
+ * @return int64_t 1/sqrt(m) in Q30
+ */
+static int64_t rsqrt_q30(int64_t m)
+{
+    // Linear guess within 17% of the result. Each Newton-Raphson step squares the error
+    int64_t y = (9LL << 28) - ((5 * m) >> 2);
+
+    for (int i = 0; i < 4; i++) {
+        const int64_t y2 = (((m * y) >> 30) * y) >> 30;
+        y = (y * ((3LL << 30) - y2)) >> 31;
+    }
+
+    return y;
+}
+
+/**
+ * @brief Scales a vector to unit length
+ *
+ * @param v Vector. Its components may be in any scale and come back in Q30. The sum of their squares must fit 63 bits
+ * @param size Number of components
+ * @return int32_t E_SUCCESS on success. E_INVALID_PARAMETER for a zero vector, which is left untouched
+ */
+static int32_t normalize(int32_t * const v, uint32_t size)
+{
+    uint64_t sum = 0;
+
+    for (uint32_t i = 0; i < size; i++) sum += (int64_t)v[i] * v[i];
+    if (sum == 0) return E_INVALID_PARAMETER;
+
+    // sum = m * 2^(64 - shift) with m from 0.25 to 1, so 1/sqrt(sum) = 1/sqrt(m) * 2^(shift/2 - 32)
+    const uint32_t shift = __builtin_clzll(sum) & ~1;
+    const int64_t y = rsqrt_q30((sum << shift) >> 34);
+
+    for (uint32_t i = 0; i < size; i++) v[i] = ((int64_t)v[i] * y) >> (32 - shift / 2);
+
+    return E_SUCCESS;
+}
+
+int32_t fusion_init(struct fusion * const fusion, const struct fusion_config * const config)
+{
+    if (config->rate_hz == 0 || config->gyro_range_dps > FUSION_MAX_GYRO_RANGE_DPS) return E_INVALID_PARAMETER;
+
+    fusion->q.w = FUSION_Q30_ONE;
+    fusion->q.x = 0;
+    fusion->q.y = 0;
+    fusion->q.z = 0;
+    fusion->filter = config->filter;
+    fusion->gyro_step = (config->gyro_range_dps * DEG_TO_HALF_RAD_Q40) / config->rate_hz;
+    // The complementary gain applies to half the rotation, like the gyroscope. Madgwick steps the whole quaternion
+    const uint32_t divider = config->filter == FUSION_COMPLEMENTARY ? 2000 : 1000;
+    fusion->gain_step = ((uint64_t)config->gain_milli << 30) / ((uint64_t)divider * config->rate_hz);
+
+    return E_SUCCESS;
+}
+
+void fusion_update(struct fusion * const fusion, const int16_t accel[3], const int16_t gyro[3])
+{
+    const int32_t w = fusion->q.w, x = fusion->q.x, y = fusion->q.y, z = fusion->q.z;
+    int32_t a[3] = {accel[0], accel[1], accel[2]};
+    int32_t h[3];
+    int32_t dq[4];
+
+    // Half the rotation during this sample
+    for (int i = 0; i < 3; i++) h[i] = ((int64_t)gyro[i] * fusion->gyro_step) >> 10;
+
+    const int32_t has_accel = normalize(a, 3) == E_SUCCESS;
+    // Half the gravity direction the orientation expects
+    const int32_t vx = mul_q30(x, z) - mul_q30(w, y);
+    const int32_t vy = mul_q30(w, x) + mul_q30(y, z);
+    const int32_t vz = FUSION_Q30_ONE / 2 - mul_q30(x, x) - mul_q30(y, y);
+
+    if (has_accel && fusion->filter == FUSION_COMPLEMENTARY) {
+        // Twice the error is the sine of the angle between measured and expected gravity, towards the rotation axis
+        const int32_t e[3] = {
+            mul_q30(a[1], vz) - mul_q30(a[2], vy),
+            mul_q30(a[2], vx) - mul_q30(a[0], vz),
+            mul_q30(a[0], vy) - mul_q30(a[1], vx)
+        };
+        for (int i = 0; i < 3; i++) h[i] += mul_q30(e[i], 2 * fusion->gain_step);
+    }
+
+    dq[0] = -mul_q30(x, h[0]) - mul_q30(y, h[1]) - mul_q30(z, h[2]);
+    dq[1] = mul_q30(w, h[0]) + mul_q30(y, h[2]) - mul_q30(z, h[1]);
+    dq[2] = mul_q30(w, h[1]) - mul_q30(x, h[2]) + mul_q30(z, h[0]);
+    dq[3] = mul_q30(w, h[2]) + mul_q30(x, h[1]) - mul_q30(y, h[0]);
+
+    if (has_accel && fusion->filter == FUSION_MADGWICK) {
+        // Objective function halved, so every component fits Q30
+        const int32_t f0 = vx - a[0] / 2, f1 = vy - a[1] / 2, f2 = vz - a[2] / 2;
+        // Gradient divided by 8 and accumulated at full precision: only its direction matters
+        int32_t s[4] = {
+            (-(int64_t)y * f0 + (int64_t)x * f1) >> 31,
+            ((int64_t)z * f0 + (int64_t)w * f1 - 2 * (int64_t)x * f2) >> 31,
+            (-(int64_t)w * f0 + (int64_t)z * f1 - 2 * (int64_t)y * f2) >> 31,
+            ((int64_t)x * f0 + (int64_t)y * f1) >> 31
+        };
+        if (normalize(s, 4) == E_SUCCESS) {
+            for (int i = 0; i < 4; i++) dq[i] -= mul_q30(s[i], fusion->gain_step);
+        }
+    }
+
+    int32_t q[4] = {w + dq[0], x + dq[1], y + dq[2], z + dq[3]};
+    normalize(q, 4);
+    fusion->q.w = q[0];
+    fusion->q.x = q[1];
+    fusion->q.y = q[2];
+    fusion->q.z = q[3];
+}
+
+int32_t fusion_float_init(struct fusion_float * const fusion, const struct fusion_config * const config)
+{
+    if (config->rate_hz == 0 || config->gyro_range_dps > FUSION_MAX_GYRO_RANGE_DPS) return E_INVALID_PARAMETER;
+
+    fusion->q[0] = 1.0f;
+    fusion->q[1] = 0.0f;
+    fusion->q[2] = 0.0f;
+    fusion->q[3] = 0.0f;
+    fusion->filter = config->filter;
+    fusion->gyro_step = config->gyro_range_dps * (3.14159265f / 180.0f) / 32768.0f / (2.0f * config->rate_hz);
+    const float divider = config->filter == FUSION_COMPLEMENTARY ? 2000.0f : 1000.0f;
+    fusion->gain_step = config->gain_milli / (divider * config->rate_hz);
+
+    return E_SUCCESS;
+}
+
+void fusion_float_update(struct fusion_float * const fusion, const int16_t accel[3], const int16_t gyro[3])
+{
+    const float w = fusion->q[0], x = fusion->q[1], y = fusion->q[2], z = fusion->q[3];
+    float a[3] = {accel[0], accel[1], accel[2]};
+    float h[3];
+    float dq[4];
+
+    for (int i = 0; i < 3; i++) h[i] = gyro[i] * fusion->gyro_step;
+
+    const float norm = a[0] * a[0] + a[1] * a[1] + a[2] * a[2];
+    const int32_t has_accel = norm > 0.0f;
+    if (has_accel) {
+        const float r = 1.0f / sqrtf(norm);
+        for (int i = 0; i < 3; i++) a[i] *= r;
+    }
+    const float vx = x * z - w * y;
+    const float vy = w * x + y * z;
+    const float vz = 0.5f - x * x - y * y;
+
+    if (has_accel && fusion->filter == FUSION_COMPLEMENTARY) {
+        h[0] += 2.0f * (a[1] * vz - a[2] * vy) * fusion->gain_step;
+        h[1] += 2.0f * (a[2] * vx - a[0] * vz) * fusion->gain_step;
+        h[2] += 2.0f * (a[0] * vy - a[1] * vx) * fusion->gain_step;
+    }
+
+    dq[0] = -x * h[0] - y * h[1] - z * h[2];
+    dq[1] = w * h[0] + y * h[2] - z * h[1];
+    dq[2] = w * h[1] - x * h[2] + z * h[0];
+    dq[3] = w * h[2] + x * h[1] - y * h[0];
+
+    if (has_accel && fusion->filter == FUSION_MADGWICK) {
+        const float f0 = vx - a[0] / 2, f1 = vy - a[1] / 2, f2 = vz - a[2] / 2;
+        float s[4] = {-y * f0 + x * f1, z * f0 + w * f1 - 2 * x * f2, -w * f0 + z * f1 - 2 * y * f2, x * f0 + y * f1};
+        const float s_norm = s[0] * s[0] + s[1] * s[1] + s[2] * s[2] + s[3] * s[3];
+        if (s_norm > 0.0f) {
+            const float r = fusion->gain_step / sqrtf(s_norm);
+            for (int i = 0; i < 4; i++) dq[i] -= s[i] * r;
+        }
+    }
+
+    const float q[4] = {w + dq[0], x + dq[1], y + dq[2], z + dq[3]};
+    const float r = 1.0f / sqrtf(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+    for (int i = 0; i < 4; i++) fusion->q[i] = q[i] * r;
+}
+
+void fusion_float_get_quat(const struct fusion_float * const fusion, struct fusion_quat * const q)
+{
+    q->w = (int32_t)(fusion->q[0] * FUSION_Q30_ONE);
+    q->x = (int32_t)(fusion->q[1] * FUSION_Q30_ONE);
+    q->y = (int32_t)(fusion->q[2] * FUSION_Q30_ONE);
+    q->z = (int32_t)(fusion->q[3] * FUSION_Q30_ONE);
+}
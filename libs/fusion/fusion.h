@@ -0,0 +1,114 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#ifndef LIBS_FUSION_FUSION_H_
+#define LIBS_FUSION_FUSION_H_
+
+#include <stdint.h>
+
+/**
+ * @brief Orientation from accelerometer and gyroscope samples.
+ *
+ * The gyroscope is integrated into a quaternion at every sample and the accelerometer pulls it towards gravity,
+ * either with a proportional correction (complementary filter, as in Mahony) or with a gradient descent step
+ * (Madgwick). The fixed point filter needs no FPU: the quaternion is kept in Q30 and every product is a 32x32->64
+ * bits multiply. Normalizations use a Newton-Raphson reciprocal square root, so an update takes no division.
+ *
+ * The float filter takes the same configuration and gives the same quaternion. It is meant for CPUs with an FPU.
+ *
+ * Samples are raw sensor values: the scale of the accelerometer does not matter and the gyroscope scale comes from
+ * its full scale range.
+ */
+
+/** 1.0 in Q30 */
+#define FUSION_Q30_ONE (1 << 30)
+
+/** Quaternion in Q30. Identity is {FUSION_Q30_ONE, 0, 0, 0} */
+struct fusion_quat {
+    int32_t w;
+    int32_t x;
+    int32_t y;
+    int32_t z;
+};
+
+enum fusion_filter {
+    FUSION_COMPLEMENTARY,   /** Proportional correction towards gravity */
+    FUSION_MADGWICK,        /** Gradient descent step towards gravity */
+};
+
+struct fusion_config {
+    enum fusion_filter filter;  /** Filter to use */
+    uint32_t rate_hz;           /** Sample rate */
+    uint32_t gyro_range_dps;    /** Gyroscope full scale in degrees/s, given by a raw value of 32768 */
+    uint32_t gain_milli;        /** Proportional gain (complementary) or beta (Madgwick) in rad/s, x1000 */
+};
+
+/** Fixed point filter */
+struct fusion {
+    struct fusion_quat q;       /** Orientation */
+    enum fusion_filter filter;  /** Filter in use */
+    int32_t gyro_step;          /** Half the rotation of a raw gyroscope unit during a sample in rad, Q40 */
+    int32_t gain_step;          /** Correction applied during a sample, Q30 */
+};
+
+/** Float filter */
+struct fusion_float {
+    float q[4];                 /** Orientation as w, x, y, z */
+    enum fusion_filter filter;  /** Filter in use */
+    float gyro_step;            /** Half the rotation of a raw gyroscope unit during a sample in rad */
+    float gain_step;            /** Correction applied during a sample */
+};
+
+/** Highest gyroscope full scale */
+#define FUSION_MAX_GYRO_RANGE_DPS 2000
+
+/**
+ * @brief Initializes a fixed point filter. The orientation starts at identity
+ *
+ * @param fusion Filter
+ * @param config Configuration
+ * @return int32_t E_SUCCESS on success. E_INVALID_PARAMETER for a zero rate or a range above FUSION_MAX_GYRO_RANGE_DPS
+ */
+extern int32_t fusion_init(struct fusion * const fusion, const struct fusion_config * const config);
+
+/**
+ * @brief Updates the orientation with a sample
+ *
+ * @param fusion Filter
+ * @param accel Raw accelerometer x, y and z. All zero skips the correction
+ * @param gyro Raw gyroscope x, y and z
+ */
+extern void fusion_update(struct fusion * const fusion, const int16_t accel[3], const int16_t gyro[3]);
+
+/**
+ * @brief Initializes a float filter. The orientation starts at identity
+ *
+ * @param fusion Filter
+ * @param config Configuration
+ * @return int32_t E_SUCCESS on success. E_INVALID_PARAMETER for a zero rate or a range above FUSION_MAX_GYRO_RANGE_DPS
+ */
+extern int32_t fusion_float_init(struct fusion_float * const fusion, const struct fusion_config * const config);
+
+/**
+ * @brief Updates the orientation with a sample
+ *
+ * @param fusion Filter
+ * @param accel Raw accelerometer x, y and z. All zero skips the correction
+ * @param gyro Raw gyroscope x, y and z
+ */
+extern void fusion_float_update(struct fusion_float * const fusion, const int16_t accel[3], const int16_t gyro[3]);
+
+/**
+ * @brief Gets the orientation of a float filter in Q30
+ *
+ * @param fusion Filter
+ * @param q [out] Orientation
+ */
+extern void fusion_float_get_quat(const struct fusion_float * const fusion, struct fusion_quat * const q);
+
+#endif // LIBS_FUSION_FUSION_H_
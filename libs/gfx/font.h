@@ -0,0 +1,43 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#ifndef LIBS_GFX_FONT_H_
+#define LIBS_GFX_FONT_H_
+
+#include <stdint.h>
+
+/**
+ * @brief Bitmap fonts.
+ *
+ * Each glyph is a bitmap of width x height pixels that starts at a byte of the font bitmap; its rows follow each
+ * other without padding, most significant bits first. Pixels are 1 bit (on or off) or 4 bits (coverage from 0 to 15,
+ * for anti-aliased fonts).
+ */
+
+struct gfx_glyph {
+    uint16_t offset;            /** First byte of the glyph in the font bitmap */
+    uint8_t width;              /** Width of the bitmap */
+    uint8_t height;             /** Height of the bitmap */
+    int8_t x_offset;            /** Bitmap position from the pen */
+    int8_t y_offset;            /** Bitmap position from the top of the line */
+    uint8_t advance;            /** Pen move to the next glyph */
+};
+
+struct gfx_font {
+    uint8_t bpp;                /** Bits per pixel: 1 or 4 */
+    uint8_t first;              /** First character */
+    uint8_t last;               /** Last character. Others are drawn as first */
+    uint8_t height;             /** Line height */
+    const struct gfx_glyph *glyphs; /** Glyphs from first to last */
+    const uint8_t *bitmap;      /** Bitmaps of the glyphs */
+};
+
+/** 5x7 pixels font in 6x8 cells, 1 bit, ASCII from ' ' to '~' */
+extern const struct gfx_font gfx_font_5x7;
+
+#endif // LIBS_GFX_FONT_H_
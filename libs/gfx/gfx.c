@@ -0,0 +1,451 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#include "libs/gfx/gfx.h"
+#include "libs/gfx/font.h"
+
+#include "include/errors.h"
+
+#include "ulibc/include/utils.h"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+static inline uint8_t rect_is_empty(const struct gfx_rect * const rect)
+{
+    return rect->w <= 0 || rect->h <= 0;
+}
+
+static inline int32_t rect_area(const struct gfx_rect * const rect)
+{
+    return rect_is_empty(rect) ? 0 : (int32_t)rect->w * rect->h;
+}
+
+/**
+ * @brief Intersection of two rectangles. Empty when they do not overlap
+ */
+static struct gfx_rect rect_intersect(const struct gfx_rect * const a, const struct gfx_rect * const b)
+{
+    const int32_t x0 = CHOOSE_MAX(a->x, b->x);
+    const int32_t y0 = CHOOSE_MAX(a->y, b->y);
+    const int32_t x1 = CHOOSE_MIN(a->x + a->w, b->x + b->w);
+    const int32_t y1 = CHOOSE_MIN(a->y + a->h, b->y + b->h);
+
+    if (x1 <= x0 || y1 <= y0) return (struct gfx_rect){0, 0, 0, 0};
+    return (struct gfx_rect){x0, y0, x1 - x0, y1 - y0};
+}
+
+/**
+ * @brief Bounding box of two rectangles. An empty rectangle adds nothing
+ */
+static struct gfx_rect rect_union(const struct gfx_rect * const a, const struct gfx_rect * const b)
+{
+    if (rect_is_empty(a)) return *b;
+    if (rect_is_empty(b)) return *a;
+
+    const int32_t x0 = CHOOSE_MIN(a->x, b->x);
+    const int32_t y0 = CHOOSE_MIN(a->y, b->y);
+    const int32_t x1 = CHOOSE_MAX(a->x + a->w, b->x + b->w);
+    const int32_t y1 = CHOOSE_MAX(a->y + a->h, b->y + b->h);
+
+    return (struct gfx_rect){x0, y0, x1 - x0, y1 - y0};
+}
+
+static inline const struct gfx_glyph *find_glyph(const struct gfx_font * const font, char c)
+{
+    const uint8_t code = (uint8_t)c;
+
+    if (code < font->first || code > font->last) return &font->glyphs[0];
+    return &font->glyphs[code - font->first];
+}
+
+/**
+ * @brief Computes the pixels an object may touch
+ */
+static void update_bounds(struct gfx_object * const object)
+{
+    switch (object->type) {
+        case GFX_RECT:
+            break;
+
+        case GFX_LINE:
+            object->bounds.x = CHOOSE_MIN(object->line.x0, object->line.x1);
+            object->bounds.y = CHOOSE_MIN(object->line.y0, object->line.y1);
+            object->bounds.w = abs(object->line.x1 - object->line.x0) + 1;
+            object->bounds.h = abs(object->line.y1 - object->line.y0) + 1;
+            break;
+
+        case GFX_TEXT: {
+            int16_t pen = object->text.x;
+            object->bounds = (struct gfx_rect){object->text.x, object->text.y, 0, 0};
+            for (const char *c = object->text.string; *c != '\0'; c++) {
+                const struct gfx_glyph *glyph = find_glyph(object->text.font, *c);
+                const struct gfx_rect box = {pen + glyph->x_offset, object->text.y + glyph->y_offset,
+                    glyph->width, glyph->height};
+                object->bounds = rect_union(&object->bounds, &box);
+                pen += glyph->advance;
+            }
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Returns the object of an id, or NULL for an unknown id
+ */
+static struct gfx_object *find_object(struct gfx_scene * const scene, int32_t id)
+{
+    if (id < 0 || (uint32_t)id >= scene->count) return NULL;
+    return &scene->objects[id];
+}
+
+static inline void damage_object(struct gfx_scene * const scene, const struct gfx_object * const object)
+{
+    if (object->visible) gfx_invalidate(scene, &object->bounds);
+}
+
+/**
+ * @brief Appends an object and damages it
+ */
+static int32_t add_object(struct gfx_scene * const scene, const struct gfx_object * const object)
+{
+    if (scene->count >= scene->capacity) return E_TX_QUEUE_FULL;
+
+    struct gfx_object *added = &scene->objects[scene->count];
+    *added = *object;
+    update_bounds(added);
+    damage_object(scene, added);
+
+    return scene->count++;
+}
+
+/**
+ * @brief Fills the part of a rectangle that falls in the tile
+ */
+static void fill(const struct gfx_rect * const tile, uint16_t *pixels, const struct gfx_rect * const rect,
+    uint16_t color)
+{
+    const struct gfx_rect area = rect_intersect(tile, rect);
+
+    if (rect_is_empty(&area)) return;
+
+    for (int32_t y = area.y; y < area.y + area.h; y++) {
+        uint16_t *row = &pixels[(y - tile->y) * tile->w + area.x - tile->x];
+        for (int32_t x = 0; x < area.w; x++) row[x] = color;
+    }
+}
+
+/**
+ * @brief Draws the pixels of a line that fall in the tile (Bresenham)
+ */
+static void draw_line(const struct gfx_rect * const tile, uint16_t *pixels, const struct gfx_object * const line)
+{
+    int32_t x = line->line.x0, y = line->line.y0;
+    const int32_t x1 = line->line.x1, y1 = line->line.y1;
+    const int32_t dx = abs(x1 - x), sx = x < x1 ? 1 : -1;
+    const int32_t dy = -abs(y1 - y), sy = y < y1 ? 1 : -1;
+    int32_t err = dx + dy;
+
+    // Horizontal and vertical lines are their bounds
+    if (dx == 0 || dy == 0) {
+        fill(tile, pixels, &line->bounds, line->color);
+        return;
+    }
+
+    for (;;) {
+        if (x >= tile->x && x < tile->x + tile->w && y >= tile->y && y < tile->y + tile->h) {
+            pixels[(y - tile->y) * tile->w + x - tile->x] = line->color;
+        }
+        if (x == x1 && y == y1) break;
+        const int32_t e2 = 2 * err;
+        if (e2 >= dy) { err += dy; x += sx; }
+        if (e2 <= dx) { err += dx; y += sy; }
+    }
+}
+
+/**
+ * @brief Mixes two 5/6/5 bits colors, field by field and rounded
+ *
+ * @param fg Foreground
+ * @param bg Background
+ * @param alpha Coverage of the foreground, 0 to 15
+ */
+static inline uint16_t blend565(uint16_t fg, uint16_t bg, uint32_t alpha)
+{
+    const uint32_t beta = 15 - alpha;
+    const uint32_t r = (((fg >> 11) & 0x1f) * alpha + ((bg >> 11) & 0x1f) * beta + 7) / 15;
+    const uint32_t g = (((fg >> 5) & 0x3f) * alpha + ((bg >> 5) & 0x3f) * beta + 7) / 15;
+    const uint32_t b = ((fg & 0x1f) * alpha + (bg & 0x1f) * beta + 7) / 15;
+
+    return (uint16_t)(r << 11 | g << 5 | b);
+}
+
+/**
+ * @brief Draws the pixels of a glyph that fall in the tile
+ */
+static void draw_glyph(const struct gfx_rect * const tile, uint16_t *pixels, const struct gfx_font * const font,
+    const struct gfx_glyph * const glyph, const struct gfx_rect * const box, uint16_t color)
+{
+    const struct gfx_rect area = rect_intersect(tile, box);
+    const uint8_t *bitmap = &font->bitmap[glyph->offset];
+
+    if (rect_is_empty(&area)) return;
+
+    for (int32_t y = area.y; y < area.y + area.h; y++) {
+        uint16_t *row = &pixels[(y - tile->y) * tile->w - tile->x];
+        uint32_t bit = (y - box->y) * glyph->width + area.x - box->x;
+
+        if (font->bpp == 1) {
+            for (int32_t x = area.x; x < area.x + area.w; x++, bit++) {
+                if (IS_BIT_SET(bitmap[bit >> 3], 0x80 >> (bit & 7))) row[x] = color;
+            }
+        } else {
+            for (int32_t x = area.x; x < area.x + area.w; x++, bit++) {
+                const uint32_t alpha = (bit & 1) ? bitmap[bit >> 1] & 0x0f : bitmap[bit >> 1] >> 4;
+                if (alpha == 15) row[x] = color;
+                else if (alpha != 0) row[x] = blend565(color, row[x], alpha);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Draws the glyphs of a text that fall in the tile
+ */
+static void draw_text(const struct gfx_rect * const tile, uint16_t *pixels, const struct gfx_object * const text)
+{
+    const struct gfx_font *font = text->text.font;
+    int32_t pen = text->text.x;
+
+    for (const char *c = text->text.string; *c != '\0'; c++) {
+        const struct gfx_glyph *glyph = find_glyph(font, *c);
+        const struct gfx_rect box = {pen + glyph->x_offset, text->text.y + glyph->y_offset,
+            glyph->width, glyph->height};
+        // Glyphs go left to right: once past the tile, the rest are too
+        if (box.x >= tile->x + tile->w) break;
+        draw_glyph(tile, pixels, font, glyph, &box, text->color);
+        pen += glyph->advance;
+    }
+}
+
+/**
+ * @brief Draws the scene over a tile and sends it to the display
+ */
+static int32_t render_tile(struct gfx_scene * const scene, const struct gfx_rect * const tile)
+{
+    int32_t ret;
+    uint16_t *pixels = scene->tile;
+    const uint32_t count = tile->w * tile->h;
+
+    for (uint32_t i = 0; i < count; i++) pixels[i] = scene->background;
+
+    for (uint32_t i = 0; i < scene->count; i++) {
+        const struct gfx_object *object = &scene->objects[i];
+        if (!object->visible) continue;
+        const struct gfx_rect overlap = rect_intersect(tile, &object->bounds);
+        if (rect_is_empty(&overlap)) continue;
+
+        switch (object->type) {
+            case GFX_RECT: fill(tile, pixels, &object->bounds, object->color); break;
+            case GFX_LINE: draw_line(tile, pixels, object); break;
+            case GFX_TEXT: draw_text(tile, pixels, object); break;
+        }
+    }
+
+    ret = scene->display->blit(tile, pixels);
+    if (ret < 0) { goto exit; }
+
+    scene->stats.blits++;
+    scene->stats.pixels += count;
+
+    exit:
+    return ret;
+}
+
+void gfx_init(struct gfx_scene * const scene, const struct gfx_display * const display,
+    struct gfx_object * const objects, uint32_t capacity, uint16_t background)
+{
+    const struct gfx_rect screen = {0, 0, display->width, display->height};
+
+    scene->display = display;
+    scene->objects = objects;
+    scene->capacity = capacity;
+    scene->count = 0;
+    scene->background = background;
+    scene->damaged = 0;
+    scene->stats = (struct gfx_stats){0, 0, 0};
+    gfx_invalidate(scene, &screen);
+}
+
+int32_t gfx_add_rect(struct gfx_scene * const scene, const struct gfx_rect * const rect, uint16_t color)
+{
+    const struct gfx_object object = {.type = GFX_RECT, .color = color, .visible = TRUE, .bounds = *rect};
+
+    return add_object(scene, &object);
+}
+
+int32_t gfx_add_line(struct gfx_scene * const scene, int16_t x0, int16_t y0, int16_t x1, int16_t y1,
+    uint16_t color)
+{
+    const struct gfx_object object = {.type = GFX_LINE, .color = color, .visible = TRUE,
+        .line = {x0, y0, x1, y1}};
+
+    return add_object(scene, &object);
+}
+
+int32_t gfx_add_text(struct gfx_scene * const scene, const struct gfx_font * const font, int16_t x, int16_t y,
+    const char *string, uint16_t color)
+{
+    const struct gfx_object object = {.type = GFX_TEXT, .color = color, .visible = TRUE,
+        .text = {font, string, x, y}};
+
+    return add_object(scene, &object);
+}
+
+int32_t gfx_set_color(struct gfx_scene * const scene, int32_t id, uint16_t color)
+{
+    struct gfx_object *object = find_object(scene, id);
+
+    if (object == NULL) return E_INVALID_PARAMETER;
+    if (object->color == color) return E_SUCCESS;
+
+    object->color = color;
+    damage_object(scene, object);
+
+    return E_SUCCESS;
+}
+
+int32_t gfx_move(struct gfx_scene * const scene, int32_t id, int16_t dx, int16_t dy)
+{
+    struct gfx_object *object = find_object(scene, id);
+
+    if (object == NULL) return E_INVALID_PARAMETER;
+
+    damage_object(scene, object);
+    switch (object->type) {
+        case GFX_RECT:
+            break;
+
+        case GFX_LINE:
+            object->line.x0 += dx;
+            object->line.y0 += dy;
+            object->line.x1 += dx;
+            object->line.y1 += dy;
+            break;
+
+        case GFX_TEXT:
+            object->text.x += dx;
+            object->text.y += dy;
+            break;
+    }
+    object->bounds.x += dx;
+    object->bounds.y += dy;
+    damage_object(scene, object);
+
+    return E_SUCCESS;
+}
+
+int32_t gfx_set_text(struct gfx_scene * const scene, int32_t id, const char *string)
+{
+    struct gfx_object *object = find_object(scene, id);
+
+    if (object == NULL || object->type != GFX_TEXT) return E_INVALID_PARAMETER;
+
+    damage_object(scene, object);
+    object->text.string = string;
+    update_bounds(object);
+    damage_object(scene, object);
+
+    return E_SUCCESS;
+}
+
+int32_t gfx_set_visible(struct gfx_scene * const scene, int32_t id, uint8_t visible)
+{
+    struct gfx_object *object = find_object(scene, id);
+
+    if (object == NULL) return E_INVALID_PARAMETER;
+    visible = visible ? TRUE : FALSE;
+    if (object->visible == visible) return E_SUCCESS;
+
+    // Damaged while visible: before showing it the area is the same
+    object->visible = TRUE;
+    damage_object(scene, object);
+    object->visible = visible;
+
+    return E_SUCCESS;
+}
+
+void gfx_invalidate(struct gfx_scene * const scene, const struct gfx_rect * const rect)
+{
+    const struct gfx_rect screen = {0, 0, scene->display->width, scene->display->height};
+    struct gfx_rect added = rect_intersect(&screen, rect);
+
+    if (rect_is_empty(&added)) return;
+
+    // Merges while the bounding box costs no more pixels than both apart. Every merge removes a rectangle from the
+    // list and the grown one is checked against all the others again
+    restart:
+    for (uint32_t i = 0; i < scene->damaged; i++) {
+        const struct gfx_rect merged = rect_union(&added, &scene->damage[i]);
+        if (rect_area(&merged) <= rect_area(&added) + rect_area(&scene->damage[i])) {
+            added = merged;
+            scene->damage[i] = scene->damage[--scene->damaged];
+            goto restart;
+        }
+    }
+
+    if (scene->damaged < GFX_MAX_DAMAGE) {
+        scene->damage[scene->damaged++] = added;
+        return;
+    }
+
+    // Full list: merges with the rectangle that grows the least
+    uint32_t best = 0;
+    int32_t best_growth = INT32_MAX;
+    for (uint32_t i = 0; i < scene->damaged; i++) {
+        const struct gfx_rect merged = rect_union(&added, &scene->damage[i]);
+        const int32_t growth = rect_area(&merged) - rect_area(&scene->damage[i]);
+        if (growth < best_growth) {
+            best = i;
+            best_growth = growth;
+        }
+    }
+    added = rect_union(&added, &scene->damage[best]);
+    scene->damage[best] = scene->damage[--scene->damaged];
+    goto restart;
+}
+
+int32_t gfx_render(struct gfx_scene * const scene)
+{
+    int32_t ret = E_SUCCESS;
+
+    if (scene->damaged == 0) { goto exit; }
+
+    scene->stats.renders++;
+    while (scene->damaged > 0) {
+        const struct gfx_rect area = scene->damage[scene->damaged - 1];
+        // Tiles are whole rows of the area when they fit, so each one is a single window
+        const int16_t tile_w = CHOOSE_MIN(area.w, GFX_TILE_PIXELS);
+        const int16_t tile_h = CHOOSE_MAX(1, GFX_TILE_PIXELS / tile_w);
+
+        for (int32_t y = area.y; y < area.y + area.h; y += tile_h) {
+            for (int32_t x = area.x; x < area.x + area.w; x += tile_w) {
+                const struct gfx_rect tile = {x, y, CHOOSE_MIN(tile_w, area.x + area.w - x),
+                    CHOOSE_MIN(tile_h, area.y + area.h - y)};
+                // The area stays damaged, to be drawn whole by the next render
+                ret = render_tile(scene, &tile);
+                if (ret < 0) { goto exit; }
+            }
+        }
+        scene->damaged--;
+    }
+
+    exit:
+    return ret;
+}
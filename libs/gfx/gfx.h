@@ -0,0 +1,202 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#ifndef LIBS_GFX_GFX_H_
+#define LIBS_GFX_GFX_H_
+
+#include "libs/gfx/font.h"
+
+#include <stdint.h>
+
+/**
+ * @brief Retained mode 2D renderer.
+ *
+ * A scene is a list of objects (filled rectangles, lines and text) drawn in order over a background color. Changing
+ * an object damages the area it covered and the area it covers now. gfx_render() draws only the damaged areas: each
+ * one is split in tiles of at most GFX_TILE_PIXELS pixels that are drawn in RAM and sent to the display with a single
+ * windowed write, so there is no frame buffer and no pixel is sent twice within a tile.
+ *
+ * Damaged rectangles are merged when their bounding box costs no more pixels than the two apart. When the list is
+ * full a new rectangle is merged with the one it grows the least.
+ *
+ * Colors are the 16 bits pixels of the display. Objects, and the strings of text objects, are owned by the caller
+ * and must live as long as the scene.
+ */
+
+/** Damaged rectangles kept before they are forced to merge */
+#define GFX_MAX_DAMAGE 16
+
+/** Pixels of the tile drawn in RAM */
+#define GFX_TILE_PIXELS 1024
+
+struct gfx_rect {
+    int16_t x;
+    int16_t y;
+    int16_t w;
+    int16_t h;
+};
+
+struct gfx_display {
+    uint16_t width;
+    uint16_t height;
+    /**
+     * @brief Writes pixels to a rectangle of the display, row by row
+     */
+    int32_t (*blit)(const struct gfx_rect * const rect, const uint16_t *pixels);
+};
+
+enum gfx_type {
+    GFX_RECT,
+    GFX_LINE,
+    GFX_TEXT,
+};
+
+struct gfx_object {
+    enum gfx_type type;
+    uint16_t color;
+    uint8_t visible;
+    struct gfx_rect bounds;     /** Pixels the object may touch */
+    union {
+        struct {
+            int16_t x0, y0, x1, y1;
+        } line;
+        struct {
+            const struct gfx_font *font;
+            const char *string;
+            int16_t x;          /** Pen at the first glyph */
+            int16_t y;          /** Top of the line */
+        } text;
+    };
+};
+
+struct gfx_stats {
+    uint32_t renders;           /** Calls to gfx_render() that drew something */
+    uint32_t blits;             /** Tiles sent to the display */
+    uint32_t pixels;            /** Pixels sent to the display */
+};
+
+struct gfx_scene {
+    const struct gfx_display *display;
+    struct gfx_object *objects;
+    uint32_t capacity;
+    uint32_t count;
+    uint16_t background;
+    struct gfx_rect damage[GFX_MAX_DAMAGE];
+    uint32_t damaged;
+    struct gfx_stats stats;
+    uint16_t tile[GFX_TILE_PIXELS];
+};
+
+/**
+ * @brief Initializes an empty scene. The whole display is damaged, so the first render clears it
+ *
+ * @param scene Scene
+ * @param display Display
+ * @param objects Storage of the objects
+ * @param capacity Number of objects the storage holds
+ * @param background Background color
+ */
+extern void gfx_init(struct gfx_scene * const scene, const struct gfx_display * const display,
+    struct gfx_object * const objects, uint32_t capacity, uint16_t background);
+
+/**
+ * @brief Adds a filled rectangle
+ *
+ * @param scene Scene
+ * @param rect Rectangle
+ * @param color Color
+ * @return int32_t Object id. E_TX_QUEUE_FULL if the scene is full
+ */
+extern int32_t gfx_add_rect(struct gfx_scene * const scene, const struct gfx_rect * const rect, uint16_t color);
+
+/**
+ * @brief Adds a line, both ends included
+ *
+ * @param scene Scene
+ * @param x0 Start column
+ * @param y0 Start row
+ * @param x1 End column
+ * @param y1 End row
+ * @param color Color
+ * @return int32_t Object id. E_TX_QUEUE_FULL if the scene is full
+ */
+extern int32_t gfx_add_line(struct gfx_scene * const scene, int16_t x0, int16_t y0, int16_t x1, int16_t y1,
+    uint16_t color);
+
+/**
+ * @brief Adds a line of text. Only the pixels of the glyphs are drawn: the background shows through
+ *
+ * @param scene Scene
+ * @param font Font
+ * @param x Column of the pen
+ * @param y Top row of the line
+ * @param string Text. Must live as long as the object
+ * @param color Color
+ * @return int32_t Object id. E_TX_QUEUE_FULL if the scene is full
+ */
+extern int32_t gfx_add_text(struct gfx_scene * const scene, const struct gfx_font * const font, int16_t x, int16_t y,
+    const char *string, uint16_t color);
+
+/**
+ * @brief Changes the color of an object
+ *
+ * @param scene Scene
+ * @param id Object id
+ * @param color Color
+ * @return int32_t E_SUCCESS on success. E_INVALID_PARAMETER for an unknown id
+ */
+extern int32_t gfx_set_color(struct gfx_scene * const scene, int32_t id, uint16_t color);
+
+/**
+ * @brief Moves an object
+ *
+ * @param scene Scene
+ * @param id Object id
+ * @param dx Columns to move
+ * @param dy Rows to move
+ * @return int32_t E_SUCCESS on success. E_INVALID_PARAMETER for an unknown id
+ */
+extern int32_t gfx_move(struct gfx_scene * const scene, int32_t id, int16_t dx, int16_t dy);
+
+/**
+ * @brief Changes the text of a text object. Must also be called when the string changed in place
+ *
+ * @param scene Scene
+ * @param id Object id
+ * @param string Text. Must live as long as the object
+ * @return int32_t E_SUCCESS on success. E_INVALID_PARAMETER for an unknown id or an object that is not text
+ */
+extern int32_t gfx_set_text(struct gfx_scene * const scene, int32_t id, const char *string);
+
+/**
+ * @brief Shows or hides an object
+ *
+ * @param scene Scene
+ * @param id Object id
+ * @param visible TRUE to show
+ * @return int32_t E_SUCCESS on success. E_INVALID_PARAMETER for an unknown id
+ */
+extern int32_t gfx_set_visible(struct gfx_scene * const scene, int32_t id, uint8_t visible);
+
+/**
+ * @brief Damages a rectangle, so it is drawn again by the next render
+ *
+ * @param scene Scene
+ * @param rect Rectangle
+ */
+extern void gfx_invalidate(struct gfx_scene * const scene, const struct gfx_rect * const rect);
+
+/**
+ * @brief Draws the damaged rectangles
+ *
+ * @param scene Scene
+ * @return int32_t E_SUCCESS on success. Rectangles not sent stay damaged
+ */
+extern int32_t gfx_render(struct gfx_scene * const scene);
+
+#endif // LIBS_GFX_GFX_H_
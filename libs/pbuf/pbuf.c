@@ -0,0 +1,119 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#include "libs/pbuf/pbuf.h"
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+/**
+ * @brief Gets the first byte of the memory of a buffer
+ *
+ * @param pbuf Buffer
+ * @return uint8_t* Start of the buffer memory
+ */
+static uint8_t *buffer_start(const struct pbuf * const pbuf)
+{
+    const struct pbuf_pool *pool = pbuf->pool;
+    return pool->storage + (uint32_t)(pbuf - pool->pbufs) * pool->stride;
+}
+
+struct pbuf *pbuf_alloc(struct pbuf_pool * const pool)
+{
+    struct pbuf *pbuf = NULL;
+
+    // Masking interrupts up to configMAX_SYSCALL_INTERRUPT_PRIORITY is valid both from tasks and from ISRs
+    UBaseType_t mask = taskENTER_CRITICAL_FROM_ISR();
+    if (pool->free != NULL) {
+        pbuf = pool->free;
+        pool->free = pbuf->next;
+    } else if (pool->fresh > 0) {
+        pool->fresh--;
+        pbuf = &pool->pbufs[pool->fresh];
+        pbuf->pool = pool;
+    }
+
+    if (pbuf != NULL) {
+        pool->available--;
+        if (pool->available < pool->min_available) pool->min_available = pool->available;
+    } else {
+        pool->failures++;
+    }
+    taskEXIT_CRITICAL_FROM_ISR(mask);
+
+    if (pbuf != NULL) {
+        pbuf->next = NULL;
+        pbuf->payload = buffer_start(pbuf) + pool->headroom;
+        pbuf->size = 0;
+        pbuf->refs = 1;
+    }
+
+    return pbuf;
+}
+
+void pbuf_ref(struct pbuf * const pbuf)
+{
+    UBaseType_t mask = taskENTER_CRITICAL_FROM_ISR();
+    pbuf->refs++;
+    taskEXIT_CRITICAL_FROM_ISR(mask);
+}
+
+void pbuf_free(struct pbuf * const pbuf)
+{
+    if (pbuf == NULL) return;
+
+    struct pbuf_pool *pool = pbuf->pool;
+
+    UBaseType_t mask = taskENTER_CRITICAL_FROM_ISR();
+    if (--pbuf->refs == 0) {
+        pbuf->next = pool->free;
+        pool->free = pbuf;
+        pool->available++;
+    }
+    taskEXIT_CRITICAL_FROM_ISR(mask);
+}
+
+uint32_t pbuf_headroom(const struct pbuf * const pbuf)
+{
+    return pbuf->payload - buffer_start(pbuf);
+}
+
+uint32_t pbuf_tailroom(const struct pbuf * const pbuf)
+{
+    return pbuf->pool->capacity - pbuf_headroom(pbuf) - pbuf->size;
+}
+
+uint8_t *pbuf_push_header(struct pbuf * const pbuf, uint32_t size)
+{
+    if (size > pbuf_headroom(pbuf)) return NULL;
+
+    pbuf->payload -= size;
+    pbuf->size += size;
+    return pbuf->payload;
+}
+
+uint8_t *pbuf_pull_header(struct pbuf * const pbuf, uint32_t size)
+{
+    if (size > pbuf->size) return NULL;
+
+    pbuf->payload += size;
+    pbuf->size -= size;
+    return pbuf->payload;
+}
+
+uint8_t *pbuf_put(struct pbuf * const pbuf, uint32_t size)
+{
+    if (size > pbuf_tailroom(pbuf)) return NULL;
+
+    uint8_t *tail = pbuf->payload + pbuf->size;
+    pbuf->size += size;
+    return tail;
+}
@@ -0,0 +1,145 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#ifndef LIBS_PBUF_PBUF_H_
+#define LIBS_PBUF_PBUF_H_
+
+#include <stdint.h>
+
+/**
+ * @brief Pools of fixed size, reference counted packet buffers.
+ *
+ * A buffer is filled once by its producer and then handed from subsystem to subsystem as a pointer. Every buffer
+ * keeps headroom in front of its payload, so a header (an SPI command byte, a protocol or log record header) is
+ * prepended with pbuf_push_header() instead of copying the payload after it.
+ *
+ * Pools are statically allocated with PBUF_POOL_DEFINE() and need no initialization. pbuf_alloc(), pbuf_ref() and
+ * pbuf_free() may be called from tasks and from ISRs.
+ */
+
+/** Alignment of every buffer of a pool */
+#define PBUF_ALIGNMENT 4
+
+/** Size of a buffer rounded up to PBUF_ALIGNMENT */
+#define PBUF_STRIDE(size) (((size) + PBUF_ALIGNMENT - 1) & ~(PBUF_ALIGNMENT - 1))
+
+struct pbuf_pool;
+
+struct pbuf {
+    struct pbuf *next;          /** Links free buffers. Free for the owner to chain buffers otherwise */
+    struct pbuf_pool *pool;     /** Pool the buffer belongs to */
+    uint8_t *payload;           /** First byte of the payload */
+    uint16_t size;              /** Size of the payload in bytes */
+    volatile uint16_t refs;     /** Number of references. The buffer goes back to the pool when it drops to 0 */
+};
+
+struct pbuf_pool {
+    struct pbuf * const pbufs;  /** Buffer descriptors */
+    uint8_t * const storage;    /** Buffer memory, stride bytes per buffer */
+    const uint16_t count;       /** Number of buffers */
+    const uint16_t stride;      /** Distance between two buffers in storage */
+    const uint16_t capacity;    /** Bytes of each buffer, headroom included */
+    const uint16_t headroom;    /** Bytes reserved before the payload of a newly allocated buffer */
+
+    uint16_t fresh;             /** Buffers never allocated, taken from the end of pbufs */
+    uint16_t available;         /** Buffers in the pool */
+    uint16_t min_available;     /** Lowest value of available. Tells how close the pool got to exhaustion */
+    uint32_t failures;          /** Number of pbuf_alloc() calls that found the pool empty */
+    struct pbuf *free;          /** Buffers given back to the pool */
+};
+
+/**
+ * @brief Defines a static pool of buffers
+ *
+ * @param _name Name of the struct pbuf_pool object
+ * @param _count Number of buffers
+ * @param _size Payload bytes of each buffer
+ * @param _headroom Bytes reserved before the payload for headers
+ */
+#define PBUF_POOL_DEFINE(_name, _count, _size, _headroom)                                               \
+    static struct pbuf _name##_pbufs[(_count)];                                                         \
+    static uint8_t _name##_storage[(_count)][PBUF_STRIDE((_headroom) + (_size))]                        \
+        __attribute__((aligned(PBUF_ALIGNMENT)));                                                       \
+    static struct pbuf_pool _name = {                                                                   \
+        .pbufs = _name##_pbufs,                                                                         \
+        .storage = &_name##_storage[0][0],                                                              \
+        .count = (_count),                                                                              \
+        .stride = PBUF_STRIDE((_headroom) + (_size)),                                                   \
+        .capacity = (_headroom) + (_size),                                                              \
+        .headroom = (_headroom),                                                                        \
+        .fresh = (_count),                                                                              \
+        .available = (_count),                                                                          \
+        .min_available = (_count),                                                                      \
+    }
+
+/**
+ * @brief Takes a buffer from a pool. Its payload is empty, after headroom bytes, and it holds one reference
+ *
+ * @param pool Pool
+ * @return struct pbuf* Buffer or NULL if the pool is empty
+ */
+extern struct pbuf *pbuf_alloc(struct pbuf_pool * const pool);
+
+/**
+ * @brief Adds a reference to a buffer. Every reference must be released with pbuf_free()
+ *
+ * @param pbuf Buffer
+ */
+extern void pbuf_ref(struct pbuf * const pbuf);
+
+/**
+ * @brief Releases a reference to a buffer. The last one gives the buffer back to its pool
+ *
+ * @param pbuf Buffer. NULL is ignored
+ */
+extern void pbuf_free(struct pbuf * const pbuf);
+
+/**
+ * @brief Gets the bytes available before the payload
+ *
+ * @param pbuf Buffer
+ * @return uint32_t Headroom in bytes
+ */
+extern uint32_t pbuf_headroom(const struct pbuf * const pbuf);
+
+/**
+ * @brief Gets the bytes available after the payload
+ *
+ * @param pbuf Buffer
+ * @return uint32_t Tailroom in bytes
+ */
+extern uint32_t pbuf_tailroom(const struct pbuf * const pbuf);
+
+/**
+ * @brief Grows the payload to the front to make room for a header
+ *
+ * @param pbuf Buffer
+ * @param size Size of the header in bytes
+ * @return uint8_t* Start of the header (the new payload) or NULL if there is not enough headroom
+ */
+extern uint8_t *pbuf_push_header(struct pbuf * const pbuf, uint32_t size);
+
+/**
+ * @brief Removes a header from the front of the payload
+ *
+ * @param pbuf Buffer
+ * @param size Size of the header in bytes
+ * @return uint8_t* New payload or NULL if the payload is smaller than size
+ */
+extern uint8_t *pbuf_pull_header(struct pbuf * const pbuf, uint32_t size);
+
+/**
+ * @brief Grows the payload at its end
+ *
+ * @param pbuf Buffer
+ * @param size Number of bytes to append
+ * @return uint8_t* Where the appended bytes go or NULL if there is not enough tailroom
+ */
+extern uint8_t *pbuf_put(struct pbuf * const pbuf, uint32_t size);
+
+#endif // LIBS_PBUF_PBUF_H_
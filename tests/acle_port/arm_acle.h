@@ -0,0 +1,58 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#ifndef TESTS_ACLE_PORT_ARM_ACLE_H_
+#define TESTS_ACLE_PORT_ARM_ACLE_H_
+
+#include <stdint.h>
+
+// The ACLE SIMD intrinsics used by libs/audio, in plain C as the ACLE specification defines them, so the code built
+// for __ARM_FEATURE_SIMD32 compiles and runs on the host. Pairs hold the first sample in the low half, as a
+// little endian word load does on the Cortex-M4
+
+typedef int32_t int16x2_t;
+
+static inline int32_t acle_saturate(int64_t value, uint32_t bits)
+{
+    const int64_t max = (1LL << (bits - 1)) - 1;
+    const int64_t min = -(1LL << (bits - 1));
+
+    return value > max ? max : value < min ? min : value;
+}
+
+static inline int16_t acle_low(int16x2_t pair)
+{
+    return (int16_t)(pair & 0xffff);
+}
+
+static inline int16_t acle_high(int16x2_t pair)
+{
+    return (int16_t)((uint32_t)pair >> 16);
+}
+
+static inline int16x2_t acle_pair(int32_t low, int32_t high)
+{
+    return (int16x2_t)(((uint32_t)high << 16) | ((uint32_t)low & 0xffff));
+}
+
+/** Saturates to a signed range of bits bits */
+#define __ssat(value, bits) ((int32_t)acle_saturate((value), (bits)))
+
+/** Adds both halves, saturating each to 16 bits */
+static inline int16x2_t __qadd16(int16x2_t a, int16x2_t b)
+{
+    return acle_pair(acle_saturate(acle_low(a) + acle_low(b), 16), acle_saturate(acle_high(a) + acle_high(b), 16));
+}
+
+/** Adds the products of both halves to a 64 bits accumulator */
+static inline int64_t __smlald(int16x2_t a, int16x2_t b, int64_t acc)
+{
+    return acc + (int32_t)acle_low(a) * acle_low(b) + (int32_t)acle_high(a) * acle_high(b);
+}
+
+#endif // TESTS_ACLE_PORT_ARM_ACLE_H_
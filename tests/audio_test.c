@@ -0,0 +1,239 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#include "libs/audio/audio.h"
+
+#include "ulibc/include/utils.h"
+
+#include "tests/test.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** Samples of the random blocks. Odd, so the paths that take two samples at a time also run their tail */
+#define BLOCK 1001
+
+/** Random blocks checked against the reference of each function */
+#define ROUNDS 200
+
+/** Sources of the largest mix */
+#define MAX_SOURCES 4
+
+#if defined(__ARM_FEATURE_SIMD32)
+#define NAME "audio_simd_test"
+#else
+#define NAME "audio_test"
+#endif
+
+static int16_t src[MAX_SOURCES][BLOCK];
+static int16_t dst[2 * BLOCK];
+static int16_t expected[2 * BLOCK];
+
+static int16_t saturate(int64_t value)
+{
+    return value > INT16_MAX ? INT16_MAX : value < INT16_MIN ? INT16_MIN : value;
+}
+
+/**
+ * @brief Random sample. A third of them sits at or next to full scale, where saturation happens
+ */
+static int16_t random_sample(void)
+{
+    static const int16_t edges[] = {INT16_MIN, INT16_MIN + 1, -1, 0, 1, INT16_MAX - 1, INT16_MAX};
+
+    if (rand() % 3 == 0) return edges[rand() % ARRAY_SIZE(edges)];
+    return rand() - RAND_MAX / 2;
+}
+
+static void random_block(int16_t * const block, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++) block[i] = random_sample();
+}
+
+static void test_layout(void)
+{
+    int16_t left[3] = {1, INT16_MIN, 3}, right[3] = {-1, INT16_MAX, -3}, stereo[6], l[3], r[3];
+    static const int16_t interleaved[6] = {1, -1, INT16_MIN, INT16_MAX, 3, -3};
+    static const int16_t doubled[6] = {1, 1, INT16_MIN, INT16_MIN, 3, 3};
+
+    audio_interleave(left, right, stereo, 3);
+    CHECK(memcmp(stereo, interleaved, sizeof(stereo)) == 0);
+    audio_deinterleave(stereo, l, r, 3);
+    CHECK(memcmp(l, left, sizeof(l)) == 0 && memcmp(r, right, sizeof(r)) == 0);
+    audio_mono_to_stereo(left, stereo, 3);
+    CHECK(memcmp(stereo, doubled, sizeof(stereo)) == 0);
+}
+
+static void test_mix_into(void)
+{
+    // Saturation edges, on both samples of a pair and on the tail
+    int16_t a[5] = {INT16_MAX, INT16_MIN, INT16_MIN, INT16_MAX, -100};
+    const int16_t b[5] = {1, -1, INT16_MIN, INT16_MIN, INT16_MIN};
+    static const int16_t sums[5] = {INT16_MAX, INT16_MIN, INT16_MIN, -1, INT16_MIN};
+
+    audio_mix_into(a, b, 5);
+    CHECK(memcmp(a, sums, sizeof(a)) == 0);
+
+    for (uint32_t round = 0; round < ROUNDS; round++) {
+        const uint32_t count = BLOCK - round % 2;
+        random_block(dst, count);
+        random_block(src[0], count);
+        for (uint32_t i = 0; i < count; i++) expected[i] = saturate(dst[i] + src[0][i]);
+        audio_mix_into(dst, src[0], count);
+        CHECK(memcmp(dst, expected, count * sizeof(int16_t)) == 0);
+    }
+}
+
+static void test_mix(void)
+{
+    const int16_t *sources[MAX_SOURCES] = {src[0], src[1], src[2], src[3]};
+
+    // Sources that cancel each other do not clip: the sum saturates once, at the end
+    src[0][0] = INT16_MAX;
+    src[1][0] = INT16_MAX;
+    src[2][0] = INT16_MIN;
+    audio_mix(dst, sources, 3, 1);
+    CHECK(dst[0] == INT16_MAX - 1);
+
+    // No sources is silence
+    dst[0] = dst[1] = 1234;
+    audio_mix(dst, sources, 0, 2);
+    CHECK(dst[0] == 0 && dst[1] == 0);
+
+    for (uint32_t round = 0; round < ROUNDS; round++) {
+        const uint32_t n_sources = round % (MAX_SOURCES + 1);
+        const uint32_t count = BLOCK - round % 2;
+
+        for (uint32_t j = 0; j < MAX_SOURCES; j++) random_block(src[j], count);
+        for (uint32_t i = 0; i < count; i++) {
+            int64_t sum = 0;
+            for (uint32_t j = 0; j < n_sources; j++) sum += src[j][i];
+            expected[i] = saturate(sum);
+        }
+        audio_mix(dst, sources, n_sources, count);
+        CHECK(memcmp(dst, expected, count * sizeof(int16_t)) == 0);
+
+        // In place, into the first source
+        if (n_sources > 0) {
+            audio_mix(src[0], sources, n_sources, count);
+            CHECK(memcmp(src[0], expected, count * sizeof(int16_t)) == 0);
+        }
+    }
+}
+
+static void test_gain(void)
+{
+    int16_t block[4] = {INT16_MIN, INT16_MAX, -1, 1};
+
+    // -1.0 * -1.0 is +1.0, one past the largest sample
+    audio_gain(block, dst, 4, INT16_MIN);
+    CHECK(dst[0] == INT16_MAX && dst[1] == INT16_MIN + 1 && dst[2] == 1 && dst[3] == -1);
+    audio_gain(block, dst, 4, INT16_MAX);
+    CHECK(dst[0] == INT16_MIN + 1 && dst[1] == INT16_MAX - 1 && dst[2] == -1 && dst[3] == 1);
+    audio_gain(block, block, 4, 0);
+    CHECK(block[0] == 0 && block[1] == 0 && block[2] == 0 && block[3] == 0);
+
+    for (uint32_t round = 0; round < ROUNDS; round++) {
+        const int16_t gain = random_sample();
+        random_block(src[0], BLOCK);
+        for (uint32_t i = 0; i < BLOCK; i++) expected[i] = saturate(((int32_t)src[0][i] * gain + (1 << 14)) >> 15);
+        audio_gain(src[0], src[0], BLOCK, gain);
+        CHECK(memcmp(src[0], expected, BLOCK * sizeof(int16_t)) == 0);
+    }
+}
+
+static void test_gain_ramp(void)
+{
+    // A fade out of a full scale stereo block: every frame gets one gain on both channels, the first one the start
+    for (uint32_t i = 0; i < 2 * 100; i++) src[0][i] = INT16_MIN;
+    audio_gain_ramp(src[0], dst, 100, 2, INT16_MIN, 0);
+    CHECK(dst[0] == INT16_MAX && dst[1] == INT16_MAX);
+    for (uint32_t i = 1; i < 100; i++) {
+        CHECK(dst[2 * i] == dst[2 * i + 1]);
+        CHECK(dst[2 * i] <= dst[2 * i - 2]);
+    }
+    CHECK(dst[198] > 0 && dst[198] <= INT16_MAX / 100 + 1);
+
+    // A ramp from -1.0 to almost +1.0 never wraps around
+    audio_gain_ramp(src[0], dst, 200, 1, INT16_MIN, INT16_MAX);
+    for (uint32_t i = 1; i < 200; i++) CHECK(dst[i] <= dst[i - 1]);
+
+    // A constant ramp is a constant gain
+    random_block(src[0], BLOCK);
+    audio_gain(src[0], expected, BLOCK, 12345);
+    audio_gain_ramp(src[0], dst, BLOCK, 1, 12345, 12345);
+    CHECK(memcmp(dst, expected, BLOCK * sizeof(int16_t)) == 0);
+
+    // No frames touches nothing
+    dst[0] = 77;
+    audio_gain_ramp(src[0], dst, 0, 2, 0, 0);
+    CHECK(dst[0] == 77);
+}
+
+static void test_dot(void)
+{
+    // Every product at its largest: the 64 bits accumulator takes what 32 bits could not
+    for (uint32_t i = 0; i < BLOCK; i++) src[0][i] = src[1][i] = INT16_MIN;
+    CHECK(audio_dot(src[0], src[1], BLOCK) == (int64_t)BLOCK << 30);
+    CHECK(audio_dot(src[0], src[1], 0) == 0);
+
+    for (uint32_t round = 0; round < ROUNDS; round++) {
+        const uint32_t count = BLOCK - round % 2;
+        int64_t sum = 0;
+
+        random_block(src[0], count);
+        random_block(src[1], count);
+        for (uint32_t i = 0; i < count; i++) sum += (int64_t)src[0][i] * src[1][i];
+        CHECK(audio_dot(src[0], src[1], count) == sum);
+    }
+}
+
+static void test_conversions(void)
+{
+    static int32_t wide[4];
+    static const int32_t s24[6] = {0x7fffff, 0x7fff7f, -0x800000, -129, -128, 127};
+    static const int16_t s16[6] = {INT16_MAX, INT16_MAX, INT16_MIN, -1, 0, 0};
+    static const uint8_t packed[9] = {0xff, 0xff, 0x7f, 0x00, 0x00, 0x80, 0x7f, 0xff, 0xff};
+    static const uint8_t u8[3] = {0, 128, 255};
+    int16_t out[6];
+
+    // In place: the 24 bits samples start where the 16 bits ones do
+    int16_t *in_place = (int16_t *)wide;
+    in_place[0] = INT16_MIN;
+    in_place[1] = -1;
+    in_place[2] = INT16_MAX;
+    audio_s16_to_s24(in_place, wide, 3);
+    CHECK(wide[0] == -0x800000 && wide[1] == -256 && wide[2] == 0x7fff00);
+
+    // Rounding past the largest sample saturates
+    audio_s24_to_s16(s24, out, 6);
+    CHECK(memcmp(out, s16, sizeof(out)) == 0);
+
+    audio_s24le_to_s16(packed, out, 3);
+    CHECK(out[0] == INT16_MAX && out[1] == INT16_MIN && out[2] == -1);
+
+    audio_u8_to_s16(u8, out, 3);
+    CHECK(out[0] == INT16_MIN && out[1] == 0 && out[2] == 32512);
+}
+
+int main(void)
+{
+    srand(7);
+
+    test_layout();
+    test_mix_into();
+    test_mix();
+    test_gain();
+    test_gain_ramp();
+    test_dot();
+    test_conversions();
+
+    return test_report(NAME);
+}
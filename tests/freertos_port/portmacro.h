@@ -0,0 +1,51 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#ifndef TESTS_FREERTOS_PORT_PORTMACRO_H_
+#define TESTS_FREERTOS_PORT_PORTMACRO_H_
+
+#include <stdint.h>
+
+// Just enough of a port for the FreeRTOS headers to build on the host. The tests are single threaded: critical
+// sections and interrupt masking do nothing, and each test provides the few kernel functions its code calls
+
+#define portCHAR        char
+#define portFLOAT       float
+#define portDOUBLE      double
+#define portLONG        long
+#define portSHORT       short
+#define portSTACK_TYPE  uint32_t
+#define portBASE_TYPE   long
+
+typedef portSTACK_TYPE StackType_t;
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define portMAX_DELAY               (TickType_t)0xffffffffUL
+#define portTICK_TYPE_IS_ATOMIC     1
+#define portSTACK_GROWTH            (-1)
+#define portTICK_PERIOD_MS          ((TickType_t)1000 / configTICK_RATE_HZ)
+#define portBYTE_ALIGNMENT          8
+
+#define portYIELD()
+#define portEND_SWITCHING_ISR(x)                (void)(x)
+#define portYIELD_FROM_ISR(x)                   portEND_SWITCHING_ISR(x)
+#define portSET_INTERRUPT_MASK_FROM_ISR()       0
+#define portCLEAR_INTERRUPT_MASK_FROM_ISR(x)    (void)(x)
+#define portDISABLE_INTERRUPTS()
+#define portENABLE_INTERRUPTS()
+#define portENTER_CRITICAL()
+#define portEXIT_CRITICAL()
+#define portNOP()
+#define portMEMORY_BARRIER()
+
+#define portTASK_FUNCTION_PROTO(vFunction, pvParameters)    void vFunction(void *pvParameters)
+#define portTASK_FUNCTION(vFunction, pvParameters)          void vFunction(void *pvParameters)
+
+#endif // TESTS_FREERTOS_PORT_PORTMACRO_H_
@@ -0,0 +1,235 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#include "libs/fusion/fusion.h"
+
+#include "include/errors.h"
+
+#include "ulibc/include/utils.h"
+
+#include "tests/test.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/** Configuration of the MPU6050 fusion task: ±2000 dps gyroscope and ±2 g accelerometer */
+#define RATE_HZ 1000
+#define GYRO_RANGE_DPS 2000
+#define ACCEL_ONE_G 16384
+
+/** Seconds of motion fed to the filters */
+#define SECONDS 20
+
+/** Peak accelerometer noise in raw units */
+#define ACCEL_NOISE 200
+
+/** Largest angle allowed between the fixed point and the float orientation, in degrees */
+#define MAX_FIXED_FLOAT_DEG 0.01
+
+/** Largest tilt error allowed at the end, in degrees, for the filters that correct it */
+#define MAX_TILT_DEG 0.5
+
+/** Relative error allowed in the gyroscope step of the float filter */
+#define MAX_GYRO_STEP_ERROR 1e-6
+
+/** 1.0 in Q40, the format of the gyroscope step of the fixed point filter */
+#define Q40_ONE 1099511627776.0
+
+/**
+ * @brief Angle between two orientations in degrees
+ */
+static double angle_deg(const double a[4], const double b[4])
+{
+    // q and -q are the same orientation
+    const double sign = a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3] < 0 ? -1 : 1;
+    double difference = 0, sum = 0;
+
+    // acos() of the dot product would turn the rounding of the float filter into hundredths of a degree
+    for (int i = 0; i < 4; i++) {
+        difference += (a[i] - sign * b[i]) * (a[i] - sign * b[i]);
+        sum += (a[i] + sign * b[i]) * (a[i] + sign * b[i]);
+    }
+    return 4 * atan2(sqrt(difference), sqrt(sum)) * 180 / M_PI;
+}
+
+/**
+ * @brief Angle between the gravity directions of two orientations in degrees. Blind to rotations about gravity
+ */
+static double tilt_deg(const double a[4], const double b[4])
+{
+    double va[3], vb[3];
+    const double *q[2] = {a, b};
+    double *v[2] = {va, vb};
+
+    for (int i = 0; i < 2; i++) {
+        v[i][0] = 2 * (q[i][1] * q[i][3] - q[i][0] * q[i][2]);
+        v[i][1] = 2 * (q[i][0] * q[i][1] + q[i][2] * q[i][3]);
+        v[i][2] = q[i][0] * q[i][0] - q[i][1] * q[i][1] - q[i][2] * q[i][2] + q[i][3] * q[i][3];
+    }
+    const double dot = va[0] * vb[0] + va[1] * vb[1] + va[2] * vb[2];
+    return acos(dot > 1 ? 1 : dot < -1 ? -1 : dot) * 180 / M_PI;
+}
+
+static void from_q30(const struct fusion_quat * const q, double out[4])
+{
+    out[0] = (double)q->w / FUSION_Q30_ONE;
+    out[1] = (double)q->x / FUSION_Q30_ONE;
+    out[2] = (double)q->y / FUSION_Q30_ONE;
+    out[3] = (double)q->z / FUSION_Q30_ONE;
+}
+
+/**
+ * @brief Rotates the true orientation by what the gyroscope measured, exactly
+ */
+static void integrate(double q[4], const int16_t gyro[3])
+{
+    const double scale = GYRO_RANGE_DPS * M_PI / 180 / 32768 / RATE_HZ;
+    const double r[3] = {gyro[0] * scale, gyro[1] * scale, gyro[2] * scale};
+    const double angle = sqrt(r[0] * r[0] + r[1] * r[1] + r[2] * r[2]);
+    double d[4] = {1, 0, 0, 0};
+
+    if (angle > 0) {
+        d[0] = cos(angle / 2);
+        for (int i = 0; i < 3; i++) d[i + 1] = sin(angle / 2) * r[i] / angle;
+    }
+    const double w = q[0], x = q[1], y = q[2], z = q[3];
+    q[0] = w * d[0] - x * d[1] - y * d[2] - z * d[3];
+    q[1] = w * d[1] + x * d[0] + y * d[3] - z * d[2];
+    q[2] = w * d[2] - x * d[3] + y * d[0] + z * d[1];
+    q[3] = w * d[3] + x * d[2] - y * d[1] + z * d[0];
+}
+
+/**
+ * @brief Gyroscope sample at time t: a few hundred dps on every axis, changing smoothly
+ */
+static void motion_gyro(uint32_t n, int16_t gyro[3])
+{
+    const double t = (double)n / RATE_HZ;
+    const double dps[3] = {
+        300 * sin(2 * M_PI * 0.7 * t),
+        200 * sin(2 * M_PI * 0.3 * t + 1),
+        150 * cos(2 * M_PI * 0.5 * t),
+    };
+
+    for (int i = 0; i < 3; i++) gyro[i] = lrint(dps[i] * 32768 / GYRO_RANGE_DPS);
+}
+
+/**
+ * @brief Accelerometer sample for an orientation: gravity in the sensor frame, plus noise
+ */
+static void motion_accel(const double q[4], int16_t accel[3])
+{
+    const double v[3] = {
+        2 * (q[1] * q[3] - q[0] * q[2]),
+        2 * (q[0] * q[1] + q[2] * q[3]),
+        q[0] * q[0] - q[1] * q[1] - q[2] * q[2] + q[3] * q[3],
+    };
+
+    for (int i = 0; i < 3; i++) accel[i] = lrint(v[i] * ACCEL_ONE_G) + rand() % (2 * ACCEL_NOISE + 1) - ACCEL_NOISE;
+}
+
+/**
+ * @brief Checks that both filters turn a raw gyroscope unit into the same rotation, whatever the configuration
+ */
+static void test_gyro_step(void)
+{
+    static const uint32_t ranges[] = {250, 500, 1000, 2000};
+    static const uint32_t rates[] = {100, 200, 500, 1000};
+    struct fusion fixed;
+    struct fusion_float fp;
+
+    for (uint32_t i = 0; i < ARRAY_SIZE(ranges); i++) {
+        for (uint32_t k = 0; k < ARRAY_SIZE(rates); k++) {
+            const struct fusion_config config = {
+                .filter = FUSION_COMPLEMENTARY, .rate_hz = rates[k], .gyro_range_dps = ranges[i], .gain_milli = 0,
+            };
+            CHECK(fusion_init(&fixed, &config) == E_SUCCESS);
+            CHECK(fusion_float_init(&fp, &config) == E_SUCCESS);
+
+            const double exact = ranges[i] * M_PI / 180 / 32768 / (2.0 * rates[k]);
+            // Rounding the constant costs up to half a unit per degree/s per sample, and the division one unit
+            CHECK(fabs(fixed.gyro_step - exact * Q40_ONE) <= 1 + 0.5 * ranges[i] / rates[k]);
+            CHECK(fabs(fp.gyro_step - exact) / exact < MAX_GYRO_STEP_ERROR);
+        }
+    }
+}
+
+/**
+ * @brief Feeds the same motion to both filters
+ *
+ * @param config Filter configuration
+ * @param corrects Non-zero if the filter pulls the tilt towards gravity
+ */
+static void test_filter(const char *name, const struct fusion_config * const config, uint32_t corrects)
+{
+    struct fusion fixed;
+    struct fusion_float fp;
+    struct fusion_quat q;
+    double truth[4] = {1, 0, 0, 0}, fixed_q[4], float_q[4];
+    double max_deg = 0;
+    int16_t gyro[3], accel[3];
+
+    CHECK(fusion_init(&fixed, config) == E_SUCCESS);
+    CHECK(fusion_float_init(&fp, config) == E_SUCCESS);
+    srand(1);
+
+    for (uint32_t n = 0; n < SECONDS * RATE_HZ; n++) {
+        motion_gyro(n, gyro);
+        integrate(truth, gyro);
+        motion_accel(truth, accel);
+        fusion_update(&fixed, accel, gyro);
+        fusion_float_update(&fp, accel, gyro);
+
+        from_q30(&fixed.q, fixed_q);
+        fusion_float_get_quat(&fp, &q);
+        from_q30(&q, float_q);
+        max_deg = CHOOSE_MAX(max_deg, angle_deg(fixed_q, float_q));
+    }
+
+    const double fixed_tilt = tilt_deg(fixed_q, truth), float_tilt = tilt_deg(float_q, truth);
+    CHECK(max_deg <= MAX_FIXED_FLOAT_DEG);
+    if (corrects) {
+        CHECK(fixed_tilt <= MAX_TILT_DEG);
+        CHECK(float_tilt <= MAX_TILT_DEG);
+    }
+
+    // Host time per update
+    const uint64_t fixed_start = test_now_us();
+    for (uint32_t n = 0; n < SECONDS * RATE_HZ; n++) fusion_update(&fixed, accel, gyro);
+    const uint64_t float_start = test_now_us();
+    for (uint32_t n = 0; n < SECONDS * RATE_HZ; n++) fusion_float_update(&fp, accel, gyro);
+    const uint64_t end = test_now_us();
+
+    printf("%-14s %9.4f %9.3f %9.3f %9.3f %8.1f %8.1f\n", name, max_deg, angle_deg(fixed_q, truth), fixed_tilt,
+        float_tilt, (float_start - fixed_start) * 1000.0 / (SECONDS * RATE_HZ),
+        (end - float_start) * 1000.0 / (SECONDS * RATE_HZ));
+}
+
+int main(void)
+{
+    static const struct {
+        const char *name;
+        struct fusion_config config;
+        uint32_t corrects;
+    } cases[] = {
+        {"gyro only", {FUSION_COMPLEMENTARY, RATE_HZ, GYRO_RANGE_DPS, 0}, 0},
+        {"complementary", {FUSION_COMPLEMENTARY, RATE_HZ, GYRO_RANGE_DPS, 1000}, 1},
+        {"madgwick", {FUSION_MADGWICK, RATE_HZ, GYRO_RANGE_DPS, 100}, 1},
+    };
+
+    test_gyro_step();
+
+    printf("%-14s %9s %9s %9s %9s %8s %8s\n", "filter", "vs float", "error", "tilt", "f tilt", "ns", "f ns");
+    for (uint32_t i = 0; i < ARRAY_SIZE(cases); i++) test_filter(cases[i].name, &cases[i].config, cases[i].corrects);
+    printf("(degrees: largest fixed vs float angle, final fixed point error and tilt error of both filters against "
+        "the true orientation; host time per update)\n");
+
+    return test_report("fusion_test");
+}
@@ -0,0 +1,322 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#include "libs/gfx/gfx.h"
+#include "libs/gfx/font.h"
+
+#include "drivers/ili9328/ili9328_driver.h"
+#include "drivers/ili9328/ili9328_emu.h"
+#include "drivers/ili9328/ili9328_gfx.h"
+
+#include "include/errors.h"
+
+#include "ulibc/include/utils.h"
+
+#include "tests/host_kernel.h"
+#include "tests/test.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/** Screen size of the ILI9328 gfx display */
+#define WIDTH 320
+#define HEIGHT 240
+
+/** Objects of the scene */
+#define OBJECTS 24
+
+/** Random changes, each followed by a render */
+#define ROUNDS 400
+
+/** Scattered damages of the merge stress */
+#define SCATTERED 200
+
+/** Resolution of the emulated clock while every task is blocked, in ns */
+#define KERNEL_STEP_NS 100000
+
+static struct gfx_object objects[OBJECTS];
+static struct gfx_scene scene;
+
+/** Full-frame render of the scene, drawn object by object over the whole screen */
+static uint16_t frame[HEIGHT][WIDTH];
+
+/** Strings of the text objects, one per object that may become text */
+static char strings[OBJECTS][16];
+
+static uint64_t clock_ns;
+
+static uint64_t test_clock_now(void *arg)
+{
+    return clock_ns;
+}
+
+static void test_clock_advance(void *arg, uint64_t ns)
+{
+    clock_ns += ns;
+}
+
+static const struct host_kernel_clock kernel_clock = {
+    .now_ns = test_clock_now, .advance_ns = test_clock_advance, .arg = NULL, .step_ns = KERNEL_STEP_NS,
+};
+
+static void frame_pixel(int32_t x, int32_t y, uint16_t color)
+{
+    if (x >= 0 && x < WIDTH && y >= 0 && y < HEIGHT) frame[y][x] = color;
+}
+
+static void frame_line(const struct gfx_object * const line)
+{
+    int32_t x = line->line.x0, y = line->line.y0;
+    const int32_t x1 = line->line.x1, y1 = line->line.y1;
+    const int32_t dx = abs(x1 - x), sx = x < x1 ? 1 : -1;
+    const int32_t dy = -abs(y1 - y), sy = y < y1 ? 1 : -1;
+    int32_t err = dx + dy;
+
+    for (;;) {
+        frame_pixel(x, y, line->color);
+        if (x == x1 && y == y1) break;
+        const int32_t e2 = 2 * err;
+        if (e2 >= dy) { err += dy; x += sx; }
+        if (e2 <= dx) { err += dx; y += sy; }
+    }
+}
+
+static void frame_text(const struct gfx_object * const text)
+{
+    const struct gfx_font *font = text->text.font;
+    int32_t pen = text->text.x;
+
+    for (const char *c = text->text.string; *c != '\0'; c++) {
+        const uint8_t code = (uint8_t)*c;
+        const struct gfx_glyph *glyph = &font->glyphs[code < font->first || code > font->last ? 0 : code - font->first];
+        const uint8_t *bitmap = &font->bitmap[glyph->offset];
+
+        for (uint32_t bit = 0; bit < (uint32_t)glyph->width * glyph->height; bit++) {
+            if (IS_BIT_SET(bitmap[bit >> 3], 0x80 >> (bit & 7))) {
+                frame_pixel(pen + glyph->x_offset + bit % glyph->width, text->text.y + glyph->y_offset +
+                    bit / glyph->width, text->color);
+            }
+        }
+        pen += glyph->advance;
+    }
+}
+
+/**
+ * @brief Draws the whole scene into the frame, without tiles or damage
+ */
+static void render_frame(void)
+{
+    for (uint32_t y = 0; y < HEIGHT; y++) {
+        for (uint32_t x = 0; x < WIDTH; x++) frame[y][x] = scene.background;
+    }
+
+    for (uint32_t i = 0; i < scene.count; i++) {
+        const struct gfx_object *object = &objects[i];
+        if (!object->visible) continue;
+
+        switch (object->type) {
+            case GFX_RECT:
+                for (int32_t y = object->bounds.y; y < object->bounds.y + object->bounds.h; y++) {
+                    for (int32_t x = object->bounds.x; x < object->bounds.x + object->bounds.w; x++) {
+                        frame_pixel(x, y, object->color);
+                    }
+                }
+                break;
+            case GFX_LINE: frame_line(object); break;
+            case GFX_TEXT: frame_text(object); break;
+        }
+    }
+}
+
+/**
+ * @brief Checks the screen against the full-frame render
+ *
+ * @return uint32_t Pixels that differ
+ */
+static uint32_t check_screen(void)
+{
+    uint32_t wrong = 0;
+
+    render_frame();
+    for (uint16_t y = 0; y < HEIGHT; y++) {
+        for (uint16_t x = 0; x < WIDTH; x++) {
+            if (ili9328_emu_pixel(&ili9328_emu, x, y) != frame[y][x]) wrong++;
+        }
+    }
+    CHECK(wrong == 0);
+
+    return wrong;
+}
+
+/**
+ * @brief Checks the damage list: bounded and inside the screen
+ */
+static void check_damage(void)
+{
+    CHECK(scene.damaged <= GFX_MAX_DAMAGE);
+    for (uint32_t i = 0; i < scene.damaged; i++) {
+        const struct gfx_rect *rect = &scene.damage[i];
+        CHECK(rect->w > 0 && rect->h > 0);
+        CHECK(rect->x >= 0 && rect->y >= 0 && rect->x + rect->w <= WIDTH && rect->y + rect->h <= HEIGHT);
+    }
+}
+
+static void random_string(char * const string, uint32_t size)
+{
+    const uint32_t length = rand() % size;
+
+    // Includes characters outside the font, drawn as its first glyph
+    for (uint32_t i = 0; i < length; i++) string[i] = rand() % 2 ? ' ' + rand() % 95 : 1 + rand() % 127;
+    string[length] = '\0';
+}
+
+/**
+ * @brief Fills the scene with random objects, some of them partly off the screen
+ */
+static void build_scene(void)
+{
+    for (uint32_t i = 0; i < OBJECTS; i++) {
+        const int16_t x = rand() % (WIDTH + 40) - 20, y = rand() % (HEIGHT + 40) - 20;
+        int32_t id;
+
+        switch (i % 4) {
+            case 0: {
+                const struct gfx_rect rect = {x, y, 1 + rand() % 80, 1 + rand() % 60};
+                id = gfx_add_rect(&scene, &rect, rand());
+                break;
+            }
+            case 1:
+                id = gfx_add_line(&scene, x, y, x + rand() % 200 - 100, y + rand() % 200 - 100, rand());
+                break;
+            case 2:
+                // Horizontal and vertical lines take the path of the bounds
+                id = rand() % 2 ? gfx_add_line(&scene, x, y, x + rand() % 100, y, rand()) :
+                    gfx_add_line(&scene, x, y, x, y - rand() % 100, rand());
+                break;
+            default:
+                random_string(strings[i], sizeof(strings[i]));
+                id = gfx_add_text(&scene, &gfx_font_5x7, x, y, strings[i], rand());
+                break;
+        }
+        CHECK(id == (int32_t)i);
+        check_damage();
+    }
+    const struct gfx_rect rect = {0, 0, 1, 1};
+    CHECK(gfx_add_rect(&scene, &rect, 0) == E_TX_QUEUE_FULL);
+}
+
+/**
+ * @brief One random change to the scene
+ */
+static void random_change(void)
+{
+    const int32_t id = rand() % OBJECTS;
+
+    switch (rand() % 4) {
+        case 0: CHECK(gfx_move(&scene, id, rand() % 81 - 40, rand() % 61 - 30) == E_SUCCESS); break;
+        case 1: CHECK(gfx_set_color(&scene, id, rand()) == E_SUCCESS); break;
+        case 2: CHECK(gfx_set_visible(&scene, id, rand() % 3) == E_SUCCESS); break;
+        default:
+            if (objects[id].type == GFX_TEXT) {
+                random_string(strings[id], sizeof(strings[id]));
+                CHECK(gfx_set_text(&scene, id, strings[id]) == E_SUCCESS);
+            } else {
+                CHECK(gfx_set_text(&scene, id, "") == E_INVALID_PARAMETER);
+            }
+            break;
+    }
+}
+
+/**
+ * @brief Renders only the damage after each round of changes and checks it against the full frame
+ */
+static void test_incremental(void)
+{
+    uint32_t wrong = 0;
+    uint32_t pixels = scene.stats.pixels;
+
+    for (uint32_t round = 0; round < ROUNDS; round++) {
+        const uint32_t changes = 1 + rand() % 4;
+        for (uint32_t i = 0; i < changes; i++) {
+            random_change();
+            check_damage();
+        }
+        CHECK(gfx_render(&scene) == E_SUCCESS);
+        CHECK(scene.damaged == 0);
+        wrong += check_screen();
+    }
+    pixels = scene.stats.pixels - pixels;
+
+    printf("%-12s %10u %10.1f%%\n", "incremental", pixels / ROUNDS, 100.0 * pixels / ROUNDS / (WIDTH * HEIGHT));
+    CHECK(wrong == 0);
+}
+
+/**
+ * @brief Writes wrong pixels in the GRAM behind the driver, so only drawing the rectangle again fixes them
+ */
+static void corrupt(const struct gfx_rect * const rect)
+{
+    for (int32_t y = CHOOSE_MAX(rect->y, 0); y < CHOOSE_MIN(rect->y + rect->h, HEIGHT); y++) {
+        for (int32_t x = CHOOSE_MAX(rect->x, 0); x < CHOOSE_MIN(rect->x + rect->w, WIDTH); x++) {
+            ili9328_emu.gram[ILI9328_EMU_GRAM_V - 1 - x][y] ^= 0xffff;
+        }
+    }
+}
+
+/**
+ * @brief Scattered small damages fill the list and are forced to merge: the list stays bounded and covers them all
+ */
+static void test_damage_bound(void)
+{
+    for (uint32_t i = 0; i < SCATTERED; i++) {
+        const struct gfx_rect rect = {rand() % (WIDTH + 10) - 5, rand() % (HEIGHT + 10) - 5, 1 + rand() % 4,
+            1 + rand() % 4};
+
+        corrupt(&rect);
+        gfx_invalidate(&scene, &rect);
+        check_damage();
+    }
+    CHECK(scene.damaged == GFX_MAX_DAMAGE);
+
+    const uint32_t blits = scene.stats.blits, pixels = scene.stats.pixels;
+    CHECK(gfx_render(&scene) == E_SUCCESS);
+    CHECK(scene.damaged == 0);
+    printf("%-12s %10u %10.1f%% (%u tiles)\n", "scattered", scene.stats.pixels - pixels,
+        100.0 * (scene.stats.pixels - pixels) / (WIDTH * HEIGHT), scene.stats.blits - blits);
+
+    // Off the screen or empty damages nothing
+    gfx_invalidate(&scene, &(struct gfx_rect){WIDTH, 0, 10, 10});
+    gfx_invalidate(&scene, &(struct gfx_rect){-10, -10, 10, 10});
+    gfx_invalidate(&scene, &(struct gfx_rect){10, 10, 0, 10});
+    CHECK(scene.damaged == 0);
+    check_screen();
+}
+
+int main(void)
+{
+    srand(5);
+    host_kernel_init(&kernel_clock);
+    ili9328_emu_reset(&ili9328_emu);
+    CHECK(ili9328_init() == E_SUCCESS);
+
+    gfx_init(&scene, &ili9328_gfx_display, objects, OBJECTS, ILI9328_BLUE_SOLID);
+    check_damage();
+    build_scene();
+
+    printf("%-12s %10s %11s\n", "render", "pixels", "of screen");
+    CHECK(gfx_render(&scene) == E_SUCCESS);
+    printf("%-12s %10u %10.1f%%\n", "first", scene.stats.pixels, 100.0 * scene.stats.pixels / (WIDTH * HEIGHT));
+    check_screen();
+
+    test_incremental();
+    test_damage_bound();
+    printf("(pixels sent per render; the full-frame render would send the whole screen every time)\n");
+
+    return test_report("gfx_test");
+}
@@ -0,0 +1,424 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#include "tests/host_kernel.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ucontext.h>
+
+/** Tasks, counting the one that called host_kernel_init() */
+#define MAX_TASKS 8
+
+/** Queues and mutexes */
+#define MAX_QUEUES 16
+
+/** Host stack of each task. The stack given to xTaskCreateStatic() is sized for the MCU, not for the host */
+#define TASK_STACK_SIZE (256 * 1024)
+
+/** Longest time every task may stay blocked before the test is taken as deadlocked */
+#define DEADLOCK_NS (600 * 1000000000ULL)
+
+#define NS_PER_TICK (1000000000ULL / configTICK_RATE_HZ)
+
+#define NO_DEADLINE UINT64_MAX
+
+struct host_task;
+
+/**
+ * @brief Condition a blocked task waits for
+ *
+ * @return int Non-zero once the task may run again
+ */
+typedef int (*wait_condition)(struct host_task * const task);
+
+struct host_task {
+    ucontext_t context;
+    TaskFunction_t function;
+    void *arg;
+    UBaseType_t priority;
+    uint32_t notifications;
+    wait_condition condition;   /** NULL while the task can run */
+    void *object;               /** What condition looks at */
+    uint64_t deadline_ns;       /** Time the wait ends anyway */
+    uint8_t finished;           /** The task function returned */
+};
+
+struct host_queue {
+    uint8_t *storage;
+    UBaseType_t length;
+    UBaseType_t item_size;
+    UBaseType_t count;
+    UBaseType_t head;
+    struct host_task *owner;    /** Mutex: task holding it */
+    uint32_t depth;             /** Mutex: times taken by owner */
+};
+
+static const struct host_kernel_clock *kernel_clock;
+static struct host_task tasks[MAX_TASKS];
+static uint32_t task_count;
+static struct host_task *current;
+static struct host_queue queues[MAX_QUEUES];
+static uint32_t queue_count;
+static struct host_kernel_stats kernel_stats;
+
+static uint64_t now_ns(void)
+{
+    return kernel_clock->now_ns(kernel_clock->arg);
+}
+
+static int task_can_run(struct host_task * const task)
+{
+    if (task->finished) return 0;
+    return task->condition == NULL || task->condition(task) || now_ns() >= task->deadline_ns;
+}
+
+/**
+ * @brief Picks the task of highest priority that can run. Tasks of the same priority take turns
+ */
+static struct host_task *pick_task(void)
+{
+    struct host_task *best = NULL;
+    const uint32_t first = (current - tasks + 1) % task_count;
+
+    for (uint32_t i = 0; i < task_count; i++) {
+        struct host_task *task = &tasks[(first + i) % task_count];
+        if (!task_can_run(task)) continue;
+        if (best == NULL || task->priority > best->priority) best = task;
+    }
+
+    return best;
+}
+
+static void switch_to(struct host_task * const next)
+{
+    struct host_task *previous = current;
+
+    if (next == previous) return;
+    kernel_stats.switches++;
+    current = next;
+    swapcontext(&previous->context, &next->context);
+}
+
+/**
+ * @brief Runs other tasks until the current one can run again. While every task is blocked, time passes
+ */
+static void schedule(void)
+{
+    uint64_t idle_since = now_ns();
+
+    while (1) {
+        struct host_task *next = pick_task();
+        if (next != NULL) {
+            switch_to(next);
+            // Back here once another task switched to this one, which it only does when this one can run
+            if (task_can_run(current)) return;
+            idle_since = now_ns();
+            continue;
+        }
+
+        uint64_t step = kernel_clock->step_ns;
+        for (uint32_t i = 0; i < task_count; i++) {
+            if (tasks[i].finished || tasks[i].deadline_ns == NO_DEADLINE) continue;
+            if (tasks[i].deadline_ns - now_ns() < step) step = tasks[i].deadline_ns - now_ns();
+        }
+        kernel_clock->advance_ns(kernel_clock->arg, step);
+
+        if (now_ns() - idle_since > DEADLOCK_NS) {
+            printf("host_kernel: every task blocked for %llu s\n", DEADLOCK_NS / 1000000000ULL);
+            abort();
+        }
+    }
+}
+
+/**
+ * @brief Blocks the current task until condition holds or ticks elapse
+ *
+ * @return int Non-zero if condition holds
+ */
+static int block(wait_condition condition, void *object, TickType_t ticks)
+{
+    const uint64_t deadline = ticks == portMAX_DELAY ? NO_DEADLINE : now_ns() + (uint64_t)ticks * NS_PER_TICK;
+
+    current->object = object;
+    while (!condition(current)) {
+        if (now_ns() >= deadline) return 0;
+        current->condition = condition;
+        current->deadline_ns = deadline;
+        schedule();
+        current->condition = NULL;
+        current->deadline_ns = NO_DEADLINE;
+    }
+
+    return 1;
+}
+
+/**
+ * @brief Lets a task of higher priority that became ready run first, as the FreeRTOS scheduler would
+ */
+static void preempt(void)
+{
+    struct host_task *next = pick_task();
+
+    if (next != NULL && next->priority > current->priority) switch_to(next);
+}
+
+static void task_entry(void)
+{
+    current->function(current->arg);
+    current->finished = 1;
+    current->condition = NULL;
+    schedule();
+}
+
+void host_kernel_init(const struct host_kernel_clock * const clock)
+{
+    kernel_clock = clock;
+    memset(tasks, 0, sizeof(tasks));
+    memset(queues, 0, sizeof(queues));
+    memset(&kernel_stats, 0, sizeof(kernel_stats));
+    queue_count = 0;
+    task_count = 1;
+    current = &tasks[0];
+    current->priority = tskIDLE_PRIORITY + 1;
+    current->deadline_ns = NO_DEADLINE;
+}
+
+uint32_t host_kernel_mutex_depth(QueueHandle_t mutex)
+{
+    return ((struct host_queue *)mutex)->depth;
+}
+
+void host_kernel_get_stats(struct host_kernel_stats * const stats)
+{
+    *stats = kernel_stats;
+}
+
+/* Tasks */
+
+TaskHandle_t xTaskCreateStatic(TaskFunction_t function, const char * const name, const uint32_t stack_depth,
+    void * const arg, UBaseType_t priority, StackType_t * const stack, StaticTask_t * const tcb)
+{
+    (void)name;
+    (void)stack_depth;
+    (void)stack;
+    (void)tcb;
+
+    if (task_count == MAX_TASKS) return NULL;
+    struct host_task *task = &tasks[task_count++];
+
+    task->function = function;
+    task->arg = arg;
+    task->priority = priority;
+    task->deadline_ns = NO_DEADLINE;
+    getcontext(&task->context);
+    task->context.uc_stack.ss_sp = malloc(TASK_STACK_SIZE);
+    task->context.uc_stack.ss_size = TASK_STACK_SIZE;
+    task->context.uc_link = NULL;
+    makecontext(&task->context, task_entry, 0);
+    preempt();
+
+    return task;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return current;
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return now_ns() / NS_PER_TICK;
+}
+
+TickType_t xTaskGetTickCountFromISR(void)
+{
+    return xTaskGetTickCount();
+}
+
+static int never(struct host_task * const task)
+{
+    (void)task;
+    return 0;
+}
+
+void vTaskDelay(const TickType_t ticks)
+{
+    block(never, NULL, ticks);
+}
+
+static int notified(struct host_task * const task)
+{
+    return task->notifications != 0;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks)
+{
+    if (!block(notified, NULL, ticks)) {
+        if (ticks > 0) kernel_stats.notify_timeouts++;
+        return 0;
+    }
+
+    const uint32_t value = current->notifications;
+    current->notifications = clear ? 0 : value - 1;
+    return value;
+}
+
+BaseType_t xTaskGenericNotify(TaskHandle_t task_to_notify, uint32_t value, eNotifyAction action,
+    uint32_t *previous_value)
+{
+    struct host_task *task = task_to_notify;
+
+    if (previous_value != NULL) *previous_value = task->notifications;
+    switch (action) {
+        case eSetBits: task->notifications |= value; break;
+        case eIncrement: task->notifications++; break;
+        case eSetValueWithOverwrite: task->notifications = value; break;
+        case eSetValueWithoutOverwrite: if (task->notifications == 0) task->notifications = value; break;
+        default: break;
+    }
+    preempt();
+
+    return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task_to_notify, BaseType_t *higher_priority_task_woken)
+{
+    struct host_task *task = task_to_notify;
+
+    task->notifications++;
+    // The switch happens when the interrupted task blocks: ISRs run in the middle of driver calls
+    if (higher_priority_task_woken != NULL && task->priority > current->priority) {
+        *higher_priority_task_woken = pdTRUE;
+    }
+}
+
+/* Queues and mutexes */
+
+static struct host_queue *new_queue(void)
+{
+    if (queue_count == MAX_QUEUES) return NULL;
+    return &queues[queue_count++];
+}
+
+QueueHandle_t xQueueGenericCreateStatic(const UBaseType_t length, const UBaseType_t item_size, uint8_t *storage,
+    StaticQueue_t *buffer, const uint8_t type)
+{
+    (void)buffer;
+    (void)type;
+
+    struct host_queue *queue = new_queue();
+    if (queue == NULL) return NULL;
+
+    queue->storage = storage;
+    queue->length = length;
+    queue->item_size = item_size;
+
+    return queue;
+}
+
+static int queue_has_room(struct host_task * const task)
+{
+    const struct host_queue *queue = task->object;
+    return queue->count < queue->length;
+}
+
+static int queue_has_item(struct host_task * const task)
+{
+    const struct host_queue *queue = task->object;
+    return queue->count > 0;
+}
+
+BaseType_t xQueueGenericSend(QueueHandle_t handle, const void * const item, TickType_t ticks,
+    const BaseType_t position)
+{
+    struct host_queue *queue = handle;
+
+    if (!block(queue_has_room, queue, ticks)) return errQUEUE_FULL;
+
+    UBaseType_t index;
+    if (position == queueSEND_TO_FRONT) {
+        queue->head = (queue->head + queue->length - 1) % queue->length;
+        index = queue->head;
+    } else {
+        index = (queue->head + queue->count) % queue->length;
+    }
+    memcpy(queue->storage + index * queue->item_size, item, queue->item_size);
+    queue->count++;
+    preempt();
+
+    return pdPASS;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t handle, void * const buffer, TickType_t ticks)
+{
+    struct host_queue *queue = handle;
+
+    if (!block(queue_has_item, queue, ticks)) return errQUEUE_EMPTY;
+
+    memcpy(buffer, queue->storage + queue->head * queue->item_size, queue->item_size);
+    queue->head = (queue->head + 1) % queue->length;
+    queue->count--;
+    preempt();
+
+    return pdPASS;
+}
+
+UBaseType_t uxQueueMessagesWaiting(const QueueHandle_t handle)
+{
+    return ((const struct host_queue *)handle)->count;
+}
+
+QueueHandle_t xQueueCreateMutexStatic(const uint8_t type, StaticQueue_t *buffer)
+{
+    (void)type;
+    (void)buffer;
+
+    return new_queue();
+}
+
+static int mutex_free(struct host_task * const task)
+{
+    const struct host_queue *mutex = task->object;
+    return mutex->owner == NULL || mutex->owner == task;
+}
+
+BaseType_t xQueueTakeMutexRecursive(QueueHandle_t handle, TickType_t ticks)
+{
+    struct host_queue *mutex = handle;
+
+    if (!block(mutex_free, mutex, ticks)) return pdFAIL;
+
+    mutex->owner = current;
+    mutex->depth++;
+
+    return pdPASS;
+}
+
+BaseType_t xQueueGiveMutexRecursive(QueueHandle_t handle)
+{
+    struct host_queue *mutex = handle;
+
+    if (mutex->owner != current) {
+        printf("host_kernel: mutex given by a task that does not hold it\n");
+        abort();
+    }
+    if (--mutex->depth == 0) {
+        mutex->owner = NULL;
+        preempt();
+    }
+
+    return pdPASS;
+}
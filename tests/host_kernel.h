@@ -0,0 +1,64 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#ifndef TESTS_HOST_KERNEL_H_
+#define TESTS_HOST_KERNEL_H_
+
+#include <stdint.h>
+
+#include "FreeRTOS.h"
+#include "queue.h"
+
+/**
+ * @brief Just enough of the FreeRTOS kernel to run driver tasks on the host.
+ *
+ * Tasks are coroutines: one runs at a time and it only gives the CPU away when it blocks or when it wakes a task of
+ * higher priority, so the tests are deterministic. When every task is blocked the kernel advances the clock of the
+ * test, whose emulators raise the IRQs that wake the tasks again. A tick is 1ms of that clock.
+ *
+ * Provides static tasks, delays, task notifications, queues and recursive mutexes. The caller of
+ * host_kernel_init() becomes a task itself.
+ */
+
+/** Clock the kernel runs on */
+struct host_kernel_clock {
+    uint64_t (*now_ns)(void *arg);              /** Current time */
+    void (*advance_ns)(void *arg, uint64_t ns); /** Lets time pass, running whatever happens meanwhile */
+    void *arg;                                  /** Argument of both functions */
+    uint64_t step_ns;                           /** Time advanced at once while every task is blocked */
+};
+
+/** Kernel statistics */
+struct host_kernel_stats {
+    uint32_t switches;          /** Context switches */
+    uint32_t notify_timeouts;   /** Waits of ulTaskNotifyTake() that ended in timeout */
+};
+
+/**
+ * @brief Starts the kernel. The calling thread becomes a task of priority tskIDLE_PRIORITY + 1
+ *
+ * @param clock Clock the kernel runs on. Must live as long as the kernel
+ */
+extern void host_kernel_init(const struct host_kernel_clock * const clock);
+
+/**
+ * @brief Gets how many times a recursive mutex is taken
+ *
+ * @param mutex Recursive mutex
+ * @return uint32_t Times taken and not given back. 0 if it is free
+ */
+extern uint32_t host_kernel_mutex_depth(QueueHandle_t mutex);
+
+/**
+ * @brief Gets kernel statistics
+ *
+ * @param stats [out] Statistics
+ */
+extern void host_kernel_get_stats(struct host_kernel_stats * const stats);
+
+#endif // TESTS_HOST_KERNEL_H_
@@ -0,0 +1,41 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#include "ulibc/include/log.h"
+
+#include "tests/test.h"
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+
+uint32_t test_failures = 0;
+uint32_t test_warnings = 0;
+uint32_t test_log_quiet = 0;
+
+// Drivers log through ulibc, which needs the USART. The tests only show warnings and errors on stdout
+
+void ulog(enum log_level level, const char *tag, const char *fmt, ...)
+{
+    if (level < WARN_LVL) return;
+    test_warnings++;
+    if (test_log_quiet) return;
+
+    va_list args;
+    va_start(args, fmt);
+    printf("[%s] ", tag);
+    vprintf(fmt, args);
+    printf("\n");
+    va_end(args);
+}
+
+void hex_ulog(const void *data, uint32_t len)
+{
+    (void)data;
+    (void)len;
+}
@@ -0,0 +1,331 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#include "drivers/ili9328/ili9328_console.h"
+#include "drivers/ili9328/ili9328_driver.h"
+#include "drivers/ili9328/ili9328_driver_regs.h"
+#include "drivers/ili9328/ili9328_emu.h"
+
+#include "libs/gfx/font.h"
+
+#include "include/errors.h"
+
+#include "ulibc/include/log.h"
+#include "ulibc/include/utils.h"
+
+#include "tests/host_kernel.h"
+#include "tests/test.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** Screen as the driver uses it. The console reads it turned, with screen columns as its rows */
+#define WIDTH 320
+#define HEIGHT 240
+
+/** Cell of the 5x7 font */
+#define CELL_WIDTH 6
+#define CELL_HEIGHT 8
+
+/** Background of the console, not the color of the cleared GRAM */
+#define BACKGROUND ILI9328_BLUE_SOLID
+
+/** Random lines printed by the scrolling test, enough to wrap the scroll register several times */
+#define LINES 600
+
+/** Lines printed between two checks of the screen */
+#define CHECK_EVERY 7
+
+/** Rows kept by the model, a multiple of the rows of the screen */
+#define MODEL_ROWS (4 * ILI9328_CONSOLE_ROWS)
+
+/** Resolution of the emulated clock while every task is blocked, in ns */
+#define KERNEL_STEP_NS 100000
+
+struct model_row {
+    char text[ILI9328_CONSOLE_COLUMNS];
+    uint32_t length;
+    uint16_t color;
+};
+
+/** Rows the console should show, the last ILI9328_CONSOLE_ROWS of those written */
+static struct model_row model[MODEL_ROWS];
+static uint32_t model_count;
+
+static uint64_t clock_ns;
+
+static uint64_t test_clock_now(void *arg)
+{
+    return clock_ns;
+}
+
+static void test_clock_advance(void *arg, uint64_t ns)
+{
+    clock_ns += ns;
+}
+
+static const struct host_kernel_clock kernel_clock = {
+    .now_ns = test_clock_now, .advance_ns = test_clock_advance, .arg = NULL, .step_ns = KERNEL_STEP_NS,
+};
+
+/**
+ * @brief Adds a line to the model: it wraps at the end of a row and at each '\n', and is truncated as queued
+ */
+static void model_print(const char *text, uint16_t color)
+{
+    char line[ILI9328_CONSOLE_LINE_SIZE];
+
+    strncpy(line, text, sizeof(line) - 1);
+    line[sizeof(line) - 1] = '\0';
+    text = line;
+
+    do {
+        struct model_row *row = &model[model_count++ % MODEL_ROWS];
+        row->length = 0;
+        row->color = color;
+        while (*text != '\0' && *text != '\n' && row->length < ILI9328_CONSOLE_COLUMNS) {
+            row->text[row->length++] = *text++;
+        }
+        if (*text == '\n') text++;
+    } while (*text != '\0');
+}
+
+static int32_t print(const char *text, uint16_t color)
+{
+    const int32_t ret = ili9328_console_print(text, color);
+
+    if (ret == E_SUCCESS) model_print(text, color);
+    return ret;
+}
+
+/**
+ * @brief Lets the console task draw what is queued
+ */
+static void drain(void)
+{
+    vTaskDelay(1);
+}
+
+/**
+ * @brief Pixel of a cell of a row the model expects, in reading orientation
+ *
+ * @param row Row, NULL for an empty one
+ * @param column Cell
+ * @param x Pixel across the cell, from its left
+ * @param y Pixel down the cell, from its top
+ */
+static uint16_t model_pixel(const struct model_row * const row, uint32_t column, uint32_t x, uint32_t y)
+{
+    const struct gfx_font *font = &gfx_font_5x7;
+
+    if (row == NULL || column >= row->length) return BACKGROUND;
+
+    const uint8_t code = (uint8_t)row->text[column];
+    const struct gfx_glyph *glyph = &font->glyphs[code < font->first || code > font->last ? 0 : code - font->first];
+    const int32_t gx = x - glyph->x_offset, gy = y - glyph->y_offset;
+    if (gx < 0 || gy < 0 || gx >= glyph->width || gy >= glyph->height) return BACKGROUND;
+
+    const uint32_t bit = gy * glyph->width + gx;
+    return IS_BIT_SET(font->bitmap[glyph->offset + (bit >> 3)], 0x80 >> (bit & 7)) ? row->color : BACKGROUND;
+}
+
+/**
+ * @brief Checks what the panel shows, scroll applied, against the model. Reading row 0 is the oldest one shown, at
+ * the right edge of the landscape screen; its text runs down the screen
+ *
+ * @return uint32_t Pixels that differ
+ */
+static uint32_t check_screen(void)
+{
+    const uint32_t shown = CHOOSE_MIN(model_count, ILI9328_CONSOLE_ROWS);
+    const uint32_t oldest = model_count - shown;
+    uint32_t wrong = 0;
+
+    for (uint32_t k = 0; k < ILI9328_CONSOLE_ROWS; k++) {
+        const struct model_row *row = k < shown ? &model[(oldest + k) % MODEL_ROWS] : NULL;
+        for (uint16_t y = 0; y < HEIGHT; y++) {
+            for (uint32_t cy = 0; cy < CELL_HEIGHT; cy++) {
+                const uint16_t x = WIDTH - 1 - k * CELL_HEIGHT - cy;
+                const uint16_t expected = model_pixel(row, y / CELL_WIDTH, y % CELL_WIDTH, cy);
+                if (ili9328_emu_shown_pixel(&ili9328_emu, x, y) != expected) wrong++;
+            }
+        }
+    }
+    CHECK(wrong == 0);
+
+    return wrong;
+}
+
+static void random_line(char * const line, uint32_t size)
+{
+    const uint32_t length = rand() % 3 ? rand() % (ILI9328_CONSOLE_COLUMNS + 1) : rand() % size;
+
+    // Some new lines, some characters outside the font
+    for (uint32_t i = 0; i < length; i++) {
+        const uint32_t kind = rand() % 20;
+        line[i] = kind == 0 ? '\n' : kind == 1 ? 1 + rand() % 31 : ' ' + rand() % 95;
+    }
+    line[length] = '\0';
+}
+
+/**
+ * @brief Fills the screen without scrolling, then one more row scrolls it by one row
+ */
+static void test_fill(void)
+{
+    struct ili9328_console_stats stats;
+    char line[8];
+
+    for (uint32_t i = 0; i < ILI9328_CONSOLE_ROWS; i++) {
+        snprintf(line, sizeof(line), "row %u", i);
+        CHECK(print(line, ILI9328_WHITE_SOLID) == E_SUCCESS);
+        if (i % ILI9328_CONSOLE_LINES == ILI9328_CONSOLE_LINES - 1) drain();
+    }
+    drain();
+    ili9328_console_get_stats(&stats);
+    CHECK(stats.lines == ILI9328_CONSOLE_ROWS && stats.scrolls == 0);
+    CHECK(ili9328_emu.regs[ILI9328_REG_VERTICAL_SCROLL_CTRL] == 0);
+    check_screen();
+
+    CHECK(print("first scroll", ILI9328_RED_SOLID) == E_SUCCESS);
+    drain();
+    ili9328_console_get_stats(&stats);
+    CHECK(stats.scrolls == 1);
+    CHECK(ili9328_emu.regs[ILI9328_REG_VERTICAL_SCROLL_CTRL] == CELL_HEIGHT);
+    check_screen();
+}
+
+/**
+ * @brief Wrapping, new lines, empty lines and lines longer than the queue takes
+ */
+static void test_wrapping(void)
+{
+    char longest[2 * ILI9328_CONSOLE_LINE_SIZE];
+
+    for (uint32_t i = 0; i < sizeof(longest) - 1; i++) longest[i] = 'a' + i % 26;
+    longest[sizeof(longest) - 1] = '\0';
+
+    CHECK(print("", ILI9328_GREEN_SOLID) == E_SUCCESS);
+    CHECK(print("one\ntwo\n\nfour\n", ILI9328_GREEN_SOLID) == E_SUCCESS);
+    CHECK(print("\n", ILI9328_GREEN_SOLID) == E_SUCCESS);
+    CHECK(print(longest, ILI9328_YELLOW_SOLID) == E_SUCCESS);
+    CHECK(print(&longest[ILI9328_CONSOLE_LINE_SIZE - ILI9328_CONSOLE_COLUMNS - 1], ILI9328_YELLOW_SOLID) ==
+        E_SUCCESS);
+    drain();
+    check_screen();
+}
+
+/**
+ * @brief Lines printed while the queue is full are dropped and the others are drawn in order
+ */
+static void test_queue_full(void)
+{
+    struct ili9328_console_stats before, after;
+    char line[16];
+
+    ili9328_console_get_stats(&before);
+    for (uint32_t i = 0; i < ILI9328_CONSOLE_LINES; i++) {
+        snprintf(line, sizeof(line), "queued %u", i);
+        CHECK(print(line, ILI9328_WHITE_SOLID) == E_SUCCESS);
+    }
+    CHECK(print("dropped", ILI9328_RED_SOLID) == E_TX_QUEUE_FULL);
+    drain();
+    ili9328_console_get_stats(&after);
+    CHECK(after.dropped - before.dropped == 1);
+    CHECK(after.lines - before.lines == ILI9328_CONSOLE_LINES);
+    check_screen();
+}
+
+/**
+ * @brief The log sink prints "tag: message" in the color of the level
+ */
+static void test_log_sink(void)
+{
+    static const struct {
+        enum log_level level;
+        uint16_t color;
+    } levels[] = {
+        {DEBUG_LVL, ILI9328_GREEN_SOLID},
+        {INFO_LVL, ILI9328_RGB(0, 63, 31)},
+        {WARN_LVL, ILI9328_YELLOW_SOLID},
+        {ERROR_LVL, ILI9328_RED_SOLID},
+    };
+    char message[ULOG_SINK_MESSAGE_SIZE], text[ILI9328_CONSOLE_LINE_SIZE + ULOG_SINK_MESSAGE_SIZE];
+
+    for (uint32_t i = 0; i < ARRAY_SIZE(levels); i++) {
+        // The longest message takes more than the line the console queues
+        const uint32_t length = snprintf(message, sizeof(message), "level %u ", levels[i].level);
+        const uint32_t padding = i * (sizeof(message) - 1 - length) / (ARRAY_SIZE(levels) - 1);
+        memset(&message[length], 'x', padding);
+        message[length + padding] = '\0';
+        ili9328_console_log_sink(levels[i].level, "tag", message);
+        snprintf(text, sizeof(text), "tag: %s", message);
+        model_print(text, levels[i].color);
+    }
+    drain();
+    check_screen();
+}
+
+/**
+ * @brief Random lines past many turns of the scroll register
+ */
+static void test_scrolling(void)
+{
+    struct ili9328_console_stats before, after;
+    char line[ILI9328_CONSOLE_LINE_SIZE + 20];
+    uint32_t wrong = 0, rows = model_count;
+
+    ili9328_console_get_stats(&before);
+    for (uint32_t i = 0; i < LINES; i++) {
+        random_line(line, sizeof(line));
+        CHECK(print(line, rand()) == E_SUCCESS);
+        if (i % CHECK_EVERY == CHECK_EVERY - 1) {
+            drain();
+            wrong += check_screen();
+        }
+    }
+    drain();
+    wrong += check_screen();
+    ili9328_console_get_stats(&after);
+    rows = model_count - rows;
+
+    CHECK(after.scrolls - before.scrolls == rows);
+    CHECK(ili9328_emu.regs[ILI9328_REG_VERTICAL_SCROLL_CTRL] ==
+        (model_count - ILI9328_CONSOLE_ROWS) % ILI9328_CONSOLE_ROWS * CELL_HEIGHT);
+    CHECK(wrong == 0);
+
+    printf("%8u lines %8u rows %8u scrolls %10.1f pixels/row\n", after.lines - before.lines, rows,
+        after.scrolls - before.scrolls, (double)(after.pixels - before.pixels) / rows);
+    printf("(a row redrawn in full is %u pixels; scrolling in software would redraw %u)\n",
+        ILI9328_CONSOLE_COLUMNS * CELL_WIDTH * CELL_HEIGHT, WIDTH * HEIGHT);
+}
+
+int main(void)
+{
+    srand(9);
+    host_kernel_init(&kernel_clock);
+    ili9328_emu_reset(&ili9328_emu);
+    CHECK(ili9328_init() == E_SUCCESS);
+
+    CHECK(ili9328_console_print("too early", ILI9328_WHITE_SOLID) == E_NOT_INITIALIZED);
+    CHECK(ili9328_console_start(BACKGROUND) == E_SUCCESS);
+    check_screen();
+
+    test_fill();
+    test_wrapping();
+    test_queue_full();
+    test_log_sink();
+    test_scrolling();
+
+    return test_report("ili9328_console_test");
+}
@@ -0,0 +1,280 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#include "drivers/ili9328/ili9328_driver.h"
+#include "drivers/ili9328/ili9328_driver_regs.h"
+#include "drivers/ili9328/ili9328_emu.h"
+
+#include "include/errors.h"
+
+#include "ulibc/include/utils.h"
+
+#include "tests/host_kernel.h"
+#include "tests/test.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** Screen size as the driver uses it: landscape, 270 degrees from the panel */
+#define WIDTH 320
+#define HEIGHT 240
+
+/** Random rectangles drawn over the screen and checked against the model */
+#define ROUNDS 300
+
+/** Resolution of the emulated clock while every task is blocked, in ns */
+#define KERNEL_STEP_NS 100000
+
+/** What the screen should show */
+static uint16_t model[HEIGHT][WIDTH];
+
+static uint16_t pixels[WIDTH * HEIGHT];
+
+static uint64_t clock_ns;
+
+// Only the delays of ili9328_init() run on the kernel: time passes and nothing else happens meanwhile
+
+static uint64_t test_clock_now(void *arg)
+{
+    return clock_ns;
+}
+
+static void test_clock_advance(void *arg, uint64_t ns)
+{
+    clock_ns += ns;
+}
+
+static const struct host_kernel_clock kernel_clock = {
+    .now_ns = test_clock_now, .advance_ns = test_clock_advance, .arg = NULL, .step_ns = KERNEL_STEP_NS,
+};
+
+/**
+ * @brief Checks the whole GRAM against the model
+ *
+ * @return uint32_t Pixels that differ
+ */
+static uint32_t check_screen(void)
+{
+    uint32_t wrong = 0;
+
+    for (uint16_t y = 0; y < HEIGHT; y++) {
+        for (uint16_t x = 0; x < WIDTH; x++) {
+            if (ili9328_emu_pixel(&ili9328_emu, x, y) != model[y][x]) wrong++;
+        }
+    }
+    CHECK(wrong == 0);
+
+    return wrong;
+}
+
+/**
+ * @brief Checks that the GRAM window was set back to the whole screen
+ */
+static void check_full_window(void)
+{
+    CHECK(ili9328_emu.regs[ILI9328_REG_HORIZONTAL_ADDRESS_START] == 0);
+    CHECK(ili9328_emu.regs[ILI9328_REG_HORIZONTAL_ADDRESS_END] == HEIGHT - 1);
+    CHECK(ili9328_emu.regs[ILI9328_REG_VERTICAL_ADDRESS_START] == 0);
+    CHECK(ili9328_emu.regs[ILI9328_REG_VERTICAL_ADDRESS_END] == WIDTH - 1);
+}
+
+static void model_fill(const struct ili9328_window * const window)
+{
+    for (uint16_t y = window->point_st.y_pos; y <= window->point_end.y_pos; y++) {
+        for (uint16_t x = window->point_st.x_pos; x <= window->point_end.x_pos; x++) model[y][x] = window->window_color;
+    }
+}
+
+static void model_blit(const struct ili9328_window * const window, const uint16_t *source)
+{
+    for (uint16_t y = window->point_st.y_pos; y <= window->point_end.y_pos; y++) {
+        for (uint16_t x = window->point_st.x_pos; x <= window->point_end.x_pos; x++) model[y][x] = *source++;
+    }
+}
+
+static struct ili9328_window random_window(void)
+{
+    struct ili9328_window window;
+
+    window.point_st.x_pos = rand() % WIDTH;
+    window.point_st.y_pos = rand() % HEIGHT;
+    window.point_end.x_pos = window.point_st.x_pos + rand() % (WIDTH - window.point_st.x_pos);
+    window.point_end.y_pos = window.point_st.y_pos + rand() % (HEIGHT - window.point_st.y_pos);
+    window.window_color = rand();
+
+    return window;
+}
+
+static void test_fill_rect(void)
+{
+    // Corners, edges and sizes that leave a tail after the unrolled loop
+    static const struct ili9328_window windows[] = {
+        {{0, 0}, {0, 0}, ILI9328_RED_SOLID},
+        {{WIDTH - 1, HEIGHT - 1}, {WIDTH - 1, HEIGHT - 1}, ILI9328_GREEN_SOLID},
+        {{WIDTH - 1, 0}, {WIDTH - 1, HEIGHT - 1}, ILI9328_BLUE_SOLID},
+        {{0, HEIGHT - 1}, {WIDTH - 1, HEIGHT - 1}, ILI9328_YELLOW_SOLID},
+        {{10, 20}, {16, 22}, ILI9328_WHITE_SOLID},
+        {{100, 50}, {107, 57}, 0x1234},
+    };
+
+    for (uint32_t i = 0; i < ARRAY_SIZE(windows); i++) {
+        const uint32_t before = ili9328_emu.gram_writes;
+        const uint32_t area = (windows[i].point_end.x_pos - windows[i].point_st.x_pos + 1) *
+            (windows[i].point_end.y_pos - windows[i].point_st.y_pos + 1);
+
+        CHECK(ili9328_fill_rect(&windows[i]) == E_SUCCESS);
+        model_fill(&windows[i]);
+        // Every pixel is written once: the address counter wraps inside the window
+        CHECK(ili9328_emu.gram_writes - before == area);
+        check_full_window();
+    }
+    check_screen();
+}
+
+static void test_blit(void)
+{
+    static const struct ili9328_window windows[] = {
+        {{0, 0}, {0, 0}},
+        {{WIDTH - 3, HEIGHT - 5}, {WIDTH - 1, HEIGHT - 1}},
+        {{0, 0}, {WIDTH - 1, 0}},
+        {{37, 11}, {37 + 12, 11 + 6}},
+        {{0, 0}, {WIDTH - 1, HEIGHT - 1}},
+    };
+
+    for (uint32_t i = 0; i < ARRAY_SIZE(windows); i++) {
+        const uint32_t area = (windows[i].point_end.x_pos - windows[i].point_st.x_pos + 1) *
+            (windows[i].point_end.y_pos - windows[i].point_st.y_pos + 1);
+        const uint32_t before = ili9328_emu.gram_writes;
+
+        for (uint32_t k = 0; k < area; k++) pixels[k] = rand();
+        CHECK(ili9328_blit(&windows[i], pixels) == E_SUCCESS);
+        model_blit(&windows[i], pixels);
+        CHECK(ili9328_emu.gram_writes - before == area);
+        check_full_window();
+        check_screen();
+    }
+}
+
+/**
+ * @brief Rectangles outside the screen, inverted or missing are refused before anything reaches the bus
+ */
+static void test_clipping(void)
+{
+    static const struct ili9328_window windows[] = {
+        {{0, 0}, {WIDTH, 0}},
+        {{0, 0}, {0, HEIGHT}},
+        {{WIDTH - 1, HEIGHT - 1}, {WIDTH, HEIGHT}},
+        {{10, 10}, {9, 10}},
+        {{10, 10}, {10, 9}},
+        {{WIDTH, HEIGHT}, {WIDTH, HEIGHT}},
+    };
+    const uint32_t writes = ili9328_emu.data_writes;
+
+    for (uint32_t i = 0; i < ARRAY_SIZE(windows); i++) {
+        CHECK(ili9328_fill_rect(&windows[i]) == E_INVALID_PARAMETER);
+        CHECK(ili9328_blit(&windows[i], pixels) == E_INVALID_PARAMETER);
+        CHECK(ili9328_set_gram_window(&windows[i]) == E_INVALID_PARAMETER);
+    }
+    CHECK(ili9328_fill_rect(NULL) == E_INVALID_PARAMETER);
+    CHECK(ili9328_blit(NULL, pixels) == E_INVALID_PARAMETER);
+    CHECK(ili9328_blit(&(struct ili9328_window){{0, 0}, {1, 1}}, NULL) == E_INVALID_PARAMETER);
+    CHECK(ili9328_set_scroll(WIDTH) == E_INVALID_PARAMETER);
+
+    CHECK(ili9328_emu.data_writes == writes);
+    check_screen();
+}
+
+/**
+ * @brief Random fills and blits, checked against the model
+ */
+static void test_random(void)
+{
+    for (uint32_t round = 0; round < ROUNDS; round++) {
+        const struct ili9328_window window = random_window();
+
+        if (round % 2) {
+            CHECK(ili9328_fill_rect(&window) == E_SUCCESS);
+            model_fill(&window);
+        } else {
+            const uint32_t area = (window.point_end.x_pos - window.point_st.x_pos + 1) *
+                (window.point_end.y_pos - window.point_st.y_pos + 1);
+            for (uint32_t k = 0; k < area; k++) pixels[k] = rand();
+            CHECK(ili9328_blit(&window, pixels) == E_SUCCESS);
+            model_blit(&window, pixels);
+        }
+    }
+    check_full_window();
+    check_screen();
+}
+
+/**
+ * @brief The hardware scroll moves what is shown, not what is drawn
+ */
+static void test_scroll(void)
+{
+    static const uint16_t scrolls[] = {1, 8, WIDTH - 1, 0};
+    uint32_t wrong = 0;
+
+    for (uint32_t i = 0; i < ARRAY_SIZE(scrolls); i++) {
+        CHECK(ili9328_set_scroll(scrolls[i]) == E_SUCCESS);
+        for (uint16_t y = 0; y < HEIGHT; y++) {
+            for (uint16_t x = 0; x < WIDTH; x++) {
+                if (ili9328_emu_shown_pixel(&ili9328_emu, (x + scrolls[i]) % WIDTH, y) != model[y][x]) wrong++;
+            }
+        }
+    }
+    CHECK(wrong == 0);
+    check_screen();
+}
+
+/**
+ * @brief Bus writes per pixel for rectangles of a few sizes
+ */
+static void bus_cost(void)
+{
+    static const uint16_t sizes[] = {1, 2, 8, 32, 240};
+
+    printf("%6s %12s %12s\n", "size", "fill w/px", "blit w/px");
+    for (uint32_t i = 0; i < ARRAY_SIZE(sizes); i++) {
+        const struct ili9328_window window = {{0, 0}, {sizes[i] - 1, sizes[i] - 1}, ILI9328_BLACK_SOLID};
+        const double area = (double)sizes[i] * sizes[i];
+
+        const uint32_t fill_start = ili9328_emu.index_writes + ili9328_emu.data_writes;
+        ili9328_fill_rect(&window);
+        const uint32_t blit_start = ili9328_emu.index_writes + ili9328_emu.data_writes;
+        ili9328_blit(&window, pixels);
+        const uint32_t end = ili9328_emu.index_writes + ili9328_emu.data_writes;
+
+        printf("%3ux%-3u %12.3f %12.3f\n", sizes[i], sizes[i], (blit_start - fill_start) / area,
+            (end - blit_start) / area);
+    }
+    printf("(bus writes, index and data, per pixel of a square rectangle)\n");
+}
+
+int main(void)
+{
+    srand(3);
+    host_kernel_init(&kernel_clock);
+    ili9328_emu_reset(&ili9328_emu);
+
+    CHECK(ili9328_init() == E_SUCCESS);
+    ili9328_clear_screen(ILI9328_BLACK_SOLID);
+    check_full_window();
+    check_screen();
+
+    test_fill_rect();
+    test_blit();
+    test_clipping();
+    test_random();
+    test_scroll();
+    bus_cost();
+
+    return test_report("ili9328_test");
+}
@@ -0,0 +1,177 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#include "libs/audio/nco.h"
+
+#include "include/errors.h"
+
+#include "ulibc/include/utils.h"
+
+#include "tests/test.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/** Largest error of nco_sine() against a 16 bits sine, in LSB, as documented */
+#define MAX_SINE_ERROR 2
+
+/** Phases between two points of the sine sweep */
+#define SWEEP_STEP 509
+
+/** Rate of the codec the tone generator feeds */
+#define RATE_HZ 8000
+
+/** Samples generated by the benchmark */
+#define BENCH_SAMPLES (4 * 1024 * 1024)
+
+#define TWO_PI_OVER_2_32 (2 * M_PI / 4294967296.0)
+
+static int16_t output[2 * RATE_HZ];
+static volatile int16_t sink;
+
+/**
+ * @brief Checks nco_sine() against sinf() over the whole circle
+ *
+ * @return uint32_t Largest error in LSB
+ */
+static uint32_t test_sine(void)
+{
+    uint32_t max_error = 0;
+    uint64_t phase = 0;
+
+    for (; phase < (1ULL << 32); phase += SWEEP_STEP) {
+        const int32_t expected = lrintf(32767 * sinf((float)(phase * TWO_PI_OVER_2_32)));
+        const uint32_t error = abs(nco_sine(phase) - expected);
+        max_error = CHOOSE_MAX(max_error, error);
+    }
+    // Quadrant edges, where the table runs backwards or changes sign
+    for (uint32_t quadrant = 0; quadrant < 4; quadrant++) {
+        for (int32_t delta = -2; delta <= 2; delta++) {
+            const uint32_t edge = (quadrant << 30) + delta;
+            const int32_t expected = lrint(32767 * sin(edge * TWO_PI_OVER_2_32));
+            const uint32_t error = abs(nco_sine(edge) - expected);
+            max_error = CHOOSE_MAX(max_error, error);
+        }
+    }
+    CHECK(max_error <= MAX_SINE_ERROR);
+
+    return max_error;
+}
+
+/**
+ * @brief Generates a second of a tone into one channel of a stereo buffer and checks it against sinf()
+ *
+ * @return uint32_t Largest error in LSB
+ */
+static uint32_t test_generate(uint32_t frequency_hz, int16_t amplitude)
+{
+    struct nco nco;
+    uint32_t max_error = 0;
+
+    for (uint32_t i = 0; i < ARRAY_SIZE(output); i++) output[i] = 0x5a5a;
+    CHECK(nco_init(&nco, frequency_hz, RATE_HZ, amplitude) == E_SUCCESS);
+
+    // In blocks, as the player does: the phase carries over
+    for (uint32_t done = 0; done < RATE_HZ; done += 100) nco_generate(&nco, &output[2 * done], 100, 2);
+
+    for (uint32_t i = 0; i < RATE_HZ; i++) {
+        const uint32_t phase = (uint32_t)((uint64_t)i * nco.step);
+        const int32_t expected = lrintf(amplitude * sinf((float)(phase * TWO_PI_OVER_2_32)));
+        const uint32_t error = abs(output[2 * i] - expected);
+        max_error = CHOOSE_MAX(max_error, error);
+        CHECK(output[2 * i + 1] == 0x5a5a);
+    }
+    // Table error scaled to the amplitude, plus the rounding of the scaling
+    CHECK(max_error <= MAX_SINE_ERROR + 1);
+
+    // The frequency is exact to rate / 2^33 and the phase carries over whole seconds
+    const double actual_hz = nco.step * (double)RATE_HZ / 4294967296.0;
+    CHECK(fabs(actual_hz - frequency_hz) <= RATE_HZ / 8589934592.0);
+    CHECK(nco.phase == (uint32_t)((uint64_t)RATE_HZ * nco.step));
+
+    return max_error;
+}
+
+static void test_parameters(void)
+{
+    struct nco nco;
+
+    CHECK(nco_init(&nco, 1000, 0, INT16_MAX) == E_INVALID_PARAMETER);
+    CHECK(nco_init(&nco, RATE_HZ / 2, RATE_HZ, INT16_MAX) == E_INVALID_PARAMETER);
+    CHECK(nco_init(&nco, RATE_HZ / 2 - 1, RATE_HZ, INT16_MAX) == E_SUCCESS);
+    CHECK(nco_init(&nco, 0, RATE_HZ, INT16_MAX) == E_SUCCESS);
+
+    // A new frequency keeps the phase
+    CHECK(nco_init(&nco, 1000, RATE_HZ, INT16_MAX) == E_SUCCESS);
+    nco_generate(&nco, output, 3, 1);
+    const uint32_t phase = nco.phase;
+    CHECK(nco_set_frequency(&nco, 2000, RATE_HZ) == E_SUCCESS);
+    CHECK(nco.phase == phase);
+    CHECK(nco_set_frequency(&nco, RATE_HZ, RATE_HZ) == E_INVALID_PARAMETER);
+}
+
+/**
+ * @brief Host time per sample of nco_generate() and of a sinf() loop doing the same
+ */
+static void benchmark(double * const nco_ns, double * const sinf_ns)
+{
+    struct nco nco;
+    const uint32_t block = 256;
+
+    nco_init(&nco, 1000, RATE_HZ, INT16_MAX);
+    const uint64_t nco_start = test_now_us();
+    for (uint32_t done = 0; done < BENCH_SAMPLES; done += block) {
+        nco_generate(&nco, output, block, 1);
+        sink = output[block - 1];
+    }
+    const uint64_t sinf_start = test_now_us();
+    uint32_t phase = 0;
+    for (uint32_t done = 0; done < BENCH_SAMPLES; done += block) {
+        for (uint32_t i = 0; i < block; i++) {
+            output[i] = lrintf(INT16_MAX * sinf((float)(phase * TWO_PI_OVER_2_32)));
+            phase += nco.step;
+        }
+        sink = output[block - 1];
+    }
+    const uint64_t end = test_now_us();
+
+    *nco_ns = (sinf_start - nco_start) * 1000.0 / BENCH_SAMPLES;
+    *sinf_ns = (end - sinf_start) * 1000.0 / BENCH_SAMPLES;
+}
+
+int main(void)
+{
+    static const struct {
+        uint32_t frequency_hz;
+        int16_t amplitude;
+    } tones[] = {
+        {1, INT16_MAX},
+        {440, INT16_MAX},
+        {1000, INT16_MAX / 2},
+        {3999, INT16_MAX},
+        {1234, 1000},
+    };
+    double nco_ns, sinf_ns;
+
+    test_parameters();
+    printf("nco_sine: largest error %u LSB\n", test_sine());
+
+    printf("%6s %9s %9s\n", "Hz", "amplitude", "error");
+    for (uint32_t i = 0; i < ARRAY_SIZE(tones); i++) {
+        printf("%6u %9d %9u\n", tones[i].frequency_hz, tones[i].amplitude,
+            test_generate(tones[i].frequency_hz, tones[i].amplitude));
+    }
+    printf("(at %u Hz, largest error against sinf() in LSB)\n", RATE_HZ);
+
+    benchmark(&nco_ns, &sinf_ns);
+    printf("nco_generate: %.2f ns/sample, sinf: %.2f ns/sample (host)\n", nco_ns, sinf_ns);
+
+    return test_report("nco_test");
+}
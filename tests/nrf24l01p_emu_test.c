@@ -0,0 +1,570 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#include "drivers/nrf24l01p/nrf24l01p.h"
+#include "drivers/nrf24l01p/nrf24l01p_defs.h"
+#include "drivers/nrf24l01p/nrf24l01p_emu.h"
+#include "drivers/nrf24l01p/nrf24l01p_rx.h"
+#include "drivers/nrf24l01p/nrf24l01p_tx.h"
+
+#include "libs/pbuf/pbuf.h"
+
+#include "include/errors.h"
+
+#include "ulibc/include/utils.h"
+
+#include "tests/host_kernel.h"
+#include "tests/test.h"
+
+#include "FreeRTOS.h"
+#include "queue.h"
+#include "task.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/** Payloads streamed by each scenario */
+#define STREAM_PACKETS 2000
+
+/** Timeout of the stream operations in ticks */
+#define STREAM_TIMEOUT 100
+
+static struct nrf24l01p_emu_channel channel;
+static struct nrf24l01p_emu radio_a, radio_b;
+
+static const struct spi_device spi_a = {.ops = &nrf24l01p_emu_spi_ops, .priv = &radio_a};
+static const struct gpio_device cs_a = {.ops = &nrf24l01p_emu_cs_ops, .priv = &radio_a};
+static const struct gpio_device ce_a = {.ops = &nrf24l01p_emu_ce_ops, .priv = &radio_a};
+static struct nrf24l01p_shadow shadow_a;
+static const struct nrf24l01p device_a = {
+    .spi_device = &spi_a, .ce_gpio = &ce_a, .cs_gpio = &cs_a, .shadow = &shadow_a,
+};
+
+static const struct spi_device spi_b = {.ops = &nrf24l01p_emu_spi_ops, .priv = &radio_b};
+static const struct gpio_device cs_b = {.ops = &nrf24l01p_emu_cs_ops, .priv = &radio_b};
+static const struct gpio_device ce_b = {.ops = &nrf24l01p_emu_ce_ops, .priv = &radio_b};
+static struct nrf24l01p_shadow shadow_b;
+static const struct nrf24l01p device_b = {
+    .spi_device = &spi_b, .ce_gpio = &ce_b, .cs_gpio = &cs_b, .shadow = &shadow_b,
+};
+
+/** Resolution of the emulated clock while every task is blocked, in ns */
+#define KERNEL_STEP_NS 10000
+
+// The driver tasks run on the host kernel, over the channel clock: the timeouts and rates of the driver are measured
+// in emulated time
+
+static uint64_t channel_now(void *arg)
+{
+    return nrf24l01p_emu_now(arg);
+}
+
+static void channel_advance(void *arg, uint64_t ns)
+{
+    nrf24l01p_emu_advance(arg, ns);
+}
+
+static const struct host_kernel_clock kernel_clock = {
+    .now_ns = channel_now, .advance_ns = channel_advance, .arg = &channel, .step_ns = KERNEL_STEP_NS,
+};
+
+/**
+ * @brief Checks that no task kept the lock of a radio
+ */
+static void check_unlocked(const struct nrf24l01p * const device)
+{
+    CHECK(device->shadow->lock == NULL || host_kernel_mutex_depth(device->shadow->lock) == 0);
+}
+
+/**
+ * @brief Waits of ulTaskNotifyTake() that ended in timeout so far
+ */
+static uint32_t notify_timeouts(void)
+{
+    struct host_kernel_stats stats;
+    host_kernel_get_stats(&stats);
+    return stats.notify_timeouts;
+}
+
+/**
+ * @brief Reads every payload waiting in the RX FIFO of the receiver
+ *
+ * @param received [in/out] Payloads received so far
+ * @param in_order [in/out] Cleared if a payload does not carry the next sequence number
+ */
+static void drain_receiver(uint32_t *received, uint32_t *in_order)
+{
+    while (1) {
+        uint8_t status, width, payload[NRF24L01P_MAX_PAYLOAD];
+
+        CHECK(nrf24l01p_get_status(&device_b, &status) == E_SUCCESS);
+        uint8_t pipe = (status & STATUS_RX_P_NO_MSK) >> STATUS_RX_P_NO_SHIFT;
+        if (pipe == STATUS_RX_P_NO_EMPTY) break;
+
+        CHECK(nrf24l01p_get_rx_payload_width(&device_b, pipe, &width) == E_SUCCESS);
+        CHECK(nrf24l01p_r_rx_payload(&device_b, width, payload) == E_SUCCESS);
+        CHECK(nrf24l01p_clear_status_irq(&device_b, STATUS_RX_DR) == E_SUCCESS);
+        if (payload[0] != (uint8_t)*received) *in_order = 0;
+        (*received)++;
+    }
+}
+
+/**
+ * @brief ISR of the IRQ pin of the transmitter
+ */
+static void radio_a_irq(void *arg)
+{
+    (void)arg;
+    nrf24l01p_tx_irq_handler(&device_a);
+}
+
+/**
+ * @brief ISR of the IRQ pin of the receiver, for the scenarios that run the RX service on it
+ */
+static void radio_b_irq(void *arg)
+{
+    (void)arg;
+    nrf24l01p_rx_irq_handler();
+}
+
+/**
+ * @brief Connects both radios over a fresh channel. A transmits, B receives
+ */
+static void radios_setup(uint32_t loss_per_mille, uint32_t bit_error_ppm)
+{
+    memset(&channel, 0, sizeof(channel));
+    channel.latency_us = 1;
+    channel.loss_per_mille = loss_per_mille;
+    channel.bit_error_ppm = bit_error_ppm;
+    channel.spi_byte_ns = 1000;
+    channel.seed = 7;
+
+    CHECK(nrf24l01p_emu_connect(&channel, &radio_a, &radio_b) == E_SUCCESS);
+    radio_a.irq_handler = radio_a_irq;
+    radio_b.irq_handler = NULL;
+    radio_b.invalid_pipe_period = 0;
+    CHECK(nrf24l01p_default_setup(&device_a) == E_SUCCESS);
+    CHECK(nrf24l01p_default_setup(&device_b) == E_SUCCESS);
+    CHECK(nrf24l01p_standby_1(&device_a) == E_SUCCESS);
+    CHECK(nrf24l01p_standby_1(&device_b) == E_SUCCESS);
+    nrf24l01p_enable_receiver(&device_b);
+}
+
+/**
+ * @brief Streams STREAM_PACKETS payloads of 1 to 32 bytes from A to B and checks the accounting of the stream
+ * against what the emulated radios saw
+ */
+static void test_stream(uint32_t loss_per_mille, uint32_t bit_error_ppm)
+{
+    struct nrf24l01p_stream stream;
+    uint32_t received = 0, in_order = 1, write_errors = 0;
+    uint8_t payload[NRF24L01P_MAX_PAYLOAD];
+
+    radios_setup(loss_per_mille, bit_error_ppm);
+    const uint32_t timeouts = notify_timeouts();
+    const uint32_t warnings = test_warnings;
+    // Every MAX_RT is logged: counted below instead of printed
+    test_log_quiet = 1;
+
+    CHECK(nrf24l01p_stream_start(&device_a, &stream) == E_SUCCESS);
+    for (uint32_t i = 0; i < STREAM_PACKETS; i++) {
+        for (uint32_t k = 0; k < sizeof(payload); k++) payload[k] = i + k;
+        int32_t ret = nrf24l01p_stream_write(&device_a, &stream, 1 + i % NRF24L01P_MAX_PAYLOAD, payload,
+            STREAM_TIMEOUT);
+        // Only losing a payload to MAX_RT is acceptable
+        if (ret < 0) {
+            CHECK(ret == E_TIMEOUT);
+            write_errors++;
+        }
+        drain_receiver(&received, &in_order);
+    }
+    int32_t ret = nrf24l01p_stream_stop(&device_a, &stream, STREAM_TIMEOUT);
+    drain_receiver(&received, &in_order);
+    test_log_quiet = 0;
+
+    check_unlocked(&device_a);
+    check_unlocked(&device_b);
+    // The writer slept until the radio sent or gave up on a payload, never until its timeout
+    CHECK(notify_timeouts() == timeouts);
+    CHECK(test_warnings - warnings == stream.max_rt);
+    CHECK(stream.written + write_errors == STREAM_PACKETS);
+    CHECK(stream.packets + stream.discarded == stream.written);
+    // Acknowledged means acknowledged: the stream agrees with the transmitter
+    CHECK(stream.packets == radio_a.tx_packets);
+    CHECK(received == radio_b.rx_packets);
+    CHECK(received >= stream.packets);
+    CHECK(radio_b.rx_overflows == 0);
+    if (stream.max_rt == 0) {
+        CHECK(ret == E_SUCCESS);
+        CHECK(write_errors == 0 && stream.discarded == 0);
+        CHECK(received == STREAM_PACKETS);
+        CHECK(in_order);
+    } else {
+        CHECK(stream.discarded > 0);
+    }
+
+    printf("%5u %6u %8u %8u %9u %6u %8u %9.2f\n", loss_per_mille, bit_error_ppm, stream.packets, stream.discarded,
+        radio_a.tx_attempts, stream.max_rt, nrf24l01p_stream_rate(&stream),
+        stream.arc_samples ? (double)stream.arc_sum / stream.arc_samples : 0.0);
+}
+
+/**
+ * @brief Streams to a receiver that is powered down: every payload ends in MAX_RT and is discarded
+ */
+static void test_no_receiver(void)
+{
+    struct nrf24l01p_stream stream;
+    uint8_t payload[4] = {0}, observe;
+    int32_t ret;
+
+    radios_setup(0, 0);
+    const uint32_t notify_timeouts_before = notify_timeouts();
+    test_log_quiet = 1;
+    CHECK(nrf24l01p_power_down(&device_b) == E_SUCCESS);
+
+    CHECK(nrf24l01p_stream_start(&device_a, &stream) == E_SUCCESS);
+    CHECK(nrf24l01p_stream_write(&device_a, &stream, sizeof(payload), payload, STREAM_TIMEOUT) == E_SUCCESS);
+    CHECK(nrf24l01p_stream_stop(&device_a, &stream, STREAM_TIMEOUT) == E_TIMEOUT);
+    CHECK(nrf24l01p_get_observe_tx(&device_a, &observe) == E_SUCCESS);
+    CHECK((observe & OBSERVE_TX_ARC_CNT) == SETUP_RETR_ARC_MSK);
+    CHECK(stream.max_rt == 1 && stream.packets == 0 && stream.written == 1 && stream.discarded == 1);
+
+    // The FIFO fills up behind the first payload: one write reports the MAX_RT that flushed it
+    uint32_t timeouts = 0;
+    CHECK(nrf24l01p_stream_start(&device_a, &stream) == E_SUCCESS);
+    for (uint32_t i = 0; i < 5; i++) {
+        ret = nrf24l01p_stream_write(&device_a, &stream, sizeof(payload), payload, STREAM_TIMEOUT);
+        CHECK(ret == E_SUCCESS || ret == E_TIMEOUT);
+        if (ret == E_TIMEOUT) timeouts++;
+    }
+    CHECK(nrf24l01p_stream_stop(&device_a, &stream, STREAM_TIMEOUT) == E_TIMEOUT);
+    test_log_quiet = 0;
+    CHECK(timeouts > 0);
+    CHECK(stream.packets == 0 && stream.written + timeouts == 5 && stream.discarded == stream.written);
+    check_unlocked(&device_a);
+    CHECK(notify_timeouts() == notify_timeouts_before);
+}
+
+/** Payloads delivered to a callback route */
+struct route_log {
+    uint32_t count;             /** Payloads delivered */
+    uint32_t in_order;          /** Cleared if a payload does not carry the next sequence number */
+    uint32_t misrouted;         /** Payloads sent to another pipe */
+    uint32_t hold;              /** Non-zero to keep the buffers of the payloads in held */
+    uint32_t held_count;
+    struct pbuf *held[2 * NRF24L01P_RX_BUFFERS];
+};
+
+/**
+ * @brief Checks a payload sent by send_to_pipe()
+ */
+static void check_payload(struct route_log * const log, const struct nrf24l01p_packet * const packet)
+{
+    if (packet->buffer->payload[0] != (uint8_t)log->count) log->in_order = 0;
+    if (packet->buffer->payload[1] != packet->pipe) log->misrouted++;
+    log->count++;
+}
+
+static void route_callback(const struct nrf24l01p_packet * const packet, void *arg)
+{
+    struct route_log *log = arg;
+
+    check_payload(log, packet);
+    if (log->hold && log->held_count < ARRAY_SIZE(log->held)) {
+        pbuf_ref(packet->buffer);
+        log->held[log->held_count++] = packet->buffer;
+    }
+}
+
+/**
+ * @brief Releases the buffers kept by route_callback()
+ */
+static void release_held(struct route_log * const log)
+{
+    for (uint32_t i = 0; i < log->held_count; i++) pbuf_free(log->held[i]);
+    log->held_count = 0;
+}
+
+/**
+ * @brief Takes every packet waiting in a queue
+ *
+ * @param queue Queue. NULL for the shared queue of the RX service
+ */
+static void drain_queue(struct route_log * const log, QueueHandle_t queue)
+{
+    struct nrf24l01p_packet packet;
+
+    while (queue == NULL ? nrf24l01p_rx_receive(&packet, 0) == E_SUCCESS : xQueueReceive(queue, &packet, 0)) {
+        check_payload(log, &packet);
+        pbuf_free(packet.buffer);
+    }
+}
+
+/**
+ * @brief Streams count payloads from A to a pipe of B. Each carries its sequence number and the pipe
+ */
+static void send_to_pipe(uint8_t pipe, uint32_t count, uint32_t first)
+{
+    static const uint8_t addrs[][5] = {
+        {0xe7, 0xe7, 0xe7, 0xe7, 0xe7},
+        {0xc2, 0xc2, 0xc2, 0xc2, 0xc2},
+        {0xc3, 0xc2, 0xc2, 0xc2, 0xc2},
+    };
+    struct nrf24l01p_stream stream;
+    uint8_t payload[8] = {0};
+
+    // The ACK comes back to pipe 0 of A, which listens to the address it sends to
+    CHECK(nrf24l01p_set_tx_addr(&device_a, sizeof(addrs[pipe]), addrs[pipe]) == E_SUCCESS);
+    CHECK(nrf24l01p_set_addr_p0(&device_a, sizeof(addrs[pipe]), addrs[pipe]) == E_SUCCESS);
+
+    CHECK(nrf24l01p_stream_start(&device_a, &stream) == E_SUCCESS);
+    for (uint32_t i = 0; i < count; i++) {
+        payload[0] = first + i;
+        payload[1] = pipe;
+        CHECK(nrf24l01p_stream_write(&device_a, &stream, sizeof(payload), payload, STREAM_TIMEOUT) == E_SUCCESS);
+    }
+    CHECK(nrf24l01p_stream_stop(&device_a, &stream, STREAM_TIMEOUT) == E_SUCCESS);
+    // Lets the RX service drain the RX FIFO
+    vTaskDelay(2);
+}
+
+/**
+ * @brief Starts the RX service on B, with pipe 2 enabled
+ */
+static void rx_setup(uint32_t loss_per_mille)
+{
+    const struct nrf24l01p_pipe_config config = {.enabled = 1, .auto_ack = 1, .dynamic_payload = 1};
+
+    radios_setup(loss_per_mille, 0);
+    radio_b.irq_handler = radio_b_irq;
+    CHECK(nrf24l01p_configure_pipe(&device_b, 2, &config) == E_SUCCESS);
+    CHECK(nrf24l01p_rx_start(&device_b) == E_SUCCESS);
+}
+
+/**
+ * @brief Routes pipe 0 to the shared queue, pipe 1 to a callback and pipe 2 to a queue of its own
+ */
+static void test_rx_routing(void)
+{
+    static uint8_t queue_storage[NRF24L01P_RX_QUEUE_LENGTH * sizeof(struct nrf24l01p_packet)];
+    static StaticQueue_t queue_buffer;
+    struct route_log logs[3] = {{.in_order = 1}, {.in_order = 1}, {.in_order = 1}};
+    struct nrf24l01p_rx_stats before, after;
+    const uint32_t count = 10;
+
+    const QueueHandle_t queue = xQueueCreateStatic(NRF24L01P_RX_QUEUE_LENGTH, sizeof(struct nrf24l01p_packet),
+        queue_storage, &queue_buffer);
+    rx_setup(0);
+    CHECK(nrf24l01p_rx_set_callback(1, route_callback, &logs[1]) == E_SUCCESS);
+    CHECK(nrf24l01p_rx_set_queue(2, queue) == E_SUCCESS);
+    nrf24l01p_rx_get_stats(&before);
+
+    // Interleaved so that each route sees the others in between
+    for (uint32_t round = 0; round < 2; round++) {
+        for (uint8_t pipe = 0; pipe < 3; pipe++) send_to_pipe(pipe, count / 2, round * count / 2);
+    }
+    drain_queue(&logs[0], NULL);
+    drain_queue(&logs[2], queue);
+    nrf24l01p_rx_get_stats(&after);
+
+    for (uint32_t pipe = 0; pipe < 3; pipe++) {
+        CHECK(logs[pipe].count == count);
+        CHECK(logs[pipe].in_order);
+        CHECK(logs[pipe].misrouted == 0);
+        CHECK(after.pipe_received[pipe] - before.pipe_received[pipe] == count);
+    }
+    CHECK(after.received - before.received == 3 * count);
+    CHECK(after.dropped == before.dropped && after.errors == before.errors);
+    CHECK(nrf24l01p_rx_get_pool()->available == NRF24L01P_RX_BUFFERS);
+
+    nrf24l01p_rx_set_callback(1, NULL, NULL);
+    nrf24l01p_rx_set_queue(2, NULL);
+    nrf24l01p_rx_stop();
+    check_unlocked(&device_b);
+}
+
+/**
+ * @brief Overloads the RX service: first its shared queue, then its buffer pool. Once the consumer catches up every
+ * payload gets through again, so a flushed RX FIFO did not stall the radio
+ */
+static void test_rx_overload(void)
+{
+    static struct route_log log = {.in_order = 1};
+    struct nrf24l01p_rx_stats before, after;
+    const struct pbuf_pool *pool = nrf24l01p_rx_get_pool();
+
+    rx_setup(0);
+
+    // Nobody takes from the shared queue: what does not fit is dropped and its buffer goes back to the pool
+    nrf24l01p_rx_get_stats(&before);
+    send_to_pipe(0, NRF24L01P_RX_QUEUE_LENGTH + 8, 0);
+    nrf24l01p_rx_get_stats(&after);
+    CHECK(after.received - before.received == NRF24L01P_RX_QUEUE_LENGTH);
+    CHECK(after.dropped - before.dropped == 8);
+    CHECK(pool->available == NRF24L01P_RX_BUFFERS - NRF24L01P_RX_QUEUE_LENGTH);
+    drain_queue(&log, NULL);
+    CHECK(log.count == NRF24L01P_RX_QUEUE_LENGTH && log.in_order);
+    CHECK(pool->available == NRF24L01P_RX_BUFFERS);
+
+    // A callback keeps every buffer: once the pool is empty the RX FIFO is flushed
+    memset(&log, 0, sizeof(log));
+    log.in_order = 1;
+    log.hold = 1;
+    CHECK(nrf24l01p_rx_set_callback(0, route_callback, &log) == E_SUCCESS);
+    const uint32_t failures = pool->failures;
+    nrf24l01p_rx_get_stats(&before);
+    send_to_pipe(0, 2 * NRF24L01P_RX_BUFFERS, 0);
+    nrf24l01p_rx_get_stats(&after);
+    CHECK(log.count == NRF24L01P_RX_BUFFERS && log.in_order);
+    CHECK(pool->available == 0 && pool->min_available == 0);
+    CHECK(pool->failures > failures);
+    CHECK(after.dropped > before.dropped);
+
+    release_held(&log);
+    CHECK(pool->available == NRF24L01P_RX_BUFFERS);
+    log.hold = 0;
+    log.count = 0;
+    send_to_pipe(0, NRF24L01P_RX_BUFFERS, 0);
+    CHECK(log.count == NRF24L01P_RX_BUFFERS && log.in_order);
+
+    nrf24l01p_rx_set_callback(0, NULL, NULL);
+    nrf24l01p_rx_stop();
+    check_unlocked(&device_b);
+}
+
+/**
+ * @brief The receiver reports an invalid pipe number now and then: the RX FIFO is flushed, the error counted and the
+ * service goes on
+ */
+static void test_rx_invalid_pipe(void)
+{
+    static struct route_log log;
+    struct nrf24l01p_rx_stats before, after;
+    const uint32_t period = 5, count = 40;
+
+    rx_setup(0);
+    CHECK(nrf24l01p_rx_set_callback(0, route_callback, &log) == E_SUCCESS);
+    radio_b.invalid_pipe_period = period;
+    nrf24l01p_rx_get_stats(&before);
+    const uint32_t warnings = test_warnings;
+    test_log_quiet = 1;
+
+    send_to_pipe(0, count, 0);
+    test_log_quiet = 0;
+    nrf24l01p_rx_get_stats(&after);
+
+    const uint32_t errors = after.errors - before.errors;
+    CHECK(errors == count / period);
+    CHECK(test_warnings - warnings == errors);
+    // Each flush loses at most the RX FIFO
+    CHECK(log.count < count && log.count >= count - errors * NRF24L01P_EMU_FIFO_DEPTH);
+    CHECK(log.misrouted == 0);
+
+    radio_b.invalid_pipe_period = 0;
+    log.count = 0;
+    send_to_pipe(0, 10, 0);
+    CHECK(log.count == 10);
+
+    nrf24l01p_rx_set_callback(0, NULL, NULL);
+    nrf24l01p_rx_stop();
+    check_unlocked(&device_b);
+}
+
+/**
+ * @brief Once stopped the RX service masks RX_DR and leaves the radio alone. Starting it again unmasks it
+ */
+static void test_rx_stop(void)
+{
+    struct nrf24l01p_rx_stats before, after;
+
+    rx_setup(0);
+    nrf24l01p_rx_stop();
+    CHECK(radio_b.regs[NRF24L01P_REG_CONFIG] & CONFIG_MASK_RX_DR);
+
+    nrf24l01p_rx_get_stats(&before);
+    send_to_pipe(0, 3, 0);
+    nrf24l01p_rx_get_stats(&after);
+    CHECK(after.irqs == before.irqs && after.received == before.received);
+    CHECK(radio_b.rx_count == 3);
+
+    // The packets left in the RX FIFO keep RX_DR set: the service must be woken for them once
+    CHECK(nrf24l01p_rx_start(&device_b) == E_SUCCESS);
+    CHECK(!(radio_b.regs[NRF24L01P_REG_CONFIG] & CONFIG_MASK_RX_DR));
+    vTaskDelay(2);
+    nrf24l01p_rx_get_stats(&after);
+    CHECK(after.received - before.received == 3);
+    drain_queue(&(struct route_log){0}, NULL);
+
+    nrf24l01p_rx_stop();
+    check_unlocked(&device_b);
+}
+
+/**
+ * @brief Measures the RX service: payloads delivered to a callback per second of emulated time, and host time spent
+ * per payload by the driver and the emulator
+ */
+static void benchmark_rx(uint32_t loss_per_mille)
+{
+    static struct route_log log;
+    const uint32_t count = STREAM_PACKETS;
+
+    rx_setup(loss_per_mille);
+    memset(&log, 0, sizeof(log));
+    CHECK(nrf24l01p_rx_set_callback(0, route_callback, &log) == E_SUCCESS);
+
+    const uint64_t start_ns = nrf24l01p_emu_now(&channel);
+    const uint64_t start_us = test_now_us();
+    send_to_pipe(0, count, 0);
+    const uint64_t host_us = test_now_us() - start_us;
+    const uint64_t elapsed_ns = nrf24l01p_emu_now(&channel) - start_ns;
+
+    CHECK(log.count == count);
+    printf("%5u %8u %8llu %10.2f\n", loss_per_mille, log.count,
+        (unsigned long long)((uint64_t)log.count * 1000000000ULL / elapsed_ns), host_us * 1000.0 / count);
+
+    nrf24l01p_rx_set_callback(0, NULL, NULL);
+    nrf24l01p_rx_stop();
+}
+
+int main(void)
+{
+    static const struct {
+        uint32_t loss_per_mille;
+        uint32_t bit_error_ppm;
+    } cases[] = {
+        {0, 0},
+        {100, 0},
+        {300, 0},
+        {0, 300},
+        {100, 300},
+        // Heavy enough for payloads to hit MAX_RT in the middle of the stream
+        {500, 0},
+    };
+
+    host_kernel_init(&kernel_clock);
+
+    printf("%5s %6s %8s %8s %9s %6s %8s %9s\n", "loss", "ber", "acked", "dropped", "attempts", "max_rt", "pkt/s",
+        "arc avg");
+    for (uint32_t i = 0; i < ARRAY_SIZE(cases); i++) test_stream(cases[i].loss_per_mille, cases[i].bit_error_ppm);
+    printf("(loss in 1/1000, ber in ppm, pkt/s in emulated time)\n");
+
+    test_no_receiver();
+
+    test_rx_routing();
+    test_rx_overload();
+    test_rx_invalid_pipe();
+    test_rx_stop();
+
+    printf("%5s %8s %8s %10s\n", "loss", "received", "pkt/s", "host ns");
+    benchmark_rx(0);
+    benchmark_rx(100);
+    printf("(RX service to a callback, pkt/s in emulated time, host ns per packet)\n");
+
+    return test_report("nrf24l01p_emu_test");
+}
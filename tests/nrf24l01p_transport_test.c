@@ -0,0 +1,352 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#include "drivers/nrf24l01p/nrf24l01p.h"
+#include "drivers/nrf24l01p/nrf24l01p_defs.h"
+#include "drivers/nrf24l01p/nrf24l01p_emu.h"
+#include "drivers/nrf24l01p/nrf24l01p_rx.h"
+#include "drivers/nrf24l01p/nrf24l01p_transport.h"
+#include "drivers/nrf24l01p/nrf24l01p_tx.h"
+
+#include "libs/pbuf/pbuf.h"
+
+#include "include/errors.h"
+
+#include "ulibc/include/utils.h"
+
+#include "tests/host_kernel.h"
+#include "tests/test.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** Resolution of the emulated clock while every task is blocked, in ns */
+#define KERNEL_STEP_NS 10000
+
+/** Time in ticks the transport waits for a frame, and consecutive timeouts before giving up */
+#define TRANSPORT_TIMEOUT 20
+#define TRANSPORT_RETRIES 10
+
+/** Largest message sent */
+#define MAX_MESSAGE 4000
+
+/** A message of MAX_MESSAGE bytes must get through in this many ticks, whatever the channel */
+#define MAX_MESSAGE_TICKS 1000
+
+static struct nrf24l01p_emu_channel channel;
+static struct nrf24l01p_emu radio_a, radio_b;
+
+static const struct spi_device spi_a = {.ops = &nrf24l01p_emu_spi_ops, .priv = &radio_a};
+static const struct gpio_device cs_a = {.ops = &nrf24l01p_emu_cs_ops, .priv = &radio_a};
+static const struct gpio_device ce_a = {.ops = &nrf24l01p_emu_ce_ops, .priv = &radio_a};
+static struct nrf24l01p_shadow shadow_a;
+static const struct nrf24l01p device_a = {
+    .spi_device = &spi_a, .ce_gpio = &ce_a, .cs_gpio = &cs_a, .shadow = &shadow_a,
+};
+
+static const struct spi_device spi_b = {.ops = &nrf24l01p_emu_spi_ops, .priv = &radio_b};
+static const struct gpio_device cs_b = {.ops = &nrf24l01p_emu_cs_ops, .priv = &radio_b};
+static const struct gpio_device ce_b = {.ops = &nrf24l01p_emu_ce_ops, .priv = &radio_b};
+static struct nrf24l01p_shadow shadow_b;
+static const struct nrf24l01p device_b = {
+    .spi_device = &spi_b, .ce_gpio = &ce_b, .cs_gpio = &cs_b, .shadow = &shadow_b,
+};
+
+static uint64_t channel_now(void *arg)
+{
+    return nrf24l01p_emu_now(arg);
+}
+
+static void channel_advance(void *arg, uint64_t ns)
+{
+    nrf24l01p_emu_advance(arg, ns);
+}
+
+static const struct host_kernel_clock kernel_clock = {
+    .now_ns = channel_now, .advance_ns = channel_advance, .arg = &channel, .step_ns = KERNEL_STEP_NS,
+};
+
+/*
+ * The RX service runs on B, the receiver. It serves a single radio, so A, the sender, reads the SACKs out of its
+ * RX FIFO by itself, into buffers of its own
+ */
+
+PBUF_POOL_DEFINE(sack_pool, 4, NRF24L01P_MAX_PAYLOAD, 0);
+
+/** Task waiting in sender_rx_frame() for the IRQ of A */
+static TaskHandle_t volatile sack_waiter;
+
+static void radio_a_irq(void *arg)
+{
+    BaseType_t woken = pdFALSE;
+
+    (void)arg;
+    nrf24l01p_tx_irq_handler(&device_a);
+    if (sack_waiter != NULL) vTaskNotifyGiveFromISR(sack_waiter, &woken);
+}
+
+static void radio_b_irq(void *arg)
+{
+    (void)arg;
+    nrf24l01p_tx_irq_handler(&device_b);
+    nrf24l01p_rx_irq_handler();
+}
+
+static int32_t sender_tx_begin(struct nrf24l01p_transport * const transport)
+{
+    return nrf24l01p_transport_radio_ops.tx_begin_op(transport);
+}
+
+static int32_t sender_tx_frame(struct nrf24l01p_transport * const transport, const void * const frame, uint32_t size)
+{
+    return nrf24l01p_transport_radio_ops.tx_frame_op(transport, frame, size);
+}
+
+static int32_t sender_tx_end(struct nrf24l01p_transport * const transport)
+{
+    return nrf24l01p_transport_radio_ops.tx_end_op(transport);
+}
+
+static int32_t sender_rx_frame(struct nrf24l01p_transport * const transport, struct pbuf ** const frame,
+    uint32_t timeout)
+{
+    const struct nrf24l01p *device = ((struct nrf24l01p_transport_radio *)transport->priv)->device;
+    const uint32_t start = xTaskGetTickCount();
+    uint8_t status, width;
+    int32_t ret;
+
+    sack_waiter = xTaskGetCurrentTaskHandle();
+    while (1) {
+        // Clearing RX_DR first lets the next packet raise the IRQ again
+        ret = nrf24l01p_clear_status_irq(device, STATUS_RX_DR);
+        if (ret < 0) { goto exit; }
+        status = nrf24l01p_get_last_status(device);
+        const uint8_t pipe = (status & STATUS_RX_P_NO_MSK) >> STATUS_RX_P_NO_SHIFT;
+        if (pipe != STATUS_RX_P_NO_EMPTY) {
+            ret = nrf24l01p_get_rx_payload_width(device, pipe, &width);
+            if (ret < 0) { goto exit; }
+            *frame = pbuf_alloc(&sack_pool);
+            CHECK(*frame != NULL);
+            ret = nrf24l01p_r_rx_payload(device, width, pbuf_put(*frame, width));
+            if (ret < 0) {
+                pbuf_free(*frame);
+                goto exit;
+            }
+            ret = width;
+            goto exit;
+        }
+
+        const uint32_t elapsed = xTaskGetTickCount() - start;
+        if (elapsed > timeout) {
+            ret = E_RX_QUEUE_EMPTY;
+            goto exit;
+        }
+        ulTaskNotifyTake(pdTRUE, timeout - elapsed + 1);
+    }
+
+    exit:
+    sack_waiter = NULL;
+    return ret;
+}
+
+static const struct nrf24l01p_transport_operations sender_ops = {
+    .tx_begin_op = sender_tx_begin,
+    .tx_frame_op = sender_tx_frame,
+    .tx_end_op = sender_tx_end,
+    .rx_frame_op = sender_rx_frame,
+};
+
+/*
+ * Receiver task
+ */
+
+#define RECEIVER_TASK_SIZE 256
+
+static StackType_t receiver_stack[RECEIVER_TASK_SIZE];
+static StaticTask_t receiver_tcb;
+
+/** What the receiver task got */
+static struct {
+    struct nrf24l01p_transport *transport;
+    volatile uint32_t stop;         /** Set by the sender once every message was acknowledged */
+    volatile uint32_t stopped;
+    uint32_t messages;              /** Messages received */
+    uint32_t mismatches;            /** Messages that differ from the one sent */
+    uint32_t errors;                /** nrf24l01p_transport_receive() errors other than E_RX_QUEUE_EMPTY */
+    uint8_t buffer[MAX_MESSAGE];
+} receiver;
+
+/** Sizes of the messages sent. Covers empty messages, fragment boundaries and windows of more than 32 fragments */
+static const uint32_t sizes[] = {
+    0, 1, NRF24L01P_TRANSPORT_FRAGMENT_SIZE - 2, NRF24L01P_TRANSPORT_FRAGMENT_SIZE - 1,
+    NRF24L01P_TRANSPORT_FRAGMENT_SIZE, 500, NRF24L01P_TRANSPORT_WINDOW * NRF24L01P_TRANSPORT_FRAGMENT_SIZE - 2,
+    2000, MAX_MESSAGE, 100, MAX_MESSAGE, 33,
+};
+
+static uint8_t messages[ARRAY_SIZE(sizes)][MAX_MESSAGE];
+
+static void receiver_task(void *arg)
+{
+    (void)arg;
+
+    while (1) {
+        // One round per test case
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        // Keeps answering after the last message: the sender may still ask for a final SACK that got lost
+        while (!receiver.stop) {
+            int32_t ret = nrf24l01p_transport_receive(receiver.transport, receiver.buffer, sizeof(receiver.buffer));
+            if (ret == E_RX_QUEUE_EMPTY) continue;
+            if (ret < 0) {
+                receiver.errors++;
+                continue;
+            }
+
+            // Exactly once and in order: the n-th message received is the n-th sent
+            if (receiver.messages >= ARRAY_SIZE(sizes) || (uint32_t)ret != sizes[receiver.messages] ||
+                memcmp(receiver.buffer, messages[receiver.messages], ret) != 0) {
+                receiver.mismatches++;
+            }
+            receiver.messages++;
+        }
+        receiver.stopped = 1;
+    }
+}
+
+/**
+ * @brief Connects both radios over a fresh channel and puts both in RX mode, as the transport leaves them
+ */
+static void radios_setup(uint32_t loss_per_mille, uint32_t bit_error_ppm)
+{
+    memset(&channel, 0, sizeof(channel));
+    channel.latency_us = 1;
+    channel.loss_per_mille = loss_per_mille;
+    channel.bit_error_ppm = bit_error_ppm;
+    channel.spi_byte_ns = 1000;
+    channel.seed = 11;
+
+    CHECK(nrf24l01p_emu_connect(&channel, &radio_a, &radio_b) == E_SUCCESS);
+    radio_a.irq_handler = radio_a_irq;
+    radio_b.irq_handler = radio_b_irq;
+    CHECK(nrf24l01p_default_setup(&device_a) == E_SUCCESS);
+    CHECK(nrf24l01p_default_setup(&device_b) == E_SUCCESS);
+    CHECK(nrf24l01p_standby_1(&device_a) == E_SUCCESS);
+    CHECK(nrf24l01p_standby_1(&device_b) == E_SUCCESS);
+    nrf24l01p_enable_receiver(&device_a);
+    nrf24l01p_enable_receiver(&device_b);
+}
+
+/**
+ * @brief Sends every message from A to B and checks that each arrives once, whole and in order
+ */
+static void test_round_trip(uint32_t loss_per_mille, uint32_t bit_error_ppm)
+{
+    static struct nrf24l01p_transport_radio radio_a_ops, radio_b_ops;
+    static struct nrf24l01p_transport sender, receiver_transport;
+    uint32_t bytes = 0, failed = 0, slowest = 0;
+
+    radios_setup(loss_per_mille, bit_error_ppm);
+    CHECK(nrf24l01p_rx_start(&device_b) == E_SUCCESS);
+
+    memset(&radio_a_ops, 0, sizeof(radio_a_ops));
+    memset(&radio_b_ops, 0, sizeof(radio_b_ops));
+    radio_a_ops.device = &device_a;
+    radio_b_ops.device = &device_b;
+    sender = (struct nrf24l01p_transport){
+        .ops = &sender_ops, .priv = &radio_a_ops, .timeout = TRANSPORT_TIMEOUT, .retries = TRANSPORT_RETRIES,
+    };
+    receiver_transport = (struct nrf24l01p_transport){
+        .ops = &nrf24l01p_transport_radio_ops, .priv = &radio_b_ops, .timeout = TRANSPORT_TIMEOUT,
+        .retries = TRANSPORT_RETRIES,
+    };
+    receiver.transport = &receiver_transport;
+    receiver.stop = 0;
+    receiver.stopped = 0;
+    receiver.messages = 0;
+    receiver.mismatches = 0;
+    receiver.errors = 0;
+
+    // MAX_RT on the lossy channels is expected and recovered by the protocol
+    test_log_quiet = 1;
+    static TaskHandle_t receiver_handle;
+    if (receiver_handle == NULL) {
+        receiver_handle = xTaskCreateStatic(receiver_task, "receiver", RECEIVER_TASK_SIZE, NULL, tskIDLE_PRIORITY + 1,
+            receiver_stack, &receiver_tcb);
+    }
+    xTaskNotifyGive(receiver_handle);
+
+    const uint64_t start_ns = nrf24l01p_emu_now(&channel);
+    const uint64_t start_us = test_now_us();
+    for (uint32_t i = 0; i < ARRAY_SIZE(sizes); i++) {
+        const uint32_t start = xTaskGetTickCount();
+        int32_t ret = nrf24l01p_transport_send(&sender, messages[i], sizes[i]);
+        const uint32_t ticks = xTaskGetTickCount() - start;
+
+        if (ret != (int32_t)sizes[i]) failed++;
+        else bytes += sizes[i];
+        if (ticks > slowest) slowest = ticks;
+    }
+    const uint64_t host_us = test_now_us() - start_us;
+    const uint64_t elapsed_ns = nrf24l01p_emu_now(&channel) - start_ns;
+
+    receiver.stop = 1;
+    while (!receiver.stopped) vTaskDelay(TRANSPORT_TIMEOUT);
+    test_log_quiet = 0;
+    nrf24l01p_rx_stop();
+
+    // The window never stalls: every message gets through, the largest one in bounded time
+    CHECK(failed == 0);
+    CHECK(slowest <= MAX_MESSAGE_TICKS);
+    CHECK(receiver.messages == ARRAY_SIZE(sizes));
+    CHECK(receiver.mismatches == 0);
+    CHECK(receiver.errors == 0);
+    if (loss_per_mille == 0 && bit_error_ppm == 0) CHECK(sender.stats.retransmissions == 0);
+    CHECK(sack_pool.available == sack_pool.count);
+    CHECK(nrf24l01p_rx_get_pool()->available == NRF24L01P_RX_BUFFERS);
+    CHECK(host_kernel_mutex_depth(shadow_a.lock) == 0 && host_kernel_mutex_depth(shadow_b.lock) == 0);
+
+    printf("%5u %6u %8u %9llu %8u %8u %6u %8u %8u %8.1f\n", loss_per_mille, bit_error_ppm, bytes,
+        (unsigned long long)((uint64_t)bytes * 1000000000ULL / elapsed_ns), sender.stats.frames_sent,
+        sender.stats.retransmissions, sender.stats.sacks, sender.stats.timeouts, slowest,
+        bytes ? host_us * 1000.0 / bytes : 0.0);
+}
+
+int main(void)
+{
+    static const struct {
+        uint32_t loss_per_mille;
+        uint32_t bit_error_ppm;
+    } cases[] = {
+        {0, 0},
+        {100, 0},
+        {300, 0},
+        {0, 300},
+        {100, 300},
+    };
+
+    host_kernel_init(&kernel_clock);
+
+    srand(3);
+    for (uint32_t i = 0; i < ARRAY_SIZE(sizes); i++) {
+        for (uint32_t k = 0; k < sizes[i]; k++) messages[i][k] = rand();
+    }
+
+    printf("%5s %6s %8s %9s %8s %8s %6s %8s %8s %8s\n", "loss", "ber", "bytes", "bytes/s", "frames", "resent",
+        "sacks", "timeouts", "slowest", "host ns");
+    for (uint32_t i = 0; i < ARRAY_SIZE(cases); i++) {
+        test_round_trip(cases[i].loss_per_mille, cases[i].bit_error_ppm);
+    }
+    printf("(loss in 1/1000, ber in ppm, bytes/s in emulated time, slowest message in ticks, host ns per byte)\n");
+
+    return test_report("nrf24l01p_transport_test");
+}
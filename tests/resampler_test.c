@@ -0,0 +1,191 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#include "libs/audio/resampler.h"
+
+#include "include/errors.h"
+
+#include "ulibc/include/utils.h"
+
+#include "tests/test.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/** Rate of the codec the WAV player converts to */
+#define OUT_RATE_HZ 8000
+
+/** Filter sizing of the WAV player: WAV_PLAYER_RESAMPLER_TAPS, _MIN_TAPS and _COEFFS */
+#define PLAYER_TAPS 64
+#define PLAYER_MIN_TAPS 16
+#define PLAYER_COEFFS (80 * PLAYER_TAPS)
+
+/** Input of each measurement: half a second at the highest rate */
+#define MAX_INPUT 24000
+
+/** Passband edge as a fraction of the output Nyquist frequency, and the ripple allowed up to it */
+#define PASSBAND_EDGE 0.45
+#define PASSBAND_RIPPLE_DB 0.1
+
+/** Stopband edge as a fraction of the output Nyquist frequency, and the rejection needed beyond it */
+#define STOPBAND_EDGE 1.375
+#define STOPBAND_REJECTION_DB 55.0
+
+/** Level and frequency of the SNR measurement, and the SNR needed */
+#define SNR_LEVEL 0.5
+#define SNR_FREQ_HZ 1000.0
+#define SNR_DB 75.0
+
+/** Seconds of stereo converted by the benchmark */
+#define BENCH_SECONDS 4
+
+static int16_t coeffs[PLAYER_COEFFS];
+static int16_t history[2][2 * PLAYER_TAPS];
+static int16_t input[2 * MAX_INPUT];
+static int16_t output[2 * MAX_INPUT];
+
+/**
+ * @brief Sets up a converter the way the WAV player does for a file at in_rate_hz
+ *
+ * @return uint32_t Taps of the filter. 0 if the player would reject the ratio
+ */
+static uint32_t player_init(struct resampler * const resampler, uint32_t in_rate_hz, int16_t * const history)
+{
+    const uint32_t phases = resampler_coeffs_size(in_rate_hz, OUT_RATE_HZ, 1);
+    const uint32_t taps = CHOOSE_MIN(PLAYER_TAPS, PLAYER_COEFFS / phases);
+
+    if (taps < PLAYER_MIN_TAPS) return 0;
+    if (resampler_init(resampler, in_rate_hz, OUT_RATE_HZ, taps, coeffs, ARRAY_SIZE(coeffs), history) != E_SUCCESS) {
+        return 0;
+    }
+
+    return taps;
+}
+
+/**
+ * @brief Converts a tone and fits a sine at its frequency to the output, once the filter settled
+ *
+ * @param in_rate_hz Input rate
+ * @param freq_hz Frequency of the tone
+ * @param level Amplitude of the tone, relative to full scale
+ * @param snr_db [out] Power of the fitted sine over the power of what is left. May be NULL
+ * @return double Output power relative to the input power, in dB
+ */
+static double measure_tone(uint32_t in_rate_hz, double freq_hz, double level, double *snr_db)
+{
+    struct resampler resampler;
+    const uint32_t count = in_rate_hz / 2;
+    const double amplitude = level * INT16_MAX;
+    double in_power = 0, out_power = 0, ss = 0, cc = 0, xs = 0, xc = 0, residue = 0;
+
+    CHECK(player_init(&resampler, in_rate_hz, history[0]) > 0);
+    for (uint32_t i = 0; i < count; i++) {
+        input[i] = lrint(amplitude * sin(2 * M_PI * freq_hz * i / in_rate_hz));
+        in_power += (double)input[i] * input[i];
+    }
+    in_power /= count;
+    const uint32_t produced = resampler_process(&resampler, input, count, 1, output, 1);
+    CHECK(produced <= resampler_max_output(&resampler, count));
+
+    // The first quarter holds the filter settling
+    const uint32_t first = produced / 4;
+    // A tone above the output Nyquist frequency comes out at its alias
+    const double out_freq_hz = fabs(freq_hz - OUT_RATE_HZ * floor(freq_hz / OUT_RATE_HZ + 0.5));
+    for (uint32_t i = first; i < produced; i++) {
+        const double t = 2 * M_PI * out_freq_hz * i / OUT_RATE_HZ;
+        ss += sin(t) * sin(t);
+        cc += cos(t) * cos(t);
+        xs += output[i] * sin(t);
+        xc += output[i] * cos(t);
+        out_power += (double)output[i] * output[i];
+    }
+    out_power /= produced - first;
+
+    if (snr_db != NULL) {
+        const double a = xs / ss, b = xc / cc;
+        double signal = 0;
+        for (uint32_t i = first; i < produced; i++) {
+            const double t = 2 * M_PI * out_freq_hz * i / OUT_RATE_HZ;
+            const double fit = a * sin(t) + b * cos(t);
+            signal += fit * fit;
+            residue += (output[i] - fit) * (output[i] - fit);
+        }
+        *snr_db = 10 * log10(signal / residue);
+    }
+
+    return 10 * log10(out_power / in_power);
+}
+
+/**
+ * @brief Converts BENCH_SECONDS of interleaved stereo block by block, as the player does
+ *
+ * @return double Host time per output frame in ns
+ */
+static double benchmark(uint32_t in_rate_hz)
+{
+    struct resampler resamplers[2];
+    const uint32_t block = 128;
+    uint32_t produced = 0;
+
+    player_init(&resamplers[0], in_rate_hz, history[0]);
+    resamplers[1] = resamplers[0];
+    resamplers[1].history = history[1];
+    resampler_reset(&resamplers[1]);
+    for (uint32_t i = 0; i < 2 * block; i++) input[i] = rand();
+
+    const uint64_t start = test_now_us();
+    for (uint32_t done = 0; done < BENCH_SECONDS * in_rate_hz; done += block) {
+        const uint32_t count = CHOOSE_MIN(block, BENCH_SECONDS * in_rate_hz - done);
+        resampler_process(&resamplers[0], &input[0], count, 2, &output[0], 2);
+        produced += resampler_process(&resamplers[1], &input[1], count, 2, &output[1], 2);
+    }
+    const uint64_t elapsed_us = test_now_us() - start;
+
+    CHECK(produced >= BENCH_SECONDS * OUT_RATE_HZ - 1 && produced <= BENCH_SECONDS * OUT_RATE_HZ + 1);
+    return elapsed_us * 1000.0 / produced;
+}
+
+int main(void)
+{
+    static const uint32_t rates[] = {11025, 16000, 22050, 32000, 44100, 48000};
+    const double nyquist_hz = OUT_RATE_HZ / 2;
+
+    printf("%6s %4s %8s %10s %12s %8s\n", "in Hz", "taps", "SNR dB", "ripple dB", "rejection dB", "ns/frame");
+    for (uint32_t i = 0; i < ARRAY_SIZE(rates); i++) {
+        struct resampler resampler;
+        double snr_db, ripple_db = 0, rejection_db = INFINITY;
+
+        const uint32_t taps = player_init(&resampler, rates[i], history[0]);
+        CHECK(taps >= PLAYER_MIN_TAPS);
+        if (taps == 0) continue;
+
+        measure_tone(rates[i], SNR_FREQ_HZ, SNR_LEVEL, &snr_db);
+        CHECK(snr_db >= SNR_DB);
+
+        for (double freq_hz = 100; freq_hz <= PASSBAND_EDGE * nyquist_hz; freq_hz += 100) {
+            const double gain_db = measure_tone(rates[i], freq_hz, SNR_LEVEL, NULL);
+            ripple_db = CHOOSE_MAX(ripple_db, fabs(gain_db));
+        }
+        CHECK(ripple_db <= PASSBAND_RIPPLE_DB);
+
+        for (double freq_hz = STOPBAND_EDGE * nyquist_hz; freq_hz < rates[i] / 2.0; freq_hz += 250) {
+            const double gain_db = measure_tone(rates[i], freq_hz, SNR_LEVEL, NULL);
+            rejection_db = CHOOSE_MIN(rejection_db, -gain_db);
+        }
+        CHECK(rejection_db >= STOPBAND_REJECTION_DB);
+
+        printf("%6u %4u %8.1f %10.3f %12.1f %8.1f\n", rates[i], taps, snr_db, ripple_db, rejection_db,
+            benchmark(rates[i]));
+    }
+    printf("(to %u Hz, ripple up to %.0f Hz, rejection from %.0f Hz, stereo host time per output frame)\n",
+        OUT_RATE_HZ, PASSBAND_EDGE * nyquist_hz, STOPBAND_EDGE * nyquist_hz);
+
+    return test_report("resampler_test");
+}
@@ -0,0 +1,247 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#include "drivers/sdcard/sdcard.h"
+#define SDCARD_INTERNAL
+#include "drivers/sdcard/sdcard_common.h"
+#include "drivers/sdcard/sdcard_spi_impl.h"
+#include "drivers/sdcard/sdcard_spi_emu.h"
+
+#include "include/errors.h"
+#include "include/device/gpio.h"
+#include "include/device/spi.h"
+
+#include "libs/crc7/crc7.h"
+
+#include "ulibc/include/utils.h"
+
+#include "tests/test.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/** Number of blocks moved by each benchmark run */
+#define BENCH_BLOCKS 64
+
+/** Blocks of the image used by the data and benchmark tests (4MiB) */
+#define IMAGE_BLOCKS 8192
+
+static const char *crc_mode_name[] = {"block", "off"};
+
+static char image_path[] = "/tmp/sdcard_emu_test_XXXXXX";
+
+static struct sdcard_spi_emu emu;
+static const struct spi_device spi = {.ops = &sdcard_spi_emu_spi_ops, .priv = &emu};
+static const struct gpio_device cs = {.ops = &sdcard_spi_emu_cs_ops, .priv = &emu};
+static const struct sdcard_spi_priv priv = {.spi = &spi, .cs = &cs};
+
+static uint8_t buffer[BENCH_BLOCKS * 512];
+static uint8_t readback[BENCH_BLOCKS * 512];
+
+/**
+ * @brief Resizes the (sparse) image file
+ */
+static void image_resize(uint32_t blocks)
+{
+    FILE *image = fopen(image_path, "r+b");
+    if (image == NULL || ftruncate(fileno(image), (off_t)blocks * 512) != 0) {
+        printf("can not resize %s\n", image_path);
+        exit(1);
+    }
+    fclose(image);
+}
+
+/**
+ * @brief Opens the emulator over the image and initializes the card
+ */
+static int32_t card_open(struct sdcard * const sdcard, uint32_t high_capacity)
+{
+    memset(&emu, 0, sizeof(emu));
+    emu.high_capacity = high_capacity;
+    emu.init_acmd41_count = 2;
+    emu.access_bytes = 2;
+    emu.busy_bytes = 16;
+
+    int32_t ret = sdcard_spi_emu_open(&emu, image_path);
+    if (ret != E_SUCCESS) return ret;
+
+    sdcard->priv = &priv;
+    return sdcard_init(sdcard);
+}
+
+/**
+ * @brief Checks the capacity told by the CSD for images around the limits of each card type
+ */
+static void test_capacity(void)
+{
+    static const struct {
+        uint32_t high_capacity;
+        uint32_t image_blocks;
+        int32_t open_ret;
+        uint32_t block_count;
+    } cases[] = {
+        // SDHC counts 512KiB units
+        {1, 1, E_INVALID_PARAMETER, 0},
+        {1, 1023, E_INVALID_PARAMETER, 0},
+        {1, 1024, E_SUCCESS, 1024},
+        {1, 3000, E_SUCCESS, 2048},
+        {1, 65536, E_SUCCESS, 65536},
+        // SDSC goes from 4 blocks up to 4GiB, C_SIZE_MULT then READ_BL_LEN grow with the image
+        {0, 3, E_INVALID_PARAMETER, 0},
+        {0, 4, E_SUCCESS, 4},
+        {0, 4 * 4096, E_SUCCESS, 4 * 4096},
+        {0, 4 * 4096 + 8, E_SUCCESS, 4 * 4096 + 8},
+        {0, 5000, E_SUCCESS, 5000},
+        {0, 512 * 4096, E_SUCCESS, 512 * 4096},
+        {0, 512 * 4096 + 1024, E_SUCCESS, 512 * 4096 + 1024},
+        {0, 1024 * 4096, E_SUCCESS, 1024 * 4096},
+        {0, 2048 * 4096, E_SUCCESS, 2048 * 4096},
+        {0, 2048 * 4096 + 1, E_INVALID_PARAMETER, 0},
+    };
+
+    for (uint32_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        struct sdcard sdcard = {0};
+        uint32_t block_count = 0;
+
+        image_resize(cases[i].image_blocks);
+        int32_t ret = card_open(&sdcard, cases[i].high_capacity);
+        CHECK(ret == cases[i].open_ret);
+        if (ret != E_SUCCESS) continue;
+
+        CHECK(sdcard_get_block_count(&sdcard, &block_count) == E_SUCCESS);
+        CHECK(block_count == cases[i].block_count);
+        sdcard_spi_emu_close(&emu);
+    }
+}
+
+/**
+ * @brief Writes or reads BENCH_BLOCKS blocks, one by one or with a single multiple block command
+ *
+ * @return uint32_t Bus bytes used by the transfer
+ */
+static uint32_t transfer(const struct sdcard * const sdcard, uint32_t multi, uint32_t write, uint64_t *elapsed_us)
+{
+    uint32_t bus_bytes = emu.bus_bytes;
+    uint64_t start = test_now_us();
+    int32_t ret = E_SUCCESS;
+
+    if (multi) {
+        ret = write ? sdcard_write_blocks(sdcard, 100, BENCH_BLOCKS, buffer) :
+            sdcard_read_blocks(sdcard, 100, BENCH_BLOCKS, readback);
+    } else {
+        for (uint32_t i = 0; i < BENCH_BLOCKS && ret >= 0; i++) {
+            ret = write ? sdcard_write_block(sdcard, 100 + i, buffer + i * 512) :
+                sdcard_read_block(sdcard, 100 + i, readback + i * 512);
+        }
+    }
+
+    *elapsed_us = test_now_us() - start;
+    CHECK(ret >= 0);
+    return emu.bus_bytes - bus_bytes;
+}
+
+/**
+ * @brief Recomputes the CRC7 and end bit of every pre-built command frame
+ */
+static void test_command_frames(void)
+{
+    static const uint8_t *frames[] = {
+        sdcard_cmd0_frame, sdcard_cmd8_frame, sdcard_cmd9_frame, sdcard_cmd12_frame, sdcard_cmd13_frame,
+        sdcard_cmd16_frame, sdcard_acmd41_frame, sdcard_cmd55_frame, sdcard_cmd58_frame, sdcard_cmd59_off_frame,
+        sdcard_cmd59_on_frame,
+    };
+
+    for (uint32_t i = 0; i < ARRAY_SIZE(frames); i++) {
+        uint8_t built[6];
+
+        CHECK(frames[i][5] == ((calc_crc7(frames[i], 5) << 1) | 0x01));
+        // Same frame as the one built at run time
+        sdcard_build_command(frames[i][0] & 0x3f, (uint32_t)frames[i][1] << 24 | (uint32_t)frames[i][2] << 16 |
+            (uint32_t)frames[i][3] << 8 | frames[i][4], built);
+        CHECK(memcmp(built, frames[i], sizeof(built)) == 0);
+    }
+}
+
+/**
+ * @brief Round trips data in every CRC mode and prints bus bytes and host time per block
+ */
+static void test_transfers(void)
+{
+    printf("%-5s %-8s %-5s %-6s %11s %9s\n", "card", "crc", "check", "op", "bytes/block", "us/block");
+
+    image_resize(IMAGE_BLOCKS);
+    for (uint32_t high_capacity = 0; high_capacity < 2; high_capacity++) {
+        for (uint32_t mode = SDCARD_CRC_BLOCK; mode <= SDCARD_CRC_OFF; mode++) {
+            for (uint32_t crc_check = 0; crc_check < 2; crc_check++) {
+                struct sdcard sdcard = {.crc_mode = mode, .crc_check = crc_check};
+                uint64_t elapsed_us;
+
+                if (mode == SDCARD_CRC_OFF && crc_check) {
+                    CHECK(card_open(&sdcard, high_capacity) == E_INVALID_PARAMETER);
+                    sdcard_spi_emu_close(&emu);
+                    continue;
+                }
+                CHECK(card_open(&sdcard, high_capacity) == E_SUCCESS);
+
+                for (uint32_t multi = 0; multi < 2; multi++) {
+                    static const char *op[2][2] = {{"read", "write"}, {"read*", "write*"}};
+
+                    for (uint32_t i = 0; i < sizeof(buffer); i++) buffer[i] = rand();
+                    memset(readback, 0, sizeof(readback));
+
+                    // Write first, then read it back
+                    for (uint32_t step = 0; step < 2; step++) {
+                        uint32_t write = step == 0;
+                        uint32_t bus_bytes = transfer(&sdcard, multi, write, &elapsed_us);
+                        printf("%-5s %-8s %-5s %-6s %11u %9.2f\n", high_capacity ? "SDHC" : "SDSC",
+                            crc_mode_name[mode], crc_check ? "yes" : "no", op[multi][write],
+                            bus_bytes / BENCH_BLOCKS, (double)elapsed_us / BENCH_BLOCKS);
+                    }
+                    CHECK(memcmp(buffer, readback, sizeof(buffer)) == 0);
+                }
+
+                // Corrupted blocks must be caught whenever the CRC is checked
+                if (mode != SDCARD_CRC_OFF) {
+                    emu.read_crc_error_period = 3;
+                    CHECK(sdcard_read_blocks(&sdcard, 100, 8, readback) < 0);
+                    emu.read_crc_error_period = 0;
+                    CHECK(sdcard_read_blocks(&sdcard, 100, 8, readback) >= 0);
+                }
+                if (crc_check) {
+                    emu.write_crc_error_period = 3;
+                    CHECK(sdcard_write_blocks(&sdcard, 100, 8, buffer) < 0);
+                    emu.write_crc_error_period = 0;
+                    CHECK(sdcard_write_blocks(&sdcard, 100, 8, buffer) >= 0);
+                }
+
+                sdcard_spi_emu_close(&emu);
+            }
+        }
+    }
+    printf("(* multiple block commands)\n");
+}
+
+int main(void)
+{
+    int fd = mkstemp(image_path);
+    if (fd < 0) {
+        printf("can not create %s\n", image_path);
+        return 1;
+    }
+    close(fd);
+
+    test_command_frames();
+    test_capacity();
+    test_transfers();
+
+    unlink(image_path);
+    return test_report("sdcard_emu_test");
+}
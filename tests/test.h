@@ -0,0 +1,57 @@
+/**
+ * @author Cristóvão Zuppardo Rufino <cristovaozr@gmail.com>
+ * @version 0.1
+ *
+ * @copyright Copyright Cristóvão Zuppardo Rufino (c) 2021
+ * Please see LICENCE file to information regarding licensing
+ */
+
+#ifndef TESTS_TEST_H_
+#define TESTS_TEST_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+/** Number of failed CHECK()s. The test program returns non-zero if any failed */
+extern uint32_t test_failures;
+
+/** Number of warnings and errors logged by the code under test */
+extern uint32_t test_warnings;
+
+/** Non-zero to count warnings and errors without printing them, in scenarios that expect them */
+extern uint32_t test_log_quiet;
+
+/**
+ * @brief Checks a condition, printing where it failed
+ */
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+        test_failures++; \
+    } \
+} while (0)
+
+/**
+ * @brief Current time of the host in microseconds, for the benchmarks
+ */
+static inline uint64_t test_now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/**
+ * @brief Prints the test summary
+ *
+ * @param name Name of the test program
+ * @return int Exit code of the test program
+ */
+static inline int test_report(const char *name)
+{
+    printf("%s: %s (%u failures)\n", name, test_failures ? "FAILED" : "PASSED", test_failures);
+    return test_failures ? 1 : 0;
+}
+
+#endif // TESTS_TEST_H_
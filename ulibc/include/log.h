@@ -9,6 +9,8 @@
 #ifndef ULIBC_INCLUDE_LOG_H_
 #define ULIBC_INCLUDE_LOG_H_
 
+#include "ulibc/include/ustdio.h"
+
 #include <stdint.h>
 
 /**
@@ -22,6 +24,25 @@ enum log_level {
     ERROR_LVL   // Red color
 };
 
+/** Longest message given to the log sink, terminator included. Messages are truncated as in the log output itself */
+#define ULOG_SINK_MESSAGE_SIZE USTDIO_OUTPUT_SIZE
+
+/**
+ * @brief Receives a copy of every log line, besides the default output. Called from the task that logs
+ *
+ * @param level Log level
+ * @param tag Tag of the line
+ * @param message Formatted message, without colors or line ending
+ */
+typedef void (*ulog_sink)(enum log_level level, const char *tag, const char *message);
+
+/**
+ * @brief Sets the log sink
+ *
+ * @param sink Sink. NULL to remove it
+ */
+extern void ulog_set_sink(ulog_sink sink);
+
 /**
  * @brief Logs something to the default output
  * 
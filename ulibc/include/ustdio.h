@@ -10,11 +10,23 @@
 #define ULIBC_INCLUDE_USTDIO_H_
 
 #include <stdarg.h>
+#include <stdint.h>
+
+/** Longest output of uprintf()/uvprintf(), terminator included. Longer outputs are truncated */
+#define USTDIO_OUTPUT_SIZE 80
 
 extern int uprintf(const char *fmt, ...);
 
 extern int uvprintf(const char *fmt, va_list ap);
 
+/**
+ * @brief Number of uprintf()/uvprintf() outputs dropped because every output buffer stayed in use for as long as
+ * they waited for one (100 ticks)
+ *
+ * @return uint32_t Outputs dropped since boot
+ */
+extern uint32_t uprintf_dropped(void);
+
 extern int ugetchar(void);
 
 extern int uputchar(int c);
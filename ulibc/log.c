@@ -11,6 +11,8 @@
 #include "ulibc/include/ustdio.h"
 
 #include <stdarg.h>
+#include <stdio.h>
+#include <stddef.h>
 
 #define DBG_COLOR "\e[1m\e[32m"
 #define INFO_COLOR "\e[1m\e[36m"
@@ -18,6 +20,13 @@
 #define ERROR_COLOR "\e[1m\e[31m"
 #define END_COLOR "\e[0m"
 
+static ulog_sink log_sink = NULL;
+
+void ulog_set_sink(ulog_sink sink)
+{
+    log_sink = sink;
+}
+
 void ulog(enum log_level level, const char *tag, const char *fmt, ...)
 {
     va_list ap;
@@ -53,6 +62,15 @@ void ulog(enum log_level level, const char *tag, const char *fmt, ...)
     va_end(ap);
 
     uprintf(END_COLOR "\r\n");
+
+    const ulog_sink sink = log_sink;
+    if (sink != NULL) {
+        char message[ULOG_SINK_MESSAGE_SIZE];
+        va_start(ap, fmt);
+        vsnprintf(message, sizeof(message), fmt, ap);
+        va_end(ap);
+        sink(level, tag, message);
+    }
 }
 
 void hex_ulog(const void *data, uint32_t len)
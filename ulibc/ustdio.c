@@ -9,37 +9,84 @@
 #include "include/device/device.h"
 #include "include/device/usart.h"
 
+#include "libs/pbuf/pbuf.h"
+
+#include "ulibc/include/ustdio.h"
+#include "ulibc/include/utils.h"
+
 #include <stdio.h>
 #include <stdarg.h>
 #include <stdint.h>
 #include <string.h>
 
+#include "FreeRTOS.h"
+#include "task.h"
+
 #define DEFAULT_TIMEOUT 100
 
-static char output[80];
+/** Tasks printing at the same time. Each one formats into a buffer of its own */
+#define OUTPUT_BUFFERS 4
+
+/** Time in ticks a task waits for an output buffer before its output is dropped */
+#define OUTPUT_WAIT_TIMEOUT DEFAULT_TIMEOUT
+
+PBUF_POOL_DEFINE(output_pool, OUTPUT_BUFFERS, USTDIO_OUTPUT_SIZE, 0);
 static const struct usart_device *usart = NULL;
+static uint32_t dropped = 0;
+
+/**
+ * @brief Gets an output buffer. While every buffer is in use, waits for another task to finish printing
+ *
+ * @return struct pbuf* Output buffer. NULL if none was released in OUTPUT_WAIT_TIMEOUT ticks
+ */
+static struct pbuf *output_alloc(void) {
+    struct pbuf *output = pbuf_alloc(&output_pool);
+
+    // Without the scheduler running no other task holds a buffer, and none could release it
+    if (output != NULL || xTaskGetSchedulerState() != taskSCHEDULER_RUNNING) return output;
+
+    const TickType_t start = xTaskGetTickCount();
+    while (output == NULL && xTaskGetTickCount() - start < OUTPUT_WAIT_TIMEOUT) {
+        // A buffer is held for as long as writing one line to the USART takes
+        vTaskDelay(1);
+        output = pbuf_alloc(&output_pool);
+    }
+
+    return output;
+}
 
 int uprintf(const char *fmt, ...) {
     va_list ap;
 
-    if (usart == NULL) usart = device_get_by_name(DEFAULT_USART);
-    if (usart == NULL) return -1;
-
     va_start(ap, fmt);
-    int ret = vsnprintf(output, sizeof(output), fmt, ap);
-    usart_write(usart, output, ret, DEFAULT_TIMEOUT);
+    int ret = uvprintf(fmt, ap);
     va_end(ap);
     return ret;
 }
 
 int uvprintf(const char *fmt, va_list ap) {
     if (usart == NULL) usart = device_get_by_name(DEFAULT_USART);
+    if (usart == NULL) return -1;
 
-    int ret = vsnprintf(output, sizeof(output), fmt, ap);
-    usart_write(usart, output, ret, DEFAULT_TIMEOUT);
+    struct pbuf *output = output_alloc();
+    if (output == NULL) {
+        dropped++;
+        return -1;
+    }
+
+    int ret = vsnprintf((char *)output->payload, pbuf_tailroom(output), fmt, ap);
+    if (ret > 0) {
+        output->size = CHOOSE_MIN(ret, USTDIO_OUTPUT_SIZE - 1);
+        usart_write(usart, output->payload, output->size, DEFAULT_TIMEOUT);
+    }
+    pbuf_free(output);
     return ret;
 }
 
+uint32_t uprintf_dropped(void) {
+    return dropped;
+}
+
 int ugetchar(void) {
     int ret;
     uint8_t byte;